@@ -0,0 +1,290 @@
+/** Copyright (c) 2011, Edgar Solomonik, all rights reserved.
+  * \addtogroup benchmarks
+  * @{
+  * \addtogroup model_calibration
+  * @{
+  * \brief Sweeps the parameter space of each performance model (collectives, transposes,
+  *        dense and sparse local kernels, padded redistributions), fits all models and
+  *        writes the coefficients along with goodness-of-fit statistics to a file
+  *        in the format of src/shared/init_models.cxx
+  */
+
+#include <ctf.hpp>
+#include "../src/redistribution/nosym_transp.h"
+#include <set>
+
+using namespace CTF;
+
+void factorize(std::set<int> & ps, int p){
+  ps.insert(p);
+  for (int i=2; i<p; i++){
+    if (p%i == 0) factorize(ps, p/i);
+  }
+}
+
+/**
+ * \brief sweeps message sizes of bcast, reduce, allreduce, and all-to-all-v over sub-communicators of each size
+ */
+void calibrate_comm(World & dw, int64_t max_sz, int niter){
+  MPI_Op madd;
+  MPI_Op_create([](void * a, void * b, int * n, MPI_Datatype*){
+                  for (int i=0; i<*n; i++){
+                    ((double*)b)[i] += ((double*)a)[i];
+                  }
+                }, 1, &madd);
+  std::set<int> ps;
+  factorize(ps, dw.np);
+  for (std::set<int>::iterator it=ps.begin(); it!=ps.end(); it++){
+    int np = *it;
+    if (np == 1) continue;
+    MPI_Comm cm;
+    MPI_Comm_split(dw.comm, dw.rank/np, dw.rank%np, &cm);
+    {
+      CTF_int::CommData cdt(cm);
+      for (int64_t n=1; n<=max_sz; n*=4){
+        double * buf  = (double*)malloc(sizeof(double)*n);
+        double * rbuf = (double*)malloc(sizeof(double)*n);
+        int64_t * counts = (int64_t*)malloc(sizeof(int64_t)*np);
+        int64_t * displs = (int64_t*)malloc(sizeof(int64_t)*np);
+        std::fill(buf, buf+n, 1.0);
+        for (int i=0; i<niter; i++){
+          cdt.bcast(buf, n, MPI_DOUBLE, 0);
+          cdt.allred(buf, rbuf, n, MPI_DOUBLE, MPI_SUM);
+          cdt.allred(buf, rbuf, n, MPI_DOUBLE, madd);
+          cdt.red(buf, rbuf, n, MPI_DOUBLE, MPI_SUM, 0);
+          cdt.red(buf, rbuf, n, MPI_DOUBLE, madd, 0);
+          //dense all-to-all-v with equal blocks, then sparse all-to-all-v to a single neighbor
+          for (int sparse=0; sparse<2; sparse++){
+            int64_t blk = n/np;
+            for (int p=0; p<np; p++){
+              if (sparse) counts[p] = (p == (cdt.rank+1)%np || p == (cdt.rank+np-1)%np) ? blk : 0;
+              else        counts[p] = blk;
+              displs[p] = p == 0 ? 0 : displs[p-1]+counts[p-1];
+            }
+            cdt.all_to_allv(buf, counts, displs, sizeof(double), rbuf, counts, displs);
+          }
+        }
+        free(buf);
+        free(rbuf);
+        free(counts);
+        free(displs);
+      }
+    }
+    MPI_Comm_free(&cm);
+  }
+  MPI_Op_free(&madd);
+}
+
+/**
+ * \brief sweeps sizes and contiguity classes of the local nonsymmetric transpose kernel
+ */
+void calibrate_transp(int64_t max_sz, int niter){
+  Ring<> r;
+  int const ctg_lens[] = {1, 16, 256};
+  for (int order=3; order<=4; order++){
+    for (int c=0; c<3; c++){
+      for (int64_t N=1024; N<=max_sz; N*=4){
+        int edge_len[order];
+        int new_order[order];
+        edge_len[0] = ctg_lens[c] == 1 ? (int)std::max(2.,pow((double)N, 1./order)) : ctg_lens[c];
+        int64_t rN = std::max((int64_t)1, N/edge_len[0]);
+        int64_t tot_sz = edge_len[0];
+        for (int i=1; i<order; i++){
+          edge_len[i] = (int)std::max(2.,pow((double)rN, 1./(order-1)))+i-1;
+          tot_sz *= edge_len[i];
+        }
+        //keep the first dimension in place unless calibrating the non-contiguous model
+        new_order[0] = ctg_lens[c] == 1 ? order-1 : 0;
+        for (int i=1; i<order; i++){
+          new_order[i] = ctg_lens[c] == 1 ? order-1-i : order-i;
+        }
+        double * data = (double*)malloc(sizeof(double)*tot_sz);
+        for (int64_t i=0; i<tot_sz; i++){
+          data[i] = (double)i;
+        }
+        for (int i=0; i<niter; i++){
+          CTF_int::nosym_transpose(order, new_order, edge_len, (char*)data, 1, &r);
+          CTF_int::nosym_transpose(order, new_order, edge_len, (char*)data, 0, &r);
+        }
+        free(data);
+      }
+    }
+  }
+}
+
+/**
+ * \brief sweeps shapes of dense local contractions with the BLAS, generic semiring, and custom function kernels
+ */
+void calibrate_gemm(World & sw, int64_t max_sz, int niter){
+  Semiring<double> mp(-INFINITY,
+                      [](double a, double b){ return std::max(a,b); },
+                      MPI_MAX,
+                      0.,
+                      [](double a, double b){ return a+b; });
+  Function<> fmul([](double a, double b){ return a*b; });
+  for (int64_t mn=8; mn*mn<=max_sz; mn*=2){
+    for (int64_t k=4; k*mn<=max_sz; k*=4){
+      int m = mn, n = mn+3;
+      Matrix<> A(m, k, sw);
+      Matrix<> B(k, n, sw);
+      Matrix<> C(m, n, sw);
+      Matrix<> C2(m, n, sw);
+      Matrix<> Am(m, k, sw, mp);
+      Matrix<> Bm(k, n, sw, mp);
+      Matrix<> Cm(m, n, sw, mp);
+      A.fill_random(-.5, .5);
+      B.fill_random(-.5, .5);
+      C.fill_random(-.5, .5);
+      C2.fill_random(-.5, .5);
+      Am["ij"] = A["ij"];
+      Bm["ij"] = B["ij"];
+      for (int i=0; i<niter; i++){
+        C["ij"] += A["ik"]*B["kj"];
+        Cm["ij"] += Am["ik"]*Bm["kj"];
+        C["ij"] += fmul(A["ik"],B["kj"]);
+        C2["ij"] += C["ij"]*C2["ij"];
+      }
+    }
+  }
+}
+
+/**
+ * \brief sweeps densities of sparse local contraction kernels (CSR times dense, dense times CSR, CSR times CSR)
+ */
+void calibrate_csrmm(World & w, int64_t max_sz, int niter){
+  Function<> fmul([](double a, double b){ return a*b; });
+  for (int64_t n=32; n*n<=max_sz; n*=2){
+    for (double sp=.0001; sp<.5; sp*=4.){
+      int m = n+1, k = n+2;
+      Matrix<> A(m, k, SP, w);
+      Matrix<> B(k, n, SP, w);
+      Matrix<> Ad(m, k, w);
+      Matrix<> Bd(k, n, w);
+      Matrix<> C(m, n, w);
+      Matrix<> Cs(m, n, SP, w);
+      Vector<> b(k, w);
+      Vector<> c(m, w);
+      A.fill_sp_random(-.5, .5, sp);
+      B.fill_sp_random(-.5, .5, sp);
+      Ad.fill_random(-.5, .5);
+      Bd.fill_random(-.5, .5);
+      b.fill_random(-.5, .5);
+      for (int i=0; i<niter; i++){
+        C["ij"] += A["ik"]*Bd["kj"];
+        C["ij"] += Ad["ik"]*B["kj"];
+        C["ij"] += fmul(A["ik"],Bd["kj"]);
+        Cs["ij"] += A["ik"]*B["kj"];
+        c["i"] += A["ij"]*b["j"];
+      }
+    }
+  }
+}
+
+/**
+ * \brief sweeps sizes of redistributions between processor grid mappings, with edge lengths chosen
+ *        to not divide the processor grid, so that padding and depadding is needed
+ */
+void calibrate_redist(World & dw, int64_t max_sz, int niter){
+  int plens[] = {dw.np};
+  Partition prl(1, plens);
+  for (int64_t n=16; n*n<=max_sz; n*=2){
+    for (int pad=0; pad<3; pad++){
+      int lens[] = {(int)n+pad, (int)n+2*pad+1};
+      int sym[] = {NS, NS};
+      Tensor<> A(2, lens, sym, dw, "ij", prl["i"]);
+      Tensor<> B(2, lens, sym, dw, "ij", prl["j"]);
+      Tensor<> As(2, true, lens, sym, dw, "ij", prl["i"]);
+      Tensor<> Bs(2, true, lens, sym, dw, "ij", prl["j"]);
+      A.fill_random(-.5, .5);
+      As.fill_sp_random(-.5, .5, .1);
+      for (int i=0; i<niter; i++){
+        B["ij"] = A["ij"];
+        A["ij"] = B["ij"];
+        Bs["ij"] = As["ij"];
+        As["ij"] = Bs["ij"];
+      }
+    }
+  }
+}
+
+void calibrate_all(World & dw, int64_t max_sz, int niter){
+  World sw(MPI_COMM_SELF);
+  if (dw.rank == 0) printf("Calibrating collective models\n");
+  calibrate_comm(dw, max_sz, niter);
+  if (dw.rank == 0) printf("Calibrating transpose models\n");
+  calibrate_transp(max_sz, niter);
+  if (dw.rank == 0) printf("Calibrating dense local contraction models\n");
+  calibrate_gemm(sw, max_sz, niter);
+  if (dw.rank == 0) printf("Calibrating sparse local contraction models\n");
+  calibrate_csrmm(sw, max_sz, niter);
+  calibrate_csrmm(dw, max_sz, niter);
+  if (dw.rank == 0) printf("Calibrating redistribution models\n");
+  calibrate_redist(dw, max_sz, niter);
+}
+
+char* getCmdOption(char ** begin,
+                   char ** end,
+                   const   std::string & option){
+  char ** itr = std::find(begin, end, option);
+  if (itr != end && ++itr != end){
+    return *itr;
+  }
+  return 0;
+}
+
+
+int main(int argc, char ** argv){
+  int rank, np, niter;
+  int64_t max_sz;
+  char const * fname;
+  int const in_num = argc;
+  char ** input_str = argv;
+
+  MPI_Init(&argc, &argv);
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+  MPI_Comm_size(MPI_COMM_WORLD, &np);
+
+  if (getCmdOption(input_str, input_str+in_num, "-maxsz")){
+    max_sz = atol(getCmdOption(input_str, input_str+in_num, "-maxsz"));
+    if (max_sz < 1024) max_sz = 1<<20;
+  } else max_sz = 1<<20;
+
+  if (getCmdOption(input_str, input_str+in_num, "-niter")){
+    niter = atoi(getCmdOption(input_str, input_str+in_num, "-niter"));
+    if (niter < 1) niter = 3;
+  } else niter = 3;
+
+  if (getCmdOption(input_str, input_str+in_num, "-o")){
+    fname = getCmdOption(input_str, input_str+in_num, "-o");
+  } else fname = "model_coeffs.cxx";
+
+  {
+    World dw(MPI_COMM_WORLD, argc, argv);
+
+    if (CTF_int::get_all_models().size() == 0){
+      if (rank == 0)
+        printf("No performance models are registered, CTF must be built with -DTUNE to calibrate models\n");
+    } else {
+      if (rank == 0){
+        printf("Calibrating %d models with max size %ld and %d iterations per configuration\n",
+               (int)CTF_int::get_all_models().size(), max_sz, niter);
+      }
+      //fit once to obtain estimates, then sweep again so fit statistics are computed on the refined model
+      calibrate_all(dw, max_sz, niter);
+      CTF_int::update_all_models(dw.comm);
+      calibrate_all(dw, max_sz, niter);
+      CTF_int::update_all_models(dw.comm);
+      CTF_int::write_all_models(fname, dw.comm);
+      if (rank == 0)
+        printf("Wrote model coefficients and fit statistics to %s\n", fname);
+    }
+  }
+
+  MPI_Finalize();
+  return 0;
+}
+
+/**
+ * @}
+ * @}
+ */
@@ -11,9 +11,7 @@ using namespace CTF;
 // compute a single Jacobi iteration to get new x, elementwise: x_i <== d_i*(b_i-sum_j R_ij*x_j)
 // solves Ax=b where R_ij=A_ij for i!=j, while R_ii=0, and d_i=1/A_ii
 void jacobi_iter(Matrix<> & R, Vector<> & b, Vector<> & d, Vector<> &x){
-  x["i"] = -R["ij"]*x["j"];
-  x["i"] += b["i"];
-  x["i"] *= d["i"];
+  x["i"] = d["i"]*(b["i"]-R["ij"]*x["j"]);
 }
 
 int jacobi(int     n,
@@ -39,12 +39,12 @@ Vector<float> mis(Matrix<float> & undir_A){
     //if there are no such vertices we are done
     if (v.nnz_tot == 0) return s;
 
-    //find everything connected to non-removed vertices
-    v["i"] += A["ij"]*v["j"];
+    //find all non-removed vertices connected to non-removed vertices,
+    //the mask skips edges into removed vertices
+    v["i"].masked(r, true) += A["ij"]*v["j"];
 
     //filter down to non-removed vertices that have no incoming
     //edges from non-removed vertices (are roots in remainder graph)
-    v["i"] += (1.+n)*r["i"];
     v.sparsify([](float f){ return f==1.0; });
 
     //add these to MIS
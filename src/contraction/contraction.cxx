@@ -13,10 +13,13 @@
 #include "ctr_2d_general.h"
 #include "spctr_offload.h"
 #include "spctr_2d_general.h"
+#include "spmspv.h"
+#include "../summation/ewise.h"
 #include "../symmetry/sym_indices.h"
 #include "../symmetry/symmetrization.h"
 #include "../redistribution/nosym_transp.h"
 #include "../redistribution/redist.h"
+#include "../redistribution/cyclic_reshuffle.h"
 #include "../sparse_formats/coo.h"
 #include "../sparse_formats/csr.h"
 #include <cfloat>
@@ -26,10 +29,14 @@ namespace CTF_int {
 
   using namespace CTF;
 
+  /** \brief report of the outermost contraction being executed, NULL if its World is not recording reports */
+  static Contraction_report * active_ctr_report = NULL;
+
   contraction::~contraction(){
     if (idx_A != NULL) cdealloc(idx_A);
     if (idx_B != NULL) cdealloc(idx_B);
     if (idx_C != NULL) cdealloc(idx_C);
+    if (idx_mask != NULL) cdealloc(idx_mask);
   }
 
   contraction::contraction(contraction const & other){
@@ -47,6 +54,15 @@ namespace CTF_int {
     func      = other.func;
     alpha = other.alpha;
     beta  = other.beta;
+    mask     = other.mask;
+    mask_cmp = other.mask_cmp;
+    home_acc_C = other.home_acc_C;
+    slab_if_no_fit = other.slab_if_no_fit;
+    idx_mask = NULL;
+    if (mask != NULL){
+      idx_mask = (int*)alloc(sizeof(int)*mask->order);
+      memcpy(idx_mask, other.idx_mask, sizeof(int)*mask->order);
+    }
   }
  
   contraction::contraction(tensor *               A_,
@@ -66,6 +82,11 @@ namespace CTF_int {
     func = func_;
     alpha = alpha_;
     beta  = beta_;
+    mask  = NULL;
+    idx_mask = NULL;
+    mask_cmp = false;
+    home_acc_C = NULL;
+    slab_if_no_fit = false;
     
     idx_A = (int*)alloc(sizeof(int)*A->order);
     idx_B = (int*)alloc(sizeof(int)*B->order);
@@ -92,11 +113,143 @@ namespace CTF_int {
     func = func_;
     alpha = alpha_;
     beta  = beta_;
+    mask  = NULL;
+    idx_mask = NULL;
+    mask_cmp = false;
+    home_acc_C = NULL;
+    slab_if_no_fit = false;
     
     conv_idx(A->order, cidx_A, &idx_A, B->order, cidx_B, &idx_B, C->order, cidx_C, &idx_C);
   }
 
+  void contraction::set_mask(tensor * M, char const * cidx_M, char const * cidx_C, bool complement){
+    for (int i=0; i<C->order; i++){
+      if (C->sym[i] != NS){
+        printf("CTF ERROR: masked contractions require a nonsymmetric output tensor\n");
+        IASSERT(0);
+        return;
+      }
+    }
+    for (int i=0; i<M->order; i++){
+      if (M->sym[i] != NS){
+        printf("CTF ERROR: mask tensor must be nonsymmetric\n");
+        IASSERT(0);
+        return;
+      }
+    }
+    if (idx_mask != NULL) cdealloc(idx_mask);
+    mask = M;
+    mask_cmp = complement;
+    idx_mask = (int*)alloc(sizeof(int)*M->order);
+    for (int i=0; i<M->order; i++){
+      idx_mask[i] = -1;
+      for (int j=0; j<C->order; j++){
+        if (cidx_M[i] == cidx_C[j]) idx_mask[i] = idx_C[j];
+      }
+      for (int j=0; j<i; j++){
+        if (cidx_M[i] == cidx_M[j]) idx_mask[i] = -1;
+      }
+      if (idx_mask[i] == -1){
+        printf("CTF ERROR: each index of the mask must appear once in the mask and in the output\n");
+        IASSERT(0);
+      }
+    }
+  }
+
+  void contraction::execute_masked(){
+    TAU_FSTART(contraction_masked);
+    //a mask on the output of a sparse matrix-vector or matrix-matrix product is applied inside the kernel
+    if (mask->order <= 2){
+      A->unfold();
+      B->unfold();
+      C->unfold();
+      mask->unfold();
+      if (spmspv_applicable(this)){
+        spmspv(this);
+        TAU_FSTOP(contraction_masked);
+        return;
+      }
+      if (masked_spgemm_applicable(this)){
+        masked_spgemm(this);
+        TAU_FSTOP(contraction_masked);
+        return;
+      }
+    }
+    //otherwise an operand can be reduced to entries that match the mask on the indices they share,
+    //if it has all indices of the mask this selects exactly the entries of A*B in the mask,
+    //while for a complemented mask only an operand with all indices can be filtered
+    tensor * op[2] = {A, B};
+    int * idx_op[2] = {idx_A, idx_B};
+    tensor * mop[2] = {A, B};
+    bool is_exact = false;
+    for (int t=0; t<2; t++){
+      bool is_nonsym = true;
+      for (int i=0; i<op[t]->order; i++){
+        if (op[t]->sym[i] != NS) is_nonsym = false;
+      }
+      int nshr = 0;
+      for (int j=0; j<mask->order; j++){
+        for (int i=0; i<op[t]->order; i++){
+          if (idx_op[t][i] == idx_mask[j]){
+            nshr++;
+            break;
+          }
+        }
+      }
+      if (is_nonsym && nshr > 0 && (nshr == mask->order || !mask_cmp)){
+        mop[t] = op[t]->masked_copy(idx_op[t], mask, idx_mask, mask_cmp);
+        if (nshr == mask->order) is_exact = true;
+      }
+    }
+    if (is_exact){
+      contraction ctr(mop[0], idx_A, mop[1], idx_B, alpha, C, idx_C, beta, func);
+      ctr.execute();
+    } else {
+      //otherwise the product of the filtered operands is formed in an intermediate and the mask is applied to it
+      if (is_custom && func->is_accumulator()){
+        printf("CTF ERROR: masks on contractions with a transform require an operand with all indices of the mask\n");
+        IASSERT(0);
+      }
+      tensor * T = new tensor(C, 0, 1);
+      contraction ctr(mop[0], idx_A, mop[1], idx_B, alpha, T, idx_C, C->sr->addid(), func);
+      ctr.execute();
+      T->apply_mask(idx_C, mask, idx_mask, mask_cmp);
+      //summations expect indices numbered consecutively
+      int sidx_C[C->order];
+      for (int i=0; i<C->order; i++){
+        sidx_C[i] = i;
+        for (int j=0; j<i; j++){
+          if (idx_C[j] == idx_C[i]) sidx_C[i] = sidx_C[j];
+        }
+      }
+      summation sm(T, sidx_C, C->sr->mulid(), C, sidx_C, beta);
+      sm.execute();
+      delete T;
+    }
+    for (int t=0; t<2; t++){
+      if (mop[t] != op[t]) delete mop[t];
+    }
+    TAU_FSTOP(contraction_masked);
+  }
+
   void contraction::execute(){
+    //operands paged out by tensor::page_out() are contracted slab by slab from their files if possible,
+    //and are otherwise paged in by flush_writes()
+    bool is_paged = false;
+    tensor * tsrs[] = {A, B, C};
+    for (int t=0; t<3; t++){
+      if (tsrs[t]->page_file != MPI_FILE_NULL) is_paged = true;
+      else tsrs[t]->flush_writes();
+    }
+    if (is_paged && mask == NULL && slab_contract() == SUCCESS) return;
+    A->flush_writes();
+    B->flush_writes();
+    C->flush_writes();
+    if (mask != NULL){
+      mask->flush_writes();
+      execute_masked();
+      return;
+    }
 #if (DEBUG >= 2 || VERBOSE >= 1)
   #if DEBUG >= 2
     if (A->wrld->cdt.rank == 0) printf("Contraction::execute (head):\n");
@@ -108,8 +261,42 @@ namespace CTF_int {
 //      update_all_models(A->wrld->cdt.cm);
     //}
     
+    if (!A->wrld->record_ctr_reports || active_ctr_report != NULL){
+      int stat = home_contract();
+      assert(stat == SUCCESS); 
+      return;
+    }
+    Contraction_report rep;
+    char cname[256];
+    get_str(cname, 256);
+    rep.expr = cname;
+    rep.est_time = 0.0;
+    rep.map_time = 0.0;
+    rep.fold_time = 0.0;
+    rep.est_mem = 0;
+    active_ctr_report = &rep;
+    double st_time = MPI_Wtime();
+    double st_redist_time = get_redist_time();
+    double st_redist_comm_time = get_redist_comm_time();
+    double st_comm_time = get_comm_time();
+    double st_kernel_time = get_kernel_time();
+    int64_t st_comm_bytes = get_comm_bytes();
+    int64_t st_flops = get_flops();
+    int64_t st_mem = proc_bytes_allocated();
+    reset_peak_bytes_allocated();
+
     int stat = home_contract();
     assert(stat == SUCCESS); 
+
+    rep.tot_time = MPI_Wtime()-st_time;
+    rep.redist_time = get_redist_time()-st_redist_time;
+    rep.comm_time = (get_comm_time()-st_comm_time)-(get_redist_comm_time()-st_redist_comm_time);
+    rep.kernel_time = get_kernel_time()-st_kernel_time;
+    rep.comm_bytes = get_comm_bytes()-st_comm_bytes;
+    rep.flops = get_flops()-st_flops;
+    rep.peak_mem = peak_bytes_allocated()-st_mem;
+    active_ctr_report = NULL;
+    A->wrld->ctr_reports.push_back(rep);
   }
   
   template<typename ptype>
@@ -356,6 +543,11 @@ namespace CTF_int {
   int contraction::can_fold(){
     int nfold, * fold_idx, i, j;
     if (!is_sparse() && is_custom) return 0;
+    //folding would leave a packed symmetric pair of an operand to loops over single entries, which the
+    //reference kernel contracts by gemms on blocks instead
+    if (!is_sparse() && has_sym_seq_ctr_tile(A->order, A->lens, A->sym, idx_A, B->order, B->lens, B->sym, idx_B,
+                                             C->order, C->lens, C->sym, idx_C))
+      return 0;
     for (i=0; i<A->order; i++){
       for (j=i+1; j<A->order; j++){
         if (idx_A[i] == idx_A[j]) return 0;
@@ -1869,7 +2061,8 @@ namespace CTF_int {
         }
       }
     }
-    ASSERT(new_topo != NULL);
+    //the permuted grid may not be among the topologies of the world
+    if (new_topo == NULL) return false;
     A->topo = new_topo;
     B->topo = new_topo;
     C->topo = new_topo;
@@ -2378,16 +2571,86 @@ namespace CTF_int {
 
   }
 
-  void contraction::get_best_sel_map(distribution const * dA, distribution const * dB, distribution const * dC, topology * old_topo_A, topology * old_topo_B, topology * old_topo_C, mapping const * old_map_A, mapping const * old_map_B, mapping const * old_map_C, int & idx, double & time){
+  /**
+   * \brief bytes this process may allocate to contract A and B into C beyond the operands themselves,
+   *        the memory available, limited by the mem_budget of the world if one is set
+   */
+  static int64_t ctr_mem_avail(tensor const * A, tensor const * B, tensor const * C){
+    int64_t avail = proc_bytes_available();
+    if (C->wrld->mem_budget > 0){
+      int64_t res = 0;
+      tensor const * tsrs[] = {A, B, C};
+      for (int t=0; t<3; t++){
+        if (tsrs[t]->is_sparse)
+          res += tsrs[t]->nnz_loc*tsrs[t]->sr->pair_size();
+        else
+          res += tsrs[t]->size*tsrs[t]->sr->el_size;
+      }
+      avail = std::min(avail, C->wrld->mem_budget - res);
+    }
+    return avail;
+  }
+
+  /**
+   * \brief returns true if the output of ctr is the alias of its home mapping that map() moves to another
+   *        mapping without its data, which is then redistributed only once, back into the home buffer
+   */
+  static bool leaves_home_empty(contraction const * ctr){
+    tensor const * C = ctr->C;
+    return C == ctr->home_acc_C && C->is_home && !C->is_sparse && C->sr->has_mul();
+  }
+
+  int64_t contraction::est_peak_mem(ctr *                sctr,
+                                    bool                 is_fold,
+                                    bool                 need_remap_A,
+                                    bool                 need_remap_B,
+                                    bool                 need_remap_C,
+                                    distribution const * dA,
+                                    distribution const * dB,
+                                    distribution const * dC,
+                                    double               nnz_frac_A,
+                                    double               nnz_frac_B,
+                                    double               nnz_frac_C){
+    //operands are redistributed one at a time, C also back to its initial mapping
+    int64_t redist_mem = 0;
+    if (need_remap_A)
+      redist_mem = A->get_redist_mem(*dA, nnz_frac_A);
+    if (need_remap_B)
+      redist_mem = std::max(redist_mem, B->get_redist_mem(*dB, nnz_frac_B));
+    if (need_remap_C)
+      redist_mem = std::max(redist_mem, (int64_t)((leaves_home_empty(this) ? 1. : 2.)*C->get_redist_mem(*dC, nnz_frac_C)));
+    //folding transposes the local data of each operand out of place
+    int64_t fold_mem = 0;
+    if (is_fold){
+      tensor const * tsrs[] = {A, B, C};
+      double nnz_fracs[] = {nnz_frac_A, nnz_frac_B, nnz_frac_C};
+      for (int t=0; t<3; t++){
+        if (tsrs[t]->is_sparse)
+          fold_mem = std::max(fold_mem, (int64_t)(nnz_fracs[t]*tsrs[t]->size*tsrs[t]->sr->pair_size()));
+        else
+          fold_mem = std::max(fold_mem, tsrs[t]->size*tsrs[t]->sr->el_size);
+      }
+    }
+    //buffers of the contraction algorithm, including those for replication
+    int64_t ctr_mem;
+    if (is_sparse())
+      ctr_mem = ((spctr*)sctr)->spmem_rec(nnz_frac_A, nnz_frac_B, nnz_frac_C);
+    else
+      ctr_mem = sctr->mem_rec();
+    return std::max(std::max(redist_mem, fold_mem), ctr_mem);
+  }
+
+  void contraction::get_best_sel_map(distribution const * dA, distribution const * dB, distribution const * dC, topology * old_topo_A, topology * old_topo_B, topology * old_topo_C, mapping const * old_map_A, mapping const * old_map_B, mapping const * old_map_C, int64_t max_memuse, int & idx, double & time, int64_t & mem){
     int ret, j, d;
     int need_remap_A, need_remap_B, need_remap_C;
-    int64_t memuse;//, bmemuse;
+    int64_t memuse, bmemuse;
     double est_time, best_time;
     int btopo;
     bool is_ctr_sparse = is_sparse();
     World * wrld = A->wrld;
     CommData global_comm = wrld->cdt;
     btopo = -1;
+    bmemuse = 0;
     best_time = DBL_MAX;
     int num_tot;
     int * idx_arr; 
@@ -2395,7 +2658,6 @@ namespace CTF_int {
             B->order, idx_B,
             C->order, idx_C,
             &num_tot, &idx_arr);
-    int64_t max_memuse = proc_bytes_available();
     for (j=0; j<6; j++){
       // Attempt to map to all possible permutations of processor topology 
   #if DEBUG < 3 
@@ -2488,11 +2750,13 @@ namespace CTF_int {
               len_ctr *= edge_len;
             }
           }
-          nnz_frac_C = std::min(1.,std::max(nnz_frac_C,nnz_frac_A*nnz_frac_B*len_ctr));
+          nnz_frac_C = std::max(nnz_frac_C,ctr_nnz_frac(nnz_frac_A,nnz_frac_B,len_ctr));
         }
 
+        bool is_fold = false;
   #if FOLD_TSR
         if (can_fold()){
+          is_fold = true;
           est_time = est_time_fold();
           iparam prm = map_fold(false);
           sctr = construct_ctr(1, &prm);
@@ -2519,7 +2783,6 @@ namespace CTF_int {
         }
   #endif 
         ASSERT(est_time >= 0.0);
-        memuse = 0;
         need_remap_A = 0;
         need_remap_B = 0;
         need_remap_C = 0;
@@ -2532,9 +2795,7 @@ namespace CTF_int {
           need_remap_A = 1;
         if (need_remap_A) {
           est_time += A->est_redist_time(*dA, nnz_frac_A); 
-          memuse = A->get_redist_mem(*dA, nnz_frac_A);
-        } else
-          memuse = 0;
+        }
         if (topo_i == old_topo_B){
           for (d=0; d<B->order; d++){
             if (!comp_dim_map(&B->edge_map[d],&old_map_B[d]))
@@ -2544,7 +2805,6 @@ namespace CTF_int {
           need_remap_B = 1;
         if (need_remap_B) {
           est_time += B->est_redist_time(*dB, nnz_frac_B); 
-          memuse = std::max(memuse,B->get_redist_mem(*dB, nnz_frac_B));
         }
         if (topo_i == old_topo_C){
           for (d=0; d<C->order; d++){
@@ -2554,13 +2814,9 @@ namespace CTF_int {
         } else
           need_remap_C = 1;
         if (need_remap_C) {
-          est_time += 2.*C->est_redist_time(*dC, nnz_frac_C); 
-          memuse = std::max(1.0*memuse,2.*C->get_redist_mem(*dC, nnz_frac_C));
+          est_time += (leaves_home_empty(this) ? 1. : 2.)*C->est_redist_time(*dC, nnz_frac_C); 
         }
-        if (is_ctr_sparse)
-          memuse = MAX(((spctr*)sctr)->spmem_rec(nnz_frac_A,nnz_frac_B,nnz_frac_C), memuse);
-        else
-          memuse = MAX((int64_t)sctr->mem_rec(), memuse);
+        memuse = est_peak_mem(sctr, is_fold, need_remap_A, need_remap_B, need_remap_C, dA, dB, dC, nnz_frac_A, nnz_frac_B, nnz_frac_C);
   #if DEBUG >= 1
         if (global_comm.rank == 0){
           printf("total (with redistribution and transp) est_time = %E\n", est_time);
@@ -2586,7 +2842,7 @@ namespace CTF_int {
 
         if (est_time < best_time) {
           best_time = est_time;
-          //bmemuse = memuse;
+          bmemuse = memuse;
           btopo = 6*t+j;
         }  
         delete sctr;
@@ -2600,6 +2856,8 @@ namespace CTF_int {
     }
     int ttopo;
     MPI_Allreduce(&btopo, &ttopo, 1, MPI_INT, MPI_MIN, global_comm.cm);
+    if (btopo != ttopo) bmemuse = 0;
+    MPI_Allreduce(&bmemuse, &mem, 1, MPI_INT64_T, MPI_MAX, global_comm.cm);
     TAU_FSTOP(all_select_ctr_map);
 
     idx=ttopo;
@@ -2608,16 +2866,17 @@ namespace CTF_int {
     cdealloc(idx_arr);
   }
 
-  void contraction::get_best_exh_map(distribution const * dA, distribution const * dB, distribution const * dC, topology * old_topo_A, topology * old_topo_B, topology * old_topo_C, mapping const * old_map_A, mapping const * old_map_B, mapping const * old_map_C, int & idx, double & time, double init_best_time=DBL_MAX){
+  void contraction::get_best_exh_map(distribution const * dA, distribution const * dB, distribution const * dC, topology * old_topo_A, topology * old_topo_B, topology * old_topo_C, mapping const * old_map_A, mapping const * old_map_B, mapping const * old_map_C, int64_t max_memuse, int & idx, double & time, int64_t & mem, double init_best_time=DBL_MAX){
     int d;
     int need_remap_A, need_remap_B, need_remap_C;
-    int64_t memuse;//, bmemuse;
+    int64_t memuse, bmemuse;
     double est_time, best_time;
     int btopo;
     bool is_ctr_sparse = is_sparse();
     World * wrld = A->wrld;
     CommData global_comm = wrld->cdt;
     btopo = -1;
+    bmemuse = 0;
     best_time = init_best_time;
     int num_tot;
     int * idx_arr; 
@@ -2632,7 +2891,6 @@ namespace CTF_int {
     }
     int64_t valid_mappings = 0;
     int64_t choice_offset = 0;
-    int64_t max_memuse = proc_bytes_available();
     TAU_FSTOP(init_select_ctr_map);
     for (int i=0; i<(int)wrld->topovec.size(); i++){
 //      int tnum_choices = pow(num_choices,(int) wrld->topovec[i]->order);
@@ -2705,13 +2963,15 @@ namespace CTF_int {
               len_ctr *= edge_len;
             }
           }
-          nnz_frac_C = std::min(1.,std::max(nnz_frac_C,nnz_frac_A*nnz_frac_B*len_ctr));
+          nnz_frac_C = std::max(nnz_frac_C,ctr_nnz_frac(nnz_frac_A,nnz_frac_B,len_ctr));
         }
 
 
         ctr * sctr;
+        bool is_fold = false;
   #if FOLD_TSR
         if (can_fold()){
+          is_fold = true;
           est_time = est_time_fold();
           iparam prm = map_fold(false);
           sctr = construct_ctr(1, &prm);
@@ -2737,7 +2997,6 @@ namespace CTF_int {
   #endif 
         ASSERT(est_time >= 0.0);
 
-        memuse = 0;
         need_remap_A = 0;
         need_remap_B = 0;
         need_remap_C = 0;
@@ -2750,9 +3009,7 @@ namespace CTF_int {
           need_remap_A = 1;
         if (need_remap_A) {
           est_time += A->est_redist_time(*dA, nnz_frac_A); 
-          memuse = A->get_redist_mem(*dA, nnz_frac_A);
-        } else
-          memuse = 0;
+        }
         if (topo_i == old_topo_B){
           for (d=0; d<B->order; d++){
             if (!comp_dim_map(&B->edge_map[d],&old_map_B[d]))
@@ -2762,7 +3019,6 @@ namespace CTF_int {
           need_remap_B = 1;
         if (need_remap_B) {
           est_time += B->est_redist_time(*dB, nnz_frac_B); 
-          memuse = std::max(memuse,B->get_redist_mem(*dB, nnz_frac_B));
         }
         if (topo_i == old_topo_C){
           for (d=0; d<C->order; d++){
@@ -2772,16 +3028,12 @@ namespace CTF_int {
         } else
           need_remap_C = 1;
         if (need_remap_C) {
-          est_time += 2.*C->est_redist_time(*dC, nnz_frac_C); 
-          memuse = std::max(1.*memuse,2.*C->get_redist_mem(*dC, nnz_frac_C));
+          est_time += (leaves_home_empty(this) ? 1. : 2.)*C->est_redist_time(*dC, nnz_frac_C); 
         }
  
         if (est_time >= best_time) continue;
 
-        if (is_ctr_sparse)
-          memuse = MAX(((spctr*)sctr)->spmem_rec(nnz_frac_A,nnz_frac_B,nnz_frac_C), memuse);
-        else
-          memuse = MAX((int64_t)sctr->mem_rec(), memuse);
+        memuse = est_peak_mem(sctr, is_fold, need_remap_A, need_remap_B, need_remap_C, dA, dB, dC, nnz_frac_A, nnz_frac_B, nnz_frac_C);
   #if DEBUG >= 4
         printf("total (with redistribution and transp) est_time = %E\n", est_time);
   #endif
@@ -2805,7 +3057,7 @@ namespace CTF_int {
         }
         if (est_time < best_time) {
           best_time = est_time;
-          //bmemuse = memuse;
+          bmemuse = memuse;
           btopo = old_off+j;
         }  
         delete sctr;
@@ -2824,6 +3076,8 @@ namespace CTF_int {
     }
     int ttopo;
     MPI_Allreduce(&btopo, &ttopo, 1, MPI_INT, MPI_MIN, global_comm.cm);
+    if (btopo != ttopo) bmemuse = 0;
+    MPI_Allreduce(&bmemuse, &mem, 1, MPI_INT64_T, MPI_MAX, global_comm.cm);
     TAU_FSTOP(all_select_ctr_map);
 
     idx=ttopo;
@@ -2894,25 +3148,64 @@ namespace CTF_int {
       old_phase_C[j]   = C->edge_map[j].calc_phase();
     }
 
-    //bmemuse = UINT64_MAX;
-    int ttopo, ttopo_sel, ttopo_exh;
+    int ttopo = -1, ttopo_sel, ttopo_exh;
     double gbest_time_sel, gbest_time_exh;
-  
-    TAU_FSTART(get_best_sel_map);
-    get_best_sel_map(dA, dB, dC, old_topo_A, old_topo_B, old_topo_C, old_map_A, old_map_B, old_map_C, ttopo_sel, gbest_time_sel);
-    TAU_FSTOP(get_best_sel_map);
-    if (gbest_time_sel < 1.){
-      gbest_time_exh = gbest_time_sel+1.;
-      ttopo_exh = ttopo_sel;
-    } else {
-      TAU_FSTART(get_best_exh_map);
-      get_best_exh_map(dA, dB, dC, old_topo_A, old_topo_B, old_topo_C, old_map_A, old_map_B, old_map_C, ttopo_exh, gbest_time_exh, gbest_time_sel);
-      TAU_FSTOP(get_best_exh_map);
+    int64_t gbest_mem_sel, gbest_mem_exh;
+    //search for the fastest mapping whose predicted peak memory fits in the budget, if there is none
+    //search again limited only by the memory available
+    int64_t mem_limits[] = {ctr_mem_avail(A, B, C), proc_bytes_available()};
+    for (int l=0; l<2; l++){
+      if (l == 1){
+        if (ttopo != INT_MAX && ttopo != -1) break;
+        if (do_remap && slab_if_no_fit){
+          if (global_comm.rank == 0)
+            DPRINTF(1,"No mapping fits within %ld bytes, contracting in slabs\n", mem_limits[0]);
+          //the search left the tensors mapped to the last choice it tried, restore their mappings
+          tensor * tsrs[] = {A, B, C};
+          topology * old_topos[] = {old_topo_A, old_topo_B, old_topo_C};
+          mapping * old_maps[] = {old_map_A, old_map_B, old_map_C};
+          for (int t=0; t<3; t++){
+            tsrs[t]->clear_mapping();
+            copy_mapping(tsrs[t]->order, old_maps[t], tsrs[t]->edge_map);
+            tsrs[t]->topo = old_topos[t];
+            tsrs[t]->is_mapped = 1;
+            tsrs[t]->set_padding();
+          }
+          CTF_int::cdealloc(old_phase_A);
+          CTF_int::cdealloc(old_phase_B);
+          CTF_int::cdealloc(old_phase_C);
+          delete [] old_map_A;
+          delete [] old_map_B;
+          delete [] old_map_C;
+          delete dA;
+          delete dB;
+          delete dC;
+          return NEGATIVE;
+        }
+        if (wrld->mem_budget <= 0) break;
+        if (global_comm.rank == 0)
+          DPRINTF(1,"No mapping fits within the memory budget of %ld bytes, ignoring it\n", wrld->mem_budget);
+      }
+      TAU_FSTART(get_best_sel_map);
+      get_best_sel_map(dA, dB, dC, old_topo_A, old_topo_B, old_topo_C, old_map_A, old_map_B, old_map_C, mem_limits[l], ttopo_sel, gbest_time_sel, gbest_mem_sel);
+      TAU_FSTOP(get_best_sel_map);
+      if (gbest_time_sel < 1.){
+        gbest_time_exh = gbest_time_sel+1.;
+        ttopo_exh = ttopo_sel;
+      } else {
+        TAU_FSTART(get_best_exh_map);
+        get_best_exh_map(dA, dB, dC, old_topo_A, old_topo_B, old_topo_C, old_map_A, old_map_B, old_map_C, mem_limits[l], ttopo_exh, gbest_time_exh, gbest_mem_exh, gbest_time_sel);
+        TAU_FSTOP(get_best_exh_map);
+      }
+      if (gbest_time_sel <= gbest_time_exh){
+        ttopo = ttopo_sel;
+      } else {
+        ttopo = ttopo_exh;
+      }
     }
-    if (gbest_time_sel <= gbest_time_exh){
-      ttopo = ttopo_sel;
-    } else {
-      ttopo = ttopo_exh;
+    if (do_remap && active_ctr_report != NULL){
+      active_ctr_report->est_time += std::min(gbest_time_sel, gbest_time_exh);
+      active_ctr_report->est_mem = std::max(active_ctr_report->est_mem, gbest_time_sel <= gbest_time_exh ? gbest_mem_sel : gbest_mem_exh);
     }
 
     A->clear_mapping();
@@ -3042,7 +3335,7 @@ namespace CTF_int {
               len_ctr *= edge_len;
             }
           }
-          nnz_frac_C = std::min(1.,std::max(nnz_frac_C,nnz_frac_A*nnz_frac_B*len_ctr));
+          nnz_frac_C = std::max(nnz_frac_C,ctr_nnz_frac(nnz_frac_A,nnz_frac_B,len_ctr));
         }
         cdealloc(idx_arr);
         int64_t memuse = 0;
@@ -3101,7 +3394,22 @@ namespace CTF_int {
       }
     } else
       need_remap = 1;
-    if (need_remap)
+    if (need_remap && leaves_home_empty(this)){
+      //rather than moving the data of C, scale it by beta in the home buffer and contract into zeros,
+      //home_contract() then adds the product back into the home buffer
+      //setting rather than scaling when beta is zero, so that NaN and Inf in the old C do not survive
+      if (beta != NULL && C->sr->isequal(beta, C->sr->addid())){
+        C->sr->set(C->home_buffer, C->sr->addid(), C->home_size);
+      } else if (beta != NULL && !C->sr->isequal(beta, C->sr->mulid())){
+        for (int64_t off=0; off<C->home_size; off+=INT_MAX){
+          C->sr->scal((int)std::min((int64_t)INT_MAX, C->home_size-off), beta, C->home_buffer+off*C->sr->el_size, 1);
+        }
+      }
+      C->data = (char*)CTF_int::alloc(C->size*C->sr->el_size);
+      C->sr->set(C->data, C->sr->addid(), C->size);
+      C->is_home = 0;
+      C->is_home_acc = 1;
+    } else if (need_remap)
       C->redistribute(*dC);
                    
     TAU_FSTOP(redistribute_for_contraction);
@@ -4152,6 +4460,7 @@ namespace CTF_int {
   #endif
     }*/
 
+    double st_map_time, st_redist_time;
   #ifdef PROFILE
     TAU_FSTART(pre_map_barrier);
     MPI_Barrier(global_comm.cm);
@@ -4159,11 +4468,19 @@ namespace CTF_int {
   #endif
   #if REDIST
     //stat = map_tensors(type, fftsr, felm, alpha, beta, &ctrf);
+    st_map_time = MPI_Wtime();
+    st_redist_time = get_redist_time();
     stat = map(&ctrf);
+    if (active_ctr_report != NULL)
+      active_ctr_report->map_time += MPI_Wtime()-st_map_time-(get_redist_time()-st_redist_time);
     if (stat == ERROR) {
       printf("Failed to map tensors to physical grid\n");
       return ERROR;
     }
+    if (stat == NEGATIVE){
+      TAU_FSTOP(contract);
+      return NEGATIVE;
+    }
   #else
     if (check_mapping() != 0) {
       /* Construct the tensor algorithm we would like to use */
@@ -4181,11 +4498,19 @@ namespace CTF_int {
       }
   #endif
     } 
+    st_map_time = MPI_Wtime();
+    st_redist_time = get_redist_time();
     stat = map(&ctrf);
+    if (active_ctr_report != NULL)
+      active_ctr_report->map_time += MPI_Wtime()-st_map_time-(get_redist_time()-st_redist_time);
     if (stat == ERROR) {
       printf("Failed to map tensors to physical grid\n");
       return ERROR;
     }
+    if (stat == NEGATIVE){
+      TAU_FSTOP(contract);
+      return NEGATIVE;
+    }
 #if (VERBOSE >= 1 || DEBUG >= 1)
     if (global_comm.rank == 0){
   /*    int64_t memuse=0;
@@ -4212,6 +4537,17 @@ namespace CTF_int {
   #endif
   #endif
     //ASSERT(check_mapping());
+    if (active_ctr_report != NULL){
+      char map_str[200];
+      tensor * tsrs[3] = {A, B, C};
+      active_ctr_report->mapping.clear();
+      for (int i=0; i<3; i++){
+        tsrs[i]->get_map_str(map_str, 200);
+        if (i>0) active_ctr_report->mapping += " ";
+        active_ctr_report->mapping += map_str;
+      }
+    }
+    double st_fold_time = MPI_Wtime();
     bool is_inner = false;
   #if FOLD_TSR
     is_inner = can_fold();
@@ -4224,6 +4560,7 @@ namespace CTF_int {
       ctrf = construct_ctr(1, &prm);
     } 
   #endif
+    double fold_time = MPI_Wtime()-st_fold_time;
   #if DEBUG >=2
   if (global_comm.rank == 0){
     ctrf->print();
@@ -4337,6 +4674,7 @@ namespace CTF_int {
     TAU_FSTOP(post_ctr_func_barrier);
   #endif
     TAU_FSTOP(ctr_func);
+    st_fold_time = MPI_Wtime();
     C->unfold(1);
   #ifndef SEQ
     if (C->is_cyclic)
@@ -4344,6 +4682,8 @@ namespace CTF_int {
   #endif
     A->unfold();
     B->unfold();
+    if (active_ctr_report != NULL)
+      active_ctr_report->fold_time += fold_time + MPI_Wtime()-st_fold_time;
   #if VERBOSE >= 2
     if (A->wrld->rank == 0){
       VPRINTF(2, "Contraction permutation completed in %lf sec.\n",MPI_Wtime()-dtt);
@@ -4432,6 +4772,24 @@ namespace CTF_int {
   }
 
 
+  /**
+   * \brief returns the number of bytes desymmetrize() needs on this process to unpack
+   *        sym_tsr into the symmetry of nonsym_tsr, 0 if the symmetries are the same
+   */
+  static int64_t desymmetrize_bytes(tensor const * sym_tsr, tensor const * nonsym_tsr){
+    bool is_broken = false;
+    for (int i=0; i<sym_tsr->order; i++){
+      if (sym_tsr->sym[i] != nonsym_tsr->sym[i]) is_broken = true;
+    }
+    if (!is_broken) return 0;
+    double unpack_fact = ((double)packed_size(sym_tsr->order, sym_tsr->lens, nonsym_tsr->sym))
+                          /packed_size(sym_tsr->order, sym_tsr->lens, sym_tsr->sym);
+    if (sym_tsr->is_sparse)
+      return (int64_t)(unpack_fact*sym_tsr->nnz_loc*sym_tsr->sr->pair_size());
+    //an operand may also be copied in packed form to zero out its diagonal
+    return (int64_t)((unpack_fact+1.)*sym_tsr->size*sym_tsr->sr->el_size);
+  }
+
   int contraction::sym_contract(){
     int i;
     //int ** scl_idxs_C;
@@ -4517,6 +4875,8 @@ namespace CTF_int {
     else fptr = NULL;
 
     contraction new_ctr = contraction(tnsr_A, map_A, tnsr_B, map_B, alpha, tnsr_C, map_C, beta, fptr);
+    new_ctr.home_acc_C = home_acc_C;
+    new_ctr.slab_if_no_fit = slab_if_no_fit && tnsr_A == A && tnsr_B == B && tnsr_C == C;
     tnsr_A->unfold();
     tnsr_B->unfold();
     tnsr_C->unfold();
@@ -4591,7 +4951,26 @@ namespace CTF_int {
 
         contraction * unfold_ctr;
         new_ctr.unfold_broken_sym(&unfold_ctr);
-        if (unfold_ctr->map(&ctrf, 0) == SUCCESS){
+        //unpacking may need up to order! times the memory of the packed operands, if it does not fit on
+        //every process (within the world's mem_budget if one is set), contract all symmetric permutations
+        //of the packed operands instead, which is
+        //only done without SY index groups, since the permutations would overcount their diagonals
+        bool has_sy = false;
+        tensor * tnsrs[] = {tnsr_A, tnsr_B, tnsr_C};
+        for (int t=0; t<3; t++){
+          for (int j=0; j<tnsrs[t]->order; j++){
+            if (tnsrs[t]->sym[j] == SY) has_sy = true;
+          }
+        }
+        int64_t unpack_bytes = desymmetrize_bytes(tnsr_A, unfold_ctr->A)
+                              + desymmetrize_bytes(tnsr_B, unfold_ctr->B)
+                              + desymmetrize_bytes(tnsr_C, unfold_ctr->C);
+        if (tnsr_A == tnsr_B) unpack_bytes += tnsr_A->size*tnsr_A->sr->el_size;
+        int unpack_fits = has_sy || unpack_bytes <= ctr_mem_avail(tnsr_A, tnsr_B, tnsr_C);
+        MPI_Allreduce(MPI_IN_PLACE, &unpack_fits, 1, MPI_INT, MPI_MIN, global_comm.cm);
+        if (!unpack_fits && global_comm.rank == 0)
+          DPRINTF(1,"Unpacking needs %ld bytes, contracting packed operands\n",unpack_bytes);
+        if (unpack_fits && unfold_ctr->map(&ctrf, 0) == SUCCESS){
 /*  #else
         int sy = 0;
         for (i=0; i<A->order; i++){
@@ -4685,6 +5064,364 @@ namespace CTF_int {
     return stat;
   }
 
+  /**
+   * \brief writes the slab lo <= i < lo+S->lens[m] along mode m of dense nonsymmetric tensor T into S,
+   *        reading only the entries of the slab, each processor reading a contiguous part of it
+   */
+  static void read_slab(tensor * T, int m, int lo, tensor * S){
+    int64_t sz = 1;
+    for (int i=0; i<S->order; i++){
+      sz *= S->lens[i];
+    }
+    int64_t st = (sz*T->wrld->rank)/T->wrld->np;
+    int64_t n = (sz*(T->wrld->rank+1))/T->wrld->np - st;
+    char * pairs = (char*)alloc(T->sr->pair_size()*std::max(n,(int64_t)1));
+    PairIterator pp(T->sr, pairs);
+    for (int64_t s=0; s<n; s++){
+      int64_t r = st+s;
+      int64_t key = 0;
+      int64_t lda = 1;
+      for (int i=0; i<T->order; i++){
+        int64_t ii = r%S->lens[i] + (i == m ? lo : 0);
+        r /= S->lens[i];
+        key += ii*lda;
+        lda *= T->lens[i];
+      }
+      pp[s].write_key(key);
+    }
+    T->read(n, pairs);
+    for (int64_t s=0; s<n; s++){
+      pp[s].write_key(st+s);
+    }
+    S->write(n, T->sr->mulid(), T->sr->addid(), pairs);
+    cdealloc(pairs);
+  }
+
+  /**
+   * \brief accumulates the nonzeros of S into the slab lo <= i < lo+S->lens[m] along mode m of T
+   */
+  static void add_slab(tensor * S, int m, int lo, tensor * T){
+    int64_t n;
+    char * pairs;
+    S->read_local_nnz(&n, &pairs);
+    PairIterator pp(S->sr, pairs);
+    for (int64_t s=0; s<n; s++){
+      int64_t r = pp[s].k();
+      int64_t key = 0;
+      int64_t lda = 1;
+      for (int i=0; i<T->order; i++){
+        int64_t ii = r%S->lens[i] + (i == m ? lo : 0);
+        r /= S->lens[i];
+        key += ii*lda;
+        lda *= T->lens[i];
+      }
+      pp[s].write_key(key);
+    }
+    T->write(n, T->sr->mulid(), T->sr->mulid(), pairs);
+    if (n > 0) cdealloc(pairs);
+  }
+
+  /**
+   * \brief the elements of the slab lo <= i < hi along mode m of a tensor paged out by tensor::page_out() that
+   *        are in the file of this processor, as runs of consecutive elements, moved between the file and buf
+   *        by nonblocking MPI-IO, so that a slab can be read while the one before it is contracted
+   */
+  struct page_slab {
+    /** \brief key in the slab of the first element of each run, its offset in the file, and its length */
+    std::vector<int64_t> run_key, run_off, run_len;
+    /** \brief number of elements in all runs */
+    int64_t n;
+    /** \brief values of the elements of the runs */
+    char * buf;
+    /** \brief requests of the reads or writes in flight */
+    std::vector<MPI_Request> reqs;
+
+    page_slab(){ n = 0; buf = NULL; }
+
+    ~page_slab(){
+      wait();
+      if (buf != NULL) cdealloc(buf);
+    }
+
+    void init(tensor const * T, int m, int lo, int hi){
+      wait();
+      if (buf != NULL) cdealloc(buf);
+      run_key.clear();
+      run_off.clear();
+      run_len.clear();
+      int64_t my_st, my_n;
+      T->get_page_range(&my_st, &my_n);
+      int64_t lda = 1;
+      for (int i=0; i<m; i++){
+        lda *= T->lens[i];
+      }
+      //in element order, the slab is a run of len elements in each block of blk elements
+      int64_t blk = lda*T->lens[m];
+      int64_t len = lda*(hi-lo);
+      int64_t max_len = INT_MAX/T->sr->el_size;
+      n = 0;
+      for (int64_t j=my_st/blk; my_n>0 && j<=(my_st+my_n-1)/blk; j++){
+        int64_t st = std::max(my_st, j*blk+lo*lda);
+        int64_t end = std::min(my_st+my_n, j*blk+lo*lda+len);
+        for (; st<end; st+=max_len){
+          run_key.push_back(j*len+st-(j*blk+lo*lda));
+          run_off.push_back(st-my_st);
+          run_len.push_back(std::min(max_len, end-st));
+          n += run_len.back();
+        }
+      }
+      buf = (char*)alloc(std::max(n, (int64_t)1)*T->sr->el_size);
+    }
+
+    void start(tensor const * T, bool is_write){
+      int el_size = T->sr->el_size;
+      reqs.resize(run_len.size());
+      int64_t off = 0;
+      for (int64_t r=0; r<(int64_t)run_len.size(); r++){
+        if (is_write)
+          MPI_File_iwrite_at(T->page_file, run_off[r]*el_size, buf+off*el_size, run_len[r]*el_size, MPI_CHAR, &reqs[r]);
+        else
+          MPI_File_iread_at(T->page_file, run_off[r]*el_size, buf+off*el_size, run_len[r]*el_size, MPI_CHAR, &reqs[r]);
+        off += run_len[r];
+      }
+    }
+
+    void wait(){
+      if (reqs.size() > 0) MPI_Waitall(reqs.size(), reqs.data(), MPI_STATUSES_IGNORE);
+      reqs.clear();
+    }
+
+    /** \brief writes the values read into buf into slab S */
+    void write_to(tensor * S) const {
+      char * pairs = (char*)alloc(S->sr->pair_size()*std::max(n, (int64_t)1));
+      PairIterator pp(S->sr, pairs);
+      int64_t s = 0;
+      for (int64_t r=0; r<(int64_t)run_len.size(); r++){
+        for (int64_t i=0; i<run_len[r]; i++, s++){
+          pp[s].write_key(run_key[r]+i);
+          pp[s].write_val(buf+s*S->sr->el_size);
+        }
+      }
+      S->write(n, S->sr->mulid(), S->sr->addid(), pairs);
+      cdealloc(pairs);
+    }
+
+    /** \brief sets buf to beta times its values (read from the file if beta is not zero) plus the values of slab S */
+    void add_from(tensor * S, char const * beta){
+      algstrct const * sr = S->sr;
+      char * pairs = (char*)alloc(sr->pair_size()*std::max(n, (int64_t)1));
+      PairIterator pp(sr, pairs);
+      int64_t s = 0;
+      for (int64_t r=0; r<(int64_t)run_len.size(); r++){
+        for (int64_t i=0; i<run_len[r]; i++, s++){
+          pp[s].write_key(run_key[r]+i);
+        }
+      }
+      S->read(n, pairs);
+      bool is_zero = sr->isequal(beta, sr->addid());
+      for (s=0; s<n; s++){
+        char * v = buf+s*sr->el_size;
+        if (is_zero){
+          pp[s].read_val(v);
+        } else {
+          if (!sr->isequal(beta, sr->mulid())) sr->mul(v, beta, v);
+          sr->add(v, pp[s].d(), v);
+        }
+      }
+      cdealloc(pairs);
+    }
+  };
+
+  /**
+   * \brief returns the mode of C along which the dense nonsymmetric operands of ctr can be contracted
+   *        in slabs (the index of C with the most operand elements appearing once in each tensor), or
+   *        -1 if ctr cannot be split into slabs
+   * \param[in] ctr contraction
+   * \param[out] mode the mode of A, B, and C along which to slab, -1 for operands used whole
+   */
+  static int get_slab_mode(contraction const * ctr, int * mode){
+    tensor * tsrs[] = {ctr->A, ctr->B, ctr->C};
+    int * idxs[] = {ctr->idx_A, ctr->idx_B, ctr->idx_C};
+    tensor * C = ctr->C;
+    if (ctr->mask != NULL || ctr->A == C || ctr->B == C) return -1;
+    for (int t=0; t<3; t++){
+      if (tsrs[t]->is_sparse || tsrs[t]->has_zero_edge_len) return -1;
+      for (int i=0; i<tsrs[t]->order; i++){
+        if (tsrs[t]->sym[i] != NS) return -1;
+      }
+    }
+    for (int i=0; i<C->order; i++){
+      for (int j=0; j<i; j++){
+        if (idxs[2][i] == idxs[2][j]) return -1;
+      }
+    }
+
+    int im_C = -1;
+    double best_sz = 0.;
+    for (int c=0; c<C->order; c++){
+      double sz = 0.;
+      bool once = true;
+      for (int t=0; t<3; t++){
+        int cnt = 0;
+        double tsz = 1.;
+        for (int i=0; i<tsrs[t]->order; i++){
+          if (idxs[t][i] == idxs[2][c]) cnt++;
+          tsz *= tsrs[t]->lens[i];
+        }
+        if (cnt > 1) once = false;
+        if (cnt == 1) sz += tsz;
+      }
+      if (once && C->lens[c] > 1 && sz > best_sz){
+        best_sz = sz;
+        im_C = c;
+      }
+    }
+    if (im_C == -1) return -1;
+    for (int t=0; t<3; t++){
+      mode[t] = -1;
+      for (int i=0; i<tsrs[t]->order; i++){
+        if (idxs[t][i] == idxs[2][im_C]) mode[t] = i;
+      }
+    }
+    return im_C;
+  }
+
+  int contraction::slab_contract(){
+    tensor * tsrs[] = {A, B, C};
+    int mode[3];
+    int im_C = get_slab_mode(this, mode);
+    if (im_C == -1) return NEGATIVE;
+
+    //operands paged out by tensor::page_out() are streamed from their files slab by slab if they are split
+    //into slabs, and paged in otherwise
+    bool is_paged = false;
+    for (int t=0; t<3; t++){
+      if (tsrs[t]->page_file != MPI_FILE_NULL){
+        is_paged = true;
+        if (mode[t] == -1) tsrs[t]->page_in();
+      }
+    }
+    bool is_streamed[3];
+    for (int t=0; t<3; t++){
+      is_streamed[t] = mode[t] != -1 && tsrs[t]->page_file != MPI_FILE_NULL;
+    }
+
+    //per process: bytes of the operands used whole and of those split into slabs, the largest of each,
+    //the largest slabbed operand in pairs, the form in which slabs are moved, and the streamed operands
+    int64_t bytes[] = {0, 0, 0, 0, 0, 0};
+    for (int t=0; t<3; t++){
+      int64_t sz = tsrs[t]->size;
+      if (is_streamed[t]){
+        int64_t my_st;
+        tsrs[t]->get_page_range(&my_st, &sz);
+      }
+      int64_t b = sz*tsrs[t]->sr->el_size;
+      int s = mode[t] != -1;
+      bytes[s] += b;
+      bytes[2+s] = std::max(bytes[2+s], b);
+      if (s) bytes[4] = std::max(bytes[4], sz*tsrs[t]->sr->pair_size());
+      if (is_streamed[t]) bytes[5] += b;
+    }
+    int64_t avail = ctr_mem_avail(A, B, C);
+    int64_t gbytes[6];
+    MPI_Allreduce(bytes, gbytes, 6, MPI_INT64_T, MPI_MAX, C->wrld->comm);
+    MPI_Allreduce(MPI_IN_PLACE, &avail, 1, MPI_INT64_T, MPI_MIN, C->wrld->comm);
+    int len = C->lens[im_C];
+    //contracting a slab needs copies of the operands during folding, with the output buffered once more,
+    //and the send and receive buffers of the largest redistribution, reading or accumulating a slab
+    //needs the slab and three times its pairs (the pairs, and the buffers of read and write), and
+    //streamed operands need the file values of the slab and of the next one, which is read meanwhile,
+    //unless operands are paged out, map() found no mapping that fits, so use at least two slabs, which
+    //may again be split if need be
+    int nslab;
+    int64_t need;
+    for (nslab=(is_paged ? 1 : 2); ; nslab++){
+      int64_t ctr_need = 2*gbytes[0] + 3*gbytes[1]/nslab + 2*std::max(gbytes[2], gbytes[3]/nslab);
+      int64_t pair_need = gbytes[3]/nslab + 3*gbytes[4]/nslab;
+      need = std::max(ctr_need, pair_need) + 2*gbytes[5]/nslab;
+      if (need <= avail || nslab >= len) break;
+    }
+    int slab_len = (len+nslab-1)/nslab;
+    DPRINTF(1,"Contracting in %d slabs of length %d along mode %d of C, need %ld bytes at once, %ld available\n",
+            (len+slab_len-1)/slab_len, slab_len, im_C, need, avail);
+    TAU_FSTART(slab_contract);
+
+    //apply beta to C once, then accumulate each slab of alpha*A*B, or if C is streamed, combine each
+    //slab with beta times the one in the file
+    if (!is_streamed[2]){
+      if (C->sr->isequal(beta, C->sr->addid())){
+        C->set_zero();
+      } else if (!C->sr->isequal(beta, C->sr->mulid())){
+        int sidx[C->order];
+        for (int i=0; i<C->order; i++){ sidx[i] = i; }
+        scaling scl(C, sidx, beta);
+        scl.execute();
+      }
+    }
+    bool read_C = is_streamed[2] && !C->sr->isequal(beta, C->sr->addid());
+    //file values of the current and the next slab of each streamed operand, the next read is started
+    //before the current slab is contracted, and the output slab is written while the next one is
+    page_slab pslabs[2][3];
+    for (int t=0; t<3; t++){
+      if (is_streamed[t]){
+        pslabs[0][t].init(tsrs[t], mode[t], 0, std::min(len, slab_len));
+        if (t < 2 || read_C) pslabs[0][t].start(tsrs[t], false);
+      }
+    }
+    for (int lo=0, sl=0; lo<len; lo+=slab_len, sl++){
+      int hi = std::min(len, lo+slab_len);
+      page_slab * cur = pslabs[sl%2];
+      page_slab * nxt = pslabs[(sl+1)%2];
+      if (hi < len){
+        for (int t=0; t<3; t++){
+          if (is_streamed[t]){
+            nxt[t].init(tsrs[t], mode[t], hi, std::min(len, hi+slab_len));
+            if (t < 2 || read_C) nxt[t].start(tsrs[t], false);
+          }
+        }
+      }
+      tensor * slabs[3];
+      for (int t=0; t<3; t++){
+        if (mode[t] == -1){
+          slabs[t] = tsrs[t];
+        } else {
+          int slens[tsrs[t]->order];
+          memcpy(slens, tsrs[t]->lens, sizeof(int)*tsrs[t]->order);
+          slens[mode[t]] = hi-lo;
+          slabs[t] = new tensor(tsrs[t]->sr, tsrs[t]->order, slens, tsrs[t]->sym, tsrs[t]->wrld, 1, tsrs[t]->name, tsrs[t]->profile);
+          if (t < 2){
+            if (is_streamed[t]){
+              cur[t].wait();
+              cur[t].write_to(slabs[t]);
+            } else
+              read_slab(tsrs[t], mode[t], lo, slabs[t]);
+          }
+        }
+      }
+      contraction new_ctr(*this);
+      new_ctr.A = slabs[0];
+      new_ctr.B = slabs[1];
+      new_ctr.C = slabs[2];
+      new_ctr.beta = C->sr->addid();
+      new_ctr.execute();
+      if (is_streamed[2]){
+        cur[2].wait();
+        cur[2].add_from(slabs[2], beta);
+        cur[2].start(C, true);
+      } else
+        add_slab(slabs[2], mode[2], lo, C);
+      for (int t=0; t<3; t++){
+        if (slabs[t] != tsrs[t]) delete slabs[t];
+      }
+    }
+    for (int t=0; t<3; t++){
+      pslabs[0][t].wait();
+      pslabs[1][t].wait();
+    }
+    TAU_FSTOP(slab_contract);
+    return SUCCESS;
+  }
+
   int contraction::home_contract(){
   #ifndef HOME_CONTRACT
     return sym_contract();
@@ -4695,6 +5432,16 @@ namespace CTF_int {
     B->unfold();
     C->unfold();
 
+    if (ewise_ctr_applicable(this)){
+      ewise_ctr(this);
+      return SUCCESS;
+    }
+
+    if (spmspv_applicable(this)){
+      spmspv(this);
+      return SUCCESS;
+    }
+
     if (C->is_sparse && (C->nnz_tot > 0 || C->has_home)){
       if (C->sr->isequal(beta,C->sr->addid())){
         C->set_zero();
@@ -4769,6 +5516,8 @@ namespace CTF_int {
 
     //CTF_ctr_type_t ntype = *stype;
     contraction new_ctr = contraction(*this);
+    int slab_mode[3];
+    new_ctr.slab_if_no_fit = get_slab_mode(this, slab_mode) != -1;
 
     was_home_A = A->is_home;
     was_home_B = B->is_home;
@@ -4826,16 +5575,21 @@ namespace CTF_int {
         new_ctr.C = tensors[ntype.tid_C];*/
         new_ctr.C->data = C->data;
         new_ctr.C->home_buffer = C->home_buffer;
+        new_ctr.C->home_size = C->home_size;
         new_ctr.C->is_home = 1;
         new_ctr.C->is_mapped = 1;
         new_ctr.C->topo = C->topo;
         copy_mapping(C->order, C->edge_map, new_ctr.C->edge_map);
         new_ctr.C->set_padding();
+        new_ctr.home_acc_C = new_ctr.C;
       }
     }
 
     ret = new_ctr.sym_contract();//&ntype, ftsr, felm, alpha, beta);
-    if (ret!= SUCCESS) return ret;
+    //the flag only concerns the return of C to its home below, clear it so no later operation sees it
+    bool is_home_acc = new_ctr.C->is_home_acc;
+    new_ctr.C->is_home_acc = 0;
+    if (ret == ERROR) return ret;
     if (was_home_A) new_ctr.A->unfold();
     if (was_home_B && A != B) new_ctr.B->unfold();
     if (was_home_C) new_ctr.C->unfold();
@@ -4850,17 +5604,31 @@ namespace CTF_int {
                    &old_size_C,
                    &was_cyclic_C, &old_padding_C,
                    &old_edge_len_C, &topovec[new_ctr.C->itopo]);*/
-      C->data = new_ctr.C->data;
-      C->is_home = 0;
       TAU_FSTART(redistribute_for_ctr_home);
-      C->redistribute(dC);
-/*      remap_tensor(stype->tid_C, C, C->topo, old_size_C,
-                   old_phase_C, old_rank_C, old_virt_dim_C,
-                   old_pe_lda_C, was_cyclic_C,
-                   old_padding_C, old_edge_len_C, global_comm);*/
+      if (is_home_acc && dC.is_cyclic && C->is_cyclic){
+        //C left home without its data, so the home buffer holds beta*C, add the product into it directly
+        distribution dH = distribution(C);
+        cyclic_reshuffle(C->sym, dC, NULL, NULL, dH, NULL, NULL, &new_ctr.C->data, &C->home_buffer,
+                         C->sr, C->wrld->cdt, 0, C->sr->mulid(), C->sr->mulid());
+        CTF_int::cdealloc(new_ctr.C->data);
+      } else {
+        C->data = new_ctr.C->data;
+        C->is_home = 0;
+        C->redistribute(dC);
+/*        remap_tensor(stype->tid_C, C, C->topo, old_size_C,
+                     old_phase_C, old_rank_C, old_virt_dim_C,
+                     old_pe_lda_C, was_cyclic_C,
+                     old_padding_C, old_edge_len_C, global_comm);*/
+        if (is_home_acc){
+          for (int64_t off=0; off<C->size; off+=INT_MAX){
+            C->sr->axpy((int)std::min((int64_t)INT_MAX, C->size-off), C->sr->mulid(),
+                        C->data+off*C->sr->el_size, 1, C->home_buffer+off*C->sr->el_size, 1);
+          }
+        } else
+          memcpy(C->home_buffer, C->data, C->size*C->sr->el_size);
+        CTF_int::cdealloc(C->data);
+      }
       TAU_FSTOP(redistribute_for_ctr_home);
-      memcpy(C->home_buffer, C->data, C->size*C->sr->el_size);
-      CTF_int::cdealloc(C->data);
       C->data = C->home_buffer;
       C->is_home = 1;
       new_ctr.C->is_data_aliased = 1;
@@ -4901,6 +5669,8 @@ namespace CTF_int {
         delete new_ctr.B;
       }
     }
+    //no mapping fit in memory, so nothing was redistributed, contract in slabs instead
+    if (ret == NEGATIVE) return slab_contract();
     return SUCCESS;
   #endif
   }
@@ -5084,42 +5854,28 @@ namespace CTF_int {
     cdealloc(idx_arr);
   }
 
+  void contraction::get_str(char * str, int max_len){
+    int len = 0;
+    tensor * tsrs[3] = {C, A, B};
+    int * idxs[3] = {idx_C, idx_A, idx_B};
+    char const * seps[3] = {" <- ", "*", ""};
+    for (int t=0; t<3; t++){
+      if (len < max_len) len += snprintf(str+len, max_len-len, "%s[", tsrs[t]->name);
+      for (int i=0; i<tsrs[t]->order; i++){
+        if (len < max_len) len += snprintf(str+len, max_len-len, i>0 ? " %d" : "%d", idxs[t][i]);
+      }
+      if (len < max_len) len += snprintf(str+len, max_len-len, "]%s", seps[t]);
+    }
+  }
+
   void contraction::print(){
-    int i;
     //max = A->order+B->order+C->order;
     CommData global_comm = A->wrld->cdt;
     MPI_Barrier(global_comm.cm);
     if (global_comm.rank == 0){
 //      printf("Contracting Tensor %s with %s into %s\n", A->name, B->name, C->name);
       char cname[200];
-      cname[0] = '\0';
-      sprintf(cname, "%s", C->name);
-      sprintf(cname+strlen(cname),"[");
-      for (i=0; i<C->order; i++){
-        if (i>0)
-          sprintf(cname+strlen(cname)," %d",idx_C[i]);
-        else
-          sprintf(cname+strlen(cname),"%d",idx_C[i]);
-      }
-      sprintf(cname+strlen(cname),"] <- ");
-      sprintf(cname+strlen(cname), "%s", A->name);
-      sprintf(cname+strlen(cname),"[");
-      for (i=0; i<A->order; i++){
-        if (i>0)
-          sprintf(cname+strlen(cname)," %d",idx_A[i]);
-        else
-          sprintf(cname+strlen(cname),"%d",idx_A[i]);
-      }
-      sprintf(cname+strlen(cname),"]*");
-      sprintf(cname+strlen(cname), "%s", B->name);
-      sprintf(cname+strlen(cname),"[");
-      for (i=0; i<B->order; i++){
-        if (i>0)
-          sprintf(cname+strlen(cname)," %d",idx_B[i]);
-        else
-          sprintf(cname+strlen(cname),"%d",idx_B[i]);
-      }
-      sprintf(cname+strlen(cname),"]");
+      get_str(cname, 200);
       printf("CTF: Contraction %s\n",cname);
 
 /*
@@ -37,9 +37,21 @@ namespace CTF_int {
       bool is_custom;
       /** \brief function to execute on elements */
       bivar_function const * func;
+      /** \brief tensor whose nonzeros select the entries of A*B that are computed, NULL if none */
+      tensor * mask;
+      /** \brief indices of mask */
+      int * idx_mask;
+      /** \brief whether the entries selected are instead those not matching nonzeros of the mask */
+      bool mask_cmp;
+      /** \brief alias of the home mapping of the output set by home_contract(), which map() may move to
+                 another mapping without its data, so that C is accumulated into its home buffer, NULL if none */
+      tensor * home_acc_C;
+      /** \brief set by home_contract() if the operands can be contracted in slabs, then map() returns
+                 NEGATIVE, before redistributing anything, if no mapping fits in memory */
+      bool slab_if_no_fit;
 
       /** \brief lazy constructor */
-      contraction(){ idx_A = NULL; idx_B = NULL; idx_C=NULL; is_custom=0; alpha=NULL; beta=NULL; };
+      contraction(){ idx_A = NULL; idx_B = NULL; idx_C=NULL; is_custom=0; alpha=NULL; beta=NULL; mask=NULL; idx_mask=NULL; mask_cmp=false; home_acc_C=NULL; slab_if_no_fit=false; };
       
       /** \brief destructor */
       ~contraction();
@@ -104,6 +116,19 @@ namespace CTF_int {
                   bivar_function const * func=NULL);
 
 
+      /**
+       * \brief restricts the contraction to entries of C that match a nonzero of M,
+       *        C[idx_C] = beta*C[idx_C] + alpha * M[idx_M] o (A[idx_A] * B[idx_B]),
+       *        a mask on the output of a sparse matrix-vector or matrix-matrix product is applied within the
+       *        kernel, otherwise operands are filtered by M on the indices they share with it before the
+       *        contraction and, if no operand has all indices of M, the product is masked after it is formed
+       * \param[in] M mask tensor, nonsymmetric, only its sparsity pattern is used
+       * \param[in] cidx_M indices of M, each must be an index of C
+       * \param[in] cidx_C indices of C with the same naming as cidx_M
+       * \param[in] complement if true, keep only entries that do not match a nonzero of M
+       */
+      void set_mask(tensor * M, char const * cidx_M, char const * cidx_C, bool complement=false);
+
       /** \brief run contraction */
       void execute();
       
@@ -117,6 +142,11 @@ namespace CTF_int {
       int is_equal(contraction const & os);
 
     private:
+      /**
+       * \brief runs contraction restricted by mask
+       */
+      void execute_masked();
+
       /**
        * \brief returns true if one of the tensors is sparse 
        */
@@ -265,9 +295,32 @@ namespace CTF_int {
        */
       int try_topo_morph();
 
-      void get_best_sel_map(distribution const * dA, distribution const * dB, distribution const * dC, topology * old_topo_A, topology * old_topo_B, topology * old_topo_C, mapping const * old_map_A, mapping const * old_map_B, mapping const * old_map_C, int & idx, double & time);
+      void get_best_sel_map(distribution const * dA, distribution const * dB, distribution const * dC, topology * old_topo_A, topology * old_topo_B, topology * old_topo_C, mapping const * old_map_A, mapping const * old_map_B, mapping const * old_map_C, int64_t max_memuse, int & idx, double & time, int64_t & mem);
 
-      void get_best_exh_map(distribution const * dA, distribution const * dB, distribution const * dC, topology * old_topo_A, topology * old_topo_B, topology * old_topo_C, mapping const * old_map_A, mapping const * old_map_B, mapping const * old_map_C, int & idx, double & time, double init_best_time);
+      void get_best_exh_map(distribution const * dA, distribution const * dB, distribution const * dC, topology * old_topo_A, topology * old_topo_B, topology * old_topo_C, mapping const * old_map_A, mapping const * old_map_B, mapping const * old_map_C, int64_t max_memuse, int & idx, double & time, int64_t & mem, double init_best_time);
+
+      /**
+       * \brief predicts the most memory the contraction needs on this process at once beyond its operands,
+       *        given the current (new) mapping: the largest of the redistribution buffers, the out-of-place
+       *        transposes of folding, and the buffers of the contraction algorithm including replication
+       * \param[in] sctr contraction algorithm for the mapping
+       * \param[in] is_fold whether the operands are folded
+       * \param[in] need_remap_A whether A is redistributed from dA (similarly for B and C)
+       * \param[in] dA initial distribution of A (similarly for B and C)
+       * \param[in] nnz_frac_A estimated fraction of nonzeros in A (similarly for B and C)
+       * \return predicted peak bytes
+       */
+      int64_t est_peak_mem(ctr *                sctr,
+                           bool                 is_fold,
+                           bool                 need_remap_A,
+                           bool                 need_remap_B,
+                           bool                 need_remap_C,
+                           distribution const * dA,
+                           distribution const * dB,
+                           distribution const * dC,
+                           double               nnz_frac_A,
+                           double               nnz_frac_B,
+                           double               nnz_frac_C);
 
       /**
        * \brief find best possible mapping for contraction and redistribute tensors to this mapping
@@ -324,6 +377,16 @@ namespace CTF_int {
        */
       int home_contract();
 
+      /**
+       * \brief contracts the dense nonsymmetric operands in slabs along an index of C, each slab reading
+       *        only its part of the operands and accumulating into C, used by home_contract() when map()
+       *        finds no mapping that fits in the memory available (or the world's mem_budget), and by
+       *        execute() when operands are paged out by tensor::page_out(), whose slabs are then read from
+       *        and written to their files by nonblocking MPI-IO, overlapping with the previous slab
+       * \return SUCCESS if the contraction was done in slabs, NEGATIVE if it cannot be split
+       */
+      int slab_contract();
+
       /**
        * \brief applies scaling factor to diagonals for symmetric groups that are contracted over
        */
@@ -336,6 +399,13 @@ namespace CTF_int {
 
       /** \brief print contraction details */
       void print();
+
+      /**
+       * \brief writes contraction expression in the format printed by print, e.g. C[0 1] <- A[0 2]*B[2 1]
+       * \param[in,out] str preallocated string
+       * \param[in] max_len size of str
+       */
+      void get_str(char * str, int max_len);
   };
 
 
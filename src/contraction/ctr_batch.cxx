@@ -0,0 +1,262 @@
+/*Copyright (c) 2011, Edgar Solomonik, all rights reserved.*/
+
+#include "ctr_batch.h"
+#include "contraction.h"
+#include "../tensor/untyped_tensor.h"
+#include "../mapping/mapping.h"
+#include "../interface/world.h"
+#include "../shared/util.h"
+
+namespace CTF_int {
+  /**
+   * \brief layout of one operand of a batched contraction relative to the matrix it is passed to gemm as
+   */
+  struct batch_operand {
+    /** \brief whether the data has to be permuted into (or out of) a packed buffer */
+    bool permute;
+    /** \brief edge lengths of the packed buffer */
+    std::vector<int> lens;
+    /** \brief stride in the tensor data along each edge of the packed buffer */
+    std::vector<int64_t> lda;
+  };
+
+  /**
+   * \brief index analysis of a batched contraction, shared by all contractions of the batch
+   */
+  struct batch_plan {
+    int m, n, k;
+    /** \brief transposition of the matrices of A and B passed to gemm */
+    char tA, tB;
+    /** \brief whether C^T=B^T*A^T is computed instead of C=A*B */
+    bool swap;
+    batch_operand A, B, C;
+  };
+
+  /**
+   * \brief returns true if T is a dense nonsymmetric tensor stored unfolded and unpadded on a single processor,
+   *        so that its local data is laid out column-major in the order of its indices
+   */
+  static bool is_local_dense(tensor const * T){
+    if (T->wrld->np != 1 || !T->is_mapped || T->is_folded || T->is_sparse || T->has_zero_edge_len) return false;
+    int64_t sz = 1;
+    for (int i=0; i<T->order; i++){
+      if (T->sym[i] != NS || T->edge_map[i].calc_phase() != 1 || T->pad_edge_len[i] != T->lens[i]) return false;
+      sz *= T->lens[i];
+    }
+    return T->size == sz;
+  }
+
+  /**
+   * \brief sets op to the layout of T with indices idx when packed in the order of the indices in tgt,
+   *        which must be a permutation of idx
+   */
+  static void set_batch_operand(tensor const * T, std::string const & idx, std::string const & tgt, batch_operand & op){
+    op.permute = (idx != tgt);
+    op.lens.resize(T->order);
+    op.lda.resize(T->order);
+    for (int i=0; i<T->order; i++){
+      int j = idx.find(tgt[i]);
+      op.lens[i] = T->lens[j];
+      op.lda[i] = 1;
+      for (int l=0; l<j; l++) op.lda[i] *= T->lens[l];
+    }
+  }
+
+  /**
+   * \brief returns the product of the edge lengths of the indices in grp, whose edge lengths are taken from T
+   */
+  static int64_t batch_dim(tensor const * T, std::string const & idx, std::string const & grp){
+    int64_t d = 1;
+    for (int i=0; i<(int)grp.size(); i++){
+      d *= T->lens[idx.find(grp[i])];
+    }
+    return d;
+  }
+
+  /**
+   * \brief returns true if every index of the contraction appears once in exactly two of the operands, in which case
+   *        p is set so that each contraction of the batch is a single gemm on possibly permuted operands
+   */
+  static bool plan_batch(tensor const * A,
+                         std::string const & idx_A,
+                         tensor const * B,
+                         std::string const & idx_B,
+                         tensor const * C,
+                         std::string const & idx_C,
+                         batch_plan & p){
+    std::string M, N, K;
+    for (int i=0; i<(int)idx_C.size(); i++){
+      bool in_A = idx_A.find(idx_C[i]) != std::string::npos;
+      bool in_B = idx_B.find(idx_C[i]) != std::string::npos;
+      if (idx_C.find(idx_C[i]) != (size_t)i || in_A == in_B) return false;
+      if (in_A) M.push_back(idx_C[i]);
+      else N.push_back(idx_C[i]);
+    }
+    for (int i=0; i<(int)idx_A.size(); i++){
+      bool in_B = idx_B.find(idx_A[i]) != std::string::npos;
+      bool in_C = idx_C.find(idx_A[i]) != std::string::npos;
+      if (idx_A.find(idx_A[i]) != (size_t)i || in_B == in_C) return false;
+      if (in_B) K.push_back(idx_A[i]);
+    }
+    for (int i=0; i<(int)idx_B.size(); i++){
+      bool in_A = idx_A.find(idx_B[i]) != std::string::npos;
+      bool in_C = idx_C.find(idx_B[i]) != std::string::npos;
+      if (idx_B.find(idx_B[i]) != (size_t)i || in_A == in_C) return false;
+    }
+    int64_t m = batch_dim(C, idx_C, M);
+    int64_t n = batch_dim(C, idx_C, N);
+    int64_t k = batch_dim(A, idx_A, K);
+    if (m > INT_MAX || n > INT_MAX || k > INT_MAX) return false;
+    p.m = m;
+    p.n = n;
+    p.k = k;
+
+    p.tA = (idx_A == K+M) ? 'T' : 'N';
+    set_batch_operand(A, idx_A, p.tA == 'T' ? K+M : M+K, p.A);
+    p.tB = (idx_B == N+K) ? 'T' : 'N';
+    set_batch_operand(B, idx_B, p.tB == 'T' ? N+K : K+N, p.B);
+    p.swap = (idx_C == N+M && idx_C != M+N);
+    set_batch_operand(C, idx_C, p.swap ? N+M : M+N, p.C);
+    return true;
+  }
+
+  /**
+   * \brief copies the block with edge lengths lens from src to dst, where the element with index (i_0,i_1,...)
+   *        is at offset sum_j i_j*lda_src[j] in src and at offset sum_j i_j*lda_dst[j] in dst
+   */
+  static void strided_copy(int              order,
+                           int const *      lens,
+                           int64_t const *  lda_src,
+                           char const *     src,
+                           int64_t const *  lda_dst,
+                           char *           dst,
+                           algstrct const * sr){
+    if (order == 0){
+      sr->copy(dst, src);
+      return;
+    }
+    int64_t sz = sr->el_size;
+    std::vector<int> idx(order, 0);
+    int64_t off_src = 0, off_dst = 0;
+    for (;;){
+      sr->copy(lens[0], src+sz*off_src, lda_src[0], dst+sz*off_dst, lda_dst[0]);
+      int d = 1;
+      for (; d<order; d++){
+        idx[d]++;
+        off_src += lda_src[d];
+        off_dst += lda_dst[d];
+        if (idx[d] < lens[d]) break;
+        off_src -= lda_src[d]*lens[d];
+        off_dst -= lda_dst[d]*lens[d];
+        idx[d] = 0;
+      }
+      if (d == order) break;
+    }
+  }
+
+  /**
+   * \brief packs (dir=1) the tensor data into buf or unpacks (dir=0) buf into the tensor data
+   */
+  static void pack_batch_operand(batch_operand const & op, char * data, char * buf, int dir, algstrct const * sr){
+    int order = op.lens.size();
+    std::vector<int64_t> lda_buf(order);
+    for (int i=0; i<order; i++){
+      lda_buf[i] = i == 0 ? 1 : lda_buf[i-1]*op.lens[i-1];
+    }
+    if (dir) strided_copy(order, op.lens.data(), op.lda.data(), data, lda_buf.data(), buf, sr);
+    else strided_copy(order, op.lens.data(), lda_buf.data(), buf, op.lda.data(), data, sr);
+  }
+
+  /**
+   * \brief returns true if all tensors in T have the same shape and symmetry as T[0]
+   */
+  static bool same_shape(int n, tensor ** T){
+    for (int i=1; i<n; i++){
+      if (T[i]->order != T[0]->order || T[i]->sr->el_size != T[0]->sr->el_size) return false;
+      for (int j=0; j<T[0]->order; j++){
+        if (T[i]->lens[j] != T[0]->lens[j] || T[i]->sym[j] != T[0]->sym[j]) return false;
+      }
+    }
+    return true;
+  }
+
+  void contract_batch(int          n,
+                      tensor **    A,
+                      char const * idx_A,
+                      tensor **    B,
+                      char const * idx_B,
+                      char const * alpha,
+                      tensor **    C,
+                      char const * idx_C,
+                      char const * beta){
+    if (n <= 0) return;
+    if (!same_shape(n, A) || !same_shape(n, B) || !same_shape(n, C)){
+      printf("CTF ERROR: contract_batch requires the tensors of each operand to have the same shape\n");
+      ASSERT(0);
+      return;
+    }
+    TAU_FSTART(contract_batch);
+    algstrct const * sr = C[0]->sr;
+    if (alpha == NULL) alpha = sr->mulid();
+    if (beta == NULL) beta = sr->mulid();
+
+    batch_plan p;
+    bool is_gemm = sr->has_mul() && A[0]->sr->el_size == sr->el_size && B[0]->sr->el_size == sr->el_size &&
+                   plan_batch(A[0], std::string(idx_A, A[0]->order), B[0], std::string(idx_B, B[0]->order),
+                              C[0], std::string(idx_C, C[0]->order), p);
+    std::vector<int> loc;
+    for (int i=0; i<n; i++){
+      if (is_gemm && A[i]->wrld == C[i]->wrld && B[i]->wrld == C[i]->wrld &&
+          C[i]->data != A[i]->data && C[i]->data != B[i]->data &&
+          is_local_dense(A[i]) && is_local_dense(B[i]) && is_local_dense(C[i])){
+        loc.push_back(i);
+      } else {
+        contraction ctr(A[i], idx_A, B[i], idx_B, alpha, C[i], idx_C, beta);
+        ctr.execute();
+      }
+    }
+
+    int l = loc.size();
+    if (l > 0){
+      int64_t sz = sr->el_size;
+      int64_t mk = (int64_t)p.m*p.k, kn = (int64_t)p.k*p.n, mn = (int64_t)p.m*p.n;
+      bool beta_zero = sr->isequal(beta, sr->addid());
+      char * buf_A = p.A.permute ? (char*)alloc(l*mk*sz) : NULL;
+      char * buf_B = p.B.permute ? (char*)alloc(l*kn*sz) : NULL;
+      char * buf_C = p.C.permute ? (char*)alloc(l*mn*sz) : NULL;
+      std::vector<char const *> ptr_A(l), ptr_B(l);
+      std::vector<char *> ptr_C(l);
+      for (int j=0; j<l; j++){
+        int i = loc[j];
+        if (p.A.permute){
+          ptr_A[j] = buf_A+j*mk*sz;
+          pack_batch_operand(p.A, A[i]->data, buf_A+j*mk*sz, 1, sr);
+        } else ptr_A[j] = A[i]->data;
+        if (p.B.permute){
+          ptr_B[j] = buf_B+j*kn*sz;
+          pack_batch_operand(p.B, B[i]->data, buf_B+j*kn*sz, 1, sr);
+        } else ptr_B[j] = B[i]->data;
+        if (p.C.permute){
+          ptr_C[j] = buf_C+j*mn*sz;
+          if (beta_zero) sr->set(ptr_C[j], sr->addid(), mn);
+          else pack_batch_operand(p.C, C[i]->data, ptr_C[j], 1, sr);
+        } else ptr_C[j] = C[i]->data;
+      }
+      if (p.swap)
+        sr->gemm_batch(p.tB == 'N' ? 'T' : 'N', p.tA == 'N' ? 'T' : 'N', l, p.n, p.m, p.k,
+                       alpha, ptr_B.data(), ptr_A.data(), beta, ptr_C.data());
+      else
+        sr->gemm_batch(p.tA, p.tB, l, p.m, p.n, p.k, alpha, ptr_A.data(), ptr_B.data(), beta, ptr_C.data());
+      CTF_FLOPS_ADD(2*l*mn*p.k);
+      if (p.C.permute){
+        for (int j=0; j<l; j++){
+          pack_batch_operand(p.C, C[loc[j]]->data, ptr_C[j], 0, sr);
+        }
+      }
+      if (buf_A != NULL) cdealloc(buf_A);
+      if (buf_B != NULL) cdealloc(buf_B);
+      if (buf_C != NULL) cdealloc(buf_C);
+    }
+    TAU_FSTOP(contract_batch);
+  }
+}
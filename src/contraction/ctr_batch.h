@@ -0,0 +1,40 @@
+/*Copyright (c) 2011, Edgar Solomonik, all rights reserved.*/
+
+#ifndef __CTR_BATCH_H__
+#define __CTR_BATCH_H__
+
+#include "../interface/common.h"
+
+namespace CTF_int {
+  class tensor;
+
+  /**
+   * \brief executes the independent contractions C[i][idx_C] = beta*C[i][idx_C] + alpha*A[i][idx_A]*B[i][idx_B]
+   *        for 0<=i<n, where all A[i] have the same shape and symmetry, and so do all B[i] and all C[i].
+   *        The contractions whose operands are dense, nonsymmetric and live on the same single-processor
+   *        world are executed locally by a single algstrct::gemm_batch() call, with the index analysis done
+   *        once for the whole batch and without mapping, topology selection or per-contraction timers.
+   *        The others are executed one after another as regular contractions, so the tensors of the batch
+   *        may be spread over many sub-worlds, with each processor passing those of its own sub-worlds.
+   * \param[in] n number of contractions
+   * \param[in] A left operands
+   * \param[in] idx_A indices of the left operands
+   * \param[in] B right operands
+   * \param[in] idx_B indices of the right operands
+   * \param[in] alpha scaling factor of A[i]*B[i], NULL if multiplicative identity
+   * \param[in,out] C outputs
+   * \param[in] idx_C indices of the outputs
+   * \param[in] beta scaling factor of C[i], NULL if multiplicative identity
+   */
+  void contract_batch(int          n,
+                      tensor **    A,
+                      char const * idx_A,
+                      tensor **    B,
+                      char const * idx_B,
+                      char const * alpha,
+                      tensor **    C,
+                      char const * idx_C,
+                      char const * beta);
+}
+
+#endif
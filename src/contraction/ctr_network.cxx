@@ -0,0 +1,292 @@
+/*Copyright (c) 2011, Edgar Solomonik, all rights reserved.*/
+
+#include "ctr_network.h"
+#include "../shared/util.h"
+
+namespace CTF_int {
+  /** \brief largest network whose contraction order is found by exhaustive search over all subsets of its tensors */
+  static int const network_max_exhaustive = 12;
+
+  /**
+   * \brief returns the number of elements of a tensor with the indices in mask, where index i has extent ext[i]
+   */
+  static double mask_size(uint64_t mask, std::vector<double> const & ext){
+    double s = 1.;
+    for (int i=0; mask != 0; i++, mask >>= 1){
+      if (mask & 1) s *= ext[i];
+    }
+    return s;
+  }
+
+  /**
+   * \brief returns the indices in mask, in the order in which they appear in labels
+   */
+  static std::string mask_idx(uint64_t mask, std::string const & labels){
+    std::string idx;
+    for (int i=0; mask != 0; i++, mask >>= 1){
+      if (mask & 1) idx.push_back(labels[i]);
+    }
+    return idx;
+  }
+
+  /**
+   * \brief appends the contractions of the subset S of tensors given by the split of each subset found by
+   *        exhaustive search to the plan, returns the operand holding the result
+   */
+  static int emit_split(int                           n,
+                        int64_t                       S,
+                        std::vector<int64_t> const &  split,
+                        std::vector<uint64_t> const & res,
+                        std::string const &           labels,
+                        network_plan &                plan,
+                        std::vector<uint64_t> &       mask_res){
+    if ((S & (S-1)) == 0){
+      int i = 0;
+      while (((S >> i) & 1) == 0) i++;
+      return i;
+    }
+    int a = emit_split(n, split[S], split, res, labels, plan, mask_res);
+    int b = emit_split(n, S ^ split[S], split, res, labels, plan, mask_res);
+    plan.order.push_back(std::pair<int,int>(a, b));
+    plan.idx_res.push_back(mask_idx(res[S], labels));
+    mask_res.push_back(res[S]);
+    return n + plan.order.size() - 1;
+  }
+
+  /**
+   * \brief returns the largest number of elements a sub-network holds during a step when the index i has
+   *        extent blk[i] in the sub-network and ext[i] in the network, which are the operands and result
+   *        of the step, and, if the network is sliced, the copies of the other tensors of the network that
+   *        the sub-network holds throughout (the pieces of the sliced ones and, on nsubworld>1 sub-worlds,
+   *        the unsliced ones in full) as well as the output, into which the sub-networks are accumulated
+   */
+  static double network_peak(int                           n,
+                             std::vector<uint64_t> const & msk,
+                             std::vector<uint64_t> const & mask_res,
+                             uint64_t                      out_mask,
+                             network_plan const &          plan,
+                             std::vector<double> const &   ext,
+                             std::vector<double> const &   blk,
+                             int                           nsubworld){
+    std::vector<bool> is_copy(n, false);
+    double held = 0.;
+    if (blk != ext){
+      for (int i=0; i<n; i++){
+        is_copy[i] = nsubworld > 1 || mask_size(msk[i], blk) < mask_size(msk[i], ext);
+        if (is_copy[i]) held += mask_size(msk[i], blk);
+      }
+      held += mask_size(out_mask, ext);
+    }
+    if (plan.order.size() == 0) return is_copy[0] ? held : held + mask_size(msk[0], blk);
+    double peak = 0.;
+    for (int s=0; s<(int)plan.order.size(); s++){
+      int a = plan.order[s].first;
+      int b = plan.order[s].second;
+      double sz = mask_size(mask_res[s], blk);
+      if (a >= n || !is_copy[a]) sz += mask_size(a < n ? msk[a] : mask_res[a-n], blk);
+      if (b >= n || !is_copy[b]) sz += mask_size(b < n ? msk[b] : mask_res[b-n], blk);
+      peak = std::max(peak, sz);
+    }
+    return held + peak;
+  }
+
+  /**
+   * \brief returns the number of sub-networks when the index i has extent blk[i] in them and ext[i] in the network
+   */
+  static int64_t network_npiece(std::vector<double> const & ext,
+                                std::vector<double> const & blk){
+    int64_t npiece = 1;
+    for (int l=0; l<(int)ext.size(); l++){
+      npiece *= (int64_t)std::ceil(ext[l]/blk[l]);
+    }
+    return npiece;
+  }
+
+  int plan_network(int                       n,
+                   std::string const *       idx,
+                   int const * const *       lens,
+                   std::string const &       idx_out,
+                   int64_t                   el_size,
+                   int                       np,
+                   int64_t                   mem_limit,
+                   network_plan &            plan){
+    std::string labels;
+    std::vector<int> len_lbl;
+    for (int i=0; i<n; i++){
+      for (int j=0; j<(int)idx[i].size(); j++){
+        size_t l = labels.find(idx[i][j]);
+        if (l == std::string::npos){
+          labels.push_back(idx[i][j]);
+          len_lbl.push_back(lens[i][j]);
+        } else if (len_lbl[l] != lens[i][j]){
+          printf("CTF ERROR: index %c of the tensor network has inconsistent edge lengths %d and %d\n",
+                 idx[i][j], len_lbl[l], lens[i][j]);
+          return ERROR;
+        }
+      }
+    }
+    if (n == 0 || labels.size() > 64){
+      printf("CTF ERROR: tensor networks need at least one tensor and at most 64 distinct indices\n");
+      return ERROR;
+    }
+    std::vector<double> ext(len_lbl.begin(), len_lbl.end());
+    std::vector<uint64_t> msk(n, 0);
+    for (int i=0; i<n; i++){
+      for (int j=0; j<(int)idx[i].size(); j++){
+        msk[i] |= ((uint64_t)1) << labels.find(idx[i][j]);
+      }
+    }
+    uint64_t out_mask = 0;
+    for (int j=0; j<(int)idx_out.size(); j++){
+      size_t l = labels.find(idx_out[j]);
+      if (l == std::string::npos){
+        printf("CTF ERROR: output index %c does not appear in the tensor network\n", idx_out[j]);
+        return ERROR;
+      }
+      out_mask |= ((uint64_t)1) << l;
+    }
+
+    plan.order.clear();
+    plan.idx_res.clear();
+    plan.flops = 0.;
+    std::vector<uint64_t> mask_res;
+    if (n > 1 && n <= network_max_exhaustive){
+      //cost of the cheapest order of contractions of each subset of the tensors, built from its subsets
+      int64_t nsub = ((int64_t)1) << n;
+      std::vector<uint64_t> uni(nsub, 0), res(nsub, 0);
+      std::vector<double> cost(nsub, 0.);
+      std::vector<int64_t> split(nsub, 0);
+      for (int64_t S=1; S<nsub; S++){
+        int i = 0;
+        while (((S >> i) & 1) == 0) i++;
+        uni[S] = uni[S & (S-1)] | msk[i];
+      }
+      for (int64_t S=1; S<nsub; S++){
+        if ((S & (S-1)) == 0){
+          //single tensors keep all their indices until they are contracted
+          res[S] = uni[S];
+          continue;
+        }
+        res[S] = uni[S] & (uni[(nsub-1) ^ S] | out_mask);
+        cost[S] = -1.;
+        for (int64_t S1=(S-1)&S; S1>0; S1=(S1-1)&S){
+          int64_t S2 = S ^ S1;
+          if (S1 < S2) continue;
+          double c = cost[S1] + cost[S2] + mask_size(res[S1] | res[S2], ext);
+          if (cost[S] < 0. || c < cost[S]){
+            cost[S] = c;
+            split[S] = S1;
+          }
+        }
+      }
+      emit_split(n, nsub-1, split, res, labels, plan, mask_res);
+      plan.flops = 2.*cost[nsub-1];
+    } else if (n > 1){
+      //greedily contract the pair of live operands with the fewest operations
+      std::vector<int> live(n);
+      std::vector<uint64_t> live_mask(msk);
+      for (int i=0; i<n; i++) live[i] = i;
+      while (live.size() > 1){
+        int bi = -1, bj = -1;
+        double bc = 0., bs = 0.;
+        uint64_t bres = 0;
+        for (int i=0; i<(int)live.size(); i++){
+          for (int j=i+1; j<(int)live.size(); j++){
+            uint64_t rest = out_mask;
+            for (int l=0; l<(int)live.size(); l++){
+              if (l != i && l != j) rest |= live_mask[l];
+            }
+            uint64_t r = (live_mask[i] | live_mask[j]) & rest;
+            double c = mask_size(live_mask[i] | live_mask[j], ext);
+            double s = mask_size(r, ext);
+            if (bi == -1 || c < bc || (c == bc && s < bs)){
+              bi = i;
+              bj = j;
+              bc = c;
+              bs = s;
+              bres = r;
+            }
+          }
+        }
+        plan.order.push_back(std::pair<int,int>(live[bi], live[bj]));
+        plan.idx_res.push_back(mask_idx(bres, labels));
+        mask_res.push_back(bres);
+        plan.flops += 2.*bc;
+        live[bi] = n + plan.order.size() - 1;
+        live_mask[bi] = bres;
+        live.erase(live.begin()+bj);
+        live_mask.erase(live_mask.begin()+bj);
+      }
+    }
+
+    //halve the extent of the index whose slicing reduces the peak of a sub-network most, until the peak of each
+    //sub-network fits in the memory of the processors of a sub-world
+    std::vector<double> blk(ext);
+    double peak = network_peak(n, msk, mask_res, out_mask, plan, ext, blk, 1);
+    int64_t npiece = 1;
+    int nsubworld = 1;
+    while (peak*el_size > ((double)mem_limit)*(np/nsubworld)){
+      int bl = -1;
+      double bpeak = 0.;
+      for (int l=0; l<(int)labels.size(); l++){
+        if (blk[l] <= 1.) continue;
+        std::vector<double> tblk(blk);
+        tblk[l] = std::ceil(blk[l]/2.);
+        int tnsubworld = std::min(network_npiece(ext, tblk), (int64_t)np);
+        double p = network_peak(n, msk, mask_res, out_mask, plan, ext, tblk, tnsubworld);
+        if (bl == -1 || p < bpeak){
+          bl = l;
+          bpeak = p;
+        }
+      }
+      //stop when slicing any single index no longer shrinks the largest step, rather than slicing
+      //indices of all steps at once into exponentially many pieces
+      if (bl == -1 || bpeak >= peak) break;
+      blk[bl] = std::ceil(blk[bl]/2.);
+      peak = bpeak;
+      npiece = network_npiece(ext, blk);
+      nsubworld = std::min(npiece, (int64_t)np);
+    }
+    plan.idx_slice.clear();
+    plan.len_slice.clear();
+    plan.blk_slice.clear();
+    for (int l=0; l<(int)labels.size(); l++){
+      if (blk[l] < ext[l]){
+        plan.idx_slice.push_back(labels[l]);
+        plan.len_slice.push_back(len_lbl[l]);
+        plan.blk_slice.push_back((int)blk[l]);
+      }
+    }
+    plan.npiece = npiece;
+    plan.nsubworld = nsubworld;
+    plan.peak = peak;
+    return SUCCESS;
+  }
+
+  bool network_piece(network_plan const & plan,
+                     int64_t              q,
+                     std::string const &  idx,
+                     int const *          lens,
+                     int *                offsets,
+                     int *                ends){
+    std::vector<int> piece(plan.idx_slice.size());
+    for (int l=0; l<(int)plan.idx_slice.size(); l++){
+      int np_l = (plan.len_slice[l]+plan.blk_slice[l]-1)/plan.blk_slice[l];
+      piece[l] = q % np_l;
+      q /= np_l;
+    }
+    bool is_sliced = false;
+    for (int j=0; j<(int)idx.size(); j++){
+      size_t l = plan.idx_slice.find(idx[j]);
+      if (l == std::string::npos){
+        offsets[j] = 0;
+        ends[j] = lens[j];
+      } else {
+        offsets[j] = piece[l]*plan.blk_slice[l];
+        ends[j] = std::min(lens[j], offsets[j]+plan.blk_slice[l]);
+        is_sliced = true;
+      }
+    }
+    return is_sliced;
+  }
+}
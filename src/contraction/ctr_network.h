@@ -0,0 +1,78 @@
+/*Copyright (c) 2011, Edgar Solomonik, all rights reserved.*/
+
+#ifndef __CTR_NETWORK_H__
+#define __CTR_NETWORK_H__
+
+#include "../interface/common.h"
+
+namespace CTF_int {
+  /**
+   * \brief order of the pairwise contractions of a tensor network, along with the indices sliced to
+   *        bound the memory footprint of the intermediates
+   */
+  struct network_plan {
+    /** \brief operands contracted at each step, operand i<n is the ith tensor of the network and
+               operand n+s is the result of step s */
+    std::vector< std::pair<int,int> > order;
+    /** \brief indices of the result of each step */
+    std::vector< std::string > idx_res;
+    /** \brief sliced indices */
+    std::string idx_slice;
+    /** \brief edge length of each sliced index */
+    std::vector<int> len_slice;
+    /** \brief extent of the pieces of each sliced index, the last piece may be shorter */
+    std::vector<int> blk_slice;
+    /** \brief number of independent sub-networks (product of the number of pieces of each sliced index) */
+    int64_t npiece;
+    /** \brief number of sub-worlds over which the sub-networks are distributed */
+    int nsubworld;
+    /** \brief number of operations done by all steps of the unsliced network */
+    double flops;
+    /** \brief largest number of elements of the operands and result of a step of a sub-network, along with,
+               if the network is sliced, the copies of the tensors of the network and the output it holds */
+    double peak;
+  };
+
+  /**
+   * \brief finds the order of pairwise contractions of a network that minimizes the number of operations,
+   *        exhaustively for small networks and greedily otherwise, then, if the largest step does not fit in
+   *        memory, picks indices to slice into pieces until it does, each sub-network being executed by a
+   *        sub-world of np/nsubworld processors
+   * \param[in] n number of tensors in the network
+   * \param[in] idx indices of each tensor
+   * \param[in] lens edge lengths of each tensor
+   * \param[in] idx_out indices of the output
+   * \param[in] el_size element size in bytes
+   * \param[in] np number of processors the network is executed on
+   * \param[in] mem_limit bytes available to each processor
+   * \param[out] plan order of contractions and slicing
+   * \return SUCCESS, or ERROR if the indices of the network are inconsistent
+   */
+  int plan_network(int                       n,
+                   std::string const *       idx,
+                   int const * const *       lens,
+                   std::string const &       idx_out,
+                   int64_t                   el_size,
+                   int                       np,
+                   int64_t                   mem_limit,
+                   network_plan &            plan);
+
+  /**
+   * \brief returns the offset and extent along each index of idx of piece q of a sliced network
+   * \param[in] plan order and slicing of the network
+   * \param[in] q piece of the network
+   * \param[in] idx indices of a tensor
+   * \param[in] lens edge lengths of the tensor
+   * \param[out] offsets first element of the piece along each index
+   * \param[out] ends end of the piece along each index
+   * \return whether any index of idx is sliced
+   */
+  bool network_piece(network_plan const & plan,
+                     int64_t              q,
+                     std::string const &  idx,
+                     int const *          lens,
+                     int *                offsets,
+                     int *                ends);
+}
+
+#endif
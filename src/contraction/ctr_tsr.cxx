@@ -488,6 +488,7 @@ namespace CTF_int {
                        idx_map_C,
                        func);
       double exe_time = MPI_Wtime()-st_time;
+      kernel_time_add(exe_time);
       double tps[] = {exe_time, 1.0, (double)est_membw(), est_fp()};
       seq_tsr_ctr_mdl_cst.observe(tps);
     } else if (is_inner){
@@ -518,6 +519,7 @@ namespace CTF_int {
                       &inner_params,
                       func);
       double exe_time = MPI_Wtime()-st_time;
+      kernel_time_add(exe_time);
  //     printf("exe_time = %E est_time = %E abs_err = %e rel_err = %lf\n", exe_time,est_time,fabs(exe_time-est_time),fabs(exe_time-est_time)/exe_time);
       double tps[] = {exe_time, 1.0, (double)est_membw(), est_fp()};
       if (is_custom){
@@ -555,6 +557,7 @@ namespace CTF_int {
                       sym_C,
                       idx_map_C);
       double exe_time = MPI_Wtime()-st_time;
+      kernel_time_add(exe_time);
       double tps[] = {exe_time, 1.0, (double)est_membw(), est_fp()};
       seq_tsr_ctr_mdl_ref.observe(tps);
     }
@@ -5,6 +5,33 @@
 
 #include "ctr_comm.h"
 namespace CTF_int {
+
+  /**
+   * \brief estimates the fraction of nonzeros in a partial result computed from one of nparts equal
+   *        parts of the contracted index range, assuming nonzeros are placed independently, so that
+   *        summing nparts such partial results gives a fraction of nnz_frac
+   * \param[in] nnz_frac fraction of nonzeros in the fully reduced result
+   * \param[in] nparts number of partial results that are summed
+   * \return fraction of nonzeros in each partial result
+   */
+  inline double partial_nnz_frac(double nnz_frac, double nparts){
+    if (nparts <= 1. || nnz_frac >= 1.) return nnz_frac;
+    return 1.-pow(1.-nnz_frac, 1./nparts);
+  }
+
+  /**
+   * \brief estimates the fraction of nonzeros in the output of a contraction of sparse operands
+   * \param[in] nnz_frac_A fraction of nonzeros in A
+   * \param[in] nnz_frac_B fraction of nonzeros in B
+   * \param[in] len_ctr product of the lengths of the contracted indices
+   * \return fraction of output entries that receive at least one nonzero product
+   */
+  inline double ctr_nnz_frac(double nnz_frac_A, double nnz_frac_B, double len_ctr){
+    double f = nnz_frac_A*nnz_frac_B;
+    if (f >= 1.) return 1.;
+    return 1.-pow(1.-f, len_ctr);
+  }
+
      
   class ctr_virt : public ctr {
     public: 
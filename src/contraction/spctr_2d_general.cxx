@@ -5,6 +5,7 @@
 #include "../mapping/mapping.h"
 #include "../shared/util.h"
 #include <climits>
+#include <vector>
 
 namespace CTF_int {
 
@@ -106,8 +107,9 @@ namespace CTF_int {
         est_bcast_time += cdt_B->estimate_bcast_time(sr_B->el_size*s_B*nnz_frac_B);
     }
     if (move_C){
+      //each step reduces partial results computed from 1/edge_len of the contracted indices
       if (is_sparse_C)
-        est_bcast_time += sr_C->estimate_csr_red_time(sr_C->pair_size()*s_C*nnz_frac_C*dns_vrt_sz_C, cdt_C);
+        est_bcast_time += sr_C->estimate_csr_red_time(sr_C->pair_size()*s_C*partial_nnz_frac(nnz_frac_C, edge_len)*dns_vrt_sz_C, cdt_C);
       else
         est_bcast_time += cdt_C->estimate_red_time(sr_C->el_size*s_C*nnz_frac_C, sr_C->addmop());
     }
@@ -115,7 +117,8 @@ namespace CTF_int {
   }
 
   double spctr_2d_general::est_time_rec(int nlyr, double nnz_frac_A, double nnz_frac_B, double nnz_frac_C) {
-    return rec_ctr->est_time_rec(1, nnz_frac_A, nnz_frac_B, nnz_frac_C)*(double)edge_len/MIN(nlyr,edge_len) + est_time_fp(nlyr, nnz_frac_A, nnz_frac_B, nnz_frac_C);
+    double rec_frac_C = (move_C && is_sparse_C) ? partial_nnz_frac(nnz_frac_C, edge_len) : nnz_frac_C;
+    return rec_ctr->est_time_rec(1, nnz_frac_A, nnz_frac_B, rec_frac_C)*(double)edge_len/MIN(nlyr,edge_len) + est_time_fp(nlyr, nnz_frac_A, nnz_frac_B, nnz_frac_C);
   }
 
   int64_t spctr_2d_general::spmem_fp(double nnz_frac_A, double nnz_frac_B, double nnz_frac_C) {
@@ -126,13 +129,14 @@ namespace CTF_int {
     else mem_usage += sr_A->el_size*s_A;
     if (is_sparse_B) mem_usage += sr_B->pair_size()*s_B*nnz_frac_B;
     else mem_usage += sr_B->el_size*s_B;
-    if (is_sparse_C) mem_usage += sr_C->pair_size()*s_C*nnz_frac_C;
+    if (is_sparse_C) mem_usage += sr_C->pair_size()*s_C*(move_C ? partial_nnz_frac(nnz_frac_C, edge_len) : nnz_frac_C);
     else mem_usage += sr_C->el_size*s_C;
     return mem_usage;
   }
 
   int64_t spctr_2d_general::spmem_rec(double nnz_frac_A, double nnz_frac_B, double nnz_frac_C) {
-    return rec_ctr->spmem_rec(nnz_frac_A, nnz_frac_B, nnz_frac_C) + spmem_fp(nnz_frac_A, nnz_frac_B, nnz_frac_C);
+    double rec_frac_C = (move_C && is_sparse_C) ? partial_nnz_frac(nnz_frac_C, edge_len) : nnz_frac_C;
+    return rec_ctr->spmem_rec(nnz_frac_A, nnz_frac_B, rec_frac_C) + spmem_fp(nnz_frac_A, nnz_frac_B, nnz_frac_C);
   }
 
   char * bcast_step(int edge_len, char * A, bool is_sparse_A, bool move_A, algstrct const * sr_A, int64_t b_A, int64_t s_A, char * buf_A, CommData * cdt_A, int64_t ctr_sub_lda_A, int64_t ctr_lda_A, int nblk_A, int64_t const * size_blk_A, int & new_nblk_A, int64_t *& new_size_blk_A, int64_t * offsets_A, int ib){
@@ -278,7 +282,7 @@ new_nblk_C = nblk_C/edge_len;
   }
 
 
-  void reduce_step_post(int edge_len, char * C, bool is_sparse_C, bool move_C, algstrct const * sr_C, int64_t b_C, int64_t s_C, char * buf_C, CommData * cdt_C, int64_t ctr_sub_lda_C, int64_t ctr_lda_C, int nblk_C, int64_t * size_blk_C, int & new_nblk_C, int64_t *& new_size_blk_C, int64_t * offsets_C, int ib, char const *& rec_beta, char const * beta, char *& up_C, char *& new_C, int n_new_C_grps, int & i_new_C_grp, char ** new_C_grps){
+  void reduce_step_post(int edge_len, char * C, bool is_sparse_C, bool move_C, algstrct const * sr_C, int64_t b_C, int64_t s_C, char * buf_C, CommData * cdt_C, int64_t ctr_sub_lda_C, int64_t ctr_lda_C, int nblk_C, int64_t * size_blk_C, int & new_nblk_C, int64_t *& new_size_blk_C, int64_t * offsets_C, int ib, char const *& rec_beta, char const * beta, char *& up_C, char *& new_C, int n_new_C_grps, int & i_new_C_grp, char ** new_C_grps, std::vector<char*> & red_C_parts){
     if (move_C){
 #ifdef PROFILE
       TAU_FSTART(spctr_2d_general_barrier);
@@ -287,42 +291,20 @@ new_nblk_C = nblk_C/edge_len;
 #endif
       int owner_C   = ib % cdt_C->np;
       if (is_sparse_C){
+        //keep the slices of the reduced blocks until all steps are done, place_reduced_C then sends them to the owners at once
         int64_t csr_sz_acc = 0;
-        int64_t new_csr_sz_acc = 0;
-        char * new_Cs[new_nblk_C];
         for (int blk=0; blk<new_nblk_C; blk++){
-          new_Cs[blk] = sr_C->csr_reduce(up_C+csr_sz_acc, owner_C, cdt_C->cm);
-        
+          char * blk_C = up_C+csr_sz_acc;
+          char * part = sr_C->csr_reduce_scatter(blk_C, cdt_C->cm);
+          if (part == blk_C){
+            part = (char*)alloc(new_size_blk_C[blk]);
+            memcpy(part, blk_C, new_size_blk_C[blk]);
+          }
+          red_C_parts.push_back(part);
           csr_sz_acc += new_size_blk_C[blk];
-          new_size_blk_C[blk] = cdt_C->rank == owner_C ? ((CSR_Matrix)(new_Cs[blk])).size() : 0;
-          new_csr_sz_acc += new_size_blk_C[blk];
         }
         cdealloc(up_C);
-        if (cdt_C->rank == owner_C){
-          if (n_new_C_grps == 1){
-            alloc_ptr(new_csr_sz_acc, (void**)&up_C);
-            new_csr_sz_acc = 0;
-            ASSERT(nblk_C == new_nblk_C);
-            for (int blk=0; blk<nblk_C; blk++){
-              memcpy(up_C+new_csr_sz_acc, new_Cs[blk], new_size_blk_C[blk]);
-              cdealloc(new_Cs[blk]);
-              new_csr_sz_acc += new_size_blk_C[blk];
-            }
-            if (new_C != C) cdealloc(new_C);
-            new_C = up_C;
-          } else {
-            ASSERT(new_nblk_C == 1);
-            for (int k=0; k<ctr_lda_C; k++){
-              for (int j=0; j<ctr_sub_lda_C; j++){
-                size_blk_C[ctr_sub_lda_C*(k*n_new_C_grps+i_new_C_grp)+j] = new_size_blk_C[ctr_sub_lda_C*k+j];
-              }
-            }
-            new_C_grps[i_new_C_grp] = new_Cs[0];
-            i_new_C_grp++;
-          }
-        } else {
-          up_C = NULL;  
-        }
+        up_C = NULL;
       } else {
         if (cdt_C->rank == owner_C)
           cdt_C->red(MPI_IN_PLACE, up_C, s_C, sr_C->mdtype(), sr_C->addmop(), owner_C);
@@ -362,6 +344,118 @@ new_nblk_C = nblk_C/edge_len;
     }
   }
 
+  /**
+   * \brief sends the slices left by the reduce-scatters of the steps of a sparse contraction moving C to the owners
+   *        of the steps in one exchange within cdt_C, and places the merged blocks as the steps would have one by one
+   * \param[in] steps indices of the steps taken, step ib is owned by processor ib % cdt_C->np
+   * \param[in] nblk number of blocks of C reduced per step
+   * \param[in] red_C_parts slices of the blocks of all steps in step order, deallocated here
+   */
+  void place_reduced_C(std::vector<int64_t> const & steps, int nblk, std::vector<char*> & red_C_parts, CommData * cdt_C, char * C, int64_t ctr_sub_lda_C, int64_t ctr_lda_C, int nblk_C, int64_t * size_blk_C, char *& new_C, int n_new_C_grps, int & i_new_C_grp, char ** new_C_grps){
+    int np = cdt_C->np;
+    int nstep = steps.size();
+    ASSERT((int64_t)red_C_parts.size() == (int64_t)nstep*nblk);
+    int n_own = 0;
+    for (int k=0; k<nstep; k++){
+      if (steps[k] % np == cdt_C->rank) n_own++;
+    }
+    int64_t cnts[np], dspls[np], rcnts[np], rdspls[np];
+    int64_t bcnts[np], bdspls[np], brcnts[np], brdspls[np];
+    int64_t * szs = (int64_t*)alloc(sizeof(int64_t)*std::max(nstep*nblk, 1));
+    int64_t * rszs = (int64_t*)alloc(sizeof(int64_t)*std::max(np*n_own*nblk, 1));
+    int64_t off = 0;
+    int64_t boff = 0;
+    for (int q=0; q<np; q++){
+      dspls[q] = off;
+      bdspls[q] = boff;
+      for (int k=0; k<nstep; k++){
+        if (steps[k] % np != q) continue;
+        for (int blk=0; blk<nblk; blk++){
+          szs[off] = ((CSR_Matrix)(red_C_parts[k*nblk+blk])).size();
+          boff += szs[off];
+          off++;
+        }
+      }
+      cnts[q] = off-dspls[q];
+      bcnts[q] = boff-bdspls[q];
+      rcnts[q] = n_own*nblk;
+      rdspls[q] = q*n_own*nblk;
+    }
+    cdt_C->all_to_allv(szs, cnts, dspls, sizeof(int64_t), rszs, rcnts, rdspls);
+    char * sbuf = (char*)alloc(std::max(boff, (int64_t)1));
+    boff = 0;
+    for (int q=0; q<np; q++){
+      for (int k=0; k<nstep; k++){
+        if (steps[k] % np != q) continue;
+        for (int blk=0; blk<nblk; blk++){
+          char * part = red_C_parts[k*nblk+blk];
+          int64_t sz = ((CSR_Matrix)part).size();
+          memcpy(sbuf+boff, part, sz);
+          boff += sz;
+          cdealloc(part);
+        }
+      }
+    }
+    red_C_parts.clear();
+    int64_t brsz = 0;
+    for (int q=0; q<np; q++){
+      brdspls[q] = brsz;
+      brcnts[q] = 0;
+      for (int j=0; j<n_own*nblk; j++){
+        brcnts[q] += rszs[q*n_own*nblk+j];
+      }
+      brsz += brcnts[q];
+    }
+    char * rbuf = (char*)alloc(std::max(brsz, (int64_t)1));
+    cdt_C->all_to_allv(sbuf, bcnts, bdspls, 1, rbuf, brcnts, brdspls);
+    cdealloc(sbuf);
+
+    //merge the slices of each owned step as csr_reduce would have given them to the owner of the step
+    int64_t roffs[np];
+    memcpy(roffs, brdspls, sizeof(int64_t)*np);
+    for (int k=0; k<n_own; k++){
+      char * new_Cs[nblk];
+      int64_t new_csr_sz_acc = 0;
+      for (int blk=0; blk<nblk; blk++){
+        char * smnds[np];
+        for (int q=0; q<np; q++){
+          smnds[q] = rbuf+roffs[q];
+          roffs[q] += rszs[q*n_own*nblk+k*nblk+blk];
+        }
+        CSR_Matrix M(smnds, np);
+        new_Cs[blk] = M.all_data;
+        new_csr_sz_acc += M.size();
+      }
+      if (n_new_C_grps == 1){
+        char * up_C;
+        alloc_ptr(new_csr_sz_acc, (void**)&up_C);
+        new_csr_sz_acc = 0;
+        ASSERT(nblk_C == nblk);
+        for (int blk=0; blk<nblk; blk++){
+          int64_t sz = ((CSR_Matrix)(new_Cs[blk])).size();
+          memcpy(up_C+new_csr_sz_acc, new_Cs[blk], sz);
+          cdealloc(new_Cs[blk]);
+          new_csr_sz_acc += sz;
+        }
+        if (new_C != C) cdealloc(new_C);
+        new_C = up_C;
+      } else {
+        ASSERT(nblk == 1);
+        int64_t sz = ((CSR_Matrix)(new_Cs[0])).size();
+        for (int kk=0; kk<ctr_lda_C; kk++){
+          for (int j=0; j<ctr_sub_lda_C; j++){
+            size_blk_C[ctr_sub_lda_C*(kk*n_new_C_grps+i_new_C_grp)+j] = sz;
+          }
+        }
+        new_C_grps[i_new_C_grp] = new_Cs[0];
+        i_new_C_grp++;
+      }
+    }
+    cdealloc(rbuf);
+    cdealloc(szs);
+    cdealloc(rszs);
+  }
+
   void spctr_2d_general::run(char * A, int nblk_A, int64_t const * size_blk_A,
                              char * B, int nblk_B, int64_t const * size_blk_B,
                              char * C, int nblk_C, int64_t * size_blk_C,
@@ -479,6 +573,9 @@ new_nblk_C = nblk_C/edge_len;
 
     new_C = C;
 
+    std::vector<char*> red_C_parts;
+    std::vector<int64_t> red_C_steps;
+    int red_nblk_C = 0;
     for (ib=iidx_lyr; ib<edge_len; ib+=inum_lyr){
       op_A = bcast_step(edge_len, A, is_sparse_A, move_A, sr_A, b_A, s_A, buf_A, cdt_A, ctr_sub_lda_A, ctr_lda_A, nblk_A, size_blk_A, new_nblk_A, new_size_blk_A, offsets_A, ib);
       op_B = bcast_step(edge_len, B, is_sparse_B, move_B, sr_B, b_B, s_B, buf_B, cdt_B, ctr_sub_lda_B, ctr_lda_B, nblk_B, size_blk_B, new_nblk_B, new_size_blk_B, offsets_B, ib);
@@ -501,7 +598,11 @@ new_nblk_C = nblk_C/edge_len;
       if (is_sparse_B && move_B && (cdt_B->rank != (ib % cdt_B->np)|| b_B != 1)){
         cdealloc(op_B);
       }
-      reduce_step_post(edge_len, C, is_sparse_C, move_C, sr_C, b_C, s_C, buf_C, cdt_C, ctr_sub_lda_C, ctr_lda_C, nblk_C, size_blk_C, new_nblk_C, new_size_blk_C, offsets_C, ib, rec_ctr->beta, this->beta, up_C, new_C, n_new_C_grps, i_new_C_grp, new_C_grps);
+      reduce_step_post(edge_len, C, is_sparse_C, move_C, sr_C, b_C, s_C, buf_C, cdt_C, ctr_sub_lda_C, ctr_lda_C, nblk_C, size_blk_C, new_nblk_C, new_size_blk_C, offsets_C, ib, rec_ctr->beta, this->beta, up_C, new_C, n_new_C_grps, i_new_C_grp, new_C_grps, red_C_parts);
+      if (move_C && is_sparse_C){
+        red_C_steps.push_back(ib);
+        red_nblk_C = new_nblk_C;
+      }
       
       if (new_size_blk_A != size_blk_A)
         cdealloc(new_size_blk_A);
@@ -518,6 +619,9 @@ new_nblk_C = nblk_C/edge_len;
       if (new_size_blk_C != size_blk_C)
         cdealloc(new_size_blk_C);
     }
+    if (move_C && is_sparse_C){
+      place_reduced_C(red_C_steps, red_nblk_C, red_C_parts, cdt_C, C, ctr_sub_lda_C, ctr_lda_C, nblk_C, size_blk_C, new_C, n_new_C_grps, i_new_C_grp, new_C_grps);
+    }
 #if 0 //def OFFLOAD
     if (alloc_host_buf){
       host_pinned_free(buf_A);
@@ -156,30 +156,44 @@ namespace CTF_int {
       else
         tot_sz += cdt_B[i]->estimate_bcast_time(nnz_frac_B*size_B*sr_B->el_size);
     }
+    //each layer computes a partial sparse C from its part of the contracted indices, which is sparser
+    //than the reduced C, and each reduction step merges np of them
+    double frac_C = is_sparse_C ? partial_nnz_frac(nnz_frac_C, nlyr_C()) : nnz_frac_C;
     for (i=0; i<ncdt_C; i++){
       ASSERT(cdt_C[i]->np > 0);
-      if (is_sparse_C)
-        tot_sz += sr_C->estimate_csr_red_time(nnz_frac_C*size_C*sr_C->pair_size(), cdt_C[i]);
-      else
+      if (is_sparse_C){
+        tot_sz += sr_C->estimate_csr_red_time(frac_C*size_C*sr_C->pair_size(), cdt_C[i]);
+        frac_C = 1.-pow(1.-frac_C, cdt_C[i]->np);
+      } else
         tot_sz += cdt_C[i]->estimate_red_time(nnz_frac_C*size_C*sr_C->el_size, sr_C->addmop());
     }
     return tot_sz;
   }
 
   double spctr_replicate::est_time_rec(int nlyr, double nnz_frac_A, double nnz_frac_B, double nnz_frac_C) {
-    return rec_ctr->est_time_rec(nlyr, nnz_frac_A, nnz_frac_B, nnz_frac_C) + est_time_fp(nlyr, nnz_frac_A, nnz_frac_B, nnz_frac_C);
+    double rec_frac_C = is_sparse_C ? partial_nnz_frac(nnz_frac_C, nlyr_C()) : nnz_frac_C;
+    return rec_ctr->est_time_rec(nlyr, nnz_frac_A, nnz_frac_B, rec_frac_C) + est_time_fp(nlyr, nnz_frac_A, nnz_frac_B, nnz_frac_C);
   }
 
   int64_t spctr_replicate::spmem_fp(double nnz_frac_A, double nnz_frac_B, double nnz_frac_C){
     int64_t mem_usage = 0;
     if (is_sparse_A) mem_usage += nnz_frac_A*size_A*sr_A->pair_size();
     if (is_sparse_B) mem_usage += nnz_frac_B*size_B*sr_B->pair_size();
-    if (is_sparse_C) mem_usage += nnz_frac_C*size_C*sr_C->pair_size();
+    if (is_sparse_C) mem_usage += partial_nnz_frac(nnz_frac_C, nlyr_C())*size_C*sr_C->pair_size();
     return mem_usage;
   }
 
   int64_t spctr_replicate::spmem_rec(double nnz_frac_A, double nnz_frac_B, double nnz_frac_C){
-    return rec_ctr->spmem_rec(nnz_frac_A, nnz_frac_B, nnz_frac_C) + spmem_fp(nnz_frac_A, nnz_frac_B, nnz_frac_C);
+    double rec_frac_C = is_sparse_C ? partial_nnz_frac(nnz_frac_C, nlyr_C()) : nnz_frac_C;
+    return rec_ctr->spmem_rec(nnz_frac_A, nnz_frac_B, rec_frac_C) + spmem_fp(nnz_frac_A, nnz_frac_B, nnz_frac_C);
+  }
+
+  double spctr_replicate::nlyr_C(){
+    double nlyr = 1.;
+    for (int i=0; i<ncdt_C; i++){
+      nlyr *= cdt_C[i]->np;
+    }
+    return nlyr;
   }
 
 
@@ -277,31 +291,45 @@ namespace CTF_int {
     /*for (i=0; i<size_C; i++){
       printf("P%d C[%d]  = %lf\n",crank,i, ((double*)C)[i]);
     }*/
-    for (i=0; i<ncdt_C; i++){
-      if (i>0 && cdt_C[i-1]->rank != 0) break;
-      //ALLREDUCE(MPI_IN_PLACE, C, size_C, sr_C->mdtype(), sr_C->addmop(), cdt_C[i]->;
-      if (is_sparse_C){
-        int64_t csr_sz_acc = 0;
-        int64_t new_csr_sz_acc = 0;
-        char * new_Cs[nblk_C];
-        for (int blk=0; blk<nblk_C; blk++){
-          new_Cs[blk] = sr_C->csr_reduce(new_C+csr_sz_acc, 0, cdt_C[i]->cm);
-  //        printf("%d out of %d reds complete, size = %ld should be %ld\n",blk,nblk_C,size_blk_C[blk],((CSR_Matrix)(new_C+csr_sz_acc)).size());
-        
-          csr_sz_acc += size_blk_C[blk];
-          size_blk_C[blk] = cdt_C[i]->rank == 0 ? ((CSR_Matrix)(new_Cs[blk])).size() : 0;
-          new_csr_sz_acc += size_blk_C[blk];
-//          printf("rank %d blk size %ld tot sz %ld\n", cdt_C[i]->rank, size_blk_C[blk], new_csr_sz_acc);
+    if (is_sparse_C && ncdt_C > 0){
+      //reduce-scatter each block over all replicated dimensions, so every processor adds one slice,
+      //then gather the slices level by level in reverse onto the processor of rank 0 in each, which keeps C
+      int64_t csr_sz_acc = 0;
+      int64_t new_csr_sz_acc = 0;
+      char * new_Cs[nblk_C];
+      for (int blk=0; blk<nblk_C; blk++){
+        char * blk_C = new_C+csr_sz_acc;
+        char * part = blk_C;
+        for (i=0; i<ncdt_C; i++){
+          char * sub_part = sr_C->csr_reduce_scatter(part, cdt_C[i]->cm);
+          if (part != blk_C && sub_part != part) cdealloc(part);
+          part = sub_part;
         }
-        cdealloc(new_C);
-        alloc_ptr(new_csr_sz_acc, (void**)&new_C);
-        new_csr_sz_acc = 0;
-        for (int blk=0; blk<nblk_C; blk++){
-          memcpy(new_C+new_csr_sz_acc, new_Cs[blk], size_blk_C[blk]);
-          cdealloc(new_Cs[blk]);
-          new_csr_sz_acc += size_blk_C[blk];
-        }        
-      } else {
+        if (part == blk_C){
+          part = (char*)alloc(size_blk_C[blk]);
+          memcpy(part, blk_C, size_blk_C[blk]);
+        }
+        csr_sz_acc += size_blk_C[blk];
+        for (i=ncdt_C-1; i>=0 && part != NULL; i--){
+          part = sr_C->csr_gather(part, 0, cdt_C[i]->cm);
+        }
+        new_Cs[blk] = part;
+        size_blk_C[blk] = part != NULL ? ((CSR_Matrix)(part)).size() : 0;
+        new_csr_sz_acc += size_blk_C[blk];
+      }
+      cdealloc(new_C);
+      alloc_ptr(new_csr_sz_acc, (void**)&new_C);
+      new_csr_sz_acc = 0;
+      for (int blk=0; blk<nblk_C; blk++){
+        if (new_Cs[blk] == NULL) continue;
+        memcpy(new_C+new_csr_sz_acc, new_Cs[blk], size_blk_C[blk]);
+        cdealloc(new_Cs[blk]);
+        new_csr_sz_acc += size_blk_C[blk];
+      }
+    } else if (!is_sparse_C){
+      for (i=0; i<ncdt_C; i++){
+        if (i>0 && cdt_C[i-1]->rank != 0) break;
+        //ALLREDUCE(MPI_IN_PLACE, C, size_C, sr_C->mdtype(), sr_C->addmop(), cdt_C[i]->;
         if (cdt_C[i]->rank == 0){
           cdt_C[i]->red(MPI_IN_PLACE, new_C, size_C, sr_C->mdtype(), sr_C->addmop(), 0);
         } else {
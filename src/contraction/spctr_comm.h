@@ -48,6 +48,10 @@ namespace CTF_int{
       int64_t spmem_rec(double nnz_frac_A, double nnz_frac_B, double nnz_frac_C);
       double est_time_fp(int nlyr, double nnz_frac_A, double nnz_frac_B, double nnz_frac_C);
       double est_time_rec(int nlyr, double nnz_frac_A, double nnz_frac_B, double nnz_frac_C);
+      /**
+       * \brief returns the number of partial results of C that are reduced, i.e. the replication of C
+       */
+      double nlyr_C();
       void print();
       spctr * clone();
 
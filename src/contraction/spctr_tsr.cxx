@@ -434,6 +434,7 @@ namespace CTF_int {
     }
     
     double exe_time = MPI_Wtime() - st_time;
+    kernel_time_add(exe_time);
     double tps[] = {exe_time, 1.0, (double)est_membw(nnz_frac_A, nnz_frac_B, nnz_frac_C), est_fp(nnz_frac_B, nnz_frac_B, nnz_frac_C)};
     switch (krnl_type){
       case 0:
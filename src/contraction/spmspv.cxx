@@ -0,0 +1,641 @@
+/*Copyright (c) 2011, Edgar Solomonik, all rights reserved.*/
+
+#include "spmspv.h"
+#include "contraction.h"
+#include "../tensor/untyped_tensor.h"
+#include "../mapping/mapping.h"
+#include "../scaling/scaling.h"
+#include "../shared/util.h"
+
+namespace CTF_int {
+  LinModel<2> spmspv_push_mdl(spmspv_push_mdl_init,"spmspv_push_mdl");
+  LinModel<2> spmspv_pull_mdl(spmspv_pull_mdl_init,"spmspv_pull_mdl");
+
+  /**
+   * \brief determines which operand of ctr is the matrix and which the vector
+   * \return mode of the matrix that is contracted with the vector, -1 if ctr is not of the right form
+   */
+  static int get_spmspv_operands(contraction const * ctr,
+                                 tensor *&           M,
+                                 tensor *&           x,
+                                 bool &              M_is_A){
+    int const * idx_M, * idx_x;
+    if (ctr->A->order == 2 && ctr->B->order == 1){
+      M = ctr->A;
+      x = ctr->B;
+      idx_M = ctr->idx_A;
+      idx_x = ctr->idx_B;
+      M_is_A = true;
+    } else if (ctr->B->order == 2 && ctr->A->order == 1){
+      M = ctr->B;
+      x = ctr->A;
+      idx_M = ctr->idx_B;
+      idx_x = ctr->idx_A;
+      M_is_A = false;
+    } else return -1;
+    if (ctr->C->order != 1 || idx_M[0] == idx_M[1]) return -1;
+    int ic;
+    if (idx_x[0] == idx_M[0]) ic = 0;
+    else if (idx_x[0] == idx_M[1]) ic = 1;
+    else return -1;
+    if (ctr->idx_C[0] != idx_M[1-ic]) return -1;
+    return ic;
+  }
+
+  /**
+   * \brief computes the index of the layer of processors replicating t that this processor belongs to
+   * \param[in] t mapped tensor
+   * \return 0 if this processor holds the primary copy of its block of t
+   */
+  static int calc_idx_lyr(tensor const * t){
+    int idx_lyr = t->wrld->rank;
+    for (int i=0; i<t->order; i++){
+      mapping const * map = t->edge_map+i;
+      for (;;){
+        if (map->type == PHYSICAL_MAP)
+          idx_lyr -= t->topo->lda[map->cdt]*t->topo->dim_comm[map->cdt].rank;
+        if (!map->has_child) break;
+        map = map->child;
+      }
+    }
+    return idx_lyr;
+  }
+
+  bool spmspv_applicable(contraction const * ctr){
+    tensor * M, * x;
+    bool M_is_A;
+    if (ctr->is_custom) return false;
+    int ic = get_spmspv_operands(ctr, M, x, M_is_A);
+    if (ic == -1) return false;
+    tensor * C = ctr->C;
+    if (!M->is_sparse || M->sym[0] != NS) return false;
+    if (M->wrld != x->wrld || M->wrld != C->wrld) return false;
+    if (!M->is_mapped || !x->is_mapped || !C->is_mapped) return false;
+    if (M->is_folded || x->is_folded || C->is_folded) return false;
+    if (M->has_zero_edge_len || x->has_zero_edge_len || C->has_zero_edge_len) return false;
+    if (!C->sr->has_mul()) return false;
+    //the vectors are read and written locally, so each entry must have a single owner
+    if (x->calc_npe() < x->wrld->np || C->calc_npe() < C->wrld->np) return false;
+    if (!C->sr->has_same_ops(M->sr) || !C->sr->has_same_ops(x->sr)) return false;
+    //a mask must select entries of the output vector, its nonzeros are read locally like those of x
+    if (ctr->mask != NULL){
+      tensor * mask = ctr->mask;
+      if (mask->order != 1 || mask->wrld != M->wrld) return false;
+      if (!mask->is_mapped || mask->is_folded || mask->has_zero_edge_len) return false;
+    }
+    return true;
+  }
+
+  /**
+   * \brief sends each item, which starts with an int64_t key, to every processor p with all_res[p] == key%pp
+   * \param[in] items n items of isz bytes each
+   * \param[in] n number of items
+   * \param[in] isz size of each item in bytes
+   * \param[in] pp number of residues
+   * \param[in] all_res residue needed by each processor, -1 for none
+   * \param[in] cdt communicator over which all_res is defined
+   * \param[out] nrecv number of items received
+   * \return buffer of received items
+   */
+  static char * route_by_residue(char const * items,
+                                 int64_t      n,
+                                 int64_t      isz,
+                                 int          pp,
+                                 int const *  all_res,
+                                 CommData &   cdt,
+                                 int64_t &    nrecv){
+    int np = cdt.np;
+    int64_t * send_counts = (int64_t*)alloc(sizeof(int64_t)*np);
+    int64_t * send_displs = (int64_t*)alloc(sizeof(int64_t)*np);
+    int64_t * recv_counts = (int64_t*)alloc(sizeof(int64_t)*np);
+    int64_t * recv_displs = (int64_t*)alloc(sizeof(int64_t)*np);
+    int64_t * res_cnt = (int64_t*)alloc(sizeof(int64_t)*pp);
+    std::fill(res_cnt, res_cnt+pp, 0);
+    for (int64_t i=0; i<n; i++){
+      res_cnt[((int64_t const*)(items+isz*i))[0]%pp]++;
+    }
+    for (int p=0; p<np; p++){
+      send_counts[p] = all_res[p] == -1 ? 0 : res_cnt[all_res[p]];
+      send_displs[p] = p == 0 ? 0 : send_displs[p-1]+send_counts[p-1];
+    }
+    int64_t nsend = send_displs[np-1]+send_counts[np-1];
+    char * send_buf = (char*)alloc(isz*std::max(nsend,(int64_t)1));
+    int64_t * res_off = (int64_t*)alloc(sizeof(int64_t)*pp);
+    for (int r=0; r<pp; r++){
+      res_off[r] = r == 0 ? 0 : res_off[r-1]+res_cnt[r-1];
+    }
+    //group the items by residue once, then copy each group to every processor that needs it
+    char * res_buf = (char*)alloc(isz*std::max(n,(int64_t)1));
+    for (int64_t i=0; i<n; i++){
+      memcpy(res_buf+isz*(res_off[((int64_t const*)(items+isz*i))[0]%pp]++), items+isz*i, isz);
+    }
+    for (int p=0; p<np; p++){
+      if (send_counts[p] > 0){
+        int r = all_res[p];
+        memcpy(send_buf+isz*send_displs[p], res_buf+isz*(res_off[r]-res_cnt[r]), isz*send_counts[p]);
+      }
+    }
+    cdealloc(res_buf);
+    cdealloc(res_off);
+    cdealloc(res_cnt);
+    MPI_Alltoall(send_counts, 1, MPI_INT64_T, recv_counts, 1, MPI_INT64_T, cdt.cm);
+    for (int p=0; p<np; p++){
+      recv_displs[p] = p == 0 ? 0 : recv_displs[p-1]+recv_counts[p-1];
+    }
+    nrecv = recv_displs[np-1]+recv_counts[np-1];
+    char * recv_buf = (char*)alloc(isz*std::max(nrecv,(int64_t)1));
+    cdt.all_to_allv(send_buf, send_counts, send_displs, isz,
+                    recv_buf, recv_counts, recv_displs);
+    cdealloc(send_buf);
+    cdealloc(send_counts);
+    cdealloc(send_displs);
+    cdealloc(recv_counts);
+    cdealloc(recv_displs);
+    return recv_buf;
+  }
+
+  /**
+   * \brief sorts products by key and sums those with the same key
+   * \param[in] sr algebraic structure of the products
+   * \param[in,out] prods nprod key-value pairs, on output the first entries are the combined pairs
+   * \param[in] nprod number of products
+   * \return number of combined pairs
+   */
+  static int64_t combine_products(algstrct const * sr,
+                                  char *           prods,
+                                  int64_t          nprod){
+    int64_t psz = sr->pair_size();
+    int64_t nout = 0;
+    if (nprod > 0){
+      PairIterator pprod(sr, prods);
+      pprod.sort(nprod);
+      for (int64_t i=1; i<nprod; i++){
+        if (pprod[i].k() == pprod[nout].k())
+          sr->add(pprod[nout].d(), pprod[i].d(), pprod[nout].d());
+        else {
+          nout++;
+          if (nout != i) memcpy(pprod[nout].ptr, pprod[i].ptr, psz);
+        }
+      }
+      nout++;
+    }
+    return nout;
+  }
+
+  /**
+   * \brief applies beta of ctr to its output, then accumulates alpha times the products into it
+   * \param[in] ctr contraction whose output is written
+   * \param[in] nout number of products
+   * \param[in] prods key-value pairs of the output, deallocated here
+   */
+  static void write_products(contraction const * ctr,
+                             int64_t             nout,
+                             char *              prods){
+    tensor * C = ctr->C;
+    algstrct const * sr = C->sr;
+    if (sr->isequal(ctr->beta, sr->addid())){
+      C->set_zero();
+    } else if (!sr->isequal(ctr->beta, sr->mulid())){
+      int idx[C->order];
+      for (int i=0; i<C->order; i++) idx[i] = i;
+      scaling scl(C, idx, ctr->beta);
+      scl.execute();
+    }
+    C->write(nout, ctr->alpha, sr->mulid(), prods);
+    if (prods != NULL) cdealloc(prods);
+  }
+
+  void spmspv(contraction const * ctr){
+    TAU_FSTART(spmspv);
+    tensor * M, * x;
+    bool M_is_A;
+    int ic = get_spmspv_operands(ctr, M, x, M_is_A);
+    ASSERT(ic != -1);
+    tensor * C = ctr->C;
+    tensor * mask = ctr->mask;
+    algstrct const * sr = C->sr;
+    int64_t psz = sr->pair_size();
+    CommData & cdt = M->wrld->cdt;
+    int np = cdt.np;
+    int64_t len_c = M->lens[ic];
+    int64_t lda_c = ic == 0 ? 1 : M->lens[0];
+    int64_t len_r = M->lens[1-ic];
+    int64_t lda_r = ic == 0 ? M->lens[0] : 1;
+
+    //read the nonzeros of the vector and of the mask before C, which may alias either, is modified,
+    //x is not replicated (see spmspv_applicable), so each nonzero is read by exactly one processor,
+    //while of a replicated mask only the first layer is read
+    ASSERT(x->calc_npe() == x->wrld->np);
+    int64_t nx;
+    char * x_pairs;
+    x->read_local_nnz(&nx, &x_pairs);
+    int64_t nm = 0;
+    int64_t * m_keys = NULL;
+    if (mask != NULL && calc_idx_lyr(mask) == 0){
+      char * m_pairs;
+      mask->read_local_nnz(&nm, &m_pairs);
+      m_keys = (int64_t*)alloc(sizeof(int64_t)*std::max(nm,(int64_t)1));
+      ConstPairIterator pm(mask->sr, m_pairs);
+      for (int64_t i=0; i<nm; i++){
+        m_keys[i] = pm[i].k();
+      }
+      if (nm > 0) cdealloc(m_pairs);
+    }
+
+    //the processors that own matrix columns (rows) of each residue modulo the physical phase of the
+    //contracted (output) mode, only processors on the first layer of a replicated matrix take part
+    mapping const * cmap = M->edge_map+ic;
+    mapping const * rmap = M->edge_map+1-ic;
+    int pp = cmap->calc_phys_phase();
+    int ppr = rmap->calc_phys_phase();
+    int my_cr = cmap->calc_phys_rank(M->topo);
+    int my_rr = rmap->calc_phys_rank(M->topo);
+    if (calc_idx_lyr(M) != 0){
+      my_cr = -1;
+      my_rr = -1;
+    }
+    int * all_cr = (int*)alloc(sizeof(int)*np);
+    MPI_Allgather(&my_cr, 1, MPI_INT, all_cr, 1, MPI_INT, cdt.cm);
+
+    //send each active vector entry only to the owners of the matrix columns it multiplies
+    int64_t nact;
+    char * act = route_by_residue(x_pairs, nx, psz, pp, all_cr, cdt, nact);
+    if (nx > 0) cdealloc(x_pairs);
+    cdealloc(all_cr);
+
+    //send each mask entry only to the owners of the matrix rows it selects, so that products outside
+    //the mask are never formed
+    int64_t nmr = 0;
+    int64_t * m_rows = NULL;
+    bool * row_in = NULL;
+    int64_t nloc_r = std::max((int64_t)1, (len_r+ppr-1)/ppr);
+    if (mask != NULL){
+      int * all_rr = (int*)alloc(sizeof(int)*np);
+      MPI_Allgather(&my_rr, 1, MPI_INT, all_rr, 1, MPI_INT, cdt.cm);
+      m_rows = (int64_t*)route_by_residue((char*)m_keys, nm, sizeof(int64_t), ppr, all_rr, cdt, nmr);
+      cdealloc(all_rr);
+      cdealloc(m_keys);
+      std::sort(m_rows, m_rows+nmr);
+      nmr = std::unique(m_rows, m_rows+nmr)-m_rows;
+      row_in = (bool*)alloc(sizeof(bool)*nloc_r);
+      std::fill(row_in, row_in+nloc_r, false);
+      for (int64_t i=0; i<nmr; i++){
+        row_in[m_rows[i]/ppr] = true;
+      }
+    }
+    bool mask_cmp = ctr->mask_cmp;
+    auto keep_row = [&](int64_t r){ return row_in == NULL || row_in[r/ppr] != mask_cmp; };
+
+    //multiply the local matrix nonzeros with the active entries, pushing from the columns of the active
+    //entries when the local columns are contiguous (keys sorted within virtual blocks with contracted mode
+    //last) and there are few active entries, pulling by a scan over the local nonzeros otherwise,
+    //or, if the local rows are contiguous and the mask admits few of them, scanning only the admitted rows
+    int64_t nnz_M = my_cr == -1 ? 0 : M->nnz_loc;
+    int64_t nvirt = M->calc_nvirt();
+    int64_t nloc_c = std::max((int64_t)1, (len_c+pp-1)/pp);
+    double push_ps[] = {1.0, (double)nact*nvirt*log2(nnz_M+1)+((double)nnz_M*nact)/nloc_c};
+    double pull_ps[] = {1.0, (double)nnz_M+nloc_c};
+    bool by_row = ic == 0 && mask != NULL && !mask_cmp && (double)nmr*nvirt*log2(nnz_M+1) < (double)nnz_M;
+    bool push = !by_row && ic == 1 && spmspv_push_mdl.est_time(push_ps) < spmspv_pull_mdl.est_time(pull_ps);
+
+    double st_time = MPI_Wtime();
+    char * prods = NULL;
+    int64_t nprod = 0;
+    ConstPairIterator pM(sr, M->data);
+    ConstPairIterator pact(sr, act);
+    if (nnz_M > 0 && nact > 0){
+      if (push){
+        //find the range of local nonzeros in the column of each active entry within each virtual block,
+        //then size the output once for all products
+        PairIterator(sr, act).sort(nact);
+        int64_t * rng = (int64_t*)alloc(sizeof(int64_t)*2*nvirt*nact);
+        int64_t off = 0;
+        for (int64_t v=0; v<nvirt; v++){
+          int64_t nb = M->nnz_blk[v];
+          for (int64_t a=0; a<nact; a++){
+            int64_t lo = pact[a].k()*lda_c;
+            int64_t hi = lo+lda_c;
+            int64_t s = off, e = off+nb;
+            while (s < e){
+              int64_t mid = s+(e-s)/2;
+              if (pM[mid].k() < lo) s = mid+1;
+              else e = mid;
+            }
+            e = s;
+            while (e < off+nb && pM[e].k() < hi){
+              if (keep_row((pM[e].k()/lda_r)%len_r)) nprod++;
+              e++;
+            }
+            rng[2*(v*nact+a)]   = s;
+            rng[2*(v*nact+a)+1] = e;
+          }
+          off += nb;
+        }
+        prods = (char*)alloc(psz*std::max(nprod,(int64_t)1));
+        int64_t iprod = 0;
+        for (int64_t v=0; v<nvirt; v++){
+          for (int64_t a=0; a<nact; a++){
+            for (int64_t i=rng[2*(v*nact+a)]; i<rng[2*(v*nact+a)+1]; i++){
+              int64_t r = (pM[i].k()/lda_r)%len_r;
+              if (!keep_row(r)) continue;
+              char * pr = prods+psz*iprod;
+              ((int64_t*)pr)[0] = r;
+              if (M_is_A) sr->mul(pM[i].d(), pact[a].d(), pr+sizeof(int64_t));
+              else sr->mul(pact[a].d(), pM[i].d(), pr+sizeof(int64_t));
+              iprod++;
+            }
+          }
+        }
+        cdealloc(rng);
+      } else {
+        char * x_loc = (char*)alloc(sr->el_size*nloc_c);
+        bool * x_act = (bool*)alloc(sizeof(bool)*nloc_c);
+        std::fill(x_act, x_act+nloc_c, false);
+        for (int64_t a=0; a<nact; a++){
+          int64_t j = pact[a].k()/pp;
+          memcpy(x_loc+sr->el_size*j, pact[a].d(), sr->el_size);
+          x_act[j] = true;
+        }
+        //the ranges of local nonzeros to scan, either all of each virtual block or the admitted rows in each
+        int64_t nrng = by_row ? nvirt*nmr : 1;
+        int64_t * rng = (int64_t*)alloc(sizeof(int64_t)*2*nrng);
+        if (by_row){
+          int64_t off = 0;
+          for (int64_t v=0; v<nvirt; v++){
+            int64_t nb = M->nnz_blk[v];
+            for (int64_t m=0; m<nmr; m++){
+              int64_t lo = m_rows[m]*lda_r;
+              int64_t hi = lo+lda_r;
+              int64_t s = off, e = off+nb;
+              while (s < e){
+                int64_t mid = s+(e-s)/2;
+                if (pM[mid].k() < lo) s = mid+1;
+                else e = mid;
+              }
+              e = s;
+              while (e < off+nb && pM[e].k() < hi) e++;
+              rng[2*(v*nmr+m)]   = s;
+              rng[2*(v*nmr+m)+1] = e;
+            }
+            off += nb;
+          }
+        } else {
+          rng[0] = 0;
+          rng[1] = nnz_M;
+        }
+        //count the products first so that the output is allocated once
+        for (int64_t g=0; g<nrng; g++){
+          for (int64_t i=rng[2*g]; i<rng[2*g+1]; i++){
+            if (x_act[((pM[i].k()/lda_c)%len_c)/pp] && keep_row((pM[i].k()/lda_r)%len_r)) nprod++;
+          }
+        }
+        prods = (char*)alloc(psz*std::max(nprod,(int64_t)1));
+        int64_t iprod = 0;
+        for (int64_t g=0; g<nrng; g++){
+          for (int64_t i=rng[2*g]; i<rng[2*g+1]; i++){
+            int64_t j = ((pM[i].k()/lda_c)%len_c)/pp;
+            int64_t r = (pM[i].k()/lda_r)%len_r;
+            if (!x_act[j] || !keep_row(r)) continue;
+            char * pr = prods+psz*iprod;
+            ((int64_t*)pr)[0] = r;
+            if (M_is_A) sr->mul(pM[i].d(), x_loc+sr->el_size*j, pr+sizeof(int64_t));
+            else sr->mul(x_loc+sr->el_size*j, pM[i].d(), pr+sizeof(int64_t));
+            iprod++;
+          }
+        }
+        cdealloc(rng);
+        cdealloc(x_act);
+        cdealloc(x_loc);
+      }
+    }
+    cdealloc(act);
+    if (mask != NULL){
+      cdealloc(m_rows);
+      cdealloc(row_in);
+    }
+    int64_t nout = combine_products(sr, prods, nprod);
+    double exe_time = MPI_Wtime()-st_time;
+    //the row-restricted scan is not described by either model
+    if (push){
+      double tps[] = {exe_time, push_ps[0], push_ps[1]};
+      spmspv_push_mdl.observe(tps);
+    } else if (!by_row){
+      double tps[] = {exe_time, pull_ps[0], pull_ps[1]};
+      spmspv_pull_mdl.observe(tps);
+    }
+    write_products(ctr, nout, prods);
+    TAU_FSTOP(spmspv);
+  }
+
+  /**
+   * \brief determines the roles of the operands of a masked product of two matrices into a matrix,
+   *        S is the sparse operand whose data is not moved, Y the operand whose entries are sent to S
+   * \param[out] ic_S mode of S that is contracted
+   * \param[out] ic_Y mode of Y that is contracted
+   * \param[out] ir_C mode of C that is the other mode of S
+   * \param[out] ir_mask mode of the mask that is the other mode of S
+   * \return false if ctr is not of the right form
+   */
+  static bool get_masked_spgemm_operands(contraction const * ctr,
+                                         tensor *&           S,
+                                         tensor *&           Y,
+                                         bool &              S_is_A,
+                                         int &               ic_S,
+                                         int &               ic_Y,
+                                         int &               ir_C,
+                                         int &               ir_mask){
+    tensor * A = ctr->A, * B = ctr->B, * C = ctr->C;
+    if (ctr->mask == NULL || ctr->mask->order != 2) return false;
+    if (A->order != 2 || B->order != 2 || C->order != 2) return false;
+    if (ctr->idx_A[0] == ctr->idx_A[1] || ctr->idx_B[0] == ctr->idx_B[1] || ctr->idx_C[0] == ctr->idx_C[1]) return false;
+    if (A->is_sparse && (!B->is_sparse || A->nnz_tot >= B->nnz_tot)) S_is_A = true;
+    else if (B->is_sparse) S_is_A = false;
+    else return false;
+    S = S_is_A ? A : B;
+    Y = S_is_A ? B : A;
+    int const * idx_S = S_is_A ? ctr->idx_A : ctr->idx_B;
+    int const * idx_Y = S_is_A ? ctr->idx_B : ctr->idx_A;
+    ic_S = -1;
+    ic_Y = -1;
+    for (int i=0; i<2; i++){
+      for (int j=0; j<2; j++){
+        if (idx_S[i] == idx_Y[j]){
+          if (ic_S != -1) return false;
+          ic_S = i;
+          ic_Y = j;
+        }
+      }
+    }
+    if (ic_S == -1) return false;
+    if (ctr->idx_C[0] == idx_S[1-ic_S] && ctr->idx_C[1] == idx_Y[1-ic_Y]) ir_C = 0;
+    else if (ctr->idx_C[1] == idx_S[1-ic_S] && ctr->idx_C[0] == idx_Y[1-ic_Y]) ir_C = 1;
+    else return false;
+    ir_mask = ctr->idx_mask[0] == idx_S[1-ic_S] ? 0 : 1;
+    return true;
+  }
+
+  bool masked_spgemm_applicable(contraction const * ctr){
+    tensor * S, * Y;
+    bool S_is_A;
+    int ic_S, ic_Y, ir_C, ir_mask;
+    if (ctr->is_custom) return false;
+    if (!get_masked_spgemm_operands(ctr, S, Y, S_is_A, ic_S, ic_Y, ir_C, ir_mask)) return false;
+    tensor * C = ctr->C;
+    tensor * mask = ctr->mask;
+    tensor * ts[] = {S, Y, C, mask};
+    for (int t=0; t<4; t++){
+      if (ts[t]->wrld != S->wrld || ts[t]->sym[0] != NS) return false;
+      if (!ts[t]->is_mapped || ts[t]->is_folded || ts[t]->has_zero_edge_len) return false;
+    }
+    if (!C->sr->has_mul()) return false;
+    if (!C->sr->has_same_ops(S->sr) || !C->sr->has_same_ops(Y->sr)) return false;
+    return true;
+  }
+
+  void masked_spgemm(contraction const * ctr){
+    TAU_FSTART(masked_spgemm);
+    tensor * S, * Y;
+    bool S_is_A;
+    int ic_S, ic_Y, ir_C, ir_mask;
+    bool is_pr = get_masked_spgemm_operands(ctr, S, Y, S_is_A, ic_S, ic_Y, ir_C, ir_mask);
+    ASSERT(is_pr);
+    tensor * C = ctr->C;
+    tensor * mask = ctr->mask;
+    algstrct const * sr = C->sr;
+    int64_t psz = sr->pair_size();
+    CommData & cdt = S->wrld->cdt;
+    int np = cdt.np;
+    int64_t len_k = S->lens[ic_S];
+    int64_t len_r = S->lens[1-ic_S];
+    int64_t len_f = Y->lens[1-ic_Y];
+
+    //read the nonzeros of Y and of the mask before C, which may alias either, is modified,
+    //of replicated tensors only the first layer is read
+    int64_t ny = 0;
+    char * y_pairs = NULL;
+    if (calc_idx_lyr(Y) == 0) Y->read_local_nnz(&ny, &y_pairs);
+    int64_t nm = 0;
+    int64_t * m_keys = NULL;
+    if (calc_idx_lyr(mask) == 0){
+      char * m_pairs;
+      mask->read_local_nnz(&nm, &m_pairs);
+      m_keys = (int64_t*)alloc(sizeof(int64_t)*std::max(nm,(int64_t)1));
+      ConstPairIterator pm(mask->sr, m_pairs);
+      for (int64_t i=0; i<nm; i++){
+        m_keys[i] = pm[i].k();
+      }
+      if (nm > 0) cdealloc(m_pairs);
+    }
+
+    //the processors that own the contracted (other) mode of S for each residue modulo its physical phase,
+    //only processors on the first layer of a replicated S take part
+    mapping const * cmap = S->edge_map+ic_S;
+    mapping const * rmap = S->edge_map+1-ic_S;
+    int pp = cmap->calc_phys_phase();
+    int ppr = rmap->calc_phys_phase();
+    int my_cr = cmap->calc_phys_rank(S->topo);
+    int my_rr = rmap->calc_phys_rank(S->topo);
+    if (calc_idx_lyr(S) != 0){
+      my_cr = -1;
+      my_rr = -1;
+    }
+    int * all_res = (int*)alloc(sizeof(int)*np);
+
+    //send each entry Y[k,f] to the owners of the columns k of S, keyed so that the key has the residue of k
+    int64_t pad_k = ((len_k+pp-1)/pp)*pp;
+    ConstPairIterator py(sr, y_pairs);
+    for (int64_t i=0; i<ny; i++){
+      int64_t k = ic_Y == 0 ? py[i].k()%Y->lens[0] : py[i].k()/Y->lens[0];
+      int64_t f = ic_Y == 0 ? py[i].k()/Y->lens[0] : py[i].k()%Y->lens[0];
+      ((int64_t*)py[i].ptr)[0] = k+pad_k*f;
+    }
+    MPI_Allgather(&my_cr, 1, MPI_INT, all_res, 1, MPI_INT, cdt.cm);
+    int64_t nyr;
+    char * yr = route_by_residue(y_pairs, ny, psz, pp, all_res, cdt, nyr);
+    if (ny > 0) cdealloc(y_pairs);
+
+    //send each mask entry M[r,f] to the owners of the rows r of S
+    int64_t pad_r = ((len_r+ppr-1)/ppr)*ppr;
+    for (int64_t i=0; i<nm; i++){
+      int64_t r = ir_mask == 0 ? m_keys[i]%mask->lens[0] : m_keys[i]/mask->lens[0];
+      int64_t f = ir_mask == 0 ? m_keys[i]/mask->lens[0] : m_keys[i]%mask->lens[0];
+      m_keys[i] = r+pad_r*f;
+    }
+    MPI_Allgather(&my_rr, 1, MPI_INT, all_res, 1, MPI_INT, cdt.cm);
+    int64_t nmr;
+    int64_t * m_rows = (int64_t*)route_by_residue((char*)m_keys, nm, sizeof(int64_t), ppr, all_res, cdt, nmr);
+    if (m_keys != NULL) cdealloc(m_keys);
+    cdealloc(all_res);
+
+    double st_time = MPI_Wtime();
+    //order the received entries of Y by (k,f) and those of the mask by (r,f), so that the entries in a
+    //column of S and in a row of the mask are contiguous and ordered by f
+    PairIterator pyr(sr, yr);
+    for (int64_t i=0; i<nyr; i++){
+      int64_t k = pyr[i].k()%pad_k;
+      ((int64_t*)pyr[i].ptr)[0] = k*len_f+pyr[i].k()/pad_k;
+    }
+    pyr.sort(nyr);
+    int64_t * y_keys = (int64_t*)alloc(sizeof(int64_t)*std::max(nyr,(int64_t)1));
+    for (int64_t i=0; i<nyr; i++){
+      y_keys[i] = pyr[i].k();
+    }
+    for (int64_t i=0; i<nmr; i++){
+      m_rows[i] = (m_rows[i]%pad_r)*len_f+m_rows[i]/pad_r;
+    }
+    std::sort(m_rows, m_rows+nmr);
+    nmr = std::unique(m_rows, m_rows+nmr)-m_rows;
+
+    //for each local nonzero S[r,k], multiply it with the entries Y[k,f] for which M[r,f] is (or, for a
+    //complemented mask, is not) nonzero, merging from the shorter of the two lists, so that products
+    //outside the mask are never formed
+    bool mask_cmp = ctr->mask_cmp;
+    int64_t nnz_S = my_cr == -1 ? 0 : S->nnz_loc;
+    ConstPairIterator pS(sr, S->data);
+    int64_t const * ye_all = y_keys+nyr;
+    int64_t const * me_all = m_rows+nmr;
+    auto visit = [&](int64_t iS, std::function<void(int64_t, int64_t)> fn){
+      int64_t r = ic_S == 0 ? pS[iS].k()/S->lens[0] : pS[iS].k()%S->lens[0];
+      int64_t k = ic_S == 0 ? pS[iS].k()%S->lens[0] : pS[iS].k()/S->lens[0];
+      int64_t const * ys = std::lower_bound(y_keys, y_keys+nyr, k*len_f);
+      int64_t const * ye = std::lower_bound(ys, ye_all, (k+1)*len_f);
+      int64_t const * ms = std::lower_bound(m_rows, m_rows+nmr, r*len_f);
+      int64_t const * me = std::lower_bound(ms, me_all, (r+1)*len_f);
+      if (!mask_cmp && me-ms < ye-ys){
+        for (int64_t const * m=ms; m<me; m++){
+          int64_t const * y = std::lower_bound(ys, ye, k*len_f+(*m-r*len_f));
+          if (y != ye && *y-k*len_f == *m-r*len_f) fn(y-y_keys, r);
+        }
+      } else {
+        for (int64_t const * y=ys; y<ye; y++){
+          int64_t const * m = std::lower_bound(ms, me, r*len_f+(*y-k*len_f));
+          bool in_mask = m != me && *m-r*len_f == *y-k*len_f;
+          if (in_mask != mask_cmp) fn(y-y_keys, r);
+        }
+      }
+    };
+    int64_t nprod = 0;
+    for (int64_t i=0; i<nnz_S; i++){
+      visit(i, [&](int64_t iy, int64_t r){ nprod++; });
+    }
+    char * prods = (char*)alloc(psz*std::max(nprod,(int64_t)1));
+    int64_t iprod = 0;
+    for (int64_t i=0; i<nnz_S; i++){
+      visit(i, [&](int64_t iy, int64_t r){
+        int64_t f = y_keys[iy]%len_f;
+        char * pr = prods+psz*iprod;
+        ((int64_t*)pr)[0] = ir_C == 0 ? r+f*C->lens[0] : f+r*C->lens[0];
+        if (S_is_A) sr->mul(pS[i].d(), pyr[iy].d(), pr+sizeof(int64_t));
+        else sr->mul(pyr[iy].d(), pS[i].d(), pr+sizeof(int64_t));
+        iprod++;
+      });
+    }
+    cdealloc(y_keys);
+    cdealloc(yr);
+    cdealloc(m_rows);
+    int64_t nout = combine_products(sr, prods, nprod);
+    kernel_time_add(MPI_Wtime()-st_time);
+    write_products(ctr, nout, prods);
+    TAU_FSTOP(masked_spgemm);
+  }
+}
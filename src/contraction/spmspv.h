@@ -0,0 +1,50 @@
+/*Copyright (c) 2011, Edgar Solomonik, all rights reserved.*/
+
+#ifndef __SPMSPV_H__
+#define __SPMSPV_H__
+
+#include "../interface/common.h"
+
+namespace CTF_int {
+  class contraction;
+
+  /**
+   * \brief returns true if the contraction is a product of a sparse nonsymmetric matrix and a vector
+   *        into a vector (e.g. C["i"] += A["ij"]*B["j"] or C["j"] += B["i"]*A["ij"]) that can be
+   *        executed by spmspv(), possibly with a mask on the output vector
+   * \param[in] ctr contraction to check, operands must be unfolded
+   */
+  bool spmspv_applicable(contraction const * ctr);
+
+  /**
+   * \brief executes a sparse matrix times vector contraction without remapping any operands,
+   *        only the nonzeros of the vector are sent and each is sent only to the processors that own
+   *        the matrix columns it multiplies, locally either the columns of the received entries are
+   *        searched for (push, for a small active set) or all local nonzeros of the matrix are
+   *        scanned (pull, for a dense active set), choosing by performance model,
+   *        if ctr has a mask, its nonzeros are sent to the owners of the matrix rows they select and
+   *        products in rows outside the mask are never formed
+   * \param[in] ctr contraction for which spmspv_applicable() returned true
+   */
+  void spmspv(contraction const * ctr);
+
+  /**
+   * \brief returns true if the contraction is a masked product of two nonsymmetric matrices into a matrix
+   *        (e.g. C["ij"].masked(M) += A["ik"]*B["kj"]), at least one of which is sparse, that can be
+   *        executed by masked_spgemm()
+   * \param[in] ctr contraction to check, operands and mask must be unfolded
+   */
+  bool masked_spgemm_applicable(contraction const * ctr);
+
+  /**
+   * \brief executes a masked product of matrices without remapping the sparse operand S, each entry of
+   *        the other operand is sent to the processors that own the columns of S it multiplies and each
+   *        nonzero of the mask to the processors that own the rows of S it selects, locally a nonzero
+   *        of S is multiplied only with the entries that give products in the mask (or, for a complemented
+   *        mask, outside it), so that products outside the mask are never formed or communicated
+   * \param[in] ctr contraction for which masked_spgemm_applicable() returned true
+   */
+  void masked_spgemm(contraction const * ctr);
+}
+
+#endif
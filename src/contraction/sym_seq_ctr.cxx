@@ -6,8 +6,377 @@
 #include "../shared/offload.h"
 #include "../shared/util.h"
 
+//block size of the dimensions of gemm tiles on packed symmetric pairs
+#define SYM_SEQ_CTR_TILE_LEN 128
+
 namespace CTF_int{
-  
+
+  /**
+   * \brief innermost indices of sym_seq_ctr_loop that are done by a single kernel call rather than elementwise
+   *        mul and add calls, either one index that is nonsymmetric in all operands, done by a strided
+   *        algstrct::hadamard, or a gemm tile of indices one of whose operands stores two of them as a packed
+   *        symmetric pair, which is contracted by gemms on blocks copied out of the packed storage
+   */
+  struct sym_seq_ctr_blk {
+    /** \brief number of innermost indices done by run(), 1 for the strided kernel, 2 or 3 for a gemm tile */
+    int nidx;
+    /** \brief range of the index of the strided kernel */
+    int n;
+    /** \brief strides (in elements) of the index in A, B and C, zero for operands it does not appear in */
+    int inc_A, inc_B, inc_C;
+    /** \brief ranges of the gemm tile dimensions m (in A and C), n (in B and C) and k (in A and B), 1 if absent */
+    int len[3];
+    /** \brief strides (in elements) of the gemm tile dimensions in A, B and C, zero where they do not appear */
+    int64_t str[3][3];
+    /** \brief operand (0 for A, 1 for B, 2 for C) storing the dimensions pair_lo<=pair_hi as a packed pair */
+    int pair_op;
+    int pair_lo, pair_hi;
+    /** \brief stride (in elements) of the lower index of the packed pair */
+    int pair_str;
+
+    /** \brief offset (in elements) in operand t of the entry with gemm tile indices v */
+    int64_t offset(int t, int const * v) const {
+      if (t == pair_op){
+        int64_t h = v[pair_hi];
+        return (h*(h+1)/2 + v[pair_lo])*pair_str;
+      }
+      return v[0]*str[t][0] + v[1]*str[t][1] + v[2]*str[t][2];
+    }
+
+    /** \brief whether the block of the gemm tile starting at v0 of ranges nv has no entries of the packed pair */
+    bool is_empty(int const * v0, int const * nv) const {
+      return pair_op != -1 && v0[pair_lo] > v0[pair_hi]+nv[pair_hi]-1;
+    }
+
+    /**
+     * \brief copies the block starting at v0 of ranges nv of operand t into the column-major buffer buf, or
+     *        back from it if unpack, entries of the packed pair outside of its range are set to zero in buf
+     */
+    void pack(int              t,
+              char *           X,
+              int const *      v0,
+              int const *      nv,
+              char *           buf,
+              bool             unpack,
+              algstrct const * sr) const {
+      //A is m-by-k, B is k-by-n, and C is m-by-n
+      int const rows[] = {0, 2, 0};
+      int const cols[] = {2, 1, 1};
+      int nr = nv[rows[t]];
+      int v[3];
+      memcpy(v, v0, 3*sizeof(int));
+      if (t != pair_op){
+        for (int c=0; c<nv[cols[t]]; c++){
+          v[cols[t]] = v0[cols[t]]+c;
+          char * x = X+offset(t, v)*sr->el_size;
+          if (unpack)
+            sr->copy(nr, buf+c*nr*sr->el_size, 1, x, str[t][rows[t]]);
+          else
+            sr->copy(nr, x, str[t][rows[t]], buf+c*nr*sr->el_size, 1);
+        }
+      } else {
+        if (!unpack) sr->set(buf, sr->addid(), nr*nv[cols[t]]);
+        //the entries lo<=hi of the pair are contiguous (with the stride of lo) for each hi
+        int inc_lo = pair_lo == rows[t] ? 1 : nr;
+        int inc_hi = pair_lo == rows[t] ? nr : 1;
+        for (int h=0; h<nv[pair_hi]; h++){
+          v[pair_hi] = v0[pair_hi]+h;
+          int cnt = std::min(nv[pair_lo], v[pair_hi]+1-v0[pair_lo]);
+          if (cnt <= 0) continue;
+          char * x = X+offset(t, v)*sr->el_size;
+          char * b = buf+h*inc_hi*sr->el_size;
+          if (unpack)
+            sr->copy(cnt, b, inc_lo, x, pair_str);
+          else
+            sr->copy(cnt, x, pair_str, b, inc_lo);
+        }
+      }
+    }
+
+    void run(char const *     alpha,
+             char const *     A,
+             char const *     B,
+             char *           C,
+             algstrct const * sr) const {
+      if (nidx == 1){
+        if (alpha == NULL || sr->isequal(alpha, sr->mulid())){
+          sr->hadamard(n, NULL, A, inc_A, B, inc_B, C, inc_C);
+          CTF_FLOPS_ADD(2*n);
+        } else {
+          sr->hadamard(n, alpha, A, inc_A, B, inc_B, C, inc_C);
+          CTF_FLOPS_ADD(3*n);
+        }
+        return;
+      }
+      int bl[3];
+      for (int d=0; d<3; d++) bl[d] = std::min(len[d], SYM_SEQ_CTR_TILE_LEN);
+      char * buf_A = (char*)CTF_int::alloc(((int64_t)bl[0])*bl[2]*sr->el_size);
+      char * buf_B = (char*)CTF_int::alloc(((int64_t)bl[2])*bl[1]*sr->el_size);
+      char * buf_C = (char*)CTF_int::alloc(((int64_t)bl[0])*bl[1]*sr->el_size);
+      int v0[3], nv[3];
+      for (v0[0]=0; v0[0]<len[0]; v0[0]+=bl[0]){
+        nv[0] = std::min(bl[0], len[0]-v0[0]);
+        for (v0[1]=0; v0[1]<len[1]; v0[1]+=bl[1]){
+          nv[1] = std::min(bl[1], len[1]-v0[1]);
+          v0[2] = 0;
+          nv[2] = len[2];
+          if (is_empty(v0, nv)) continue;
+          pack(2, C, v0, nv, buf_C, false, sr);
+          for (v0[2]=0; v0[2]<len[2]; v0[2]+=bl[2]){
+            nv[2] = std::min(bl[2], len[2]-v0[2]);
+            if (is_empty(v0, nv)) continue;
+            pack(0, (char*)A, v0, nv, buf_A, false, sr);
+            pack(1, (char*)B, v0, nv, buf_B, false, sr);
+            sr->gemm('N', 'N', nv[0], nv[1], nv[2], alpha == NULL ? sr->mulid() : alpha, buf_A, buf_B, sr->mulid(), buf_C);
+            CTF_FLOPS_ADD(2*((int64_t)nv[0])*nv[1]*nv[2]);
+          }
+          nv[2] = len[2];
+          pack(2, C, v0, nv, buf_C, true, sr);
+        }
+      }
+      cdealloc(buf_A);
+      cdealloc(buf_B);
+      cdealloc(buf_C);
+    }
+  };
+
+  /**
+   * \brief renumbers the indices of a contraction so that the nidx indices in sel are innermost (numbered
+   *        0,...,nidx-1 in the order of sel), keeping the order of the others
+   */
+  static void renumber_inner(int       order_A,
+                             int *     idx_map_A,
+                             int       order_B,
+                             int *     idx_map_B,
+                             int       order_C,
+                             int *     idx_map_C,
+                             int       idx_max,
+                             int       nidx,
+                             int const * sel){
+    int new_idx[idx_max];
+    int nout = nidx;
+    for (int l=0; l<idx_max; l++){
+      new_idx[l] = -1;
+      for (int j=0; j<nidx; j++){
+        if (sel[j] == l) new_idx[l] = j;
+      }
+      if (new_idx[l] == -1) new_idx[l] = nout++;
+    }
+    int orders[] = {order_A, order_B, order_C};
+    int * idx_maps[] = {idx_map_A, idx_map_B, idx_map_C};
+    for (int t=0; t<3; t++){
+      for (int r=0; r<orders[t]; r++){
+        idx_maps[t][r] = new_idx[idx_maps[t][r]];
+      }
+    }
+  }
+
+  /**
+   * \brief finds a gemm tile of a contraction in which an operand stores two indices as a packed symmetric
+   *        pair (a group of two symmetric indices) with different gemm dimensions, i.e. that appear in different
+   *        other operands, so that the loops over the pair and over a third gemm dimension, if any, can be
+   *        done by blocked gemms, the indices of the tile are renumbered to be innermost
+   * \param[in,out] idx_map_A indices of A, renumbered on output if a tile is found
+   * \param[in,out] idx_map_B indices of B, renumbered on output if a tile is found
+   * \param[in,out] idx_map_C indices of C, renumbered on output if a tile is found
+   * \param[in] idx_max total number of indices
+   * \param[out] blk description of the tile, blk.nidx=0 if there is none
+   */
+  static void get_sym_seq_ctr_tile(int              order_A,
+                                   int const *      edge_len_A,
+                                   int const *      sym_A,
+                                   int *            idx_map_A,
+                                   int              order_B,
+                                   int const *      edge_len_B,
+                                   int const *      sym_B,
+                                   int *            idx_map_B,
+                                   int              order_C,
+                                   int const *      edge_len_C,
+                                   int const *      sym_C,
+                                   int *            idx_map_C,
+                                   int              idx_max,
+                                   sym_seq_ctr_blk & blk){
+    int orders[] = {order_A, order_B, order_C};
+    int const * edge_lens[] = {edge_len_A, edge_len_B, edge_len_C};
+    int const * syms[] = {sym_A, sym_B, sym_C};
+    int * idx_maps[] = {idx_map_A, idx_map_B, idx_map_C};
+    int cnt[3][idx_max];
+    int64_t stride[3][idx_max];
+    int len[idx_max];
+    //gemm dimension of each index, -1 if none, and whether it is nonsymmetric in all operands it appears in
+    int dim[idx_max];
+    bool is_ns[idx_max];
+    std::fill(len, len+idx_max, 1);
+    std::fill(is_ns, is_ns+idx_max, true);
+    for (int t=0; t<3; t++){
+      std::fill(cnt[t], cnt[t]+idx_max, 0);
+      std::fill(stride[t], stride[t]+idx_max, 0);
+      for (int r=0; r<orders[t]; r++){
+        int l = idx_maps[t][r];
+        cnt[t][l]++;
+        len[l] = edge_lens[t][r];
+        stride[t][l] = sy_packed_size(r, edge_lens[t], syms[t]);
+        if (syms[t][r] != NS || (r > 0 && syms[t][r-1] != NS) || stride[t][l] > INT_MAX)
+          is_ns[l] = false;
+      }
+    }
+    for (int l=0; l<idx_max; l++){
+      dim[l] = -1;
+      if (cnt[0][l] > 1 || cnt[1][l] > 1 || cnt[2][l] > 1) continue;
+      if (cnt[0][l] && cnt[2][l] && !cnt[1][l]) dim[l] = 0;
+      if (cnt[1][l] && cnt[2][l] && !cnt[0][l]) dim[l] = 1;
+      if (cnt[0][l] && cnt[1][l] && !cnt[2][l]) dim[l] = 2;
+    }
+    blk.nidx = 0;
+    int64_t best_sz = 0;
+    int sel[3];
+    for (int t=0; t<3; t++){
+      for (int r=0; r+1<orders[t]; r++){
+        if (syms[t][r] == NS || syms[t][r+1] != NS || (r > 0 && syms[t][r-1] != NS)) continue;
+        int lo = idx_maps[t][r];
+        int hi = idx_maps[t][r+1];
+        if (dim[lo] == -1 || dim[hi] == -1 || dim[lo] == dim[hi] || stride[t][lo] > INT_MAX || len[lo] <= 1) continue;
+        //the pair indices must not be part of symmetric groups in the other operands
+        bool is_ok = true;
+        for (int tt=0; tt<3; tt++){
+          if (tt == t) continue;
+          for (int rr=0; rr<orders[tt]; rr++){
+            int l = idx_maps[tt][rr];
+            if ((l == lo || l == hi) && (syms[tt][rr] != NS || (rr > 0 && syms[tt][rr-1] != NS) || stride[tt][l] > INT_MAX))
+              is_ok = false;
+          }
+        }
+        if (!is_ok) continue;
+        //the longest index of the remaining gemm dimension that is nonsymmetric everywhere
+        int third = -1;
+        for (int l=0; l<idx_max; l++){
+          if (is_ns[l] && dim[l] == 3-dim[lo]-dim[hi] && len[l] > 1 && (third == -1 || len[l] > len[third]))
+            third = l;
+        }
+        int64_t sz = ((int64_t)len[lo])*(len[lo]+1)/2*(third == -1 ? 1 : len[third]);
+        if (sz <= best_sz) continue;
+        best_sz = sz;
+        blk.nidx = third == -1 ? 2 : 3;
+        sel[0] = lo;
+        sel[1] = hi;
+        sel[2] = third;
+        blk.pair_op = t;
+        blk.pair_lo = dim[lo];
+        blk.pair_hi = dim[hi];
+        blk.pair_str = stride[t][lo];
+      }
+    }
+    if (blk.nidx == 0) return;
+    for (int d=0; d<3; d++){
+      blk.len[d] = 1;
+      for (int tt=0; tt<3; tt++) blk.str[tt][d] = 0;
+    }
+    for (int j=0; j<blk.nidx; j++){
+      blk.len[dim[sel[j]]] = len[sel[j]];
+      for (int tt=0; tt<3; tt++){
+        if (cnt[tt][sel[j]]) blk.str[tt][dim[sel[j]]] = stride[tt][sel[j]];
+      }
+    }
+    renumber_inner(order_A, idx_map_A, order_B, idx_map_B, order_C, idx_map_C, idx_max, blk.nidx, sel);
+  }
+
+  /**
+   * \brief finds the index of a contraction that is best done by a strided inner kernel, an index is eligible
+   *        if it appears at most once in each operand and is not part of any symmetric group, preferring
+   *        indices with unit stride in more operands and then longer ones, the eligible index is renumbered
+   *        to be innermost (0), keeping the order of the others
+   * \param[in,out] idx_map_A indices of A, renumbered on output if an index is found
+   * \param[in,out] idx_map_B indices of B, renumbered on output if an index is found
+   * \param[in,out] idx_map_C indices of C, renumbered on output if an index is found
+   * \param[in] idx_max total number of indices
+   * \param[out] blk description of the inner loop, blk.nidx=0 if no index is eligible
+   */
+  static void get_sym_seq_ctr_blk(int              order_A,
+                                  int const *      edge_len_A,
+                                  int const *      sym_A,
+                                  int *            idx_map_A,
+                                  int              order_B,
+                                  int const *      edge_len_B,
+                                  int const *      sym_B,
+                                  int *            idx_map_B,
+                                  int              order_C,
+                                  int const *      edge_len_C,
+                                  int const *      sym_C,
+                                  int *            idx_map_C,
+                                  int              idx_max,
+                                  sym_seq_ctr_blk & blk){
+    int orders[] = {order_A, order_B, order_C};
+    int const * edge_lens[] = {edge_len_A, edge_len_B, edge_len_C};
+    int const * syms[] = {sym_A, sym_B, sym_C};
+    int * idx_maps[] = {idx_map_A, idx_map_B, idx_map_C};
+    int cnt[3][idx_max];
+    int64_t stride[3][idx_max];
+    int len[idx_max];
+    bool is_free[idx_max];
+    std::fill(len, len+idx_max, 1);
+    std::fill(is_free, is_free+idx_max, true);
+    for (int t=0; t<3; t++){
+      std::fill(cnt[t], cnt[t]+idx_max, 0);
+      std::fill(stride[t], stride[t]+idx_max, 0);
+      for (int r=0; r<orders[t]; r++){
+        int l = idx_maps[t][r];
+        cnt[t][l]++;
+        len[l] = edge_lens[t][r];
+        stride[t][l] = sy_packed_size(r, edge_lens[t], syms[t]);
+        if (cnt[t][l] > 1 || syms[t][r] != NS || (r > 0 && syms[t][r-1] != NS) || stride[t][l] > INT_MAX)
+          is_free[l] = false;
+      }
+    }
+    int best = -1;
+    int best_nunit = -1;
+    blk.nidx = 0;
+    for (int l=0; l<idx_max; l++){
+      if (!is_free[l] || len[l] <= 1) continue;
+      int nunit = (stride[0][l] == 1) + (stride[1][l] == 1) + (stride[2][l] == 1);
+      if (nunit > best_nunit || (nunit == best_nunit && len[l] > len[best])){
+        best = l;
+        best_nunit = nunit;
+      }
+    }
+    if (best == -1) return;
+    blk.nidx = 1;
+    blk.n = len[best];
+    blk.inc_A = stride[0][best];
+    blk.inc_B = stride[1][best];
+    blk.inc_C = stride[2][best];
+    renumber_inner(order_A, idx_map_A, order_B, idx_map_B, order_C, idx_map_C, idx_max, 1, &best);
+  }
+
+  bool has_sym_seq_ctr_tile(int              order_A,
+                            int const *      edge_len_A,
+                            int const *      sym_A,
+                            int const *      idx_map_A,
+                            int              order_B,
+                            int const *      edge_len_B,
+                            int const *      sym_B,
+                            int const *      idx_map_B,
+                            int              order_C,
+                            int const *      edge_len_C,
+                            int const *      sym_C,
+                            int const *      idx_map_C){
+    int idx_max;
+    int * rev_idx_map;
+    inv_idx(order_A, idx_map_A,
+            order_B, idx_map_B,
+            order_C, idx_map_C,
+            &idx_max, &rev_idx_map);
+    cdealloc(rev_idx_map);
+    int bidx_map_A[std::max(order_A,1)];
+    int bidx_map_B[std::max(order_B,1)];
+    int bidx_map_C[std::max(order_C,1)];
+    memcpy(bidx_map_A, idx_map_A, sizeof(int)*order_A);
+    memcpy(bidx_map_B, idx_map_B, sizeof(int)*order_B);
+    memcpy(bidx_map_C, idx_map_C, sizeof(int)*order_C);
+    sym_seq_ctr_blk blk;
+    get_sym_seq_ctr_tile(order_A, edge_len_A, sym_A, bidx_map_A, order_B, edge_len_B, sym_B, bidx_map_B, order_C, edge_len_C, sym_C, bidx_map_C, idx_max, blk);
+    return blk.nidx > 0;
+  }
+
   template <int idim>
   void sym_seq_ctr_loop(char const *     alpha,
                         char const *     A,
@@ -35,7 +404,12 @@ namespace CTF_int{
                         bivar_function const * func,
                         int const *      idx,
                         int const *      rev_idx_map,
-                        int              idx_max){
+                        int              idx_max,
+                        sym_seq_ctr_blk const * blk){
+    if (blk != NULL && idim < blk->nidx){
+      blk->run(alpha, A, B, C, sr_C);
+      return;
+    }
     int imax=0;
     int rA = rev_idx_map[3*idim+0];
     int rB = rev_idx_map[3*idim+1];
@@ -116,7 +490,7 @@ namespace CTF_int{
           int nidx[idx_max];
           memcpy(nidx, idx, idx_max*sizeof(int));
           nidx[idim] = i;
-          sym_seq_ctr_loop<idim-1>(alpha, A+offsets_A[idim][nidx[idim]], sr_A, order_A, edge_len_A, sym_A, idx_map_A, offsets_A, B+offsets_B[idim][nidx[idim]], sr_B, order_B, edge_len_B, sym_B, idx_map_B, offsets_B, beta, C+offsets_C[idim][nidx[idim]], sr_C, order_C, edge_len_C, sym_C, idx_map_C, offsets_C, func, nidx, rev_idx_map, idx_max);
+          sym_seq_ctr_loop<idim-1>(alpha, A+offsets_A[idim][nidx[idim]], sr_A, order_A, edge_len_A, sym_A, idx_map_A, offsets_A, B+offsets_B[idim][nidx[idim]], sr_B, order_B, edge_len_B, sym_B, idx_map_B, offsets_B, beta, C+offsets_C[idim][nidx[idim]], sr_C, order_C, edge_len_C, sym_C, idx_map_C, offsets_C, func, nidx, rev_idx_map, idx_max, blk);
         }
       }
     } else {
@@ -124,7 +498,7 @@ namespace CTF_int{
         int nidx[idx_max];
         memcpy(nidx, idx, idx_max*sizeof(int));
         nidx[idim] = i;
-        sym_seq_ctr_loop<idim-1>(alpha, A+offsets_A[idim][nidx[idim]], sr_A, order_A, edge_len_A, sym_A, idx_map_A, offsets_A, B+offsets_B[idim][nidx[idim]], sr_B, order_B, edge_len_B, sym_B, idx_map_B, offsets_B, beta, C+offsets_C[idim][nidx[idim]], sr_C, order_C, edge_len_C, sym_C, idx_map_C, offsets_C, func, nidx, rev_idx_map, idx_max);
+        sym_seq_ctr_loop<idim-1>(alpha, A+offsets_A[idim][nidx[idim]], sr_A, order_A, edge_len_A, sym_A, idx_map_A, offsets_A, B+offsets_B[idim][nidx[idim]], sr_B, order_B, edge_len_B, sym_B, idx_map_B, offsets_B, beta, C+offsets_C[idim][nidx[idim]], sr_C, order_C, edge_len_C, sym_C, idx_map_C, offsets_C, func, nidx, rev_idx_map, idx_max, blk);
       }
 
     }
@@ -160,7 +534,12 @@ namespace CTF_int{
                         bivar_function const * func,
                         int const *      idx,
                         int const *      rev_idx_map,
-                        int              idx_max){
+                        int              idx_max,
+                        sym_seq_ctr_blk const * blk){
+    if (blk != NULL){
+      blk->run(alpha, A, B, C, sr_C);
+      return;
+    }
     int imax=0;
     int rA = rev_idx_map[0];
     int rB = rev_idx_map[1];
@@ -296,7 +675,8 @@ printf("HERE1\n");
                         bivar_function const * func,
                         int const *      idx,
                         int const *      rev_idx_map,
-                        int              idx_max);
+                        int              idx_max,
+                        sym_seq_ctr_blk const * blk);
 
 
   void compute_syoff(int              r,
@@ -456,40 +836,77 @@ printf("HERE1\n");
       }
     }
     if (idx_max <= MAX_ORD){
-      uint64_t ** offsets_A;
-      uint64_t ** offsets_B;
-      uint64_t ** offsets_C;
-      compute_syoffs(sr_A, order_A, edge_len_A, sym_A, idx_map_A, sr_B, order_B, edge_len_B, sym_B, idx_map_B, sr_C, order_C, edge_len_C, sym_C, idx_map_C, idx_max, rev_idx_map, offsets_A, offsets_B, offsets_C);
-
+      //renumber the indices so that the innermost loops can be done by a single kernel call if possible
+      int * bidx_map_A = (int*)CTF_int::alloc(sizeof(int)*std::max(order_A,1));
+      int * bidx_map_B = (int*)CTF_int::alloc(sizeof(int)*std::max(order_B,1));
+      int * bidx_map_C = (int*)CTF_int::alloc(sizeof(int)*std::max(order_C,1));
+      memcpy(bidx_map_A, idx_map_A, sizeof(int)*order_A);
+      memcpy(bidx_map_B, idx_map_B, sizeof(int)*order_B);
+      memcpy(bidx_map_C, idx_map_C, sizeof(int)*order_C);
+      sym_seq_ctr_blk blk;
+      blk.nidx = 0;
+      if (sr_C->has_mul() && sr_A->el_size == sr_C->el_size && sr_B->el_size == sr_C->el_size){
+        //contract packed symmetric pairs by gemms on blocks if possible, and otherwise do a strided innermost loop
+        get_sym_seq_ctr_tile(order_A, edge_len_A, sym_A, bidx_map_A, order_B, edge_len_B, sym_B, bidx_map_B, order_C, edge_len_C, sym_C, bidx_map_C, idx_max, blk);
+        if (blk.nidx == 0)
+          get_sym_seq_ctr_blk(order_A, edge_len_A, sym_A, bidx_map_A, order_B, edge_len_B, sym_B, bidx_map_B, order_C, edge_len_C, sym_C, bidx_map_C, idx_max, blk);
+      }
+      sym_seq_ctr_blk const * pblk = NULL;
+      int * brev_idx_map = rev_idx_map;
       //if we have something to parallelize without needing to replicate C
-      if (order_C > 1 || (order_C > 0 && idx_map_C[0] != 0)){
+      bool par_C = order_C > 1 || (order_C > 0 && idx_map_C[0] != 0);
+      if (blk.nidx > 0){
+        pblk = &blk;
+        inv_idx(order_A, bidx_map_A,
+                order_B, bidx_map_B,
+                order_C, bidx_map_C,
+                &idx_max, &brev_idx_map);
+        par_C = false;
+        for (int i=0; i<order_C; i++){
+          if (bidx_map_C[i] >= blk.nidx) par_C = true;
+        }
+      }
+      if (blk.nidx > 0 && idx_max == blk.nidx){
+        blk.run(alpha, A, B, C, sr_C);
+      } else {
+        uint64_t ** offsets_A;
+        uint64_t ** offsets_B;
+        uint64_t ** offsets_C;
+        compute_syoffs(sr_A, order_A, edge_len_A, sym_A, bidx_map_A, sr_B, order_B, edge_len_B, sym_B, bidx_map_B, sr_C, order_C, edge_len_C, sym_C, bidx_map_C, idx_max, brev_idx_map, offsets_A, offsets_B, offsets_C);
+
+        if (par_C){
 #ifdef USE_OMP    
-        #pragma omp parallel
+          #pragma omp parallel
 #endif
-        {
-          int * idx_glb = (int*)CTF_int::alloc(sizeof(int)*idx_max);
-          memset(idx_glb, 0, sizeof(int)*idx_max);
+          {
+            int * idx_glb = (int*)CTF_int::alloc(sizeof(int)*idx_max);
+            memset(idx_glb, 0, sizeof(int)*idx_max);
 
-          SWITCH_ORD_CALL(sym_seq_ctr_loop, idx_max-1, alpha, A, sr_A, order_A, edge_len_A, sym_A, idx_map_A, offsets_A, B, sr_B, order_B, edge_len_B, sym_B, idx_map_B, offsets_B, beta, C, sr_C, order_C, edge_len_C, sym_C, idx_map_C, offsets_C, NULL, idx_glb, rev_idx_map, idx_max);
-          cdealloc(idx_glb);
-        }
-      } else {
-        {
-          int * idx_glb = (int*)CTF_int::alloc(sizeof(int)*idx_max);
-          memset(idx_glb, 0, sizeof(int)*idx_max);
+            SWITCH_ORD_CALL(sym_seq_ctr_loop, idx_max-1, alpha, A, sr_A, order_A, edge_len_A, sym_A, bidx_map_A, offsets_A, B, sr_B, order_B, edge_len_B, sym_B, bidx_map_B, offsets_B, beta, C, sr_C, order_C, edge_len_C, sym_C, bidx_map_C, offsets_C, NULL, idx_glb, brev_idx_map, idx_max, pblk);
+            cdealloc(idx_glb);
+          }
+        } else {
+          {
+            int * idx_glb = (int*)CTF_int::alloc(sizeof(int)*idx_max);
+            memset(idx_glb, 0, sizeof(int)*idx_max);
 
-          SWITCH_ORD_CALL(sym_seq_ctr_loop, idx_max-1, alpha, A, sr_A, order_A, edge_len_A, sym_A, idx_map_A, offsets_A, B, sr_B, order_B, edge_len_B, sym_B, idx_map_B, offsets_B, beta, C, sr_C, order_C, edge_len_C, sym_C, idx_map_C, offsets_C, NULL, idx_glb, rev_idx_map, idx_max);
-          cdealloc(idx_glb);
+            SWITCH_ORD_CALL(sym_seq_ctr_loop, idx_max-1, alpha, A, sr_A, order_A, edge_len_A, sym_A, bidx_map_A, offsets_A, B, sr_B, order_B, edge_len_B, sym_B, bidx_map_B, offsets_B, beta, C, sr_C, order_C, edge_len_C, sym_C, bidx_map_C, offsets_C, NULL, idx_glb, brev_idx_map, idx_max, pblk);
+            cdealloc(idx_glb);
+          }
         }
+        for (int l=0; l<idx_max; l++){
+          cdealloc(offsets_A[l]);
+          cdealloc(offsets_B[l]);
+          cdealloc(offsets_C[l]);
+        }
+        cdealloc(offsets_A);
+        cdealloc(offsets_B);
+        cdealloc(offsets_C);
       }
-      for (int l=0; l<idx_max; l++){
-        cdealloc(offsets_A[l]);
-        cdealloc(offsets_B[l]);
-        cdealloc(offsets_C[l]);
-      }
-      cdealloc(offsets_A);
-      cdealloc(offsets_B);
-      cdealloc(offsets_C);
+      if (brev_idx_map != rev_idx_map) cdealloc(brev_idx_map);
+      cdealloc(bidx_map_A);
+      cdealloc(bidx_map_B);
+      cdealloc(bidx_map_C);
     } else {
       int * idx_glb = (int*)CTF_int::alloc(sizeof(int)*idx_max);
       memset(idx_glb, 0, sizeof(int)*idx_max);
@@ -655,7 +1072,7 @@ printf("HERE1\n");
           int * idx_glb = (int*)CTF_int::alloc(sizeof(int)*idx_max);
           memset(idx_glb, 0, sizeof(int)*idx_max);
 
-          SWITCH_ORD_CALL(sym_seq_ctr_loop, idx_max-1, alpha, A, sr_A, order_A, edge_len_A, sym_A, idx_map_A, offsets_A, B, sr_B, order_B, edge_len_B, sym_B, idx_map_B, offsets_B, beta, C, sr_C, order_C, edge_len_C, sym_C, idx_map_C, offsets_C, func, idx_glb, rev_idx_map, idx_max);
+          SWITCH_ORD_CALL(sym_seq_ctr_loop, idx_max-1, alpha, A, sr_A, order_A, edge_len_A, sym_A, idx_map_A, offsets_A, B, sr_B, order_B, edge_len_B, sym_B, idx_map_B, offsets_B, beta, C, sr_C, order_C, edge_len_C, sym_C, idx_map_C, offsets_C, func, idx_glb, rev_idx_map, idx_max, NULL);
           cdealloc(idx_glb);
         }
       } else {
@@ -663,7 +1080,7 @@ printf("HERE1\n");
           int * idx_glb = (int*)CTF_int::alloc(sizeof(int)*idx_max);
           memset(idx_glb, 0, sizeof(int)*idx_max);
 
-          SWITCH_ORD_CALL(sym_seq_ctr_loop, idx_max-1, alpha, A, sr_A, order_A, edge_len_A, sym_A, idx_map_A, offsets_A, B, sr_B, order_B, edge_len_B, sym_B, idx_map_B, offsets_B, beta, C, sr_C, order_C, edge_len_C, sym_C, idx_map_C, offsets_C, func, idx_glb, rev_idx_map, idx_max);
+          SWITCH_ORD_CALL(sym_seq_ctr_loop, idx_max-1, alpha, A, sr_A, order_A, edge_len_A, sym_A, idx_map_A, offsets_A, B, sr_B, order_B, edge_len_B, sym_B, idx_map_B, offsets_B, beta, C, sr_C, order_C, edge_len_C, sym_C, idx_map_C, offsets_C, func, idx_glb, rev_idx_map, idx_max, NULL);
           cdealloc(idx_glb);
         }
       }
@@ -927,3 +1344,4 @@ printf("HERE1\n");
     return 0;
   }
 }
+
@@ -28,6 +28,24 @@ namespace CTF_int {
                       uint64_t **&     offsets_C);
 
  
+  /**
+   * \brief whether sym_seq_ctr_ref contracts a packed symmetric pair of an operand by gemms on blocks, which
+   *        is the case if two indices of a group of two symmetric indices of an operand appear in different other
+   *        operands and are not symmetric there
+   */
+  bool has_sym_seq_ctr_tile(int              order_A,
+                            int const *      edge_len_A,
+                            int const *      sym_A,
+                            int const *      idx_map_A,
+                            int              order_B,
+                            int const *      edge_len_B,
+                            int const *      sym_B,
+                            int const *      idx_map_B,
+                            int              order_C,
+                            int const *      edge_len_C,
+                            int const *      sym_C,
+                            int const *      idx_map_C);
+
   /**
    * \brief performs symmetric contraction with reference (unblocked) kernel
    */
@@ -2,6 +2,7 @@
 
 #include "common.h"
 #include "../shared/util.h"
+#include "../shared/trace.h"
 #include <random>
 
 namespace CTF {
@@ -40,6 +41,44 @@ namespace CTF_int {
   LinModel<3> allred_mdl(allred_mdl_init,"allred_mdl");
   LinModel<3> allred_mdl_cst(allred_mdl_cst_init,"allred_mdl_cst");
   LinModel<3> bcast_mdl(bcast_mdl_init,"bcast_mdl");
+  LinModel<3> bcast_seg_mdl(bcast_seg_mdl_init,"bcast_seg_mdl");
+  LinModel<3> allred_seg_mdl(allred_seg_mdl_init,"allred_seg_mdl");
+
+  /* collectives on messages of more than coll_seg_thresh bytes (or INT_MAX elements) are done in segments of coll_seg_size bytes */
+  static int64_t coll_seg_thresh = ((int64_t)1)<<26;
+  static int64_t coll_seg_size = ((int64_t)1)<<23;
+
+  void set_coll_segments(int64_t thresh, int64_t seg_size){
+    coll_seg_thresh = thresh;
+    coll_seg_size = std::max((int64_t)1, seg_size);
+  }
+
+  /**
+   * \brief returns the number of elements of size tsize in each segment of a collective on count elements,
+   *        count itself if the collective is not segmented
+   */
+  static int64_t get_seg_count(int64_t count, int tsize){
+    if (count <= INT_MAX && count*tsize <= coll_seg_thresh) return count;
+    return std::max((int64_t)1, std::min((int64_t)INT_MAX, coll_seg_size/std::max(tsize,1)));
+  }
+
+  /**
+   * \brief returns the number of elements of size tsize in each segment of a broadcast of count elements
+   *        among np processors, which is pipelined in segments if it has more than INT_MAX elements or
+   *        if the model of pipelined broadcasts predicts it to be faster than the unsegmented one,
+   *        count itself if the broadcast is not segmented
+   */
+  static int64_t get_bcast_seg_count(int64_t count, int tsize, int np){
+    int64_t seg_cnt = std::max((int64_t)1, std::min((int64_t)INT_MAX, coll_seg_size/std::max(tsize,1)));
+    if (count <= seg_cnt) return count;
+    if (count > INT_MAX) return seg_cnt;
+    if (np <= 1) return count;
+    int64_t nseg = (count+seg_cnt-1)/seg_cnt;
+    double ps[] = {1.0, log2((double)np), (double)count*tsize};
+    double ps_seg[] = {1.0, (double)(np-2+nseg), ((double)count+(np-2)*seg_cnt)*tsize};
+    if (bcast_seg_mdl.est_time(ps_seg) < bcast_mdl.est_time(ps)) return seg_cnt;
+    return count;
+  }
 
 
   template <typename type>
@@ -174,6 +213,46 @@ namespace CTF_int {
     return total_flop_count;
   }
 
+  double total_comm_time = 0.0;
+  int64_t total_comm_bytes = 0;
+  double total_kernel_time = 0.0;
+  double total_redist_time = 0.0;
+  double total_redist_comm_time = 0.0;
+
+  void comm_add(double time, int64_t nbytes){
+    total_comm_time += time;
+    total_comm_bytes += nbytes;
+  }
+
+  double get_comm_time(){
+    return total_comm_time;
+  }
+
+  int64_t get_comm_bytes(){
+    return total_comm_bytes;
+  }
+
+  void kernel_time_add(double time){
+    total_kernel_time += time;
+  }
+
+  double get_kernel_time(){
+    return total_kernel_time;
+  }
+
+  void redist_time_add(double time, double comm_time){
+    total_redist_time += time;
+    total_redist_comm_time += comm_time;
+  }
+
+  double get_redist_time(){
+    return total_redist_time;
+  }
+
+  double get_redist_comm_time(){
+    return total_redist_comm_time;
+  }
+
   void handler() {
   #if (!BGP && !BGQ && !HOPPER)
     int i, size;
@@ -289,11 +368,23 @@ namespace CTF_int {
   }
      
   double CommData::estimate_bcast_time(int64_t msg_sz){
+    int64_t seg_sz = get_bcast_seg_count(msg_sz, 1, np);
+    if (seg_sz < msg_sz){
+      int64_t nseg = (msg_sz+seg_sz-1)/seg_sz;
+      double ps[] = {1.0, (double)(np-2+nseg), (double)(msg_sz+(np-2)*seg_sz)};
+      return bcast_seg_mdl.est_time(ps);
+    }
     double ps[] = {1.0, log2((double)np), (double)msg_sz};
     return bcast_mdl.est_time(ps);
   }
      
   double CommData::estimate_allred_time(int64_t msg_sz, MPI_Op op){
+    int64_t seg_sz = get_seg_count(msg_sz, 1);
+    if (seg_sz < msg_sz){
+      int64_t nseg = (msg_sz+seg_sz-1)/seg_sz;
+      double ps[] = {1.0, nseg*log2((double)np), (double)msg_sz*(np-1)/np};
+      return allred_seg_mdl.est_time(ps);
+    }
     double ps[] = {1.0, log2((double)np), (double)msg_sz*log2((double)(np))};
     if (op >= MPI_MAX && op <= MPI_REPLACE)
       return allred_mdl.est_time(ps);
@@ -333,54 +424,141 @@ namespace CTF_int {
 #ifdef TUNE
     MPI_Barrier(cm);
 #endif
+    int tsize;
+    MPI_Type_size(mdtype, &tsize);
+    int64_t seg_cnt = get_bcast_seg_count(count, tsize, np);
     double st_time = MPI_Wtime();
-    MPI_Bcast(buf, count, mdtype, root, cm);
+    if (seg_cnt == count){
+      MPI_Bcast(buf, count, mdtype, root, cm);
+    } else {
+      //pipelined broadcast along a ring starting at root, each processor forwards a segment once it has received it
+      MPI_Aint lb, ext;
+      MPI_Type_get_extent(mdtype, &lb, &ext);
+      int vrank = (rank-root+np)%np;
+      int64_t nseg = (count+seg_cnt-1)/seg_cnt;
+      std::vector<MPI_Request> rreqs, sreqs;
+      if (vrank != 0){
+        rreqs.resize(nseg);
+        for (int64_t i=0; i<nseg; i++){
+          MPI_Irecv((char*)buf+i*seg_cnt*ext, std::min(seg_cnt, count-i*seg_cnt), mdtype, (rank-1+np)%np, 0, cm, &rreqs[i]);
+        }
+      }
+      for (int64_t i=0; i<nseg; i++){
+        if (vrank != 0) MPI_Wait(&rreqs[i], MPI_STATUS_IGNORE);
+        if (vrank != np-1){
+          sreqs.push_back(MPI_Request());
+          MPI_Isend((char*)buf+i*seg_cnt*ext, std::min(seg_cnt, count-i*seg_cnt), mdtype, (rank+1)%np, 0, cm, &sreqs.back());
+        }
+      }
+      if (sreqs.size() > 0) MPI_Waitall(sreqs.size(), sreqs.data(), MPI_STATUSES_IGNORE);
+    }
 #ifdef TUNE
     MPI_Barrier(cm);
 #endif
     double exe_time = MPI_Wtime()-st_time;
-    int tsize;
-    MPI_Type_size(mdtype, &tsize);
-    double tps[] = {exe_time, 1.0, log2(np), ((double)count)*tsize};
-    bcast_mdl.observe(tps);
+    if (seg_cnt == count){
+      double tps[] = {exe_time, 1.0, log2(np), ((double)count)*tsize};
+      bcast_mdl.observe(tps);
+    } else {
+      int64_t nseg = (count+seg_cnt-1)/seg_cnt;
+      double tps[] = {exe_time, 1.0, (double)(np-2+nseg), ((double)count+(np-2)*seg_cnt)*tsize};
+      bcast_seg_mdl.observe(tps);
+    }
+    comm_add(exe_time, count*tsize);
+    TRACE_ADD_BYTES(count*tsize);
+  }
+
+  /**
+   * \brief reduces count elements of inbuf in segments of seg_cnt elements, each by a reduce-scatter followed by an
+   *        allgather into outbuf on all processors (root == -1) or a gather into outbuf on root
+   */
+  static void seg_red(void *       inbuf,
+                      void *       outbuf,
+                      int64_t      count,
+                      int64_t      seg_cnt,
+                      MPI_Datatype mdtype,
+                      MPI_Op       op,
+                      int          root,
+                      int          rank,
+                      int          np,
+                      MPI_Comm     cm){
+    MPI_Aint lb, ext;
+    MPI_Type_get_extent(mdtype, &lb, &ext);
+    char * src = (char*)(inbuf == MPI_IN_PLACE ? outbuf : inbuf);
+    int * counts = (int*)alloc(sizeof(int)*np);
+    int * displs = (int*)alloc(sizeof(int)*np);
+    char * blk = (char*)alloc(ext*(seg_cnt/np+1));
+    for (int64_t off=0; off<count; off+=seg_cnt){
+      int64_t c = std::min(seg_cnt, count-off);
+      for (int i=0; i<np; i++){
+        counts[i] = c/np + (i < c%np);
+        displs[i] = i == 0 ? 0 : displs[i-1]+counts[i-1];
+      }
+      MPI_Reduce_scatter(src+off*ext, blk, counts, mdtype, op, cm);
+      if (root == -1)
+        MPI_Allgatherv(blk, counts[rank], mdtype, (char*)outbuf+off*ext, counts, displs, mdtype, cm);
+      else
+        MPI_Gatherv(blk, counts[rank], mdtype, rank == root ? (char*)outbuf+off*ext : NULL, counts, displs, mdtype, root, cm);
+    }
+    cdealloc(blk);
+    cdealloc(displs);
+    cdealloc(counts);
   }
 
   void CommData::allred(void * inbuf, void * outbuf, int64_t count, MPI_Datatype mdtype, MPI_Op op){
 #ifdef TUNE
     MPI_Barrier(cm);
 #endif
+    int tsize;
+    MPI_Type_size(mdtype, &tsize);
+    int64_t seg_cnt = get_seg_count(count, tsize);
     double st_time = MPI_Wtime();
-    MPI_Allreduce(inbuf, outbuf, count, mdtype, op, cm);
+    if (seg_cnt == count)
+      MPI_Allreduce(inbuf, outbuf, count, mdtype, op, cm);
+    else
+      seg_red(inbuf, outbuf, count, seg_cnt, mdtype, op, -1, rank, np, cm);
 #ifdef TUNE
     MPI_Barrier(cm);
 #endif
     double exe_time = MPI_Wtime()-st_time;
-    int tsize;
-    MPI_Type_size(mdtype, &tsize);
-    double tps[] = {exe_time, 1.0, log2(np), ((double)count)*tsize*std::max(.5,(double)log2(np))};
-    if (op >= MPI_MAX && op <= MPI_REPLACE)
-      allred_mdl.observe(tps);
-    else
-      allred_mdl_cst.observe(tps);
+    if (seg_cnt == count){
+      double tps[] = {exe_time, 1.0, log2(np), ((double)count)*tsize*std::max(.5,(double)log2(np))};
+      if (op >= MPI_MAX && op <= MPI_REPLACE)
+        allred_mdl.observe(tps);
+      else
+        allred_mdl_cst.observe(tps);
+    } else {
+      int64_t nseg = (count+seg_cnt-1)/seg_cnt;
+      double tps[] = {exe_time, 1.0, nseg*log2(np), ((double)count)*tsize*(np-1)/np};
+      allred_seg_mdl.observe(tps);
+    }
+    comm_add(exe_time, count*tsize);
+    TRACE_ADD_BYTES(count*tsize);
   }
 
   void CommData::red(void * inbuf, void * outbuf, int64_t count, MPI_Datatype mdtype, MPI_Op op, int root){
 #ifdef TUNE
     MPI_Barrier(cm);
 #endif
+    int tsize;
+    MPI_Type_size(mdtype, &tsize);
+    int64_t seg_cnt = get_seg_count(count, tsize);
     double st_time = MPI_Wtime();
-    MPI_Reduce(inbuf, outbuf, count, mdtype, op, root, cm);
+    if (seg_cnt == count)
+      MPI_Reduce(inbuf, outbuf, count, mdtype, op, root, cm);
+    else
+      seg_red(inbuf, outbuf, count, seg_cnt, mdtype, op, root, rank, np, cm);
 #ifdef TUNE
     MPI_Barrier(cm);
 #endif
     double exe_time = MPI_Wtime()-st_time;
-    int tsize;
-    MPI_Type_size(mdtype, &tsize);
     double tps[] = {exe_time, 1.0, log2(np), ((double)count)*tsize*std::max(.5,(double)log2(np))};
     if (op >= MPI_MAX && op <= MPI_REPLACE)
       red_mdl.observe(tps);
     else
       red_mdl_cst.observe(tps);
+    comm_add(exe_time, count*tsize);
+    TRACE_ADD_BYTES(count*tsize);
   }
 
 
@@ -485,6 +663,8 @@ namespace CTF_int {
     int64_t tot_sz = std::max(send_displs[np-1]+send_counts[np-1], recv_displs[np-1]+recv_counts[np-1])*datum_size;
     double tps[] = {exe_time, 1.0, log2(np), (double)tot_sz};
     alltoallv_mdl.observe(tps);
+    comm_add(exe_time, (send_displs[np-1]+send_counts[np-1])*datum_size);
+    TRACE_ADD_BYTES((send_displs[np-1]+send_counts[np-1])*datum_size);
   }
 
   void cvrt_idx(int         order,
@@ -522,7 +702,6 @@ namespace CTF_int {
   }
 
   bool get_mpi_dt(int64_t count, int64_t datum_size, MPI_Datatype & dt){
-    ASSERT(count <= INT_MAX);
     bool is_new = false;
     switch (datum_size){
       case 1:
@@ -72,6 +72,35 @@ namespace CTF_int {
    */
   double get_rand48();
 
+  /**
+   * \brief returns random number in [0,1) that depends only on key and counter,
+   *        computed by the Philox4x32-10 counter-based generator, so that values
+   *        can be generated independently (in parallel) for each tensor element
+   * \param[in] key seed of the sequence
+   * \param[in] ctr_lo low 64 bits of the counter (e.g. global index of element)
+   * \param[in] ctr_hi high 64 bits of the counter (e.g. to distinguish uses of the same key)
+   */
+  inline double get_rand_ctr(uint64_t key, uint64_t ctr_lo, uint64_t ctr_hi=0){
+    uint32_t c0 = (uint32_t)ctr_lo;
+    uint32_t c1 = (uint32_t)(ctr_lo>>32);
+    uint32_t c2 = (uint32_t)ctr_hi;
+    uint32_t c3 = (uint32_t)(ctr_hi>>32);
+    uint32_t k0 = (uint32_t)key;
+    uint32_t k1 = (uint32_t)(key>>32);
+    for (int r=0; r<10; r++){
+      uint64_t p0 = (uint64_t)0xD2511F53*c0;
+      uint64_t p1 = (uint64_t)0xCD9E8D57*c2;
+      c0 = (uint32_t)(p1>>32)^c1^k0;
+      c1 = (uint32_t)p1;
+      c2 = (uint32_t)(p0>>32)^c3^k1;
+      c3 = (uint32_t)p0;
+      k0 += 0x9E3779B9;
+      k1 += 0xBB67AE85;
+    }
+    //use the top 53 bits, so the result is exactly representable and less than 1
+    return ((((uint64_t)c0)<<32 | c1)>>11)*(1.0/9007199254740992.0);
+  }
+
 
 
   void handler();
@@ -128,6 +157,35 @@ namespace CTF_int {
 
   int64_t get_flops();
 
+  /**
+   * \brief accumulates time and volume of communication done by CommData collectives on this process
+   * \param[in] time seconds spent in the collective
+   * \param[in] nbytes number of bytes sent
+   */
+  void comm_add(double time, int64_t nbytes);
+
+  double get_comm_time();
+
+  int64_t get_comm_bytes();
+
+  /**
+   * \brief accumulates time spent in local (sequential) contraction kernels on this process
+   */
+  void kernel_time_add(double time);
+
+  double get_kernel_time();
+
+  /**
+   * \brief accumulates time spent redistributing tensors on this process
+   * \param[in] time total seconds spent in the redistribution
+   * \param[in] comm_time seconds of communication done within the redistribution
+   */
+  void redist_time_add(double time, double comm_time);
+
+  double get_redist_time();
+
+  double get_redist_comm_time();
+
   class CommData {
     public:
       MPI_Comm cm;
@@ -194,17 +252,20 @@ namespace CTF_int {
       double estimate_alltoallv_time(int64_t tot_sz);
 
       /**
-       * \brief broadcast, same interface as MPI_Bcast, but excluding the comm
+       * \brief broadcast, same interface as MPI_Bcast, but excluding the comm, large messages
+       *        are pipelined in segments along a ring
        */
       void bcast(void * buf, int64_t count, MPI_Datatype mdtype, int root);
 
       /**
-       * \brief allreduce, same interface as MPI_Allreduce, but excluding the comm
+       * \brief allreduce, same interface as MPI_Allreduce, but excluding the comm, large messages
+       *        are reduced in segments, each by a reduce-scatter followed by an allgather
        */
       void allred(void * inbuf, void * outbuf, int64_t count, MPI_Datatype mdtype, MPI_Op op);
 
       /**
-       * \brief reduce, same interface as MPI_Reduce, but excluding the comm
+       * \brief reduce, same interface as MPI_Reduce, but excluding the comm, large messages
+       *        are reduced in segments, each by a reduce-scatter followed by a gather
        */
       void red(void * inbuf, void * outbuf, int64_t count, MPI_Datatype mdtype, MPI_Op op, int root);
 
@@ -252,7 +313,23 @@ namespace CTF_int {
                 int64_t *   idx);
 
   /**
-   * \brief gives a datatype for arbitrary datum_size, errors if exceeding 32-bits
+   * \brief sets the size above which CommData::allred and red communicate in pipelined segments, and the size
+   *        of the segments, also used by CommData::bcast, which pipelines messages of more than one segment
+   *        when bcast_seg_mdl predicts it to be faster than bcast_mdl, messages of more than INT_MAX elements
+   *        are always segmented
+   * \param[in] thresh messages of more than thresh bytes are segmented by allred and red (default 64 MB)
+   * \param[in] seg_size bytes in each segment (default 8 MB)
+   */
+  void set_coll_segments(int64_t thresh, int64_t seg_size);
+
+  /** \brief performance model of unsegmented broadcasts */
+  extern LinModel<3> bcast_mdl;
+  /** \brief performance model of broadcasts pipelined in segments along a ring */
+  extern LinModel<3> bcast_seg_mdl;
+
+  /**
+   * \brief gives a datatype for arbitrary datum_size, any count may be passed with it to the
+   *        CommData collectives, which split messages of more than INT_MAX elements into segments
    *
    * \param[in] count number of elements we want to communicate
    * \param[in] datum_size element size
@@ -33,6 +33,7 @@ namespace CTF_int {
   void Unifun_Term::execute(CTF::Idx_Tensor output) const {
     CTF::Idx_Tensor opA = A->execute();
     summation s(opA.parent, opA.idx_map, opA.scale, output.parent, output.idx_map, output.scale, func);
+    if (output.mask != NULL) s.set_mask(output.mask, output.mask_idx_map, output.idx_map, output.mask_cmp);
     s.execute();
   }
  
@@ -106,6 +107,7 @@ namespace CTF_int {
       assert(0);
     }
     contraction c(opA.parent, opA.idx_map, opB.parent, opB.idx_map, output.sr->mulid(), output.parent, output.idx_map, output.scale, func);
+    if (output.mask != NULL) c.set_mask(output.mask, output.mask_idx_map, output.idx_map, output.mask_cmp);
     //contraction c(opA.parent, opA.idx_map, opB.parent, opB.idx_map, NULL, output.parent, output.idx_map, output.scale, func);
     c.execute();
 //    if (scl != NULL) cdealloc(scl);
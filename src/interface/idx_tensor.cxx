@@ -91,18 +91,27 @@ namespace CTF {
     }
     memcpy(idx_map, idx_map_, parent->order*sizeof(char));
     is_intm       = 0;
+    mask          = NULL;
+    mask_idx_map  = NULL;
+    mask_cmp      = false;
   }
 
   Idx_Tensor::Idx_Tensor(algstrct const * sr) : Term(sr) {
     idx_map = NULL;
     parent  = NULL;
     is_intm = 0;
+    mask    = NULL;
+    mask_idx_map = NULL;
+    mask_cmp = false;
   }
 
   Idx_Tensor::Idx_Tensor(algstrct const * sr, double scl) : Term(sr) {
     idx_map = NULL;
     parent  = NULL;
     is_intm = 0;
+    mask    = NULL;
+    mask_idx_map = NULL;
+    mask_cmp = false;
     sr->cast_double(scl, scale);
   }
 
@@ -110,6 +119,9 @@ namespace CTF {
     idx_map = NULL;
     parent  = NULL;
     is_intm = 0;
+    mask    = NULL;
+    mask_idx_map = NULL;
+    mask_cmp = false;
     sr->cast_int(scl, scale);
   }
 
@@ -138,6 +150,13 @@ namespace CTF {
       idx_map = (char*)CTF_int::alloc(other.parent->order*sizeof(char));
       memcpy(idx_map, other.idx_map, parent->order*sizeof(char));
     }
+    mask     = other.mask;
+    mask_cmp = other.mask_cmp;
+    mask_idx_map = NULL;
+    if (mask != NULL){
+      mask_idx_map = (char*)CTF_int::alloc(mask->order*sizeof(char));
+      memcpy(mask_idx_map, other.mask_idx_map, mask->order*sizeof(char));
+    }
     sr->safecopy(scale,other.scale);
   }
 
@@ -163,12 +182,29 @@ namespace CTF {
     }
     if (parent != NULL)  cdealloc(idx_map);
     idx_map = NULL;
+    if (mask_idx_map != NULL) cdealloc(mask_idx_map);
+    mask_idx_map = NULL;
   }
 
   Term * Idx_Tensor::clone(std::map<CTF_int::tensor*, CTF_int::tensor*>* remap) const {
     return new Idx_Tensor(*this, 0, remap);
   }
 
+  Idx_Tensor & Idx_Tensor::masked(Idx_Tensor const & M, bool complement){
+    IASSERT(M.parent != NULL && !M.is_intm);
+    if (mask_idx_map != NULL) cdealloc(mask_idx_map);
+    mask = M.parent;
+    mask_cmp = complement;
+    mask_idx_map = (char*)CTF_int::alloc(mask->order*sizeof(char));
+    memcpy(mask_idx_map, M.idx_map, mask->order*sizeof(char));
+    return *this;
+  }
+
+  Idx_Tensor & Idx_Tensor::masked(CTF_int::tensor & M, bool complement){
+    IASSERT(M.order == parent->order);
+    return masked(Idx_Tensor(&M, idx_map), complement);
+  }
+
   World * Idx_Tensor::where_am_i() const {
     if (parent == NULL) return NULL;
     return parent->wrld;
@@ -289,10 +325,12 @@ namespace CTF {
       if (ts.wrld->rank == 0) ts.sr->safecopy(data, scale);
       summation s(&ts, NULL, ts.sr->mulid(), 
                   output.parent, output.idx_map, output.scale);
+      if (output.mask != NULL) s.set_mask(output.mask, output.mask_idx_map, output.idx_map, output.mask_cmp);
       s.execute();
     } else {
       summation s(this->parent, idx_map, scale,
                   output.parent, output.idx_map, output.scale);
+      if (output.mask != NULL) s.set_mask(output.mask, output.mask_idx_map, output.idx_map, output.mask_cmp);
       s.execute();
 //      output.parent->sum(scale, *this->parent, idx_map,
   //                       output.scale, output.idx_map);
@@ -17,6 +17,10 @@ namespace CTF {
       CTF_int::tensor * parent;
       char * idx_map;
       int is_intm;
+      /** \brief tensor whose nonzeros select the entries written when this is an output, NULL if none */
+      CTF_int::tensor * mask;
+      char * mask_idx_map;
+      bool mask_cmp;
 
     
       // derived clone calls copy constructor
@@ -147,6 +151,26 @@ namespace CTF {
       }*/
 
 
+      /**
+       * \brief restricts operations with this as output to entries that match a nonzero of M,
+       *        e.g. C["ij"].masked(M["ij"]) += A["ik"]*B["kj"] computes only the entries of A*B
+       *        where M is nonzero, for sparse matrix-vector and matrix-matrix products products outside the
+       *        mask are never formed, for other contractions operands are filtered by M and the product is
+       *        masked after it is formed if no operand has all indices of M,
+       *        beta*C is still applied to all of C (C is zeroed by =)
+       * \param[in] M mask tensor and its indices, each of which must be an index of this tensor,
+       *              only the sparsity pattern of M is used, M must not be an intermediate
+       * \param[in] complement if true, restrict to entries that do not match a nonzero of M
+       */
+      Idx_Tensor & masked(Idx_Tensor const & M, bool complement=false);
+
+      /**
+       * \brief restricts operations with this as output to entries where M is (or is not, if complement) nonzero
+       * \param[in] M mask tensor with the same indices as this tensor
+       * \param[in] complement if true, restrict to entries where M is zero
+       */
+      Idx_Tensor & masked(CTF_int::tensor & M, bool complement=false);
+
       /**
        * \brief figures out what world this term lives on
        */
@@ -246,6 +270,16 @@ namespace CTF {
 
       CTF_int::Term * clone(std::map< CTF_int::tensor*, CTF_int::tensor* >* remap = NULL) const { return new Typ_Idx_Tensor<dtype>(*this, 0, remap); }
 
+      Typ_Idx_Tensor<dtype> & masked(Idx_Tensor const & M, bool complement=false){
+        Idx_Tensor::masked(M, complement);
+        return *this;
+      }
+
+      Typ_Idx_Tensor<dtype> & masked(CTF_int::tensor & M, bool complement=false){
+        Idx_Tensor::masked(M, complement);
+        return *this;
+      }
+
       void operator=(CTF_int::Term const & B){ Idx_Tensor::operator=(B); }
       void operator=(Idx_Tensor const & B){ Idx_Tensor::operator=(B); }
       void operator=(double scl){ Idx_Tensor::operator=(scl); }
@@ -2,6 +2,7 @@
 
 #include "common.h"
 #include "../shared/blas_symbs.h"
+#include "../shared/lapack_symbs.h"
 namespace CTF_int{
   struct int2
   {
@@ -16,6 +17,39 @@ namespace CTF_int{
       return i;
     }
   };
+
+  /**
+   * \brief computes, along one dimension of a matrix, the local offsets of the indices this process
+   *        sends to each process in the target layout and receives from each process in the source layout,
+   *        both layouts are block-cyclic with block size b over np processes starting at process s
+   * \param[in] n length of dimension
+   * \param[in] np number of processes along dimension
+   * \param[in] me index of this process along dimension
+   * \param[in] b1 block size of source layout
+   * \param[in] s1 first process of source layout
+   * \param[in] b2 block size of target layout
+   * \param[in] s2 first process of target layout
+   * \param[out] send_idx for each target process, source layout offsets (in increasing global index)
+   * \param[out] recv_idx for each source process, target layout offsets (in increasing global index)
+   */
+  inline void get_bc_dim_offsets(int                                 n,
+                                 int                                 np,
+                                 int                                 me,
+                                 int                                 b1,
+                                 int                                 s1,
+                                 int                                 b2,
+                                 int                                 s2,
+                                 std::vector< std::vector<int64_t> > & send_idx,
+                                 std::vector< std::vector<int64_t> > & recv_idx){
+    send_idx.assign(np, std::vector<int64_t>());
+    recv_idx.assign(np, std::vector<int64_t>());
+    for (int64_t i=0; i<n; i++){
+      int o1 = (i/b1+s1)%np;
+      int o2 = (i/b2+s2)%np;
+      if (o1 == me) send_idx[o2].push_back((i/(((int64_t)b1)*np))*b1+i%b1);
+      if (o2 == me) recv_idx[o1].push_back((i/(((int64_t)b2)*np))*b2+i%b2);
+    }
+  }
 }
 
 
@@ -189,6 +223,113 @@ namespace CTF {
     }
   }
 
+  /**
+   * \brief redistributes a matrix between two block-cyclic layouts on the same pr-by-pc processor grid,
+   *        whose process with coordinates (ipr, ipc) has rank ipr+ipc*pr, packing the intersection
+   *        of the row and column sets of each pair of processes directly
+   */
+  template<typename dtype>
+  void bc_redist(int               nrow,
+                 int               ncol,
+                 int               pr,
+                 int               pc,
+                 int               ipr,
+                 int               ipc,
+                 int               mb1,
+                 int               nb1,
+                 int               rsrc1,
+                 int               csrc1,
+                 int64_t           lda1,
+                 dtype const *     data1,
+                 int               mb2,
+                 int               nb2,
+                 int               rsrc2,
+                 int               csrc2,
+                 int64_t           lda2,
+                 dtype *           data2,
+                 CTF_int::CommData cdt){
+    std::vector< std::vector<int64_t> > srow, rrow, scol, rcol;
+    CTF_int::get_bc_dim_offsets(nrow, pr, ipr, mb1, rsrc1, mb2, rsrc2, srow, rrow);
+    CTF_int::get_bc_dim_offsets(ncol, pc, ipc, nb1, csrc1, nb2, csrc2, scol, rcol);
+    int np = pr*pc;
+    int64_t * send_counts = (int64_t*)CTF_int::alloc(sizeof(int64_t)*np);
+    int64_t * send_displs = (int64_t*)CTF_int::alloc(sizeof(int64_t)*np);
+    int64_t * recv_counts = (int64_t*)CTF_int::alloc(sizeof(int64_t)*np);
+    int64_t * recv_displs = (int64_t*)CTF_int::alloc(sizeof(int64_t)*np);
+    for (int p=0; p<np; p++){
+      send_counts[p] = srow[p%pr].size()*scol[p/pr].size();
+      recv_counts[p] = rrow[p%pr].size()*rcol[p/pr].size();
+      send_displs[p] = p == 0 ? 0 : send_displs[p-1]+send_counts[p-1];
+      recv_displs[p] = p == 0 ? 0 : recv_displs[p-1]+recv_counts[p-1];
+    }
+    dtype * send_buf = (dtype*)CTF_int::alloc(sizeof(dtype)*std::max((int64_t)1,send_displs[np-1]+send_counts[np-1]));
+    dtype * recv_buf = (dtype*)CTF_int::alloc(sizeof(dtype)*std::max((int64_t)1,recv_displs[np-1]+recv_counts[np-1]));
+#ifdef USE_OMP
+    #pragma omp parallel for schedule(dynamic)
+#endif
+    for (int p=0; p<np; p++){
+      std::vector<int64_t> const & rows = srow[p%pr];
+      std::vector<int64_t> const & cols = scol[p/pr];
+      dtype * buf = send_buf+send_displs[p];
+      for (int64_t j=0; j<(int64_t)cols.size(); j++){
+        dtype const * col = data1+cols[j]*lda1;
+        for (int64_t i=0; i<(int64_t)rows.size(); i++){
+          buf[j*rows.size()+i] = col[rows[i]];
+        }
+      }
+    }
+    cdt.all_to_allv(send_buf, send_counts, send_displs, sizeof(dtype),
+                    recv_buf, recv_counts, recv_displs);
+#ifdef USE_OMP
+    #pragma omp parallel for schedule(dynamic)
+#endif
+    for (int p=0; p<np; p++){
+      std::vector<int64_t> const & rows = rrow[p%pr];
+      std::vector<int64_t> const & cols = rcol[p/pr];
+      dtype const * buf = recv_buf+recv_displs[p];
+      for (int64_t j=0; j<(int64_t)cols.size(); j++){
+        dtype * col = data2+cols[j]*lda2;
+        for (int64_t i=0; i<(int64_t)rows.size(); i++){
+          col[rows[i]] = buf[j*rows.size()+i];
+        }
+      }
+    }
+    CTF_int::cdealloc(send_buf);
+    CTF_int::cdealloc(recv_buf);
+    CTF_int::cdealloc(send_counts);
+    CTF_int::cdealloc(send_displs);
+    CTF_int::cdealloc(recv_counts);
+    CTF_int::cdealloc(recv_displs);
+  }
+
+  /**
+   * \brief determines whether a matrix is distributed cyclically (without virtualization) over a
+   *        pr-by-pc processor grid whose process with coordinates (ipr, ipc) has rank ipr+ipc*pr
+   * \param[in] M matrix
+   * \param[in] pr number of rows in processor grid
+   * \param[in] pc number of cols in processor grid
+   * \param[out] ipr row of this process in processor grid
+   * \param[out] ipc col of this process in processor grid
+   * \return whether the above holds on all processes
+   */
+  template<typename dtype>
+  bool is_cyclic_on_grid(Matrix<dtype> const & M,
+                         int                   pr,
+                         int                   pc,
+                         int &                 ipr,
+                         int &                 ipc){
+    int is_cyc = !M.is_sparse && !M.is_folded && M.symm == NS && pr*pc == M.wrld->np &&
+                 M.edge_map[0].calc_phase() == pr && M.edge_map[0].calc_phys_phase() == pr &&
+                 M.edge_map[1].calc_phase() == pc && M.edge_map[1].calc_phys_phase() == pc;
+    if (is_cyc){
+      ipr = M.edge_map[0].calc_phys_rank(M.topo);
+      ipc = M.edge_map[1].calc_phys_rank(M.topo);
+      is_cyc = (M.wrld->rank == ipr+ipc*pr);
+    }
+    MPI_Allreduce(MPI_IN_PLACE, &is_cyc, 1, MPI_INT, MPI_MIN, M.wrld->comm);
+    return is_cyc;
+  }
+
   template<typename dtype>
   void Matrix<dtype>::write_mat(int           mb,
                                 int           nb,
@@ -198,20 +339,29 @@ namespace CTF {
                                 int           csrc,
                                 int           lda,
                                 dtype const * data_){
-    if (mb==1 && nb==1 && nrow%pr==0 && ncol%pc==0 && rsrc==0 && csrc==0){
-      if (this->edge_map[0].np == pr && this->edge_map[1].np == pc){
-        if (lda == nrow/pc){
-          memcpy(this->data, (char*)data_, sizeof(dtype)*this->size);
-        } else {
-          for (int i=0; i<ncol/pc; i++){
-            memcpy(this->data+i*nrow*sizeof(dtype)/pr,(char*)(data_+i*nrow/pr), nrow*sizeof(dtype)/pr);
-          }
-        }
+    bool is_done = false;
+    if (!this->is_sparse && symm == NS && pr*pc == this->wrld->np){
+      int ipr, ipc;
+      if (is_cyclic_on_grid(*this, pr, pc, ipr, ipc)){
+        bc_redist(nrow, ncol, pr, pc, ipr, ipc,
+                  mb, nb, rsrc, csrc, lda, data_,
+                  1, 1, 0, 0, this->pad_edge_len[0]/pr, (dtype*)this->data, this->wrld->cdt);
+        is_done = true;
       } else {
-        Matrix<dtype> M(nrow, ncol, mb, nb, pr, pc, rsrc, csrc, lda, data_);
-        (*this)["ab"] = M["ab"];
+        //go through a matrix mapped cyclically onto the grid, or through pairs if that mapping is not obtained
+        int plens[] = {pr, pc};
+        Partition ip(2, plens);
+        Matrix M(nrow, ncol, "ij", ip["ij"], Idx_Partition(), 0, *this->wrld, *this->sr);
+        if (is_cyclic_on_grid(M, pr, pc, ipr, ipc)){
+          bc_redist(nrow, ncol, pr, pc, ipr, ipc,
+                    mb, nb, rsrc, csrc, lda, data_,
+                    1, 1, 0, 0, M.pad_edge_len[0]/pr, (dtype*)M.data, M.wrld->cdt);
+          (*this)["ab"] = M["ab"];
+          is_done = true;
+        }
       }
-    } else {
+    }
+    if (!is_done){
       Pair<dtype> * pairs;
       int64_t nmyr, nmyc;
       get_my_kv_pair(this->wrld->rank, nrow, ncol, mb, nb, pr, pc, rsrc, csrc, nmyr, nmyc, pairs);
@@ -242,23 +392,29 @@ namespace CTF {
                                int     csrc,
                                int     lda,
                                dtype * data_){
-    if (mb==1 && nb==1 && nrow%pr==0 && ncol%pc==0 && rsrc==0 && csrc==0){
-      if (this->edge_map[0].np == pr && this->edge_map[1].np == pc){
-        if (lda == nrow/pc){
-          memcpy((char*)data_, this->data, sizeof(dtype)*this->size);
-        } else {
-          for (int i=0; i<ncol/pc; i++){
-            memcpy((char*)(data_+i*nrow/pr), this->data+i*nrow*sizeof(dtype)/pr, nrow*sizeof(dtype)/pr);
-          }
-        }
+    bool is_done = false;
+    if (!this->is_sparse && symm == NS && pr*pc == this->wrld->np){
+      int ipr, ipc;
+      if (is_cyclic_on_grid(*this, pr, pc, ipr, ipc)){
+        bc_redist(nrow, ncol, pr, pc, ipr, ipc,
+                  1, 1, 0, 0, this->pad_edge_len[0]/pr, (dtype const*)this->data,
+                  mb, nb, rsrc, csrc, lda, data_, this->wrld->cdt);
+        is_done = true;
       } else {
+        //go through a matrix mapped cyclically onto the grid, or through pairs if that mapping is not obtained
         int plens[] = {pr, pc};
         Partition ip(2, plens);
         Matrix M(nrow, ncol, "ij", ip["ij"], Idx_Partition(), 0, *this->wrld, *this->sr);
-        M["ab"] = (*this)["ab"];
-        M.read_mat(mb, nb, pr, pc, rsrc, csrc, lda, data_);
+        if (is_cyclic_on_grid(M, pr, pc, ipr, ipc)){
+          M["ab"] = (*this)["ab"];
+          bc_redist(nrow, ncol, pr, pc, ipr, ipc,
+                    1, 1, 0, 0, M.pad_edge_len[0]/pr, (dtype const*)M.data,
+                    mb, nb, rsrc, csrc, lda, data_, M.wrld->cdt);
+          is_done = true;
+        }
       }
-    } else {
+    }
+    if (!is_done){
       Pair<dtype> * pairs;
       int64_t nmyr, nmyc;
       get_my_kv_pair(this->wrld->rank, nrow, ncol, mb, nb, pr, pc, rsrc, csrc, nmyr, nmyc, pairs);
@@ -339,4 +495,214 @@ namespace CTF {
   }
 
 
+
+  /**
+   * \brief ScaLAPACK processor grid and block size chosen for a factorization of a matrix,
+   *        along with the BLACS context, which is released on destruction
+   */
+  struct bc_layout {
+    int pr, pc, ipr, ipc, b, ictxt;
+
+    /**
+     * \brief uses the processor grid on which A is cyclically distributed, if any, and otherwise
+     *        the most square grid (with more rows if A is tall), the block size is at most 64
+     *        and small enough for each process to own a block
+     */
+    template<typename dtype>
+    bc_layout(Matrix<dtype> const & A){
+      int np = A.wrld->np;
+      pr = A.edge_map[0].calc_phys_phase();
+      pc = A.edge_map[1].calc_phys_phase();
+      if (!is_cyclic_on_grid(A, pr, pc, ipr, ipc)){
+        pr = 1;
+        for (int p=1; p*p<=np; p++){
+          if (np % p == 0) pr = p;
+        }
+        pc = np/pr;
+        if (A.nrow > A.ncol) std::swap(pr, pc);
+      }
+      ipr = A.wrld->rank%pr;
+      ipc = A.wrld->rank/pr;
+      b = std::max(1, std::min(64, std::min((A.nrow+pr-1)/pr, (A.ncol+pc-1)/pc)));
+      CTF_SCALAPACK::cblacs_gridinit(A.wrld->comm, pr, pc, &ictxt);
+    }
+
+    ~bc_layout(){
+      CTF_SCALAPACK::cblacs_gridexit(ictxt);
+    }
+
+    /**
+     * \brief initializes descriptor of an m-by-n matrix in this layout and allocates its local data
+     * \return local data, to be freed with cdealloc
+     */
+    template<typename dtype>
+    dtype * alloc_mat(int m, int n, int * desc){
+      int lld = std::max(1, CTF_SCALAPACK::cnumroc(m, b, ipr, 0, pr));
+      int nlc = CTF_SCALAPACK::cnumroc(n, b, ipc, 0, pc);
+      int info;
+      CTF_SCALAPACK::cdescinit(desc, m, n, b, b, 0, 0, ictxt, lld, &info);
+      IASSERT(info == 0);
+      return (dtype*)CTF_int::alloc(sizeof(dtype)*std::max((int64_t)1, ((int64_t)lld)*nlc));
+    }
+
+    /**
+     * \brief reads A into this layout
+     */
+    template<typename dtype>
+    dtype * read_mat(Matrix<dtype> & A, int * desc){
+      dtype * data = alloc_mat<dtype>(A.nrow, A.ncol, desc);
+      A.read_mat(b, b, pr, pc, 0, 0, desc[8], data);
+      return data;
+    }
+
+    /**
+     * \brief creates matrix with the leading m-by-n block of a matrix with descriptor desc in this layout,
+     *        distributed cyclically on the same processor grid, so the data is moved once
+     */
+    template<typename dtype>
+    Matrix<dtype> write_mat(int m, int n, int const * desc, dtype const * data, World & wrld, CTF_int::algstrct const & sr){
+      int plens[] = {pr, pc};
+      Partition ip(2, plens);
+      Matrix<dtype> M(m, n, "ij", ip["ij"], Idx_Partition(), NS, wrld, sr);
+      M.write_mat(b, b, pr, pc, 0, 0, desc[8], data);
+      return M;
+    }
+
+    /**
+     * \brief global row and column of local element (i, j)
+     */
+    int64_t glb_row(int64_t i){ return (i/b)*b*pr + ipr*b + i%b; }
+    int64_t glb_col(int64_t j){ return (j/b)*b*pc + ipc*b + j%b; }
+  };
+
+  /**
+   * \brief writes values replicated on all processes into a vector
+   */
+  template<typename dtype, typename rtype>
+  void write_replicated(Vector<dtype> & v, int n, rtype const * vals){
+    int64_t nw = v.wrld->rank == 0 ? n : 0;
+    int64_t * inds = (int64_t*)CTF_int::alloc(sizeof(int64_t)*std::max(nw,(int64_t)1));
+    dtype * dvals = (dtype*)CTF_int::alloc(sizeof(dtype)*std::max(nw,(int64_t)1));
+    for (int64_t i=0; i<nw; i++){
+      inds[i] = i;
+      dvals[i] = (dtype)vals[i];
+    }
+    v.write(nw, inds, dvals);
+    CTF_int::cdealloc(inds);
+    CTF_int::cdealloc(dvals);
+  }
+
+  template<typename dtype>
+  void Matrix<dtype>::cholesky(Matrix<dtype> & L, bool lower){
+    IASSERT(nrow == ncol);
+    bc_layout bcl(*this);
+    int desc[9];
+    dtype * A = bcl.read_mat(*this, desc);
+    int info;
+    CTF_SCALAPACK::cppotrf(lower ? 'L' : 'U', nrow, A, desc, &info);
+    IASSERT(info == 0);
+    //the other triangle still holds the input
+    int64_t nlr = CTF_SCALAPACK::cnumroc(nrow, bcl.b, bcl.ipr, 0, bcl.pr);
+    int64_t nlc = CTF_SCALAPACK::cnumroc(ncol, bcl.b, bcl.ipc, 0, bcl.pc);
+    for (int64_t j=0; j<nlc; j++){
+      int64_t gj = bcl.glb_col(j);
+      for (int64_t i=0; i<nlr; i++){
+        int64_t gi = bcl.glb_row(i);
+        if (lower ? gi < gj : gi > gj) A[j*desc[8]+i] = (dtype)0;
+      }
+    }
+    L = bcl.write_mat(nrow, ncol, desc, A, *this->wrld, *this->sr);
+    CTF_int::cdealloc(A);
+  }
+
+  template<typename dtype>
+  void Matrix<dtype>::qr(Matrix<dtype> & Q, Matrix<dtype> & R){
+    int k = std::min(nrow, ncol);
+    bc_layout bcl(*this);
+    int desc[9], desc_R[9];
+    dtype * A = bcl.read_mat(*this, desc);
+    dtype * tau = (dtype*)CTF_int::alloc(sizeof(dtype)*std::max(1, CTF_SCALAPACK::cnumroc(k, bcl.b, bcl.ipc, 0, bcl.pc)));
+    int info;
+    CTF_SCALAPACK::cpgeqrf(nrow, ncol, A, desc, tau, &info);
+    IASSERT(info == 0);
+    //R is the upper triangle of the leading k rows, below it are the Householder vectors needed to form Q
+    dtype * dR = bcl.alloc_mat<dtype>(k, ncol, desc_R);
+    int64_t nlr = CTF_SCALAPACK::cnumroc(k, bcl.b, bcl.ipr, 0, bcl.pr);
+    int64_t nlc = CTF_SCALAPACK::cnumroc(ncol, bcl.b, bcl.ipc, 0, bcl.pc);
+    for (int64_t j=0; j<nlc; j++){
+      int64_t gj = bcl.glb_col(j);
+      for (int64_t i=0; i<nlr; i++){
+        dR[j*desc_R[8]+i] = bcl.glb_row(i) > gj ? (dtype)0 : A[j*desc[8]+i];
+      }
+    }
+    R = bcl.write_mat(k, ncol, desc_R, dR, *this->wrld, *this->sr);
+    CTF_int::cdealloc(dR);
+    CTF_SCALAPACK::cporgqr(nrow, k, k, A, desc, tau, &info);
+    IASSERT(info == 0);
+    Q = bcl.write_mat(nrow, k, desc, A, *this->wrld, *this->sr);
+    CTF_int::cdealloc(tau);
+    CTF_int::cdealloc(A);
+  }
+
+  template<typename dtype>
+  void Matrix<dtype>::svd(Matrix<dtype> & U, Vector<dtype> & S, Matrix<dtype> & VT, int rank){
+    typedef typename CTF_SCALAPACK::real_type<dtype>::type rtype;
+    int k = std::min(nrow, ncol);
+    bc_layout bcl(*this);
+    int desc[9], desc_U[9], desc_VT[9];
+    dtype * A = bcl.read_mat(*this, desc);
+    dtype * dU = bcl.alloc_mat<dtype>(nrow, k, desc_U);
+    dtype * dVT = bcl.alloc_mat<dtype>(k, ncol, desc_VT);
+    rtype * dS = (rtype*)CTF_int::alloc(sizeof(rtype)*std::max(k,1));
+    int info;
+    CTF_SCALAPACK::cpgesvd('V', 'V', nrow, ncol, A, desc, dS, dU, desc_U, dVT, desc_VT, &info);
+    IASSERT(info == 0);
+    CTF_int::cdealloc(A);
+    //a truncated factorization keeps the leading columns of U and rows of VT
+    if (rank <= 0 || rank > k) rank = k;
+    U = bcl.write_mat(nrow, rank, desc_U, dU, *this->wrld, *this->sr);
+    VT = bcl.write_mat(rank, ncol, desc_VT, dVT, *this->wrld, *this->sr);
+    S = Vector<dtype>(rank, *this->wrld, *this->sr);
+    write_replicated(S, rank, dS);
+    CTF_int::cdealloc(dU);
+    CTF_int::cdealloc(dVT);
+    CTF_int::cdealloc(dS);
+  }
+
+  template<typename dtype>
+  void Matrix<dtype>::eigh(Matrix<dtype> & U, Vector<dtype> & D){
+    typedef typename CTF_SCALAPACK::real_type<dtype>::type rtype;
+    IASSERT(nrow == ncol);
+    bc_layout bcl(*this);
+    int desc[9], desc_U[9];
+    dtype * A = bcl.read_mat(*this, desc);
+    dtype * dU = bcl.alloc_mat<dtype>(nrow, ncol, desc_U);
+    rtype * dD = (rtype*)CTF_int::alloc(sizeof(rtype)*std::max(nrow,1));
+    int info;
+    CTF_SCALAPACK::cpsyevd('V', 'L', nrow, A, desc, dD, dU, desc_U, &info);
+    IASSERT(info == 0);
+    CTF_int::cdealloc(A);
+    U = bcl.write_mat(nrow, ncol, desc_U, dU, *this->wrld, *this->sr);
+    D = Vector<dtype>(nrow, *this->wrld, *this->sr);
+    write_replicated(D, nrow, dD);
+    CTF_int::cdealloc(dU);
+    CTF_int::cdealloc(dD);
+  }
+
+  template<typename dtype>
+  void Matrix<dtype>::solve_tri(Matrix<dtype> & L, Matrix<dtype> & X, bool lower, bool from_left, bool transp_L){
+    IASSERT(L.nrow == L.ncol);
+    IASSERT(L.nrow == (from_left ? nrow : ncol));
+    bc_layout bcl(*this);
+    int desc_L[9], desc_B[9];
+    dtype * dL = bcl.read_mat(L, desc_L);
+    dtype * B = bcl.read_mat(*this, desc_B);
+    //'C' is the conjugate transpose for complex types and the transpose for real ones
+    CTF_SCALAPACK::cptrsm(from_left ? 'L' : 'R', lower ? 'L' : 'U', transp_L ? 'C' : 'N', 'N',
+                          nrow, ncol, (dtype)1, dL, desc_L, B, desc_B);
+    X = bcl.write_mat(nrow, ncol, desc_B, B, *this->wrld, *this->sr);
+    CTF_int::cdealloc(dL);
+    CTF_int::cdealloc(B);
+  }
+
 }
@@ -2,6 +2,8 @@
 #define __MATRIX_H__
 
 namespace CTF {
+  template<typename dtype> class Vector;
+
   /**
    * \addtogroup CTF
    * @{
@@ -132,7 +134,8 @@ namespace CTF {
 
       /**
        * \brief writes a nonsymmetric matrix from a block-cyclic initial distribution
-       *        this is `cheap' if mb=nb=1, nrow%pr=0, ncol%pc=0, rsrc=0, csrc=0, but is done via sparse read/write otherwise
+       *        this is done by a direct all-to-all redistribution if the matrix is dense and nonsymmetric and wrld has pr*pc processors,
+       *        but via sparse read/write otherwise
        *        assumes processor grid is row-major (otherwise transpose matrix)
        * \param[in] mb row block dimension
        * \param[in] nb col block dimension
@@ -156,7 +159,8 @@ namespace CTF {
  
       /**
        * \brief constructor for a nonsymmetric matrix with a block-cyclic initial distribution
-       *        this is `cheap' if mb=nb=1, nrow%pr=0, ncol%pc=0, but is done via sparse read/write otherwise
+       *        this is done by a direct all-to-all redistribution if the matrix is dense and nonsymmetric and wrld has pr*pc processors,
+       *        but via sparse read/write otherwise
        *        assumes processor grid is row-major (otherwise transpose matrix)
        * \param[in] nrow number of matrix rows
        * \param[in] ncol number of matrix columns
@@ -191,7 +195,8 @@ namespace CTF {
 
       /**
        * \brief construct Matrix from ScaLAPACK array descriptor
-       *        `cheap' if mb=nb=1, nrow%pr=0, ncol%pc=0, rsrc=0, csrc=0, but is done via sparse read/write otherwise
+       *        done by a direct all-to-all redistribution if the matrix is dense and nonsymmetric and wrld has pr*pc processors,
+       *        but via sparse read/write otherwise
        *        assumes processor grid is row-major (otherwise transpose matrix)
        * \param[in] desc ScaLAPACK descriptor array:
        *                 see ScaLAPACK docs for "Array Descriptor for In-core Dense Matrices"
@@ -210,7 +215,8 @@ namespace CTF {
 
       /**
        * \brief reads a nonsymmetric matrix into a block-cyclic initial distribution
-       *        this is `cheap' if mb=nb=1, nrow%pr=0, ncol%pc=0, rsrc=0, csrc=0, but is done via sparse read/write otherwise
+       *        this is done by a direct all-to-all redistribution if the matrix is dense and nonsymmetric and wrld has pr*pc processors,
+       *        but via sparse read/write otherwise
        *        assumes processor grid is row-major (otherwise transpose matrix)
        * \param[in] mb row block dimension
        * \param[in] nb col block dimension
@@ -233,7 +239,8 @@ namespace CTF {
  
       /**
        * \brief read Matrix into ScaLAPACK array descriptor
-       *        `cheap' if mb=nb=1, nrow%pr=0, ncol%pc=0, rsrc=0, csrc=0, but is done via sparse read/write otherwise
+       *        done by a direct all-to-all redistribution if the matrix is dense and nonsymmetric and wrld has pr*pc processors,
+       *        but via sparse read/write otherwise
        *        assumes processor grid is row-major (otherwise transpose matrix)
        * \param[in] desc ScaLAPACK descriptor array:
        *                 see ScaLAPACK docs for "Array Descriptor for In-core Dense Matrices"
@@ -246,6 +253,50 @@ namespace CTF {
        * \brief prints matrix by row and column (modify print(...) overload in set.h if you would like a different print format)
        */
       void print_matrix();
+
+      /**
+       * \brief computes the Cholesky factorization of a symmetric (Hermitian) positive definite matrix via ScaLAPACK,
+       *        the processor grid is taken from the mapping of this matrix if it is distributed cyclically on a 2D grid,
+       *        data is moved once into and out of a block-cyclic layout, available for float, double, and complex types
+       *        when CTF is built with -DUSE_SCALAPACK
+       * \param[out] L lower triangular factor, so this=L*L^H (or if lower=false upper triangular, so this=L^H*L)
+       * \param[in] lower whether to compute the lower or upper triangular factor
+       */
+      void cholesky(Matrix<dtype> & L, bool lower=true);
+
+      /**
+       * \brief computes the reduced QR factorization of this m-by-n matrix via ScaLAPACK (see cholesky())
+       * \param[out] Q m-by-min(m,n) matrix with orthonormal columns
+       * \param[out] R min(m,n)-by-n upper triangular matrix, so that this=Q*R
+       */
+      void qr(Matrix<dtype> & Q, Matrix<dtype> & R);
+
+      /**
+       * \brief computes the reduced singular value decomposition of this m-by-n matrix via ScaLAPACK (see cholesky())
+       * \param[out] U m-by-k matrix of left singular vectors
+       * \param[out] S vector of k singular values in decreasing order
+       * \param[out] VT k-by-n matrix of right singular vectors, so that this=U*diag(S)*VT
+       * \param[in] rank if positive and less than min(m,n), k=rank and the factorization is truncated, otherwise k=min(m,n)
+       */
+      void svd(Matrix<dtype> & U, Vector<dtype> & S, Matrix<dtype> & VT, int rank=0);
+
+      /**
+       * \brief computes the eigendecomposition of this symmetric (Hermitian) matrix via ScaLAPACK (see cholesky()),
+       *        only the lower triangle of this matrix is referenced
+       * \param[out] U matrix of eigenvectors
+       * \param[out] D vector of eigenvalues in increasing order, so that this=U*diag(D)*U^H
+       */
+      void eigh(Matrix<dtype> & U, Vector<dtype> & D);
+
+      /**
+       * \brief solves a triangular system with this matrix as right-hand side via ScaLAPACK (see cholesky())
+       * \param[in] L triangular matrix
+       * \param[out] X solution, so that op(L)*X=this if from_left, and X*op(L)=this otherwise
+       * \param[in] lower whether L is lower or upper triangular (the other triangle is not referenced)
+       * \param[in] from_left whether L multiplies X from the left or from the right
+       * \param[in] transp_L whether op(L)=L^H, the conjugate transpose (L^T for real types), otherwise op(L)=L
+       */
+      void solve_tri(Matrix<dtype> & L, Matrix<dtype> & X, bool lower=true, bool from_left=true, bool transp_L=false);
   };
   /**
    * @}
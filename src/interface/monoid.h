@@ -112,6 +112,11 @@ namespace CTF {
         return taddmop;        
       }
 
+      bool has_same_ops(CTF_int::algstrct const * other) const {
+        Monoid<dtype, is_ord> const * o = dynamic_cast<Monoid<dtype, is_ord> const *>(other);
+        return o != NULL && Set<dtype, is_ord>::has_same_ops(other) && o->fadd == fadd && o->taddmop == taddmop;
+      }
+
 
       void axpy(int          n,
                 char const * alpha,
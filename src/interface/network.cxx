@@ -0,0 +1,188 @@
+/*Copyright (c) 2011, Edgar Solomonik, all rights reserved.*/
+
+#include "../shared/memcontrol.h"
+
+namespace CTF {
+  template<typename dtype>
+  Network<dtype>::Network(int64_t mem_limit_){
+    mem_limit = mem_limit_;
+  }
+
+  template<typename dtype>
+  void Network<dtype>::add(Tensor<dtype> & T, char const * idx_T){
+    tensors.push_back(&T);
+    idx.push_back(std::string(idx_T, T.order));
+  }
+
+  template<typename dtype>
+  int Network<dtype>::get_plan(Tensor<dtype> const &    C,
+                               char const *             idx_C,
+                               CTF_int::network_plan &  plan) const {
+    std::vector<int const *> lens(tensors.size());
+    for (int i=0; i<(int)tensors.size(); i++){
+      lens[i] = tensors[i]->lens;
+      if (tensors[i]->wrld->comm != C.wrld->comm){
+        printf("CTF ERROR: all tensors of a network must live on the world of the output\n");
+        return CTF_int::ERROR;
+      }
+    }
+    int64_t mem = mem_limit;
+    if (mem < 0){
+      //every processor has to arrive at the same plan
+      mem = CTF_int::proc_bytes_available()/2;
+      MPI_Allreduce(MPI_IN_PLACE, &mem, 1, MPI_INT64_T, MPI_MIN, C.wrld->comm);
+    }
+    return CTF_int::plan_network(tensors.size(), idx.data(), lens.data(), std::string(idx_C, C.order),
+                                 C.sr->el_size, C.wrld->np, mem, plan);
+  }
+
+  template<typename dtype>
+  Tensor<dtype> * Network<dtype>::execute(CTF_int::network_plan const &         plan,
+                                          std::vector< Tensor<dtype> * > const & ops,
+                                          std::string &                         idx_R) const {
+    int n = ops.size();
+    std::vector< Tensor<dtype> * > val(ops);
+    std::vector< std::string > val_idx(idx);
+    for (int s=0; s<(int)plan.order.size(); s++){
+      int a = plan.order[s].first;
+      int b = plan.order[s].second;
+      std::string const & idx_Z = plan.idx_res[s];
+      std::vector<int> lens_Z(idx_Z.size());
+      for (int j=0; j<(int)idx_Z.size(); j++){
+        size_t l = val_idx[a].find(idx_Z[j]);
+        if (l != std::string::npos) lens_Z[j] = val[a]->lens[l];
+        else lens_Z[j] = val[b]->lens[val_idx[b].find(idx_Z[j])];
+      }
+      Tensor<dtype> * Z = new Tensor<dtype>(idx_Z.size(), lens_Z.data(), *val[a]->wrld, *val[a]->sr);
+      Z->contract(((dtype*)Z->sr->mulid())[0], *val[a], val_idx[a].c_str(), *val[b], val_idx[b].c_str(),
+                  ((dtype*)Z->sr->addid())[0], idx_Z.c_str());
+      if (a >= n) delete val[a];
+      if (b >= n) delete val[b];
+      val.push_back(Z);
+      val_idx.push_back(idx_Z);
+    }
+    idx_R = val_idx.back();
+    return val.back();
+  }
+
+  template<typename dtype>
+  void Network<dtype>::contract(dtype           alpha,
+                                Tensor<dtype> & C,
+                                char const *    idx_C,
+                                dtype           beta){
+    CTF_int::network_plan plan;
+    if (get_plan(C, idx_C, plan) != CTF_int::SUCCESS){
+      assert(0);
+      return;
+    }
+    dtype one = ((dtype*)C.sr->mulid())[0];
+    std::string idx_R;
+    if (plan.npiece == 1){
+      Tensor<dtype> * R = execute(plan, tensors, idx_R);
+      C.sum(alpha, *R, idx_R.c_str(), beta, idx_C);
+      if (plan.order.size() > 0) delete R;
+      return;
+    }
+
+    //each sub-world executes every nsubworld-th sub-network and accumulates its results into O
+    World * wrld = C.wrld;
+    int nsw = plan.nsubworld;
+    int color = wrld->rank*nsw/wrld->np;
+    MPI_Comm scomm;
+    World * sw = wrld;
+    if (nsw > 1){
+      MPI_Comm_split(wrld->comm, color, wrld->rank, &scomm);
+      sw = new World(scomm);
+    }
+    {
+      int n = tensors.size();
+      std::string idx_out(idx_C, C.order);
+      int max_order = C.order;
+      for (int i=0; i<n; i++){
+        max_order = std::max(max_order, tensors[i]->order);
+      }
+      std::vector<int> offsets(max_order), ends(max_order);
+      //scalars are replicated over their world and so cannot be summed over sub-worlds,
+      //the results of sub-networks contracted to a scalar carry an extra index of length one
+      std::string idx_O(idx_out);
+      std::vector<int> lens_O(C.lens, C.lens+C.order);
+      if (C.order == 0 && nsw > 1){
+        char l = 'A';
+        for (int i=0; i<n; i++){
+          if (idx[i].find(l) != std::string::npos){ l++; i=-1; }
+        }
+        idx_O.push_back(l);
+        lens_O.push_back(1);
+      }
+      Tensor<dtype> O(idx_O.size(), lens_O.data(), *sw, *C.sr);
+
+      //operands that no sliced index touches are the same for all sub-networks
+      std::vector< Tensor<dtype> * > sub(n, NULL);
+      std::vector<bool> is_sliced(n);
+      for (int i=0; i<n; i++){
+        is_sliced[i] = CTF_int::network_piece(plan, 0, idx[i], tensors[i]->lens, offsets.data(), ends.data());
+        if (is_sliced[i]) continue;
+        if (nsw == 1) sub[i] = tensors[i];
+        else {
+          sub[i] = new Tensor<dtype>(tensors[i]->order, tensors[i]->lens, tensors[i]->sym, *sw, *C.sr);
+          for (int c=0; c<nsw; c++){
+            tensors[i]->add_to_subworld(c == color ? sub[i] : NULL, one, one);
+          }
+        }
+      }
+
+      int64_t nround = (plan.npiece + nsw - 1)/nsw;
+      for (int64_t r=0; r<nround; r++){
+        std::vector< Tensor<dtype> * > ops(sub);
+        for (int i=0; i<n; i++){
+          if (!is_sliced[i]) continue;
+          for (int c=0; c<nsw && r*nsw+c<plan.npiece; c++){
+            CTF_int::network_piece(plan, r*nsw+c, idx[i], tensors[i]->lens, offsets.data(), ends.data());
+            Tensor<dtype> S = tensors[i]->slice(offsets.data(), ends.data());
+            if (nsw == 1) ops[i] = new Tensor<dtype>(S);
+            else {
+              Tensor<dtype> * T = NULL;
+              if (c == color) T = new Tensor<dtype>(S.order, S.lens, S.sym, *sw, *C.sr);
+              S.add_to_subworld(T, one, one);
+              if (c == color) ops[i] = T;
+            }
+          }
+        }
+        int64_t q = r*nsw + color;
+        if (q < plan.npiece){
+          Tensor<dtype> * R = execute(plan, ops, idx_R);
+          if (CTF_int::network_piece(plan, q, idx_out, C.lens, offsets.data(), ends.data())){
+            //the piece of the output of this sub-network is written into the corresponding block of O
+            std::vector<int> lens_B(C.order), zeros(C.order, 0);
+            for (int j=0; j<C.order; j++) lens_B[j] = ends[j] - offsets[j];
+            Tensor<dtype> B(C.order, lens_B.data(), *sw, *C.sr);
+            B.sum(one, *R, idx_R.c_str(), ((dtype*)C.sr->addid())[0], idx_C);
+            O.slice(offsets.data(), ends.data(), one, B, zeros.data(), lens_B.data(), one);
+          } else
+            O.sum(one, *R, idx_R.c_str(), one, idx_O.c_str());
+          if (plan.order.size() > 0) delete R;
+          for (int i=0; i<n; i++){
+            if (is_sliced[i]) delete ops[i];
+          }
+        }
+      }
+
+      if (nsw == 1)
+        C.sum(alpha, O, idx_C, beta, idx_C);
+      else {
+        Tensor<dtype> P(idx_O.size(), lens_O.data(), *wrld, *C.sr);
+        for (int c=0; c<nsw; c++){
+          P.add_from_subworld(c == color ? &O : NULL, one, one);
+        }
+        C.sum(alpha, P, idx_O.c_str(), beta, idx_C);
+        for (int i=0; i<n; i++){
+          if (!is_sliced[i]) delete sub[i];
+        }
+      }
+    }
+    if (nsw > 1){
+      delete sw;
+      MPI_Comm_free(&scomm);
+    }
+  }
+}
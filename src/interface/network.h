@@ -0,0 +1,85 @@
+/*Copyright (c) 2011, Edgar Solomonik, all rights reserved.*/
+
+#ifndef __NETWORK_H__
+#define __NETWORK_H__
+
+#include "../contraction/ctr_network.h"
+
+namespace CTF {
+  /**
+   * \addtogroup CTF
+   * @{
+   */
+
+  /**
+   * \brief network of tensors with labelled indices, contracted into an output by a sequence of pairwise
+   *        contractions chosen to minimize the number of operations. Indices that appear in the output are
+   *        kept, all others are summed over. When the intermediates of the chosen order do not fit in memory,
+   *        some indices are sliced, so that the network splits into independent sub-networks, which are
+   *        executed concurrently on sub-worlds and accumulated into the output.
+   * \param[in] dtype specifies tensor element type
+   */
+  template<typename dtype=double>
+  class Network {
+    public:
+      /** \brief tensors of the network, all living on the world of the output */
+      std::vector< Tensor<dtype> * > tensors;
+      /** \brief indices of each tensor */
+      std::vector< std::string > idx;
+      /** \brief bytes each processor may use for the operands and result of a contraction,
+                 if negative half of the memory available when the network is contracted */
+      int64_t mem_limit;
+
+      /**
+       * \brief creates an empty network
+       * \param[in] mem_limit bytes each processor may use for the operands and result of a contraction,
+       *            if negative half of the memory available when the network is contracted
+       */
+      Network(int64_t mem_limit=-1);
+
+      /**
+       * \brief adds a tensor to the network
+       * \param[in] T tensor, which must outlive the network
+       * \param[in] idx_T indices of T, e.g. "ijk" -> T_{ijk}
+       */
+      void add(Tensor<dtype> & T, char const * idx_T);
+
+      /**
+       * \brief finds the order of contractions and the indices to slice for contracting the network into C
+       * \param[in] C output tensor
+       * \param[in] idx_C indices of C, e.g. "ij" -> C_{ij}
+       * \param[out] plan order of contractions and slicing
+       * \return CTF_int::SUCCESS, or CTF_int::ERROR if the indices of the network are inconsistent
+       */
+      int get_plan(Tensor<dtype> const & C, char const * idx_C, CTF_int::network_plan & plan) const;
+
+      /**
+       * \brief contracts the network C[idx_C] = beta*C[idx_C] + alpha*network
+       * \param[in] alpha scaling factor of the network
+       * \param[in,out] C output tensor
+       * \param[in] idx_C indices of C, e.g. "ij" -> C_{ij}
+       * \param[in] beta scaling factor of C
+       */
+      void contract(dtype           alpha,
+                    Tensor<dtype> & C,
+                    char const *    idx_C,
+                    dtype           beta);
+
+    private:
+      /**
+       * \brief executes the contractions of plan on the operands ops, which live on the same world
+       * \param[in] plan order of contractions
+       * \param[in] ops operands of the network or of a sub-network
+       * \param[out] idx_R indices of the result
+       * \return result of the last contraction, or ops[0] if the network has a single tensor
+       */
+      Tensor<dtype> * execute(CTF_int::network_plan const &         plan,
+                              std::vector< Tensor<dtype> * > const & ops,
+                              std::string &                         idx_R) const;
+  };
+  /**
+   * @}
+   */
+}
+#include "network.cxx"
+#endif
@@ -25,6 +25,34 @@ namespace CTF_int {
     }
   }
 
+  template <typename dtype>
+  void default_hadamard(int           n,
+                        dtype const * alpha,
+                        dtype const * A,
+                        int           incA,
+                        dtype const * B,
+                        int           incB,
+                        dtype *       C,
+                        int           incC){
+    if (alpha != NULL){
+      dtype a = alpha[0];
+      for (int i=0; i<n; i++){
+        C[incC*i] += (A[incA*i]*B[incB*i])*a;
+      }
+    } else if (incA == 1 && incB == 1 && incC == 1){
+#ifdef USE_OMP
+      #pragma omp simd
+#endif
+      for (int i=0; i<n; i++){
+        C[i] += A[i]*B[i];
+      }
+    } else {
+      for (int i=0; i<n; i++){
+        C[incC*i] += A[incA*i]*B[incB*i];
+      }
+    }
+  }
+
   template <>
   void default_axpy<float>
                    (int,float,float const *,int,float *,int);
@@ -232,6 +260,7 @@ namespace CTF {
       dtype tmulid;
       void (*fscal)(int,dtype,dtype*,int);
       void (*faxpy)(int,dtype,dtype const*,int,dtype*,int);
+      void (*fhadamard)(int,dtype const*,dtype const*,int,dtype const*,int,dtype*,int);
       dtype (*fmul)(dtype a, dtype b);
       void (*fgemm)(char,char,int,int,int,dtype,dtype const*,dtype const*,dtype,dtype*);
       void (*fcoomm)(int,int,int,dtype,dtype const*,int const*,int const*,int,dtype const*,dtype,dtype*);
@@ -243,6 +272,7 @@ namespace CTF {
         this->tmulid    = other.tmulid;
         this->fscal     = other.fscal;
         this->faxpy     = other.faxpy;
+        this->fhadamard = other.fhadamard;
         this->fmul      = other.fmul;
         this->fgemm     = other.fgemm;
         this->fcoomm    = other.fcoomm;
@@ -278,6 +308,7 @@ namespace CTF {
         fmul      = fmul_;
         fgemm     = gemm_;
         faxpy     = axpy_;
+        fhadamard = NULL;
         fscal     = scal_;
         fcoomm    = coomm_;
         // if provided a coordinate MM kernel, don't use CSR
@@ -293,6 +324,7 @@ namespace CTF {
         fmul      = &CTF_int::default_mul<dtype>;
         fgemm     = &CTF_int::default_gemm<dtype>;
         faxpy     = &CTF_int::default_axpy<dtype>;
+        fhadamard = &CTF_int::default_hadamard<dtype>;
         fscal     = &CTF_int::default_scal<dtype>;
         fcoomm    = &CTF_int::default_coomm<dtype>;
         is_def = true;
@@ -328,6 +360,11 @@ namespace CTF {
 
       bool has_mul() const { return true; }
 
+      bool has_same_ops(CTF_int::algstrct const * other) const {
+        Semiring<dtype, is_ord> const * o = dynamic_cast<Semiring<dtype, is_ord> const *>(other);
+        return o != NULL && Monoid<dtype, is_ord>::has_same_ops(other) && o->fmul == fmul;
+      }
+
       /** \brief X["i"]=alpha*X["i"]; */
       void scal(int          n,
                 char const * alpha,
@@ -363,6 +400,31 @@ namespace CTF {
         }
       }
 
+      /** \brief C["i"]+=alpha*A["i"]*B["i"], where alpha may be NULL (multiplicative identity) and the strides may be zero */
+      void hadamard(int          n,
+                    char const * alpha,
+                    char const * A,
+                    int          incA,
+                    char const * B,
+                    int          incB,
+                    char       * C,
+                    int          incC)  const {
+        dtype const * dA = (dtype const *)A;
+        dtype const * dB = (dtype const *)B;
+        dtype * dC       = (dtype*)C;
+        if (fhadamard != NULL) fhadamard(n, (dtype const *)alpha, dA, incA, dB, incB, dC, incC);
+        else if (alpha == NULL){
+          for (int i=0; i<n; i++){
+            dC[i*incC] = this->fadd(fmul(dA[i*incA], dB[i*incB]), dC[i*incC]);
+          }
+        } else {
+          dtype a = ((dtype const *)alpha)[0];
+          for (int i=0; i<n; i++){
+            dC[i*incC] = this->fadd(fmul(fmul(dA[i*incA], dB[i*incB]), a), dC[i*incC]);
+          }
+        }
+      }
+
       /** \brief beta*C["ij"]=alpha*A^tA["ik"]*B^tB["kj"]; */
       void gemm(char         tA,
                 char         tB,
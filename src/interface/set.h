@@ -275,6 +275,10 @@ namespace CTF {
         return tmdtype;        
       }
 
+      bool has_same_ops(CTF_int::algstrct const * other) const {
+        return other == this || (dynamic_cast<Set<dtype, is_ord> const *>(other) != NULL && CTF_int::algstrct::has_same_ops(other));
+      }
+
       void min(char const * a, 
                char const * b,
                char *       c) const {
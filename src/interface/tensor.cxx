@@ -722,9 +722,24 @@ namespace CTF {
   template <typename dtype>
   void fill_random_base(dtype rmin, dtype rmax, Tensor<dtype> & T){
     assert(!T.is_sparse);
-    for (int64_t i=0; i<T.size; i++){
-      ((dtype*)T.data)[i] = CTF_int::get_rand48()*(rmax-rmin)+rmin;
+    //values are keyed on global index, so they do not depend on the mapping or number of processes
+    uint64_t key = T.wrld->glob_wrld_rng();
+    int64_t nrow, stride;
+    int64_t * rows;
+    T.get_local_rows(&nrow, &rows, &stride);
+    dtype * data = (dtype*)T.data;
+#ifdef USE_OMP
+    #pragma omp parallel for
+#endif
+    for (int64_t r=0; r<nrow; r++){
+      dtype * row = data+rows[3*r];
+      int64_t st = rows[3*r+1];
+      int64_t len = rows[3*r+2];
+      for (int64_t i=0; i<len; i++){
+        row[i] = CTF_int::get_rand_ctr(key, st+i*stride)*(rmax-rmin)+rmin;
+      }
     }
+    CTF_int::cdealloc(rows);
     T.zero_out_padding();
   }
 
@@ -756,47 +771,57 @@ namespace CTF {
     assert(0);
   }
 
+  #define SP_RAND_CHUNK (1<<16)
+
   template <typename dtype>
   void fill_sp_random_base(dtype rmin, dtype rmax, double frac_sp, Tensor<dtype> * T){
     int64_t tot_size = 1; //CTF_int::packed_size(T.order, T.lens, T.sym);
     for (int i=0; i<T->order; i++) tot_size *= T->lens[i];
-    double sf = tot_size*frac_sp;
-    double dg = 0.0;
-    //generate approximately tot_size*e^frac_sp rather than tot_size*frac_sp elements, to account for conflicts in writing them
-    for (int i=2; i<20; i++){
-      dg += sf;
-      sf *= frac_sp/i;
-    }
-    int64_t gen_size = (int64_t)(dg+.5);
-    int64_t my_gen_size = gen_size/T->wrld->np;
-    if (gen_size % T->wrld->np > T->wrld->rank){
-      my_gen_size++;
-    }
-    Pair<dtype> * pairs = (Pair<dtype>*)malloc(my_gen_size*sizeof(Pair<dtype>));
-    for (int64_t i=0; i<my_gen_size; i++){
-      pairs[i] = Pair<dtype>((int64_t)(CTF_int::get_rand48()*tot_size), 1.0);
+    frac_sp = std::max(0., std::min(1., frac_sp));
+    uint64_t key = T->wrld->glob_wrld_rng();
+    //the global index space is split into chunks, assigned cyclically to processes, and the number of
+    //nonzeros in each chunk is chosen so that there are round(tot_size*frac_sp) nonzeros in total
+    int64_t nchunk = (tot_size+SP_RAND_CHUNK-1)/SP_RAND_CHUNK;
+    int64_t my_nchunk = nchunk/T->wrld->np + (nchunk % T->wrld->np > T->wrld->rank);
+    int64_t * offs = (int64_t*)CTF_int::alloc(sizeof(int64_t)*(my_nchunk+1));
+    offs[0] = 0;
+    for (int64_t j=0; j<my_nchunk; j++){
+      int64_t c = T->wrld->rank + j*T->wrld->np;
+      int64_t nnz_st  = (int64_t)(c*(int64_t)SP_RAND_CHUNK*frac_sp+.5);
+      int64_t nnz_end = (int64_t)(std::min((c+1)*(int64_t)SP_RAND_CHUNK, tot_size)*frac_sp+.5);
+      offs[j+1] = offs[j] + nnz_end - nnz_st;
     }
-    T->write(my_gen_size,pairs);
-    char str[T->order];
-    for (int i=0; i<T->order; i++){
-      str[i] = 'a'+i;
-    }
-
-    Transform<dtype>([=](dtype & d){ d=CTF_int::get_rand48()*(rmax-rmin)+rmin; })(T->operator[](str));
-
-    /*std::vector<Pair<dtype>> pairs;
-
-
-    pairs.reserve(size*frac_sp);
-    int64_t npairs=0;
-    for (int64_t i=wrld->rank; i<tot_sz; i+=wrld->np){
-      if (CTF_int::get_rand48() < frac_sp){
-        pairs.push_back(Pair<dtype>(i,CTF_int::get_rand48()*(rmax-rmin)+rmin));
-        npairs++;
+    Pair<dtype> * pairs = (Pair<dtype>*)CTF_int::alloc(std::max(offs[my_nchunk],(int64_t)1)*sizeof(Pair<dtype>));
+#ifdef USE_OMP
+    #pragma omp parallel
+#endif
+    {
+      //bitmap of indices of the chunk that have been selected
+      std::vector<uint64_t> sel(SP_RAND_CHUNK/64, 0);
+#ifdef USE_OMP
+      #pragma omp for schedule(dynamic)
+#endif
+      for (int64_t j=0; j<my_nchunk; j++){
+        int64_t st = (T->wrld->rank + j*T->wrld->np)*(int64_t)SP_RAND_CHUNK;
+        int64_t n = std::min((int64_t)SP_RAND_CHUNK, tot_size-st);
+        int64_t k = offs[j+1]-offs[j];
+        Pair<dtype> * prs = pairs+offs[j];
+        //Floyd's algorithm, picks k distinct indices out of n using exactly k random numbers
+        for (int64_t t=n-k, l=0; t<n; t++, l++){
+          int64_t r = std::min(t, (int64_t)(CTF_int::get_rand_ctr(key, st+t, 1)*(t+1)));
+          if (sel[r/64] & (((uint64_t)1)<<(r%64))) r = t;
+          sel[r/64] |= ((uint64_t)1)<<(r%64);
+          prs[l] = Pair<dtype>(st+r, (dtype)(CTF_int::get_rand_ctr(key, st+r)*(rmax-rmin)+rmin));
+        }
+        for (int64_t l=0; l<k; l++){
+          int64_t r = prs[l].k-st;
+          sel[r/64] &= ~(((uint64_t)1)<<(r%64));
+        }
       }
     }
-    this->write(npairs, pairs.data());*/
-
+    T->write(offs[my_nchunk],pairs);
+    CTF_int::cdealloc(pairs);
+    CTF_int::cdealloc(offs);
   }
 
   template<>
@@ -976,5 +1001,22 @@ namespace CTF {
     return stsr;
   }
 
+  template<typename dtype>
+  void contract_batch(dtype                                  alpha,
+                      std::vector< Tensor<dtype> * > const & A,
+                      char const *                           idx_A,
+                      std::vector< Tensor<dtype> * > const & B,
+                      char const *                           idx_B,
+                      dtype                                  beta,
+                      std::vector< Tensor<dtype> * > const & C,
+                      char const *                           idx_C){
+    assert(A.size() == C.size() && B.size() == C.size());
+    std::vector<CTF_int::tensor*> tA(A.begin(), A.end());
+    std::vector<CTF_int::tensor*> tB(B.begin(), B.end());
+    std::vector<CTF_int::tensor*> tC(C.begin(), C.end());
+    CTF_int::contract_batch(C.size(), tA.data(), idx_A, tB.data(), idx_B, (char const *)&alpha,
+                            tC.data(), idx_C, (char const *)&beta);
+  }
+
 }
 
@@ -934,6 +934,30 @@ namespace CTF {
        */
       ~Tensor();
   };
+
+  /**
+   * \brief contracts C[i][idx_C] = beta*C[i][idx_C] + alpha*A[i][idx_A]*B[i][idx_B] for each i, where the tensors
+   *        of each operand all have the same shape. Contractions of dense nonsymmetric tensors living on
+   *        single-processor worlds are done together by local batched gemm, the rest one by one.
+   * \param[in] alpha A*B scaling factor
+   * \param[in] A first operand tensors
+   * \param[in] idx_A indices of A in contraction, e.g. "ik" -> A_{ik}
+   * \param[in] B second operand tensors
+   * \param[in] idx_B indices of B in contraction, e.g. "kj" -> B_{kj}
+   * \param[in] beta C scaling factor
+   * \param[in,out] C output tensors, as many as A and B
+   * \param[in] idx_C indices of C in contraction, e.g. "ij" -> C_{ij}
+   */
+  template<typename dtype>
+  void contract_batch(dtype                                  alpha,
+                      std::vector< Tensor<dtype> * > const & A,
+                      char const *                           idx_A,
+                      std::vector< Tensor<dtype> * > const & B,
+                      char const *                           idx_B,
+                      dtype                                  beta,
+                      std::vector< Tensor<dtype> * > const & C,
+                      char const *                           idx_C);
+
   /**
    * @}
    */
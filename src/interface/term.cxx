@@ -5,6 +5,11 @@
 #include "../tensor/algstrct.h"
 #include "../summation/summation.h"
 #include "../contraction/contraction.h"
+#include "../summation/ewise.h"
+#include "../shared/util.h"
+#ifdef USE_OMP
+#include "omp.h"
+#endif
 
 using namespace CTF;
 
@@ -151,6 +156,314 @@ namespace CTF_int {
   }
 
 
+  /** \brief number of elements of each operand evaluated together by a fused elementwise expression */
+  static int64_t const ewise_term_chunk = 1<<12;
+
+  /** \brief chunk buffers of fused elementwise expressions, kept across evaluations */
+  static std::vector<char> ewise_term_pool;
+
+  /** \brief maximum number of intermediates of fused elementwise expressions kept for reuse */
+  static int const ewise_intm_pool_max = 8;
+
+  /** \brief intermediates of fused elementwise expressions, kept across evaluations */
+  static std::vector<tensor*> ewise_intm_pool;
+
+  /**
+   * \brief returns an intermediate with the layout and algebraic structure of T from the pool,
+   *        or a new one if there is none, its data is not initialized
+   */
+  static tensor * get_ewise_intm(tensor const * T){
+    for (int i=(int)ewise_intm_pool.size()-1; i>=0; i--){
+      tensor * P = ewise_intm_pool[i];
+      if (same_layout(P, T) && P->sr->has_same_ops(T->sr)){
+        ewise_intm_pool.erase(ewise_intm_pool.begin()+i);
+        return P;
+      }
+    }
+    return new tensor(T, false, true);
+  }
+
+  /** \brief returns intermediate P to the pool, releasing the least recently used one if it is full */
+  static void release_ewise_intm(tensor * P){
+    if ((int)ewise_intm_pool.size() == ewise_intm_pool_max){
+      delete ewise_intm_pool[0];
+      ewise_intm_pool.erase(ewise_intm_pool.begin());
+    }
+    ewise_intm_pool.push_back(P);
+  }
+
+  void free_ewise_intms(World const * wrld){
+    for (int i=(int)ewise_intm_pool.size()-1; i>=0; i--){
+      if (ewise_intm_pool[i]->wrld == wrld){
+        delete ewise_intm_pool[i];
+        ewise_intm_pool.erase(ewise_intm_pool.begin()+i);
+      }
+    }
+  }
+
+  /**
+   * \brief node of an elementwise expression over the indices and distribution of an output tensor,
+   *        either an operand tensor or a sum or (Hadamard) product of nodes
+   */
+  struct ewise_node {
+    /** \brief operand tensor, NULL for sums and products */
+    tensor * tsr;
+    /** \brief sum or contract term materialized into tsr before the fused loop, otherwise NULL */
+    Term const * term;
+    /** \brief whether ops are multiplied rather than added */
+    bool is_prod;
+    /** \brief scaling factor of the node, empty if it is the multiplicative identity */
+    std::vector<char> scale;
+    std::vector<ewise_node> ops;
+
+    ewise_node(){ tsr = NULL; term = NULL; is_prod = false; }
+  };
+
+  /**
+   * \brief returns true if output is a dense tensor with distinct indices that fused elementwise
+   *        expressions may be evaluated into
+   */
+  static bool ewise_output(Idx_Tensor const & output){
+    tensor const * T = output.parent;
+    if (T == NULL || output.mask != NULL || T->order == 0 || !T->sr->has_mul()) return false;
+    for (int i=0; i<T->order; i++){
+      for (int j=0; j<i; j++){
+        if (output.idx_map[i] == output.idx_map[j]) return false;
+      }
+    }
+    return true;
+  }
+
+  static void set_ewise_scale(ewise_node & node, algstrct const * sr, char const * scale){
+    if (scale == NULL || sr->isequal(scale, sr->mulid())) node.scale.clear();
+    else node.scale.assign(scale, scale+sr->el_size);
+  }
+
+  /**
+   * \brief returns true if the tensors of term t carry every index of output and, unless t is a
+   *        contract term, no others, so that t can be evaluated into a tensor elementwise with output,
+   *        the other indices of a contract term are summed over within it, as they appear in no other
+   *        operand of an elementwise expression
+   */
+  static bool covers_ewise_idx(Term const * t, Idx_Tensor const & output){
+    std::set<Idx_Tensor*, tensor_name_less> inputs;
+    t->get_inputs(&inputs);
+    std::set<char> idx;
+    for (std::set<Idx_Tensor*>::iterator it=inputs.begin(); it!=inputs.end(); it++){
+      if ((*it)->parent == NULL) continue;
+      for (int i=0; i<(*it)->parent->order; i++){
+        idx.insert((*it)->idx_map[i]);
+      }
+    }
+    if ((int)idx.size() != output.parent->order && dynamic_cast<Contract_Term const*>(t) == NULL) return false;
+    for (int i=0; i<output.parent->order; i++){
+      if (idx.find(output.idx_map[i]) == idx.end()) return false;
+    }
+    return true;
+  }
+
+  /**
+   * \brief builds the elementwise expression of term t over output, without executing anything
+   * \param[in] t term to build the expression of
+   * \param[in] output tensor and indices the expression is evaluated into
+   * \param[in] nested if true, a sum or contract term which is not itself elementwise but carries
+   *            the indices of output (see covers_ewise_idx) becomes an operand evaluated into an
+   *            intermediate elementwise with output, e.g. R["ij"]*x["j"] in d["i"]*(b["i"]-R["ij"]*x["j"])
+   * \param[out] node expression of t
+   * \return false if t is not an elementwise expression over output
+   */
+  static bool build_ewise(Term const *       t,
+                          Idx_Tensor const & output,
+                          bool               nested,
+                          ewise_node &       node){
+    algstrct const * sr = output.parent->sr;
+    Idx_Tensor const * it = dynamic_cast<Idx_Tensor const*>(t);
+    if (it != NULL){
+      if (it->parent == NULL || it->mask != NULL || !same_layout(it->parent, output.parent)) return false;
+      if (memcmp(it->idx_map, output.idx_map, output.parent->order*sizeof(char)) != 0) return false;
+      node.tsr = it->parent;
+      set_ewise_scale(node, sr, it->scale);
+      return true;
+    }
+    Sum_Term const * st = dynamic_cast<Sum_Term const*>(t);
+    Contract_Term const * ct = dynamic_cast<Contract_Term const*>(t);
+    if (st == NULL && ct == NULL) return false;
+    std::vector<Term*> const & ops = st != NULL ? st->operands : ct->operands;
+    node.is_prod = (ct != NULL);
+    set_ewise_scale(node, sr, t->scale);
+    //the packed storage of antisymmetric and symmetric-hollow tensors is not closed under products
+    bool is_ewise = true;
+    for (int i=0; node.is_prod && i<output.parent->order; i++){
+      if (output.parent->sym[i] != NS && output.parent->sym[i] != SY) is_ewise = false;
+    }
+    for (int i=0; is_ewise && i<(int)ops.size(); i++){
+      Idx_Tensor const * op = dynamic_cast<Idx_Tensor const*>(ops[i]);
+      if (node.is_prod && op != NULL && op->parent == NULL){
+        if (node.scale.empty()) set_ewise_scale(node, sr, op->scale);
+        else if (op->scale != NULL) sr->mul(&node.scale[0], op->scale, &node.scale[0]);
+        continue;
+      }
+      node.ops.push_back(ewise_node());
+      is_ewise = build_ewise(ops[i], output, true, node.ops.back());
+    }
+    if (is_ewise && !node.ops.empty()) return true;
+    node.ops.clear();
+    node.scale.clear();
+    if (!nested || !covers_ewise_idx(t, output)) return false;
+    node.term = t;
+    return true;
+  }
+
+  /**
+   * \brief executes each term of the expression to be materialized into an intermediate from the pool
+   *        with the indices and distribution of output, and realigns operands whose mapping that changed
+   */
+  static void materialize_ewise(ewise_node &          node,
+                                Idx_Tensor const &    output,
+                                std::vector<tensor*> & intms){
+    for (int i=0; i<(int)node.ops.size(); i++){
+      materialize_ewise(node.ops[i], output, intms);
+    }
+    if (node.term == NULL) return;
+    tensor * P = get_ewise_intm(output.parent);
+    Idx_Tensor iP(P, output.idx_map);
+    P->sr->safecopy(iP.scale, P->sr->addid());
+    node.term->execute(iP);
+    node.tsr = P;
+    intms.push_back(P);
+  }
+
+  static void align_ewise(ewise_node & node, tensor const * T){
+    if (node.tsr != NULL && !same_layout(node.tsr, T)) node.tsr->align(T);
+    for (int i=0; i<(int)node.ops.size(); i++){
+      align_ewise(node.ops[i], T);
+    }
+  }
+
+  /** \brief number of chunk buffers needed to evaluate node */
+  static int ewise_nbuf(ewise_node const & node){
+    if (node.tsr != NULL) return 0;
+    int nbuf = ewise_nbuf(node.ops[0]);
+    if (node.is_prod) nbuf = std::max(nbuf, 2);
+    for (int i=1; i<(int)node.ops.size(); i++){
+      if (node.ops[i].tsr == NULL) nbuf = std::max(nbuf, 1+ewise_nbuf(node.ops[i]));
+    }
+    return nbuf;
+  }
+
+  /** \brief returns true if node multiplies any operands, which may make padding nonzero (e.g. 0*inf) */
+  static bool ewise_has_prod(ewise_node const & node){
+    if (node.is_prod) return true;
+    for (int i=0; i<(int)node.ops.size(); i++){
+      if (ewise_has_prod(node.ops[i])) return true;
+    }
+    return false;
+  }
+
+  /** \brief number of operations done per element to evaluate node */
+  static int64_t ewise_nflop(ewise_node const & node){
+    int64_t nflop = node.scale.empty() ? 0 : 1;
+    for (int i=0; i<(int)node.ops.size(); i++){
+      nflop += ewise_nflop(node.ops[i]) + (i>0);
+    }
+    return nflop;
+  }
+
+  /**
+   * \brief evaluates elements [st, st+n) of node into out
+   * \param[in] node expression to evaluate
+   * \param[in] sr algebraic structure of the elements
+   * \param[in] st offset of the first element in the local data
+   * \param[in] n number of elements, at most ewise_term_chunk
+   * \param[out] out buffer of n elements
+   * \param[in] bufs ewise_nbuf(node) consecutive chunk buffers to use as temporaries
+   */
+  static void eval_ewise(ewise_node const & node,
+                         algstrct const *   sr,
+                         int64_t            st,
+                         int                n,
+                         char *             out,
+                         char *             bufs){
+    int64_t sz = sr->el_size;
+    if (node.tsr != NULL){
+      sr->copy(out, node.tsr->data+st*sz, n);
+    } else {
+      eval_ewise(node.ops[0], sr, st, n, out, bufs);
+      for (int i=1; i<(int)node.ops.size(); i++){
+        ewise_node const & op = node.ops[i];
+        char const * src = bufs;
+        char const * alpha = NULL;
+        if (op.tsr != NULL){
+          src = op.tsr->data+st*sz;
+          if (!op.scale.empty()) alpha = &op.scale[0];
+        } else eval_ewise(op, sr, st, n, bufs, bufs+ewise_term_chunk*sz);
+        if (node.is_prod){
+          char * prd = bufs+ewise_term_chunk*sz;
+          sr->set(prd, sr->addid(), n);
+          sr->hadamard(n, alpha, out, 1, src, 1, prd, 1);
+          sr->copy(out, prd, n);
+        } else sr->axpy(n, alpha == NULL ? sr->mulid() : alpha, src, 1, out, 1);
+      }
+    }
+    if (!node.scale.empty()) sr->scal(n, &node.scale[0], out, 1);
+  }
+
+  /**
+   * \brief evaluates output = output.scale*output + node in a single pass over the local data of output,
+   *        materializing only the operands which are not themselves elementwise
+   */
+  static void execute_ewise(ewise_node & node, Idx_Tensor const & output){
+    TAU_FSTART(execute_ewise);
+    std::vector<tensor*> intms;
+    materialize_ewise(node, output, intms);
+    tensor * T = output.parent;
+    align_ewise(node, T);
+    algstrct const * sr = T->sr;
+    int64_t sz = sr->el_size;
+    char const * beta = output.scale == NULL ? sr->mulid() : output.scale;
+    bool is_zero = sr->isequal(beta, sr->addid());
+    bool is_one = sr->isequal(beta, sr->mulid());
+
+    int nthread = 1;
+#ifdef USE_OMP
+    nthread = omp_get_max_threads();
+#endif
+    int64_t bufsz = (1+ewise_nbuf(node))*ewise_term_chunk*sz;
+    if ((int64_t)ewise_term_pool.size() < nthread*bufsz) ewise_term_pool.resize(nthread*bufsz);
+    char * pool = &ewise_term_pool[0];
+    char * dT = T->data;
+    int64_t n_tot = T->size;
+    int64_t nchunk = (n_tot+ewise_term_chunk-1)/ewise_term_chunk;
+#ifdef USE_OMP
+    #pragma omp parallel for schedule(static) if (nchunk > 1)
+#endif
+    for (int64_t c=0; c<nchunk; c++){
+      int tid = 0;
+#ifdef USE_OMP
+      tid = omp_get_thread_num();
+#endif
+      char * val = pool+tid*bufsz;
+      int64_t st = c*ewise_term_chunk;
+      int n = (int)std::min(ewise_term_chunk, n_tot-st);
+      eval_ewise(node, sr, st, n, val, val+ewise_term_chunk*sz);
+      if (is_zero) sr->copy(dT+st*sz, val, n);
+      else {
+        if (!is_one) sr->scal(n, beta, dT+st*sz, 1);
+        sr->axpy(n, sr->mulid(), val, 1, dT+st*sz, 1);
+      }
+    }
+    CTF_FLOPS_ADD((ewise_nflop(node)+(is_zero ? 0 : (is_one ? 1 : 2)))*n_tot);
+  #ifndef SEQ
+    //as after a contraction, padding is restored to zero
+    if (T->is_cyclic && ewise_has_prod(node)) T->zero_out_padding();
+  #endif
+    for (int i=0; i<(int)intms.size(); i++){
+      release_ewise_intm(intms[i]);
+    }
+    TAU_FSTOP(execute_ewise);
+  }
+
+
   //general Term functions, see ../../include/ctf.hpp for doxygen comments
 
   /*Term::operator dtype() const {
@@ -412,12 +725,40 @@ namespace CTF_int {
 
   void Sum_Term::execute(Idx_Tensor output) const{
     std::vector< Term* > tmp_ops = operands;
+    if (ewise_output(output) && sr->isequal(this->scale, sr->mulid())){
+      //fuse the elementwise operands into one pass, the others are summed into output as before,
+      //which is only reordered if none of them reads output
+      ewise_node node;
+      std::vector< Term* > rest_ops;
+      for (int i=0; i<(int)operands.size(); i++){
+        node.ops.push_back(ewise_node());
+        if (!build_ewise(operands[i], output, false, node.ops.back())){
+          node.ops.pop_back();
+          rest_ops.push_back(operands[i]);
+        }
+      }
+      std::set<Idx_Tensor*, tensor_name_less > inputs;
+      for (int i=0; i<(int)rest_ops.size(); i++){
+        rest_ops[i]->get_inputs(&inputs);
+      }
+      bool reads_output = false;
+      for (std::set<Idx_Tensor*>::iterator j=inputs.begin(); j!=inputs.end(); j++){
+        if ((*j)->parent == output.parent) reads_output = true;
+      }
+      if (!node.ops.empty() && !reads_output){
+        execute_ewise(node, output);
+        if (rest_ops.empty()) return;
+        sr->safecopy(output.scale, sr->mulid());
+        tmp_ops = rest_ops;
+      }
+    }
     for (int i=0; i<((int)tmp_ops.size())-1; i++){
       tmp_ops[i]->execute(output);
       sr->safecopy(output.scale, sr->mulid());
     }
     Idx_Tensor itsr = tmp_ops.back()->execute();
     summation s(itsr.parent, itsr.idx_map, itsr.scale, output.parent, output.idx_map, output.scale);
+    if (output.mask != NULL) s.set_mask(output.mask, output.mask_idx_map, output.idx_map, output.mask_cmp);
     s.execute();
   }
 
@@ -491,6 +832,13 @@ namespace CTF_int {
 
 
   void Contract_Term::execute(Idx_Tensor output)const {
+    if (ewise_output(output)){
+      ewise_node node;
+      if (build_ewise(this, output, false, node)){
+        execute_ewise(node, output);
+        return;
+      }
+    }
     std::vector< Term* > tmp_ops;
     for (int i=0; i<(int)operands.size(); i++){
       tmp_ops.push_back(operands[i]->clone());
@@ -560,15 +908,18 @@ namespace CTF_int {
       } else if (op_A.parent == NULL){
         summation s(op_B.parent, op_B.idx_map, tscale,
                     output.parent, output.idx_map, output.scale);
+        if (output.mask != NULL) s.set_mask(output.mask, output.mask_idx_map, output.idx_map, output.mask_cmp);
         s.execute();
       } else if (op_B.parent == NULL){
         summation s(op_A.parent, op_A.idx_map, tscale,
                     output.parent, output.idx_map, output.scale);
+        if (output.mask != NULL) s.set_mask(output.mask, output.mask_idx_map, output.idx_map, output.mask_cmp);
         s.execute();
       } else {
         contraction c(op_A.parent, op_A.idx_map,
                       op_B.parent, op_B.idx_map, tscale,
                       output.parent, output.idx_map, output.scale);
+        if (output.mask != NULL) c.set_mask(output.mask, output.mask_idx_map, output.idx_map, output.mask_cmp);
         c.execute();
       }
       if (tscale != NULL) cdealloc(tscale);
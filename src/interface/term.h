@@ -18,6 +18,12 @@ namespace CTF_int {
   class Sum_Term;
   class Contract_Term;
 
+  /**
+   * \brief deletes the intermediates kept for reuse by fused elementwise expressions on wrld
+   * \param[in] wrld world being destroyed
+   */
+  void free_ewise_intms(CTF::World const * wrld);
+
   /**
    * \brief comparison function for sets of tensor pointers
    * This ensures the set iteration order is consistent across nodes
@@ -90,6 +90,41 @@ namespace CTF {
   };
 
 
+  /**
+   * \brief predicted and measured cost of one contraction, recorded by a World
+   *        between World::begin_ctr_reports() and World::end_ctr_reports(),
+   *        times are in seconds and local to this process
+   */
+  struct Contraction_report {
+    /** \brief contraction in the format C[0 1] <- A[0 2]*B[2 1] */
+    std::string expr;
+    /** \brief mappings of A, B, and C chosen for the contraction (last one if several were needed) */
+    std::string mapping;
+    /** \brief execution time of the chosen contraction algorithm predicted by the performance models */
+    double est_time;
+    /** \brief total time spent in the contraction */
+    double tot_time;
+    /** \brief time spent searching for the best mapping, excluding redistribution */
+    double map_time;
+    /** \brief time spent redistributing tensors, including communication */
+    double redist_time;
+    /** \brief time spent folding (transposing) tensors into and out of matrix layout */
+    double fold_time;
+    /** \brief time spent in local contraction kernels */
+    double kernel_time;
+    /** \brief time spent in collectives outside of redistribution */
+    double comm_time;
+    /** \brief bytes sent by collectives, including redistribution */
+    int64_t comm_bytes;
+    /** \brief number of local flops counted by the kernels */
+    int64_t flops;
+    /** \brief peak bytes per process predicted for the buffers of the chosen mappings (largest if several were needed) */
+    int64_t est_mem;
+    /** \brief peak bytes per process allocated by the contraction, observed */
+    int64_t peak_mem;
+  };
+
+
   /**
    * \brief a term is an abstract object representing some expression of tensors
    */
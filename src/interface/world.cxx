@@ -2,9 +2,12 @@
 
 #include "common.h"
 #include "world.h"
+#include "term.h"
 #include "../shared/util.h"
 #include "../shared/memcontrol.h"
 #include "../shared/offload.h"
+#include "../shared/trace.h"
+#include <map>
 
 extern "C"
 {
@@ -66,6 +69,7 @@ namespace CTF {
 #endif
     //ASSERT(0);
     this->init(comm, other.phys_topology->order, other.phys_topology->lens, 0, NULL);
+    mem_budget = other.mem_budget;
 /*    cdt         = other.cdt;
     rank        = other.rank;
     np          = other.np;
@@ -80,11 +84,13 @@ namespace CTF {
   World::World(char const * emptystring){}
 
   World::~World(){
+    CTF_int::free_ewise_intms(this);
     if (!is_copy && this != &universe){
       for (int i=0; i<(int)topovec.size(); i++){
         delete topovec[i];
       }
       delete phys_topology;
+      CTF_int::comm_cache_free(cdt.cm);
       if (this->cdt.cm == MPI_COMM_WORLD){
         ASSERT(universe_exists);
         universe_exists = false;
@@ -102,11 +108,117 @@ namespace CTF {
       HPM_Stop("CTF");
 #endif
       TAU_FSTOP(CTF);
+#ifdef TRACE
+      CTF_int::trace_flush();
+#endif
     }
 
   }
 
 
+  void World::begin_ctr_reports(){
+    ctr_reports.clear();
+    record_ctr_reports = true;
+  }
+
+  void World::end_ctr_reports(){
+    record_ctr_reports = false;
+  }
+
+  void World::set_comm_cache_limit(int limit){
+    CTF_int::comm_cache_set_limit(cdt.cm, limit);
+  }
+
+  void World::get_comm_cache_stats(int64_t & nhit, int64_t & nmiss, int & ncomm){
+    CTF_int::comm_cache_stats(cdt.cm, nhit, nmiss, ncomm);
+  }
+
+  struct ctr_report_sum {
+    std::string name;
+    int ncalls;
+    double times[7];
+    int64_t cnts[2];
+    int64_t mems[2];
+
+    bool operator<(ctr_report_sum const & other) const {
+      return times[1] > other.times[1];
+    }
+  };
+
+  void World::print_ctr_reports(int ntop, FILE * stream){
+    int64_t nrep = ctr_reports.size();
+    int64_t min_nrep;
+    MPI_Allreduce(&nrep, &min_nrep, 1, MPI_INT64_T, MPI_MIN, comm);
+    if (min_nrep != nrep){
+      if (rank == 0)
+        printf("CTF WARNING: processes recorded a different number of contraction reports, printing only the first %ld\n", min_nrep);
+      nrep = min_nrep;
+    }
+    //order of times is est, tot, map, redist, fold, kernel, comm
+    double * times = (double*)CTF_int::alloc(sizeof(double)*7*std::max(nrep,(int64_t)1));
+    int64_t * cnts = (int64_t*)CTF_int::alloc(sizeof(int64_t)*2*std::max(nrep,(int64_t)1));
+    int64_t * mems = (int64_t*)CTF_int::alloc(sizeof(int64_t)*2*std::max(nrep,(int64_t)1));
+    for (int64_t i=0; i<nrep; i++){
+      Contraction_report const & r = ctr_reports[i];
+      times[7*i]   = r.est_time;
+      times[7*i+1] = r.tot_time;
+      times[7*i+2] = r.map_time;
+      times[7*i+3] = r.redist_time;
+      times[7*i+4] = r.fold_time;
+      times[7*i+5] = r.kernel_time;
+      times[7*i+6] = r.comm_time;
+      cnts[2*i]    = r.comm_bytes;
+      cnts[2*i+1]  = r.flops;
+      mems[2*i]    = r.est_mem;
+      mems[2*i+1]  = r.peak_mem;
+    }
+    MPI_Allreduce(MPI_IN_PLACE, times, 7*nrep, MPI_DOUBLE, MPI_MAX, comm);
+    MPI_Allreduce(MPI_IN_PLACE, cnts, 2*nrep, MPI_INT64_T, MPI_SUM, comm);
+    MPI_Allreduce(MPI_IN_PLACE, mems, 2*nrep, MPI_INT64_T, MPI_MAX, comm);
+    if (rank == 0){
+      std::map<std::string, ctr_report_sum> sums;
+      double tot_time = 0.0;
+      for (int64_t i=0; i<nrep; i++){
+        std::string name = ctr_reports[i].expr + " " + ctr_reports[i].mapping;
+        std::map<std::string, ctr_report_sum>::iterator it = sums.find(name);
+        if (it == sums.end()){
+          ctr_report_sum rs;
+          rs.name = name;
+          rs.ncalls = 0;
+          std::fill(rs.times, rs.times+7, 0.0);
+          std::fill(rs.cnts, rs.cnts+2, 0);
+          std::fill(rs.mems, rs.mems+2, 0);
+          it = sums.insert(std::pair<std::string, ctr_report_sum>(name, rs)).first;
+        }
+        it->second.ncalls++;
+        for (int j=0; j<7; j++) it->second.times[j] += times[7*i+j];
+        for (int j=0; j<2; j++) it->second.cnts[j] += cnts[2*i+j];
+        for (int j=0; j<2; j++) it->second.mems[j] = std::max(it->second.mems[j], mems[2*i+j]);
+        tot_time += times[7*i+1];
+      }
+      std::vector<ctr_report_sum> vsums;
+      for (std::map<std::string, ctr_report_sum>::iterator it=sums.begin(); it!=sums.end(); it++){
+        vsums.push_back(it->second);
+      }
+      std::sort(vsums.begin(), vsums.end());
+      if (ntop < 0 || ntop > (int)vsums.size()) ntop = vsums.size();
+      fprintf(stream, "CTF: %ld contractions (%d distinct) took %lf sec, times are max over processes, bytes and flops are totals, memory is max per process\n",
+              nrep, (int)vsums.size(), tot_time);
+      fprintf(stream, "%6s %11s %11s %11s %11s %11s %11s %11s %11s %11s %11s %11s %11s  %s\n",
+              "calls", "time", "predicted", "map", "redist", "fold", "kernel", "comm", "other", "bytes", "flops", "pred mem", "peak mem", "contraction mapping");
+      for (int i=0; i<ntop; i++){
+        ctr_report_sum const & rs = vsums[i];
+        double other = std::max(0., rs.times[1]-rs.times[2]-rs.times[3]-rs.times[4]-rs.times[5]-rs.times[6]);
+        fprintf(stream, "%6d %11.6lf %11.6lf %11.6lf %11.6lf %11.6lf %11.6lf %11.6lf %11.6lf %11.4E %11.4E %11.4E %11.4E  %s\n",
+                rs.ncalls, rs.times[1], rs.times[0], rs.times[2], rs.times[3], rs.times[4], rs.times[5], rs.times[6], other,
+                (double)rs.cnts[0], (double)rs.cnts[1], (double)rs.mems[0], (double)rs.mems[1], rs.name.c_str());
+      }
+    }
+    CTF_int::cdealloc(times);
+    CTF_int::cdealloc(cnts);
+    CTF_int::cdealloc(mems);
+  }
+
   int World::init(MPI_Comm const  global_context,
                   TOPOLOGY        mach,
                   int             argc,
@@ -152,9 +264,16 @@ namespace CTF {
         printf("topovec size is %ld, via old method was %ld\n",topovec.size(), topovec2.size());*/
       } else
         topovec = peel_perm_torus(phys_topology, cdt);
+      CTF_int::comm_cache_retain(cdt.cm);
+      char * comm_cache_size = getenv("CTF_COMM_CACHE_SIZE");
+      if (comm_cache_size != NULL)
+        CTF_int::comm_cache_set_limit(cdt.cm, atoi(comm_cache_size));
     }
     CTF_int::mem_create();
     if (CTF_int::get_num_instances() == 1){
+#ifdef TRACE
+      CTF_int::trace_init(cdt.cm);
+#endif
       TAU_FSTART(CTF);
   #ifdef HPM
       HPM_Start("CTF");
@@ -239,6 +358,9 @@ namespace CTF {
       if (rank == 0)
         VPRINTF(1,"Total amount of memory available to process 0 is %ld\n", proc_bytes_available());
     } 
+    record_ctr_reports = false;
+    ctr_reports.clear();
+    mem_budget = 0;
     initialized = 1;
     if (comm == MPI_COMM_WORLD){
       if (!universe_exists){
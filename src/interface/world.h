@@ -3,6 +3,7 @@
 
 #include "common.h"
 #include "../mapping/topology.h"
+#include "timer.h"
 
 namespace CTF {
   /**
@@ -37,6 +38,18 @@ namespace CTF {
                                0x5555555555555555, 17,
                                0x71d67fffeda60000, 37,
                                0xfff7eee000000000, 43, 6364136223846793005> glob_wrld_rng;
+      /** \brief whether contractions on this world are being recorded into ctr_reports */
+      bool record_ctr_reports;
+      /** \brief cost reports of contractions executed since begin_ctr_reports() */
+      std::vector<Contraction_report> ctr_reports;
+      /**
+       * \brief bytes per process that a contraction on this world may use for its operands and the buffers
+       *        needed to contract them, 0 (default) if limited only by the memory available; contractions
+       *        choose the fastest mapping whose predicted peak memory fits (ignoring the budget if none does),
+       *        and dense ones that would exceed it are done in slabs along an index of the output,
+       *        antisymmetric operands whose unpacking would exceed it are contracted in packed form
+       */
+      int64_t mem_budget;
 
 
 
@@ -92,6 +105,42 @@ namespace CTF {
       ~World();
 
 
+      /**
+       * \brief clears any previous reports and starts recording a Contraction_report
+       *        for each contraction executed on this world
+       */
+      void begin_ctr_reports();
+
+      /**
+       * \brief stops recording contraction reports, recorded reports remain in ctr_reports
+       */
+      void end_ctr_reports();
+
+      /**
+       * \brief prints recorded contraction reports (collective), aggregating contractions with
+       *        the same expression and mapping, sorted by total time, taking the maximum
+       *        time and the total bytes and flops over all processes
+       * \param[in] ntop number of most expensive contractions to print, all if negative
+       * \param[in] stream output stream (only used on rank 0)
+       */
+      void print_ctr_reports(int ntop=-1, FILE * stream=stdout);
+
+      /**
+       * \brief sets how many communicators of processor grid dimensions are kept between contractions
+       *        and summations on this world (default 128, or the CTF_COMM_CACHE_SIZE environment variable),
+       *        the least recently used ones are freed beyond it (collective)
+       * \param[in] limit maximum number of cached communicators
+       */
+      void set_comm_cache_limit(int limit);
+
+      /**
+       * \brief gives statistics of the communicator cache of this world
+       * \param[out] nhit number of grid dimension communicators reused from the cache
+       * \param[out] nmiss number of grid dimension communicators that had to be split off
+       * \param[out] ncomm number of communicators currently cached
+       */
+      void get_comm_cache_stats(int64_t & nhit, int64_t & nmiss, int & ncomm);
+
       bool operator==(World const & other){ return comm==other.comm; }
       bool is_copy;
     private:
@@ -3,6 +3,7 @@
 #include "topology.h"
 #include "../shared/util.h"
 #include "../mapping/mapping.h"
+#include <map>
 
 #ifdef BGQ
 #include "mpix.h"
@@ -39,7 +40,8 @@ namespace CTF_int {
       dim_comm[i] = CommData(other.dim_comm[i]);
     }
 
-    is_activated = other.is_activated;
+    //the copy shares the communicators of other but does not hold them in the communicator cache
+    is_activated = false;
   }
 
   topology::topology(int         order_,
@@ -73,24 +75,149 @@ namespace CTF_int {
       this->activate();
   }
 
+  /* \brief communicator of a processor grid dimension, determined by the grid lengths and the dimension */
+  struct cached_comm {
+    std::vector<int> lens;
+    int              dim;
+    MPI_Comm         cm;
+    /* number of activated topologies using cm */
+    int              npin;
+  };
+
+  /* \brief communicators split off of one parent communicator, most recently used first */
+  struct comm_cache {
+    std::list<cached_comm> comms;
+    int                    limit;
+    int64_t                nhit;
+    int64_t                nmiss;
+    /* number of worlds on the parent communicator sharing the cache */
+    int                    nworld;
+    comm_cache(){
+      limit  = 128;
+      nhit   = 0;
+      nmiss  = 0;
+      nworld = 0;
+    }
+  };
+
+  /* every rank of a parent communicator activates and deactivates topologies in the same order, so the
+     cached set and eviction order of each cache are the same on all of them, and communicators are freed
+     collectively */
+  static std::map<MPI_Comm, comm_cache> comm_caches;
+
+  /**
+   * \brief frees the least recently used communicators that are not in use until at most limit are cached
+   */
+  static void evict(comm_cache & cc){
+    std::list<cached_comm>::iterator it = cc.comms.end();
+    while ((int)cc.comms.size() > cc.limit && it != cc.comms.begin()){
+      it--;
+      if (it->npin == 0){
+        MPI_Comm_free(&it->cm);
+        it = cc.comms.erase(it);
+      }
+    }
+  }
+
   void topology::activate(){
     if (!is_activated){
+      comm_cache & cc = comm_caches[glb_comm.cm];
       for (int i=0; i<order; i++){
-        dim_comm[i].activate(glb_comm.cm);
+        std::list<cached_comm>::iterator it = cc.comms.begin();
+        while (it != cc.comms.end() && (it->dim != i || (int)it->lens.size() != order ||
+                                        memcmp(it->lens.data(), lens, sizeof(int)*order) != 0))
+          it++;
+        if (it != cc.comms.end()){
+          cc.nhit++;
+          cc.comms.splice(cc.comms.begin(), cc.comms, it);
+        } else {
+          cc.nmiss++;
+          cached_comm c;
+          c.lens = std::vector<int>(lens, lens+order);
+          c.dim  = i;
+          c.npin = 0;
+          MPI_Comm_split(glb_comm.cm, dim_comm[i].color, dim_comm[i].rank, &c.cm);
+          cc.comms.push_front(c);
+        }
+        cc.comms.front().npin++;
+        //the communicator is owned by the cache, so the CommData is marked as not created by it
+        dim_comm[i].cm      = cc.comms.front().cm;
+        dim_comm[i].alive   = 1;
+        dim_comm[i].created = 0;
       }
+      evict(cc);
     } 
     is_activated = true;
   }
 
   void topology::deactivate(){
     if (is_activated){
+      int is_finalized;
+      MPI_Finalized(&is_finalized);
+      std::map<MPI_Comm, comm_cache>::iterator cit = comm_caches.find(glb_comm.cm);
       for (int i=0; i<order; i++){
         dim_comm[i].deactivate();
+        if (!is_finalized && cit != comm_caches.end()){
+          for (std::list<cached_comm>::iterator it=cit->second.comms.begin(); it!=cit->second.comms.end(); it++){
+            if (it->cm == dim_comm[i].cm){
+              it->npin--;
+              break;
+            }
+          }
+        }
       }
+      if (!is_finalized && cit != comm_caches.end()) evict(cit->second);
     } 
     is_activated = false;
   }
 
+  void comm_cache_set_limit(MPI_Comm parent, int limit){
+    comm_cache & cc = comm_caches[parent];
+    cc.limit = std::max(0, limit);
+    evict(cc);
+  }
+
+  void comm_cache_stats(MPI_Comm parent, int64_t & nhit, int64_t & nmiss, int & ncomm){
+    std::map<MPI_Comm, comm_cache>::iterator cit = comm_caches.find(parent);
+    if (cit == comm_caches.end()){
+      nhit  = 0;
+      nmiss = 0;
+      ncomm = 0;
+    } else {
+      nhit  = cit->second.nhit;
+      nmiss = cit->second.nmiss;
+      ncomm = cit->second.comms.size();
+    }
+  }
+
+  void comm_cache_retain(MPI_Comm parent){
+    comm_cache & cc = comm_caches[parent];
+    if (cc.nworld == 0){
+      //the last world on parent may have left communicators that were still in use, start afresh
+      cc.limit = comm_cache().limit;
+      cc.nhit  = 0;
+      cc.nmiss = 0;
+      evict(cc);
+    }
+    cc.nworld++;
+  }
+
+  void comm_cache_free(MPI_Comm parent){
+    std::map<MPI_Comm, comm_cache>::iterator cit = comm_caches.find(parent);
+    if (cit == comm_caches.end()) return;
+    if (cit->second.nworld > 0) cit->second.nworld--;
+    //other worlds on parent still use the cache
+    if (cit->second.nworld > 0) return;
+    int is_finalized;
+    MPI_Finalized(&is_finalized);
+    if (!is_finalized){
+      cit->second.limit = 0;
+      evict(cit->second);
+    }
+    if (is_finalized || cit->second.comms.size() == 0)
+      comm_caches.erase(cit);
+  }
+
   topology * get_phys_topo(CommData glb_comm,
                            TOPOLOGY mach){
     int np = glb_comm.np;
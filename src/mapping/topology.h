@@ -41,13 +41,44 @@ namespace CTF_int {
                CommData    cdt,
                bool        activate=false);
      
-      /* \brief create (split off) MPI communicators, re-entrant */ 
+      /* \brief get MPI communicators from the communicator cache of glb_comm (splitting them off if not cached), re-entrant */ 
       void activate();
 
-      /* \breif free MPI communicators, re-entrant */
+      /* \brief release MPI communicators back to the communicator cache, re-entrant */
       void deactivate();
   };
 
+  /**
+   * \brief sets the maximum number of processor grid communicators cached for a parent communicator,
+   *        least recently used communicators not held by an activated topology are freed beyond it
+   * \param[in] parent communicator of the world whose topologies are split off
+   * \param[in] limit maximum number of communicators to keep, evicting as needed (collective)
+   */
+  void comm_cache_set_limit(MPI_Comm parent, int limit);
+
+  /**
+   * \brief gives statistics of the communicator cache of a parent communicator
+   * \param[in] parent communicator of the world whose topologies are split off
+   * \param[out] nhit number of topology dimension activations that reused a cached communicator
+   * \param[out] nmiss number of topology dimension activations that had to split a communicator
+   * \param[out] ncomm number of communicators currently cached
+   */
+  void comm_cache_stats(MPI_Comm parent, int64_t & nhit, int64_t & nmiss, int & ncomm);
+
+  /**
+   * \brief registers a world on parent as a user of its communicator cache, which is shared by all worlds
+   *        on parent and freed when the last of them releases it
+   * \param[in] parent communicator of the world being created
+   */
+  void comm_cache_retain(MPI_Comm parent);
+
+  /**
+   * \brief releases the communicator cache of parent for a world, if no other world on parent uses it,
+   *        frees all cached communicators split off of parent that are not in use and forgets its statistics
+   * \param[in] parent communicator of the world being destroyed (collective)
+   */
+  void comm_cache_free(MPI_Comm parent);
+
   /**
    * \brief get dimension and torus lengths of specified topology
    *
@@ -0,0 +1,234 @@
+/*Copyright (c) 2011, Edgar Solomonik, all rights reserved.*/
+
+#include "sparse_reshuffle.h"
+#include "../shared/util.h"
+
+namespace CTF_int {
+  LinModel<4> spres_mdl(spres_mdl_init,"spres_mdl");
+
+  double spres_est_time(int64_t tot_sz, int np, int64_t nrun){
+    double ps[] = {1.0, (double)log2(np), (double)tot_sz*log2(np), (double)tot_sz*log2(nrun+1)};
+    return spres_mdl.est_time(ps);
+  }
+
+  /**
+   * \brief merges two runs of pairs sorted by key into a single sorted run
+   */
+  static void merge_runs(ConstPairIterator a,
+                         int64_t           na,
+                         ConstPairIterator b,
+                         int64_t           nb,
+                         char *            out,
+                         int64_t           psz){
+    int64_t ia=0, ib=0;
+    while (ia<na && ib<nb){
+      if (b[ib].k() < a[ia].k()){
+        memcpy(out, b[ib].ptr, psz);
+        ib++;
+      } else {
+        memcpy(out, a[ia].ptr, psz);
+        ia++;
+      }
+      out += psz;
+    }
+    if (ia<na) memcpy(out, a[ia].ptr, (na-ia)*psz);
+    if (ib<nb) memcpy(out, b[ib].ptr, (nb-ib)*psz);
+  }
+
+  void sparse_reshuffle(int                  order,
+                        int const *          lens,
+                        distribution const & old_dist,
+                        distribution const & new_dist,
+                        int64_t const *      old_nnz_blk,
+                        char const *         old_data,
+                        int64_t *            new_nnz_blk,
+                        char *&              new_data,
+                        algstrct const *     sr,
+                        CommData             ord_glb_comm){
+    TAU_FSTART(sparse_reshuffle);
+#ifdef TUNE
+    MPI_Barrier(ord_glb_comm.cm);
+#endif
+    double st_time = MPI_Wtime();
+    int np = ord_glb_comm.np;
+    int64_t psz = sr->pair_size();
+
+    int old_nvirt = 1;
+    int new_nvirt = 1;
+    int new_virt_lda[order];
+    for (int i=0; i<order; i++){
+      old_nvirt *= old_dist.virt_phase[i];
+      new_virt_lda[i] = new_nvirt;
+      new_nvirt *= new_dist.virt_phase[i];
+    }
+    int64_t nold = 0;
+    for (int v=0; v<old_nvirt; v++){
+      nold += old_nnz_blk[v];
+    }
+    int64_t nbkt = ((int64_t)np)*new_nvirt;
+
+    //compute the destination processor and virtual block of each pair from its key
+    ConstPairIterator old_prs(sr, old_data);
+    int64_t * bkt = (int64_t*)alloc(sizeof(int64_t)*std::max(nold,(int64_t)1));
+    TAU_FSTART(sparse_reshuffle_bucket);
+#ifdef USE_OMP
+    #pragma omp parallel for
+#endif
+    for (int64_t i=0; i<nold; i++){
+      int64_t k = old_prs[i].k();
+      int64_t pe = 0;
+      int64_t vb = 0;
+      for (int j=0; j<order; j++){
+        int64_t idx = k%lens[j];
+        k = k/lens[j];
+        pe += (idx%new_dist.phys_phase[j])*new_dist.pe_lda[j];
+        vb += ((idx/new_dist.phys_phase[j])%new_dist.virt_phase[j])*new_virt_lda[j];
+      }
+      bkt[i] = pe*new_nvirt+vb;
+    }
+
+    //counting sort into buckets, stable so that sorted runs of the old blocks stay sorted,
+    //static scheduling gives each thread a contiguous chunk, in order of thread number
+    int nthread = 1;
+#ifdef USE_OMP
+    nthread = omp_get_max_threads();
+#endif
+    int64_t * thread_cnt = (int64_t*)alloc(sizeof(int64_t)*nbkt*nthread);
+    std::fill(thread_cnt, thread_cnt+nbkt*nthread, 0);
+#ifdef USE_OMP
+    #pragma omp parallel for schedule(static)
+#endif
+    for (int64_t i=0; i<nold; i++){
+      int tid = 0;
+#ifdef USE_OMP
+      tid = omp_get_thread_num();
+#endif
+      thread_cnt[tid*nbkt+bkt[i]]++;
+    }
+    int64_t * send_cnt_v = (int64_t*)alloc(sizeof(int64_t)*nbkt);
+    int64_t off = 0;
+    for (int64_t b=0; b<nbkt; b++){
+      send_cnt_v[b] = 0;
+      for (int t=0; t<nthread; t++){
+        int64_t c = thread_cnt[t*nbkt+b];
+        thread_cnt[t*nbkt+b] = off;
+        off += c;
+        send_cnt_v[b] += c;
+      }
+    }
+    char * send_buf = (char*)alloc(psz*std::max(nold,(int64_t)1));
+#ifdef USE_OMP
+    #pragma omp parallel for schedule(static)
+#endif
+    for (int64_t i=0; i<nold; i++){
+      int tid = 0;
+#ifdef USE_OMP
+      tid = omp_get_thread_num();
+#endif
+      memcpy(send_buf+psz*(thread_cnt[tid*nbkt+bkt[i]]++), old_prs[i].ptr, psz);
+    }
+    cdealloc(thread_cnt);
+    cdealloc(bkt);
+    TAU_FSTOP(sparse_reshuffle_bucket);
+
+    //exchange counts for each virtual block, then the pairs
+    int64_t * recv_cnt_v = (int64_t*)alloc(sizeof(int64_t)*nbkt);
+    MPI_Alltoall(send_cnt_v, new_nvirt, MPI_INT64_T, recv_cnt_v, new_nvirt, MPI_INT64_T, ord_glb_comm.cm);
+    int64_t * send_counts = (int64_t*)alloc(sizeof(int64_t)*np);
+    int64_t * send_displs = (int64_t*)alloc(sizeof(int64_t)*np);
+    int64_t * recv_counts = (int64_t*)alloc(sizeof(int64_t)*np);
+    int64_t * recv_displs = (int64_t*)alloc(sizeof(int64_t)*np);
+    for (int p=0; p<np; p++){
+      send_counts[p] = 0;
+      recv_counts[p] = 0;
+      for (int v=0; v<new_nvirt; v++){
+        send_counts[p] += send_cnt_v[p*new_nvirt+v];
+        recv_counts[p] += recv_cnt_v[p*new_nvirt+v];
+      }
+      send_displs[p] = p == 0 ? 0 : send_displs[p-1]+send_counts[p-1];
+      recv_displs[p] = p == 0 ? 0 : recv_displs[p-1]+recv_counts[p-1];
+    }
+    int64_t nnew = recv_displs[np-1]+recv_counts[np-1];
+    char * recv_buf = (char*)alloc(psz*std::max(nnew,(int64_t)1));
+    ord_glb_comm.all_to_allv(send_buf, send_counts, send_displs, psz,
+                             recv_buf, recv_counts, recv_displs);
+    cdealloc(send_buf);
+
+    //the pairs received from each processor for a virtual block consist of runs that are sorted by key,
+    //gather them for each virtual block and merge runs pairwise until a single sorted run is left
+    TAU_FSTART(sparse_reshuffle_merge);
+    int64_t * new_off = (int64_t*)alloc(sizeof(int64_t)*(new_nvirt+1));
+    new_off[0] = 0;
+    for (int v=0; v<new_nvirt; v++){
+      new_nnz_blk[v] = 0;
+      for (int p=0; p<np; p++){
+        new_nnz_blk[v] += recv_cnt_v[p*new_nvirt+v];
+      }
+      new_off[v+1] = new_off[v]+new_nnz_blk[v];
+    }
+    new_data = (char*)alloc(psz*std::max(nnew,(int64_t)1));
+    char * aux_data = (char*)alloc(psz*std::max(nnew,(int64_t)1));
+#ifdef USE_OMP
+    #pragma omp parallel for schedule(dynamic)
+#endif
+    for (int v=0; v<new_nvirt; v++){
+      std::vector<int64_t> runs;
+      char * src = new_data+psz*new_off[v];
+      char * dst = aux_data+psz*new_off[v];
+      int64_t nv = 0;
+      for (int p=0; p<np; p++){
+        int64_t cnt = recv_cnt_v[p*new_nvirt+v];
+        if (cnt == 0) continue;
+        int64_t boff = recv_displs[p];
+        for (int w=0; w<v; w++){
+          boff += recv_cnt_v[p*new_nvirt+w];
+        }
+        memcpy(src+psz*nv, recv_buf+psz*boff, psz*cnt);
+        ConstPairIterator prs(sr, src+psz*nv);
+        runs.push_back(nv);
+        for (int64_t i=1; i<cnt; i++){
+          if (prs[i].k() < prs[i-1].k()) runs.push_back(nv+i);
+        }
+        nv += cnt;
+      }
+      runs.push_back(nv);
+      while (runs.size() > 2){
+        std::vector<int64_t> mruns;
+        int64_t r;
+        for (r=0; r+2<(int64_t)runs.size(); r+=2){
+          merge_runs(ConstPairIterator(sr, src+psz*runs[r]), runs[r+1]-runs[r],
+                     ConstPairIterator(sr, src+psz*runs[r+1]), runs[r+2]-runs[r+1],
+                     dst+psz*runs[r], psz);
+          mruns.push_back(runs[r]);
+        }
+        if (r+1<(int64_t)runs.size()){
+          memcpy(dst+psz*runs[r], src+psz*runs[r], psz*(runs[r+1]-runs[r]));
+          mruns.push_back(runs[r]);
+        }
+        mruns.push_back(nv);
+        runs.swap(mruns);
+        std::swap(src, dst);
+      }
+      if (src != new_data+psz*new_off[v])
+        memcpy(new_data+psz*new_off[v], src, psz*nv);
+    }
+    TAU_FSTOP(sparse_reshuffle_merge);
+    cdealloc(aux_data);
+    cdealloc(recv_buf);
+    cdealloc(new_off);
+    cdealloc(send_cnt_v);
+    cdealloc(recv_cnt_v);
+    cdealloc(send_counts);
+    cdealloc(send_displs);
+    cdealloc(recv_counts);
+    cdealloc(recv_displs);
+#ifdef TUNE
+    MPI_Barrier(ord_glb_comm.cm);
+#endif
+    double exe_time = MPI_Wtime()-st_time;
+    int64_t tot_sz = psz*std::max(nold, nnew);
+    double tps[] = {exe_time, 1.0, (double)log2(np), (double)tot_sz*log2(np), (double)tot_sz*log2(((int64_t)old_nvirt)*np+1)};
+    spres_mdl.observe(tps);
+    TAU_FSTOP(sparse_reshuffle);
+  }
+}
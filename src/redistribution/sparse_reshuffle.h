@@ -0,0 +1,47 @@
+/*Copyright (c) 2011, Edgar Solomonik, all rights reserved.*/
+
+#ifndef __SPARSE_RESHUFFLE_H__
+#define __SPARSE_RESHUFFLE_H__
+
+#include "../interface/common.h"
+#include "../mapping/distribution.h"
+#include "../tensor/algstrct.h"
+
+namespace CTF_int {
+  /**
+   * \brief estimates execution time of sparse_reshuffle
+   * \param[in] tot_sz amount of data (in bytes) sent/recved by this processor
+   * \param[in] np number of procs involved
+   * \param[in] nrun maximum number of sorted runs that may need to be merged into a virtual block
+   */
+  double spres_est_time(int64_t tot_sz, int np, int64_t nrun);
+
+  /**
+   * \brief redistributes the nonzeros of a sparse tensor from one cyclic distribution to another,
+   *        destination processors and virtual blocks are computed directly from the keys and
+   *        the received blocks (which are already sorted within each source block) are merged
+   *        rather than sorted, the tensor must not be replicated in either distribution
+   * \param[in] order number of tensor dimensions
+   * \param[in] lens unpadded tensor edge lengths, with respect to which keys are defined
+   * \param[in] old_dist starting data distribution
+   * \param[in] new_dist target data distribution
+   * \param[in] old_nnz_blk number of nonzeros in each virtual block of the old distribution
+   * \param[in] old_data key-value pairs in old distribution, sorted by key within each virtual block
+   * \param[out] new_nnz_blk number of nonzeros in each virtual block of the new distribution (preallocated)
+   * \param[out] new_data key-value pairs in new distribution, sorted by key within each virtual block
+   * \param[in] sr algstrct defining data type of array
+   * \param[in] ord_glb_comm communicator on which to redistribute
+   */
+  void sparse_reshuffle(int                  order,
+                        int const *          lens,
+                        distribution const & old_dist,
+                        distribution const & new_dist,
+                        int64_t const *      old_nnz_blk,
+                        char const *         old_data,
+                        int64_t *            new_nnz_blk,
+                        char *&              new_data,
+                        algstrct const *     sr,
+                        CommData             ord_glb_comm);
+}
+
+#endif
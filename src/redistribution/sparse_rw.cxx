@@ -423,6 +423,216 @@ namespace CTF_int {
     TAU_FSTOP(spsfy_tsr);
   }
 
+  /**
+   * \brief calls f(key, offset) for each element of virtual block blk of a nonsymmetric dense tensor
+   *        that is not padding, in increasing order of keys
+   */
+  template <typename func>
+  static void walk_dns_blk(int             order,
+                           int             blk,
+                           int const *     lens,
+                           int const *     edge_len,
+                           int const *     phase,
+                           int const *     phys_phase,
+                           int const *     virt_dim,
+                           int const *     phys_rank,
+                           int64_t const * edge_lda,
+                           func            f){
+    if (order == 0){
+      f(0, 0);
+      return;
+    }
+    int phase_rank[order];
+    int idx[order];
+    for (int i=0; i<order; i++){
+      phase_rank[i] = phys_rank[i] + (blk%virt_dim[i])*phys_phase[i];
+      blk = blk/virt_dim[i];
+      idx[i] = 0;
+    }
+    int64_t len0 = edge_len[0]/phase[0];
+    int64_t imax = lens[0] > phase_rank[0] ? (lens[0]-phase_rank[0]+phase[0]-1)/phase[0] : 0;
+    int64_t buf_offset = 0;
+    for (;;){
+      int64_t idx_offset = phase_rank[0];
+      bool is_pad = false;
+      for (int i=1; i<order; i++){
+        int64_t gi = idx[i]*phase[i]+phase_rank[i];
+        if (gi >= lens[i]) is_pad = true;
+        idx_offset += gi*edge_lda[i];
+      }
+      if (!is_pad){
+        for (int64_t i=0; i<imax; i++){
+          f(idx_offset+i*phase[0], buf_offset+i);
+        }
+      }
+      buf_offset += len0;
+      int act_lda;
+      for (act_lda=1; act_lda<order; act_lda++){
+        idx[act_lda]++;
+        if (idx[act_lda] >= edge_len[act_lda]/phase[act_lda])
+          idx[act_lda] = 0;
+        if (idx[act_lda] > 0)
+          break;
+      }
+      if (act_lda >= order) break;
+    }
+  }
+
+  void dns_sp_sum(int              order,
+                  int64_t          size,
+                  int              nvirt,
+                  int const *      lens,
+                  int const *      edge_len,
+                  int const *      phase,
+                  int const *      phys_phase,
+                  int const *      virt_dim,
+                  int const *      phys_rank,
+                  char const *     vdata,
+                  char const *     alpha,
+                  int64_t const *  vnnz_B,
+                  char const *     vprs_B,
+                  char const *     beta,
+                  int64_t *        vnnz_new,
+                  char *&          pprs_new,
+                  algstrct const * sr){
+    TAU_FSTART(dns_sp_sum);
+    int64_t edge_lda[order+1];
+    edge_lda[0] = 1;
+    for (int i=1; i<order; i++){
+      edge_lda[i] = edge_lda[i-1]*lens[i-1];
+    }
+    int64_t psz = sr->pair_size();
+    int64_t bsize = size/nvirt;
+    int64_t off_B[nvirt];
+    off_B[0] = 0;
+    for (int v=1; v<nvirt; v++){
+      off_B[v] = off_B[v-1]+vnnz_B[v-1];
+    }
+
+    //count the union of the keys of B and the nonzeros of A in each block
+#ifdef USE_OMP
+    #pragma omp parallel for schedule(dynamic)
+#endif
+    for (int v=0; v<nvirt; v++){
+      ConstPairIterator prs_B(sr, vprs_B+psz*off_B[v]);
+      char const * data = vdata+sr->el_size*bsize*v;
+      int64_t nB = vnnz_B[v];
+      int64_t t = 0, n = 0;
+      walk_dns_blk(order, v, lens, edge_len, phase, phys_phase, virt_dim, phys_rank, edge_lda,
+        [&](int64_t k, int64_t i){
+          while (t<nB && prs_B[t].k() < k){ t++; n++; }
+          if (t<nB && prs_B[t].k() == k){
+            t++;
+            n++;
+          } else if (!sr->isequal(data+sr->el_size*i, sr->addid()))
+            n++;
+        });
+      vnnz_new[v] = n + nB - t;
+    }
+    int64_t off_new[nvirt];
+    off_new[0] = 0;
+    for (int v=1; v<nvirt; v++){
+      off_new[v] = off_new[v-1]+vnnz_new[v-1];
+    }
+    alloc_ptr(psz*(off_new[nvirt-1]+vnnz_new[nvirt-1]), (void**)&pprs_new);
+
+    //merge, B-only pairs are scaled by beta, A-only values by alpha
+#ifdef USE_OMP
+    #pragma omp parallel for schedule(dynamic)
+#endif
+    for (int v=0; v<nvirt; v++){
+      ConstPairIterator prs_B(sr, vprs_B+psz*off_B[v]);
+      PairIterator prs_new(sr, pprs_new+psz*off_new[v]);
+      char const * data = vdata+sr->el_size*bsize*v;
+      int64_t nB = vnnz_B[v];
+      int64_t t = 0, n = 0;
+      auto cpy_B = [&](){
+        memcpy(prs_new[n].ptr, prs_B[t].ptr, psz);
+        if (beta != NULL)
+          sr->mul(prs_new[n].d(), beta, prs_new[n].d());
+        t++;
+        n++;
+      };
+      walk_dns_blk(order, v, lens, edge_len, phase, phys_phase, virt_dim, phys_rank, edge_lda,
+        [&](int64_t k, int64_t i){
+          while (t<nB && prs_B[t].k() < k) cpy_B();
+          char const * a = data+sr->el_size*i;
+          if (t<nB && prs_B[t].k() == k){
+            char b[sr->el_size];
+            char c[sr->el_size];
+            if (alpha != NULL) sr->mul(a, alpha, c);
+            else sr->copy(c, a);
+            if (beta != NULL) sr->mul(prs_B[t].d(), beta, b);
+            else prs_B[t].read_val(b);
+            prs_new[n].write_key(k);
+            sr->add(b, c, prs_new[n].d());
+            t++;
+            n++;
+          } else if (!sr->isequal(a, sr->addid())){
+            prs_new[n].write_key(k);
+            if (alpha != NULL) sr->mul(a, alpha, prs_new[n].d());
+            else prs_new[n].write_val(a);
+            n++;
+          }
+        });
+      while (t<nB) cpy_B();
+      ASSERT(n == vnnz_new[v]);
+    }
+    TAU_FSTOP(dns_sp_sum);
+  }
+
+  void sp_dns_sum(int              order,
+                  int64_t          size,
+                  int              nvirt,
+                  int const *      lens,
+                  int const *      edge_len,
+                  int const *      phase,
+                  char *           vdata,
+                  char const *     alpha,
+                  int64_t const *  vnnz_B,
+                  char const *     vprs_B,
+                  char const *     beta,
+                  algstrct const * sr){
+    TAU_FSTART(sp_dns_sum);
+    int64_t edge_lda[order+1];
+    int64_t blk_lda[order+1];
+    for (int i=0; i<order; i++){
+      edge_lda[i] = i == 0 ? 1 : edge_lda[i-1]*lens[i-1];
+      blk_lda[i] = i == 0 ? 1 : blk_lda[i-1]*(edge_len[i-1]/phase[i-1]);
+    }
+    int64_t psz = sr->pair_size();
+    int64_t bsize = size/nvirt;
+    int64_t off_B[nvirt];
+    off_B[0] = 0;
+    for (int v=1; v<nvirt; v++){
+      off_B[v] = off_B[v-1]+vnnz_B[v-1];
+    }
+#ifdef USE_OMP
+    #pragma omp parallel for schedule(dynamic)
+#endif
+    for (int v=0; v<nvirt; v++){
+      ConstPairIterator prs_B(sr, vprs_B+psz*off_B[v]);
+      char * data = vdata+sr->el_size*bsize*v;
+      if (alpha != NULL && !sr->isequal(alpha, sr->mulid())){
+        for (int64_t i=0; i<bsize; i++){
+          sr->mul(data+sr->el_size*i, alpha, data+sr->el_size*i);
+        }
+      }
+      for (int64_t t=0; t<vnnz_B[v]; t++){
+        int64_t k = prs_B[t].k();
+        int64_t off = 0;
+        for (int i=0; i<order; i++){
+          off += (((k/edge_lda[i])%lens[i])/phase[i])*blk_lda[i];
+        }
+        char b[sr->el_size];
+        if (beta != NULL) sr->mul(prs_B[t].d(), beta, b);
+        else prs_B[t].read_val(b);
+        sr->add(data+sr->el_size*off, b, data+sr->el_size*off);
+      }
+    }
+    TAU_FSTOP(sp_dns_sum);
+  }
+
 
   void bucket_by_pe(int               order,
                     int64_t           num_pair,
@@ -108,6 +108,76 @@ namespace CTF_int {
                  int64_t const *  edge_lda,
                  std::function<bool(char const*)> f);
 
+  /**
+   * \brief accumulates a dense tensor into a sparse tensor with the same (nonsymmetric) distribution,
+   *        computing B = beta*B + alpha*A by walking each dense virtual block in key order and merging
+   *        it with the sorted pairs of the corresponding sparse block, zeros of A do not create pairs
+   * \param[in] order tensor dimension
+   * \param[in] size number of values in the dense data
+   * \param[in] nvirt total virtualization factor
+   * \param[in] lens tensor edge lengths (not padded)
+   * \param[in] edge_len tensor edge lengths (padded)
+   * \param[in] phase total phase of the tensor on virtualized processor grid
+   * \param[in] phys_phase physical phase of the tensor
+   * \param[in] virt_dim virtual phase in each dimension
+   * \param[in] phys_rank physical phase rank in each dimension
+   * \param[in] vdata dense values of A
+   * \param[in] alpha scaling factor for A
+   * \param[in] vnnz_B number of pairs of B in each virtual block
+   * \param[in] vprs_B pairs of B, sorted by key within each virtual block
+   * \param[in] beta scaling factor for B
+   * \param[out] vnnz_new number of pairs in each virtual block of the result
+   * \param[out] pprs_new pairs of the result, allocated internally
+   * \param[in] sr algstrct defining data type of array
+   */
+  void dns_sp_sum(int              order,
+                  int64_t          size,
+                  int              nvirt,
+                  int const *      lens,
+                  int const *      edge_len,
+                  int const *      phase,
+                  int const *      phys_phase,
+                  int const *      virt_dim,
+                  int const *      phys_rank,
+                  char const *     vdata,
+                  char const *     alpha,
+                  int64_t const *  vnnz_B,
+                  char const *     vprs_B,
+                  char const *     beta,
+                  int64_t *        vnnz_new,
+                  char *&          pprs_new,
+                  algstrct const * sr);
+
+  /**
+   * \brief accumulates the pairs of a sparse tensor into a dense tensor with the same (nonsymmetric)
+   *        distribution, computing A = alpha*A + beta*B in place, each virtual block is scaled and the
+   *        pairs of B are scattered into it
+   * \param[in] order tensor dimension
+   * \param[in] size number of values in the dense data
+   * \param[in] nvirt total virtualization factor
+   * \param[in] lens tensor edge lengths (not padded)
+   * \param[in] edge_len tensor edge lengths (padded)
+   * \param[in] phase total phase of the tensor on virtualized processor grid
+   * \param[in,out] vdata dense values of A
+   * \param[in] alpha scaling factor for A
+   * \param[in] vnnz_B number of pairs of B in each virtual block
+   * \param[in] vprs_B pairs of B
+   * \param[in] beta scaling factor for B
+   * \param[in] sr algstrct defining data type of array
+   */
+  void sp_dns_sum(int              order,
+                  int64_t          size,
+                  int              nvirt,
+                  int const *      lens,
+                  int const *      edge_len,
+                  int const *      phase,
+                  char *           vdata,
+                  char const *     alpha,
+                  int64_t const *  vnnz_B,
+                  char const *     vprs_B,
+                  char const *     beta,
+                  algstrct const * sr);
+
   /**
    * \brief buckets key-value pairs by processor according to distribution
    * \param[in] order number of tensor dims
@@ -76,6 +76,7 @@ namespace CTF_int {
 
     is_top = 1;
     tsr = A;
+    tsr->flush_writes();
     if (tsr->has_zero_edge_len){
       return SUCCESS;
     }
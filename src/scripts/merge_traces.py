@@ -0,0 +1,37 @@
+#!/usr/bin/env python
+"""Merges per-rank CTF trace files (written when CTF is built with -DTRACE)
+into a single Chrome trace / Perfetto JSON file, one process track per rank.
+
+usage: merge_traces.py [-o merged.json] [ctf_trace.0.json ctf_trace.1.json ...]
+       if no input files are given, all ctf_trace.*.json in the current directory are merged
+"""
+import sys
+import glob
+import json
+
+def merge(fnames, out):
+    events = []
+    dropped = 0
+    for fname in fnames:
+        with open(fname) as f:
+            tr = json.load(f)
+        events.extend(tr["traceEvents"])
+        dropped += tr.get("otherData", {}).get("dropped_events", 0)
+    with open(out, "w") as f:
+        json.dump({"traceEvents": events,
+                   "displayTimeUnit": "ms",
+                   "otherData": {"nranks": len(fnames), "dropped_events": dropped}}, f)
+    print("merged %d trace files with %d events into %s" % (len(fnames), len(events), out))
+
+if __name__ == "__main__":
+    args = sys.argv[1:]
+    out = "ctf_trace.json"
+    if "-o" in args:
+        i = args.index("-o")
+        out = args[i+1]
+        del args[i:i+2]
+    if len(args) == 0:
+        args = sorted(glob.glob("ctf_trace.*.json"),
+                      key=lambda s: int(s.split(".")[-2]) if s.split(".")[-2].isdigit() else -1)
+        args = [a for a in args if a.split(".")[-2].isdigit()]
+    merge(args, out)
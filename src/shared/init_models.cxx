@@ -34,7 +34,11 @@ double red_mdl_cst_init[] = {5.7302E-07, 4.7347E-06, 6.0191E-10};
 double allred_mdl_init[] = {8.4416E-07, 6.8651E-06, 3.5845E-08};
 double allred_mdl_cst_init[] = {-3.3754E-04, 2.1343E-04, 3.0801E-09};
 double bcast_mdl_init[] = {1.5045E-06, 1.4485E-05, 3.2876E-09};
-double spredist_mdl_init[] = {1.2744E-04, 1.0278E-03, 7.6837E-08};
+double bcast_seg_mdl_init[] = {1.5045E-06, 4.0000E-06, 3.2876E-09};
+double allred_seg_mdl_init[] = {8.4416E-07, 6.8651E-06, 7.0000E-09};
+double spres_mdl_init[] = {1.2744E-04, 1.0278E-03, 7.6837E-09, 1.0000E-09};
 double csrred_mdl_init[] = {3.7005E-05, 1.1854E-04, 5.5165E-09};
 double csrred_mdl_cst_init[] = {-1.8323E-04, 1.3076E-04, 2.8732E-09};
+double spmspv_push_mdl_init[] = {2.0000E-06, 8.0000E-09};
+double spmspv_pull_mdl_init[] = {2.0000E-06, 3.0000E-09};
 }
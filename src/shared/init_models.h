@@ -13,8 +13,12 @@ namespace CTF_int{
   extern double allred_mdl_init[];
   extern double allred_mdl_cst_init[];
   extern double bcast_mdl_init[];
+  extern double bcast_seg_mdl_init[];
+  extern double allred_seg_mdl_init[];
   extern double dgtog_res_mdl_init[];
-  extern double spredist_mdl_init[];
+  extern double spres_mdl_init[];
+  extern double spmspv_push_mdl_init[];
+  extern double spmspv_pull_mdl_init[];
   extern double blres_mdl_init[];
   extern double pin_keys_mdl_init[];
   extern double seq_tsr_ctr_mdl_cst_init[];
@@ -10,6 +10,7 @@
 #include "util.h"
 #include "int_timer.h"
 #include "model.h"
+#include "trace.h"
 #include "../interface/timer.h"
 
 using namespace CTF_int;
@@ -105,6 +106,7 @@ namespace CTF{
   static std::vector<Function_timer> * function_timers = NULL;
 
   Timer::Timer(const char * name){
+    timer_name = name;
   #ifdef PROFILE
     int i;
     if (function_timers == NULL) {
@@ -139,6 +141,7 @@ namespace CTF{
   }
     
   void Timer::start(){
+    TRACE_BEGIN(timer_name);
   #ifdef PROFILE
     if (exited != 2){
       exited = 0;
@@ -149,6 +152,7 @@ namespace CTF{
   }
 
   void Timer::stop(){
+    TRACE_END(timer_name);
   #ifdef PROFILE
     if (exited == 0){
       int is_fin;
@@ -18,6 +18,10 @@ namespace CTF {
 #define TAU
 #endif
 
+#ifdef TRACE
+#define TAU
+#endif
+
 #ifdef TAU
 #define TAU_FSTART(ARG)                                           \
   do { CTF::Timer t(#ARG); t.start(); } while (0);
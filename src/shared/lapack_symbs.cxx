@@ -0,0 +1,272 @@
+/*Copyright (c) 2011, Edgar Solomonik, all rights reserved.*/
+
+#include "lapack_symbs.h"
+#include "util.h"
+
+#ifdef USE_SCALAPACK
+#if FTN_UNDERSCORE
+#define SCLPCK_FTN(name) name##_
+#else
+#define SCLPCK_FTN(name) name
+#endif
+
+namespace CTF_SCALAPACK {
+  extern "C" {
+    int  Csys2blacs_handle(MPI_Comm cm);
+    void Cfree_blacs_system_handle(int handle);
+    void Cblacs_gridinit(int * ictxt, char const * order, int nprow, int npcol);
+    void Cblacs_gridexit(int ictxt);
+
+    int  SCLPCK_FTN(numroc)(int const * n, int const * nb, int const * iproc, int const * isrcproc, int const * nprocs);
+    void SCLPCK_FTN(descinit)(int * desc, int const * m, int const * n, int const * mb, int const * nb, int const * irsrc, int const * icsrc, int const * ictxt, int const * lld, int * info);
+
+    #define DECLARE_POTRF(P, T) \
+    void SCLPCK_FTN(P##potrf)(char const * uplo, int const * n, T * A, int const * ia, int const * ja, int const * desca, int * info);
+    #define DECLARE_GEQRF(P, T) \
+    void SCLPCK_FTN(P##geqrf)(int const * m, int const * n, T * A, int const * ia, int const * ja, int const * desca, T * tau, T * work, int const * lwork, int * info);
+    #define DECLARE_ORGQR(NAME, T) \
+    void SCLPCK_FTN(NAME)(int const * m, int const * n, int const * k, T * A, int const * ia, int const * ja, int const * desca, T const * tau, T * work, int const * lwork, int * info);
+    #define DECLARE_TRSM(P, T) \
+    void SCLPCK_FTN(P##trsm)(char const * side, char const * uplo, char const * transa, char const * diag, int const * m, int const * n, T const * alpha, T const * A, int const * ia, int const * ja, int const * desca, T * B, int const * ib, int const * jb, int const * descb);
+
+    DECLARE_POTRF(ps, float)
+    DECLARE_POTRF(pd, double)
+    DECLARE_POTRF(pc, std::complex<float>)
+    DECLARE_POTRF(pz, std::complex<double>)
+    DECLARE_GEQRF(ps, float)
+    DECLARE_GEQRF(pd, double)
+    DECLARE_GEQRF(pc, std::complex<float>)
+    DECLARE_GEQRF(pz, std::complex<double>)
+    DECLARE_ORGQR(psorgqr, float)
+    DECLARE_ORGQR(pdorgqr, double)
+    DECLARE_ORGQR(pcungqr, std::complex<float>)
+    DECLARE_ORGQR(pzungqr, std::complex<double>)
+    DECLARE_TRSM(ps, float)
+    DECLARE_TRSM(pd, double)
+    DECLARE_TRSM(pc, std::complex<float>)
+    DECLARE_TRSM(pz, std::complex<double>)
+
+    void SCLPCK_FTN(psgesvd)(char const * jobu, char const * jobvt, int const * m, int const * n, float * A, int const * ia, int const * ja, int const * desca, float * S, float * U, int const * iu, int const * ju, int const * descu, float * VT, int const * ivt, int const * jvt, int const * descvt, float * work, int const * lwork, int * info);
+    void SCLPCK_FTN(pdgesvd)(char const * jobu, char const * jobvt, int const * m, int const * n, double * A, int const * ia, int const * ja, int const * desca, double * S, double * U, int const * iu, int const * ju, int const * descu, double * VT, int const * ivt, int const * jvt, int const * descvt, double * work, int const * lwork, int * info);
+    void SCLPCK_FTN(pcgesvd)(char const * jobu, char const * jobvt, int const * m, int const * n, std::complex<float> * A, int const * ia, int const * ja, int const * desca, float * S, std::complex<float> * U, int const * iu, int const * ju, int const * descu, std::complex<float> * VT, int const * ivt, int const * jvt, int const * descvt, std::complex<float> * work, int const * lwork, float * rwork, int * info);
+    void SCLPCK_FTN(pzgesvd)(char const * jobu, char const * jobvt, int const * m, int const * n, std::complex<double> * A, int const * ia, int const * ja, int const * desca, double * S, std::complex<double> * U, int const * iu, int const * ju, int const * descu, std::complex<double> * VT, int const * ivt, int const * jvt, int const * descvt, std::complex<double> * work, int const * lwork, double * rwork, int * info);
+
+    void SCLPCK_FTN(pssyevd)(char const * jobz, char const * uplo, int const * n, float * A, int const * ia, int const * ja, int const * desca, float * W, float * Z, int const * iz, int const * jz, int const * descz, float * work, int const * lwork, int * iwork, int const * liwork, int * info);
+    void SCLPCK_FTN(pdsyevd)(char const * jobz, char const * uplo, int const * n, double * A, int const * ia, int const * ja, int const * desca, double * W, double * Z, int const * iz, int const * jz, int const * descz, double * work, int const * lwork, int * iwork, int const * liwork, int * info);
+    void SCLPCK_FTN(pcheevd)(char const * jobz, char const * uplo, int const * n, std::complex<float> * A, int const * ia, int const * ja, int const * desca, float * W, std::complex<float> * Z, int const * iz, int const * jz, int const * descz, std::complex<float> * work, int const * lwork, float * rwork, int const * lrwork, int * iwork, int const * liwork, int * info);
+    void SCLPCK_FTN(pzheevd)(char const * jobz, char const * uplo, int const * n, std::complex<double> * A, int const * ia, int const * ja, int const * desca, double * W, std::complex<double> * Z, int const * iz, int const * jz, int const * descz, std::complex<double> * work, int const * lwork, double * rwork, int const * lrwork, int * iwork, int const * liwork, int * info);
+  }
+}
+#endif
+
+namespace CTF_SCALAPACK {
+  //all routines start at the first row and column of each distributed matrix
+  static int const ONE = 1;
+
+  static void no_scalapack(char const * routine){
+    printf("CTF ERROR: %s requires ScaLAPACK, reconfigure CTF with --scalapack=<libs> (which sets -DUSE_SCALAPACK)\n", routine);
+    IASSERT(0);
+  }
+
+  int cnumroc(int n, int nb, int iproc, int isrcproc, int nprocs){
+#ifdef USE_SCALAPACK
+    return SCLPCK_FTN(numroc)(&n, &nb, &iproc, &isrcproc, &nprocs);
+#else
+    no_scalapack("numroc");
+    return 0;
+#endif
+  }
+
+  void cdescinit(int * desc, int m, int n, int mb, int nb, int irsrc, int icsrc, int ictxt, int lld, int * info){
+#ifdef USE_SCALAPACK
+    SCLPCK_FTN(descinit)(desc, &m, &n, &mb, &nb, &irsrc, &icsrc, &ictxt, &lld, info);
+#else
+    no_scalapack("descinit");
+#endif
+  }
+
+  void cblacs_gridinit(MPI_Comm cm, int pr, int pc, int * ictxt){
+#ifdef USE_SCALAPACK
+    int hndl = Csys2blacs_handle(cm);
+    *ictxt = hndl;
+    Cblacs_gridinit(ictxt, "C", pr, pc);
+    Cfree_blacs_system_handle(hndl);
+#else
+    no_scalapack("blacs_gridinit");
+#endif
+  }
+
+  void cblacs_gridexit(int ictxt){
+#ifdef USE_SCALAPACK
+    Cblacs_gridexit(ictxt);
+#else
+    no_scalapack("blacs_gridexit");
+#endif
+  }
+
+#ifdef USE_SCALAPACK
+  #define DEFINE_POTRF(P, T)                                                         \
+  void cppotrf(char uplo, int n, T * A, int const * desca, int * info){              \
+    SCLPCK_FTN(P##potrf)(&uplo, &n, A, &ONE, &ONE, desca, info);                     \
+  }
+  #define DEFINE_GEQRF(P, T)                                                         \
+  void cpgeqrf(int m, int n, T * A, int const * desca, T * tau, int * info){         \
+    T dlwork;                                                                        \
+    int lwork = -1;                                                                  \
+    SCLPCK_FTN(P##geqrf)(&m, &n, A, &ONE, &ONE, desca, tau, &dlwork, &lwork, info);  \
+    lwork = (int)std::real(dlwork);                                                  \
+    T * work = (T*)CTF_int::alloc(sizeof(T)*std::max(lwork,1));                      \
+    SCLPCK_FTN(P##geqrf)(&m, &n, A, &ONE, &ONE, desca, tau, work, &lwork, info);     \
+    CTF_int::cdealloc(work);                                                         \
+  }
+  #define DEFINE_ORGQR(NAME, T)                                                                  \
+  void cporgqr(int m, int n, int k, T * A, int const * desca, T const * tau, int * info){        \
+    T dlwork;                                                                                    \
+    int lwork = -1;                                                                              \
+    SCLPCK_FTN(NAME)(&m, &n, &k, A, &ONE, &ONE, desca, tau, &dlwork, &lwork, info);              \
+    lwork = (int)std::real(dlwork);                                                              \
+    T * work = (T*)CTF_int::alloc(sizeof(T)*std::max(lwork,1));                                  \
+    SCLPCK_FTN(NAME)(&m, &n, &k, A, &ONE, &ONE, desca, tau, work, &lwork, info);                 \
+    CTF_int::cdealloc(work);                                                                     \
+  }
+  #define DEFINE_TRSM(P, T)                                                                                             \
+  void cptrsm(char side, char uplo, char transa, char diag, int m, int n, T alpha, T const * A, int const * desca,      \
+              T * B, int const * descb){                                                                                \
+    SCLPCK_FTN(P##trsm)(&side, &uplo, &transa, &diag, &m, &n, &alpha, A, &ONE, &ONE, desca, B, &ONE, &ONE, descb);     \
+  }
+#else
+  #define DEFINE_POTRF(P, T)                                                         \
+  void cppotrf(char uplo, int n, T * A, int const * desca, int * info){              \
+    no_scalapack(#P "potrf");                                                        \
+  }
+  #define DEFINE_GEQRF(P, T)                                                         \
+  void cpgeqrf(int m, int n, T * A, int const * desca, T * tau, int * info){         \
+    no_scalapack(#P "geqrf");                                                        \
+  }
+  #define DEFINE_ORGQR(NAME, T)                                                                  \
+  void cporgqr(int m, int n, int k, T * A, int const * desca, T const * tau, int * info){        \
+    no_scalapack(#NAME);                                                                         \
+  }
+  #define DEFINE_TRSM(P, T)                                                                                             \
+  void cptrsm(char side, char uplo, char transa, char diag, int m, int n, T alpha, T const * A, int const * desca,      \
+              T * B, int const * descb){                                                                                \
+    no_scalapack(#P "trsm");                                                                                            \
+  }
+#endif
+  DEFINE_POTRF(ps, float)
+  DEFINE_POTRF(pd, double)
+  DEFINE_POTRF(pc, std::complex<float>)
+  DEFINE_POTRF(pz, std::complex<double>)
+  DEFINE_GEQRF(ps, float)
+  DEFINE_GEQRF(pd, double)
+  DEFINE_GEQRF(pc, std::complex<float>)
+  DEFINE_GEQRF(pz, std::complex<double>)
+  DEFINE_ORGQR(psorgqr, float)
+  DEFINE_ORGQR(pdorgqr, double)
+  DEFINE_ORGQR(pcungqr, std::complex<float>)
+  DEFINE_ORGQR(pzungqr, std::complex<double>)
+  DEFINE_TRSM(ps, float)
+  DEFINE_TRSM(pd, double)
+  DEFINE_TRSM(pc, std::complex<float>)
+  DEFINE_TRSM(pz, std::complex<double>)
+
+  /**
+   * \brief calls real p?gesvd or p?syevd routine after a workspace query
+   */
+#ifdef USE_SCALAPACK
+  #define DEFINE_GESVD(P, T)                                                                                             \
+  void cpgesvd(char jobu, char jobvt, int m, int n, T * A, int const * desca, T * S, T * U, int const * descu,          \
+               T * VT, int const * descvt, int * info){                                                                 \
+    T dlwork;                                                                                                           \
+    int lwork = -1;                                                                                                     \
+    SCLPCK_FTN(P##gesvd)(&jobu, &jobvt, &m, &n, A, &ONE, &ONE, desca, S, U, &ONE, &ONE, descu, VT, &ONE, &ONE, descvt, \
+                         &dlwork, &lwork, info);                                                                        \
+    lwork = (int)dlwork;                                                                                                \
+    T * work = (T*)CTF_int::alloc(sizeof(T)*std::max(lwork,1));                                                         \
+    SCLPCK_FTN(P##gesvd)(&jobu, &jobvt, &m, &n, A, &ONE, &ONE, desca, S, U, &ONE, &ONE, descu, VT, &ONE, &ONE, descvt, \
+                         work, &lwork, info);                                                                           \
+    CTF_int::cdealloc(work);                                                                                            \
+  }
+  #define DEFINE_SYEVD(P, T)                                                                                             \
+  void cpsyevd(char jobz, char uplo, int n, T * A, int const * desca, T * W, T * Z, int const * descz, int * info){     \
+    T dlwork;                                                                                                           \
+    int lwork = -1, liwork = -1, dliwork;                                                                               \
+    SCLPCK_FTN(P##syevd)(&jobz, &uplo, &n, A, &ONE, &ONE, desca, W, Z, &ONE, &ONE, descz,                               \
+                         &dlwork, &lwork, &dliwork, &liwork, info);                                                     \
+    lwork = (int)dlwork;                                                                                                \
+    liwork = dliwork;                                                                                                   \
+    T * work = (T*)CTF_int::alloc(sizeof(T)*std::max(lwork,1));                                                         \
+    int * iwork = (int*)CTF_int::alloc(sizeof(int)*std::max(liwork,1));                                                 \
+    SCLPCK_FTN(P##syevd)(&jobz, &uplo, &n, A, &ONE, &ONE, desca, W, Z, &ONE, &ONE, descz,                               \
+                         work, &lwork, iwork, &liwork, info);                                                           \
+    CTF_int::cdealloc(work);                                                                                            \
+    CTF_int::cdealloc(iwork);                                                                                           \
+  }
+  /**
+   * \brief calls complex p?gesvd or p?heevd routine after a workspace query
+   */
+  #define DEFINE_CGESVD(P, R)                                                                                            \
+  void cpgesvd(char jobu, char jobvt, int m, int n, std::complex<R> * A, int const * desca, R * S, std::complex<R> * U, \
+               int const * descu, std::complex<R> * VT, int const * descvt, int * info){                                \
+    std::complex<R> dlwork;                                                                                             \
+    int lwork = -1;                                                                                                     \
+    R * rwork = (R*)CTF_int::alloc(sizeof(R)*(1+4*std::max(m,n)));                                                      \
+    SCLPCK_FTN(P##gesvd)(&jobu, &jobvt, &m, &n, A, &ONE, &ONE, desca, S, U, &ONE, &ONE, descu, VT, &ONE, &ONE, descvt, \
+                         &dlwork, &lwork, rwork, info);                                                                 \
+    lwork = (int)std::real(dlwork);                                                                                     \
+    std::complex<R> * work = (std::complex<R>*)CTF_int::alloc(sizeof(std::complex<R>)*std::max(lwork,1));               \
+    SCLPCK_FTN(P##gesvd)(&jobu, &jobvt, &m, &n, A, &ONE, &ONE, desca, S, U, &ONE, &ONE, descu, VT, &ONE, &ONE, descvt, \
+                         work, &lwork, rwork, info);                                                                    \
+    CTF_int::cdealloc(work);                                                                                            \
+    CTF_int::cdealloc(rwork);                                                                                           \
+  }
+  #define DEFINE_HEEVD(P, R)                                                                                             \
+  void cpsyevd(char jobz, char uplo, int n, std::complex<R> * A, int const * desca, R * W, std::complex<R> * Z,         \
+               int const * descz, int * info){                                                                          \
+    std::complex<R> dlwork;                                                                                             \
+    R dlrwork;                                                                                                          \
+    int lwork = -1, lrwork = -1, liwork = -1, dliwork;                                                                  \
+    SCLPCK_FTN(P##heevd)(&jobz, &uplo, &n, A, &ONE, &ONE, desca, W, Z, &ONE, &ONE, descz,                               \
+                         &dlwork, &lwork, &dlrwork, &lrwork, &dliwork, &liwork, info);                                  \
+    lwork = (int)std::real(dlwork);                                                                                     \
+    lrwork = (int)dlrwork;                                                                                              \
+    liwork = dliwork;                                                                                                   \
+    std::complex<R> * work = (std::complex<R>*)CTF_int::alloc(sizeof(std::complex<R>)*std::max(lwork,1));               \
+    R * rwork = (R*)CTF_int::alloc(sizeof(R)*std::max(lrwork,1));                                                       \
+    int * iwork = (int*)CTF_int::alloc(sizeof(int)*std::max(liwork,1));                                                 \
+    SCLPCK_FTN(P##heevd)(&jobz, &uplo, &n, A, &ONE, &ONE, desca, W, Z, &ONE, &ONE, descz,                               \
+                         work, &lwork, rwork, &lrwork, iwork, &liwork, info);                                           \
+    CTF_int::cdealloc(work);                                                                                            \
+    CTF_int::cdealloc(rwork);                                                                                           \
+    CTF_int::cdealloc(iwork);                                                                                           \
+  }
+#else
+  #define DEFINE_GESVD(P, T)                                                                                             \
+  void cpgesvd(char jobu, char jobvt, int m, int n, T * A, int const * desca, T * S, T * U, int const * descu,          \
+               T * VT, int const * descvt, int * info){                                                                 \
+    no_scalapack(#P "gesvd");                                                                                           \
+  }
+  #define DEFINE_SYEVD(P, T)                                                                                             \
+  void cpsyevd(char jobz, char uplo, int n, T * A, int const * desca, T * W, T * Z, int const * descz, int * info){     \
+    no_scalapack(#P "syevd");                                                                                           \
+  }
+  #define DEFINE_CGESVD(P, R)                                                                                            \
+  void cpgesvd(char jobu, char jobvt, int m, int n, std::complex<R> * A, int const * desca, R * S, std::complex<R> * U, \
+               int const * descu, std::complex<R> * VT, int const * descvt, int * info){                                \
+    no_scalapack(#P "gesvd");                                                                                           \
+  }
+  #define DEFINE_HEEVD(P, R)                                                                                             \
+  void cpsyevd(char jobz, char uplo, int n, std::complex<R> * A, int const * desca, R * W, std::complex<R> * Z,         \
+               int const * descz, int * info){                                                                          \
+    no_scalapack(#P "heevd");                                                                                           \
+  }
+#endif
+  DEFINE_GESVD(ps, float)
+  DEFINE_GESVD(pd, double)
+  DEFINE_CGESVD(pc, float)
+  DEFINE_CGESVD(pz, double)
+  DEFINE_SYEVD(ps, float)
+  DEFINE_SYEVD(pd, double)
+  DEFINE_HEEVD(pc, float)
+  DEFINE_HEEVD(pz, double)
+}
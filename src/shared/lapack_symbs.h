@@ -26,4 +26,79 @@ namespace CTF_LAPACK{
 }
 #endif
 
+#include <complex>
+#include "mpi.h"
+
+/**
+ * \brief wrappers of the ScaLAPACK routines used by Matrix, which take care of workspace queries and allocation,
+ *        all distributed matrices are operated on starting from their first row and column,
+ *        if CTF is built without -DUSE_SCALAPACK the wrappers print an error and abort
+ */
+namespace CTF_SCALAPACK {
+  /**
+   * \brief real type corresponding to a (possibly complex) type
+   */
+  template <typename dtype>
+  struct real_type { typedef dtype type; };
+
+  template <typename dtype>
+  struct real_type< std::complex<dtype> > { typedef dtype type; };
+
+  /**
+   * \brief number of rows or columns of a block-cyclically distributed matrix owned by process iproc
+   */
+  int cnumroc(int n, int nb, int iproc, int isrcproc, int nprocs);
+
+  /**
+   * \brief initializes ScaLAPACK array descriptor
+   */
+  void cdescinit(int * desc, int m, int n, int mb, int nb, int irsrc, int icsrc, int ictxt, int lld, int * info);
+
+  /**
+   * \brief creates a BLACS context for a pr-by-pc column-major processor grid over communicator cm
+   */
+  void cblacs_gridinit(MPI_Comm cm, int pr, int pc, int * ictxt);
+
+  /**
+   * \brief releases BLACS context created by cblacs_gridinit
+   */
+  void cblacs_gridexit(int ictxt);
+
+  void cppotrf(char uplo, int n, float * A, int const * desca, int * info);
+  void cppotrf(char uplo, int n, double * A, int const * desca, int * info);
+  void cppotrf(char uplo, int n, std::complex<float> * A, int const * desca, int * info);
+  void cppotrf(char uplo, int n, std::complex<double> * A, int const * desca, int * info);
+
+  void cpgeqrf(int m, int n, float * A, int const * desca, float * tau, int * info);
+  void cpgeqrf(int m, int n, double * A, int const * desca, double * tau, int * info);
+  void cpgeqrf(int m, int n, std::complex<float> * A, int const * desca, std::complex<float> * tau, int * info);
+  void cpgeqrf(int m, int n, std::complex<double> * A, int const * desca, std::complex<double> * tau, int * info);
+
+  /**
+   * \brief forms explicit Q from output of cpgeqrf (p?orgqr for real and p?ungqr for complex types)
+   */
+  void cporgqr(int m, int n, int k, float * A, int const * desca, float const * tau, int * info);
+  void cporgqr(int m, int n, int k, double * A, int const * desca, double const * tau, int * info);
+  void cporgqr(int m, int n, int k, std::complex<float> * A, int const * desca, std::complex<float> const * tau, int * info);
+  void cporgqr(int m, int n, int k, std::complex<double> * A, int const * desca, std::complex<double> const * tau, int * info);
+
+  void cpgesvd(char jobu, char jobvt, int m, int n, float * A, int const * desca, float * S, float * U, int const * descu, float * VT, int const * descvt, int * info);
+  void cpgesvd(char jobu, char jobvt, int m, int n, double * A, int const * desca, double * S, double * U, int const * descu, double * VT, int const * descvt, int * info);
+  void cpgesvd(char jobu, char jobvt, int m, int n, std::complex<float> * A, int const * desca, float * S, std::complex<float> * U, int const * descu, std::complex<float> * VT, int const * descvt, int * info);
+  void cpgesvd(char jobu, char jobvt, int m, int n, std::complex<double> * A, int const * desca, double * S, std::complex<double> * U, int const * descu, std::complex<double> * VT, int const * descvt, int * info);
+
+  /**
+   * \brief symmetric (p?syevd) or Hermitian (p?heevd) eigensolver
+   */
+  void cpsyevd(char jobz, char uplo, int n, float * A, int const * desca, float * W, float * Z, int const * descz, int * info);
+  void cpsyevd(char jobz, char uplo, int n, double * A, int const * desca, double * W, double * Z, int const * descz, int * info);
+  void cpsyevd(char jobz, char uplo, int n, std::complex<float> * A, int const * desca, float * W, std::complex<float> * Z, int const * descz, int * info);
+  void cpsyevd(char jobz, char uplo, int n, std::complex<double> * A, int const * desca, double * W, std::complex<double> * Z, int const * descz, int * info);
+
+  void cptrsm(char side, char uplo, char transa, char diag, int m, int n, float alpha, float const * A, int const * desca, float * B, int const * descb);
+  void cptrsm(char side, char uplo, char transa, char diag, int m, int n, double alpha, double const * A, int const * desca, double * B, int const * descb);
+  void cptrsm(char side, char uplo, char transa, char diag, int m, int n, std::complex<float> alpha, std::complex<float> const * A, int const * desca, std::complex<float> * B, int const * descb);
+  void cptrsm(char side, char uplo, char transa, char diag, int m, int n, std::complex<double> alpha, std::complex<double> const * A, int const * desca, std::complex<double> * B, int const * descb);
+}
+
 #endif
@@ -88,6 +88,45 @@ void read_off_memory_status(statm_t& result)
   std::list<mem_loc> mem_stacks[MAX_THREADS];
   #endif
 
+  //bytes allocated by alloc_ptr and not yet freed by cdealloc, and their maximum since reset_peak_bytes_allocated()
+  int64_t alloc_mem_used = 0;
+  int64_t alloc_mem_peak = 0;
+
+  /**
+   * \brief adds len bytes to those allocated, updating the peak (only approximately if threads allocate concurrently)
+   */
+  static void inc_alloc_mem_used(int64_t len){
+    int64_t used;
+#ifdef USE_OMP
+    #pragma omp atomic capture
+#endif
+    used = alloc_mem_used += len;
+    if (used > alloc_mem_peak) alloc_mem_peak = used;
+  }
+
+  /**
+   * \brief returns the size of the allocation at ptr, 0 if the allocator does not report it
+   */
+  static int64_t alloc_size(void * ptr){
+#ifdef __GLIBC__
+    return ptr == NULL ? 0 : malloc_usable_size(ptr);
+#else
+    return 0;
+#endif
+  }
+
+  int64_t proc_bytes_allocated(){
+    return alloc_mem_used;
+  }
+
+  void reset_peak_bytes_allocated(){
+    alloc_mem_peak = alloc_mem_used;
+  }
+
+  int64_t peak_bytes_allocated(){
+    return alloc_mem_peak;
+  }
+
   //application memory stack
   void * mst_buffer = 0;
   //size of memory stack
@@ -327,6 +366,7 @@ void read_off_memory_status(statm_t& result)
 #endif*/
     int pm = posix_memalign(ptr, (int64_t)ALIGN_BYTES, len);
     ASSERT(pm==0);
+    inc_alloc_mem_used(alloc_size(*ptr));
 #if 0
   #ifndef PRODUCTION
     int tid;
@@ -406,6 +446,7 @@ void read_off_memory_status(statm_t& result)
    * \param[in] tid thread id from whose stack pointer needs to be freed
    */
   int cdealloc(void * ptr, int const tid){
+    inc_alloc_mem_used(-alloc_size(ptr));
     free(ptr);
 #if 0
     if ((int64_t)((char*)ptr-(char*)mst_buffer) < mst_buffer_size && 
@@ -476,6 +517,7 @@ void read_off_memory_status(statm_t& result)
    * \param[in,out] ptr pointer to set to address to free
    */
   int cdealloc(void * ptr){ 
+    inc_alloc_mem_used(-alloc_size(ptr));
     free(ptr);
     return CTF_int::SUCCESS;
   }
@@ -11,6 +11,12 @@ namespace CTF_int {
   void set_memcap(double cap);
   void set_mem_size(int64_t size);
   int get_num_instances();
+  /** \brief bytes allocated by alloc() and not yet freed by cdealloc() (0 if the allocator cannot report sizes) */
+  int64_t proc_bytes_allocated();
+  /** \brief restarts tracking the maximum of proc_bytes_allocated() */
+  void reset_peak_bytes_allocated();
+  /** \brief maximum of proc_bytes_allocated() since the last reset_peak_bytes_allocated() */
+  int64_t peak_bytes_allocated();
 }
 
 
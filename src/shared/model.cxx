@@ -30,6 +30,29 @@ namespace CTF_int {
 #endif
   }
 
+  void write_all_models(char const * fname, MPI_Comm cm){
+#ifdef TUNE
+    int rk;
+    MPI_Comm_rank(cm, &rk);
+    FILE * fp = NULL;
+    if (rk == 0){
+      fp = fopen(fname, "w");
+      if (fp == NULL)
+        printf("CTF ERROR: unable to open %s for writing model coefficients\n", fname);
+      else
+        fprintf(fp, "namespace CTF_int{\n");
+    }
+    //all processors must participate in collecting fit statistics, even if the file could not be opened
+    for (int i=0; i<get_all_models().size(); i++){
+      get_all_models()[i]->write_coeff(fp, cm);
+    }
+    if (fp != NULL){
+      fprintf(fp, "}\n");
+      fclose(fp);
+    }
+#endif
+  }
+
 
 #define SPLINE_CHUNK_SZ = 8
 
@@ -442,6 +465,54 @@ namespace CTF_int {
     printf("%s is_tuned = %d (%ld) tot_time = %lf over_time = %lf under_time = %lf\n",name,is_tuned,nobs,tot_time,over_time,under_time);
   }
 
+  template <int nparam>
+  void LinModel<nparam>::get_fit_stats(MPI_Comm cm, int64_t & tot_nobs, double & r_sq, double & rel_err, double & max_rel_err){
+    //sums over observations of [1, t, t^2, (est-t)^2, |est-t|/t]
+    double sums[5] = {0.0, 0.0, 0.0, 0.0, 0.0};
+    max_rel_err = 0.0;
+#ifdef TUNE
+    int64_t nrcol = std::min(nobs,(int64_t)hist_size);
+    for (int64_t i=0; i<nrcol; i++){
+      double t = time_param_mat[i*mat_lda];
+      double e = est_time(time_param_mat+i*mat_lda+1);
+      sums[0] += 1.0;
+      sums[1] += t;
+      sums[2] += t*t;
+      sums[3] += (e-t)*(e-t);
+      sums[4] += fabs(e-t)/t;
+      max_rel_err = std::max(max_rel_err, fabs(e-t)/t);
+    }
+    MPI_Allreduce(MPI_IN_PLACE, sums, 5, MPI_DOUBLE, MPI_SUM, cm);
+    MPI_Allreduce(MPI_IN_PLACE, &max_rel_err, 1, MPI_DOUBLE, MPI_MAX, cm);
+#endif
+    tot_nobs = (int64_t)sums[0];
+    if (tot_nobs == 0){
+      r_sq = 0.0;
+      rel_err = 0.0;
+      return;
+    }
+    double ss_tot = sums[2] - sums[1]*sums[1]/sums[0];
+    if (ss_tot > 0.0) r_sq = 1.0 - sums[3]/ss_tot;
+    else r_sq = 0.0;
+    rel_err = sums[4]/sums[0];
+  }
+
+  template <int nparam>
+  void LinModel<nparam>::write_coeff(FILE * fp, MPI_Comm cm){
+    int64_t tot_nobs;
+    double r_sq, rel_err, max_rel_err;
+    get_fit_stats(cm, tot_nobs, r_sq, rel_err, max_rel_err);
+    if (fp == NULL) return;
+    ASSERT(name!=NULL);
+    fprintf(fp, "double %s_init[] = {",name);
+    for (int i=0; i<nparam; i++){
+      if (i>0) fprintf(fp, ", ");
+      fprintf(fp, "%1.4E", coeff_guess[i]);
+    }
+    fprintf(fp, "}; // is_tuned = %d nobs = %ld R^2 = %1.4lf mean rel. err. = %1.4lf max rel. err. = %1.4lf\n",
+            is_tuned, tot_nobs, r_sq, rel_err, max_rel_err);
+  }
+
   template class LinModel<1>;
   template class LinModel<2>;
   template class LinModel<3>;
@@ -517,6 +588,11 @@ namespace CTF_int {
   void CubicModel<nparam>::print_uo(){
     lmdl.print_uo();
   }
+
+  template <int nparam>
+  void CubicModel<nparam>::write_coeff(FILE * fp, MPI_Comm cm){
+    lmdl.write_coeff(fp, cm);
+  }
   template class CubicModel<1>;
   template class CubicModel<2>;
   template class CubicModel<3>;
@@ -2,6 +2,8 @@
 #define __MODEL_H__
 
 #include "mpi.h"
+#include <stdio.h>
+#include <vector>
 #include "init_models.h"
 
 namespace CTF_int { 
@@ -10,11 +12,22 @@ namespace CTF_int {
       virtual void update(MPI_Comm cm){};
       virtual void print(){};
       virtual void print_uo(){};
+      virtual void write_coeff(FILE * fp, MPI_Comm cm){};
   };
 
+  std::vector<Model*>& get_all_models();
   void update_all_models(MPI_Comm cm);
   void print_all_models();
 
+  /**
+   * \brief writes the coefficients of all registered models to a file in the format of init_models.cxx,
+   *        annotating each with goodness-of-fit statistics over the observations made so far,
+   *        must be called collectively over cm, only rank 0 writes the file
+   * \param[in] fname name of output file
+   * \param[in] cm communicator across which observations are collected
+   */
+  void write_all_models(char const * fname, MPI_Comm cm);
+
   /**
    * \brief Linear performance models, which given measurements, provides new model guess
    */
@@ -88,6 +101,23 @@ namespace CTF_int {
        * \brief prints time estimate errors
        */
       void print_uo();
+
+      /**
+       * \brief computes goodness-of-fit of current coefficients to the observations in history
+       * \param[in] cm communicator across which we should collect observations
+       * \param[out] tot_nobs number of observations considered over all processors
+       * \param[out] r_sq coefficient of determination (R^2) of the fit
+       * \param[out] rel_err mean relative error of the estimates
+       * \param[out] max_rel_err maximum relative error of the estimates
+       */
+      void get_fit_stats(MPI_Comm cm, int64_t & tot_nobs, double & r_sq, double & rel_err, double & max_rel_err);
+
+      /**
+       * \brief writes current coefficients and fit statistics on rank 0 of cm
+       * \param[in] fp file to write to
+       * \param[in] cm communicator across which we should collect observations
+       */
+      void write_coeff(FILE * fp, MPI_Comm cm);
   };
 
   /**
@@ -138,6 +168,13 @@ namespace CTF_int {
        */
       void print_uo();
 
+      /**
+       * \brief writes current coefficients and fit statistics on rank 0 of cm
+       * \param[in] fp file to write to
+       * \param[in] cm communicator across which we should collect observations
+       */
+      void write_coeff(FILE * fp, MPI_Comm cm);
+
   };
 
 }
@@ -0,0 +1,169 @@
+/*Copyright (c) 2011, Edgar Solomonik, all rights reserved.*/
+
+#include "util.h"
+#include "trace.h"
+#include "memcontrol.h"
+#include <string>
+#include <unordered_set>
+
+namespace CTF_int {
+  #define TRACE_MAX_THREADS 256
+  #define TRACE_DEFAULT_BUF_SIZE (1<<18)
+
+  struct trace_event {
+    /** \brief name of region or counter, interned in the names of the buffer */
+    char const * name;
+    /** \brief time since trace_init() in seconds */
+    double time;
+    /** \brief counter value (unused for regions) */
+    double val;
+    /** \brief Chrome trace phase, 'B' for begin, 'E' for end, 'C' for counter */
+    char type;
+  };
+
+  /**
+   * \brief ring buffer of events owned and written by a single thread, so no locking is needed,
+   *        once full the oldest events are overwritten
+   */
+  struct trace_buffer {
+    trace_event * events;
+    int64_t nevents;
+    /** \brief copies of the names of the events, which callers may build in temporary buffers */
+    std::unordered_set<std::string> * names;
+  };
+
+  static bool trace_active = false;
+  static double trace_start_time = 0.0;
+  static int64_t trace_buf_size = TRACE_DEFAULT_BUF_SIZE;
+  static int trace_rank = 0;
+  static trace_buffer trace_bufs[TRACE_MAX_THREADS];
+  static int64_t trace_comm_bytes = 0;
+  static int64_t trace_last_flops = 0;
+  static int64_t trace_last_mem = 0;
+
+  static inline int trace_tid(){
+#ifdef USE_OMP
+    return omp_get_thread_num()%TRACE_MAX_THREADS;
+#else
+    return 0;
+#endif
+  }
+
+  static inline void trace_record(char type, char const * name, double val){
+    trace_buffer & buf = trace_bufs[trace_tid()];
+    if (buf.events == NULL){
+      buf.events = (trace_event*)malloc(sizeof(trace_event)*trace_buf_size);
+      if (buf.events == NULL) return;
+      buf.names = new std::unordered_set<std::string>();
+    }
+    trace_event & ev = buf.events[buf.nevents%trace_buf_size];
+    ev.name = buf.names->insert(std::string(name)).first->c_str();
+    ev.time = MPI_Wtime()-trace_start_time;
+    ev.val  = val;
+    ev.type = type;
+    buf.nevents++;
+  }
+
+  void trace_init(MPI_Comm cm){
+    MPI_Comm_rank(MPI_COMM_WORLD, &trace_rank);
+    char * bsz = getenv("CTF_TRACE_BUF_SIZE");
+    if (bsz != NULL && strtoll(bsz,NULL,0) > 0)
+      trace_buf_size = strtoll(bsz,NULL,0);
+    for (int i=0; i<TRACE_MAX_THREADS; i++){
+      if (trace_bufs[i].events != NULL){
+        free(trace_bufs[i].events);
+        delete trace_bufs[i].names;
+      }
+      trace_bufs[i].events = NULL;
+      trace_bufs[i].nevents = 0;
+      trace_bufs[i].names = NULL;
+    }
+    trace_comm_bytes = 0;
+    trace_last_flops = get_flops();
+    trace_last_mem = proc_bytes_used();
+    MPI_Barrier(cm);
+    trace_start_time = MPI_Wtime();
+    trace_active = true;
+  }
+
+  void trace_begin(char const * name){
+    if (!trace_active) return;
+    trace_record('B', name, 0.0);
+  }
+
+  void trace_end(char const * name){
+    if (!trace_active) return;
+    trace_record('E', name, 0.0);
+    //counters are process-wide, so only track them from the master thread
+    if (trace_tid() == 0){
+      int64_t flops = get_flops();
+      if (flops != trace_last_flops){
+        trace_record('C', "flops", (double)flops);
+        trace_last_flops = flops;
+      }
+      int64_t mem = proc_bytes_used();
+      if (mem != trace_last_mem){
+        trace_record('C', "memory_used", (double)mem);
+        trace_last_mem = mem;
+      }
+    }
+  }
+
+  void trace_counter(char const * name, double val){
+    if (!trace_active) return;
+    trace_record('C', name, val);
+  }
+
+  void trace_add_bytes(int64_t nbytes){
+    if (!trace_active) return;
+    //threads may communicate concurrently, each records the total it brought the counter to
+    int64_t tot;
+#ifdef USE_OMP
+    #pragma omp atomic capture
+#endif
+    tot = trace_comm_bytes += nbytes;
+    trace_record('C', "bytes_sent", (double)tot);
+  }
+
+  void trace_flush(char const * prefix){
+    if (!trace_active) return;
+    trace_active = false;
+    if (prefix == NULL) prefix = getenv("CTF_TRACE_PREFIX");
+    if (prefix == NULL) prefix = "ctf_trace";
+    char fname[strlen(prefix)+32];
+    sprintf(fname, "%s.%d.json", prefix, trace_rank);
+    FILE * fp = fopen(fname, "w");
+    if (fp == NULL){
+      printf("CTF ERROR: unable to open trace file %s\n", fname);
+    } else {
+      fprintf(fp, "{\"traceEvents\":[\n");
+      fprintf(fp, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":%d,\"args\":{\"name\":\"rank %d\"}}", trace_rank, trace_rank);
+      int64_t ndropped = 0;
+      for (int t=0; t<TRACE_MAX_THREADS; t++){
+        trace_buffer & buf = trace_bufs[t];
+        if (buf.events == NULL) continue;
+        int64_t st = std::max((int64_t)0, buf.nevents-trace_buf_size);
+        ndropped += st;
+        for (int64_t i=st; i<buf.nevents; i++){
+          trace_event const & ev = buf.events[i%trace_buf_size];
+          //Chrome trace timestamps are in microseconds
+          if (ev.type == 'C')
+            fprintf(fp, ",\n{\"name\":\"%s\",\"ph\":\"C\",\"ts\":%.3f,\"pid\":%d,\"tid\":%d,\"args\":{\"%s\":%.17g}}",
+                    ev.name, ev.time*1.E6, trace_rank, t, ev.name, ev.val);
+          else
+            fprintf(fp, ",\n{\"name\":\"%s\",\"ph\":\"%c\",\"ts\":%.3f,\"pid\":%d,\"tid\":%d}",
+                    ev.name, ev.type, ev.time*1.E6, trace_rank, t);
+        }
+        free(buf.events);
+        delete buf.names;
+        buf.events = NULL;
+        buf.nevents = 0;
+        buf.names = NULL;
+      }
+      fprintf(fp, "\n],\"displayTimeUnit\":\"ms\",\"otherData\":{\"rank\":%d,\"dropped_events\":%ld}}\n", trace_rank, ndropped);
+      fclose(fp);
+      if (ndropped > 0)
+        printf("CTF WARNING: rank %d dropped %ld oldest trace events, increase CTF_TRACE_BUF_SIZE to keep them\n", trace_rank, ndropped);
+    }
+  }
+}
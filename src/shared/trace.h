@@ -0,0 +1,60 @@
+#ifndef __TRACE_H__
+#define __TRACE_H__
+
+#include <stdint.h>
+#include "mpi.h"
+
+namespace CTF_int {
+  /**
+   * \brief starts recording trace events, timestamps are relative to this (collective) call
+   * \param[in] cm communicator over which to synchronize the start time
+   */
+  void trace_init(MPI_Comm cm);
+
+  /**
+   * \brief records the beginning of a named region on the calling thread
+   * \param[in] name region name, copied into the trace
+   */
+  void trace_begin(char const * name);
+
+  /**
+   * \brief records the end of a named region on the calling thread,
+   *        along with the flop and memory usage counters if they changed
+   * \param[in] name region name, copied into the trace
+   */
+  void trace_end(char const * name);
+
+  /**
+   * \brief records a counter value on the calling thread
+   * \param[in] name counter name, copied into the trace
+   * \param[in] val value of counter
+   */
+  void trace_counter(char const * name, double val);
+
+  /**
+   * \brief accumulates the number of bytes communicated by this process and records the total
+   * \param[in] nbytes number of bytes sent by the last collective
+   */
+  void trace_add_bytes(int64_t nbytes);
+
+  /**
+   * \brief writes the events recorded by all threads of this process to
+   *        prefix.rank.json in Chrome trace (Perfetto-compatible) format and stops recording
+   * \param[in] prefix file name prefix, if NULL uses CTF_TRACE_PREFIX environment variable or "ctf_trace"
+   */
+  void trace_flush(char const * prefix=NULL);
+}
+
+#ifdef TRACE
+#define TRACE_BEGIN(NAME) CTF_int::trace_begin(NAME)
+#define TRACE_END(NAME) CTF_int::trace_end(NAME)
+#define TRACE_COUNTER(NAME, VAL) CTF_int::trace_counter(NAME, VAL)
+#define TRACE_ADD_BYTES(NBYTES) CTF_int::trace_add_bytes(NBYTES)
+#else
+#define TRACE_BEGIN(NAME)
+#define TRACE_END(NAME)
+#define TRACE_COUNTER(NAME, VAL)
+#define TRACE_ADD_BYTES(NBYTES)
+#endif
+
+#endif
@@ -42,6 +42,10 @@ volatile static int64_t int64_t_max = INT64_MAX;
 #define PROFILE CTF_PROFILE
 #endif
 
+#ifdef CTF_TRACE
+#define TRACE CTF_TRACE
+#endif
+
 #ifdef CTF_PMPI
 #define PMPI CTF_PMPI
 #endif
@@ -207,7 +207,8 @@ namespace CTF_int {
   }
 
   void CSR_Matrix::partition(int s, char ** parts_buffer, CSR_Matrix ** parts){
-    int part_nnz[s], part_nrows[s];
+    int64_t part_nnz[s];
+    int part_nrows[s];
     int m = nrow();
     int v_sz = val_size();
     char * org_vals = vals();
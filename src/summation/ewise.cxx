@@ -0,0 +1,133 @@
+/*Copyright (c) 2011, Edgar Solomonik, all rights reserved.*/
+
+#include "ewise.h"
+#include "summation.h"
+#include "../contraction/contraction.h"
+#include "../tensor/untyped_tensor.h"
+#include "../mapping/mapping.h"
+#include "../shared/util.h"
+
+namespace CTF_int {
+  /** \brief number of elements passed to each call of an algstrct vector kernel */
+  static int64_t const ewise_chunk = 1<<16;
+
+  /**
+   * \brief calls f(offset, n) on consecutive chunks of n<=ewise_chunk of n_tot elements, in parallel
+   *        if there is more than one chunk
+   */
+  template <typename func>
+  static void ewise_for(int64_t n_tot, func f){
+    int64_t nchunk = (n_tot+ewise_chunk-1)/ewise_chunk;
+#ifdef USE_OMP
+    #pragma omp parallel for schedule(static) if (nchunk > 1)
+#endif
+    for (int64_t c=0; c<nchunk; c++){
+      int64_t st = c*ewise_chunk;
+      f(st, (int)std::min(ewise_chunk, n_tot-st));
+    }
+  }
+
+  /**
+   * \brief returns true if idx_A and idx_B are identical and have no repeated indices
+   */
+  static bool same_distinct_idx(int order, int const * idx_A, int const * idx_B){
+    for (int i=0; i<order; i++){
+      if (idx_A[i] != idx_B[i]) return false;
+      for (int j=0; j<i; j++){
+        if (idx_A[i] == idx_A[j]) return false;
+      }
+    }
+    return true;
+  }
+
+  bool same_layout(tensor const * A, tensor const * B){
+    if (A->wrld != B->wrld || A->order != B->order) return false;
+    if (A->is_sparse || B->is_sparse || !A->is_mapped || !B->is_mapped || A->is_folded || B->is_folded) return false;
+    if (A->has_zero_edge_len || B->has_zero_edge_len) return false;
+    if (A->topo != B->topo || A->size != B->size || A->sr->el_size != B->sr->el_size) return false;
+    for (int i=0; i<A->order; i++){
+      if (A->lens[i] != B->lens[i] || A->sym[i] != B->sym[i] || A->pad_edge_len[i] != B->pad_edge_len[i])
+        return false;
+      if (!comp_dim_map(A->edge_map+i, B->edge_map+i)) return false;
+    }
+    return true;
+  }
+
+  bool ewise_sum_applicable(summation const * sum){
+    if (sum->is_custom || sum->mask != NULL || !sum->B->sr->has_mul()) return false;
+    if (!same_layout(sum->A, sum->B)) return false;
+    return same_distinct_idx(sum->B->order, sum->idx_A, sum->idx_B);
+  }
+
+  void ewise_sum(summation const * sum){
+    TAU_FSTART(ewise_sum);
+    algstrct const * sr = sum->B->sr;
+    char const * alpha = sum->alpha == NULL ? sr->mulid() : sum->alpha;
+    char const * beta = sum->beta == NULL ? sr->mulid() : sum->beta;
+    char const * dA = sum->A->data;
+    char * dB = sum->B->data;
+    int64_t sz = sr->el_size;
+    int64_t n_tot = sum->B->size;
+    if (dA == dB){
+      //B = (alpha+beta)*B
+      char ab[sz];
+      sr->add(alpha, beta, ab);
+      if (!sr->isequal(ab, sr->mulid())){
+        ewise_for(n_tot, [&](int64_t st, int n){ sr->scal(n, ab, dB+sz*st, 1); });
+        CTF_FLOPS_ADD(n_tot);
+      }
+    } else if (sr->isequal(beta, sr->addid())){
+      bool is_one = sr->isequal(alpha, sr->mulid());
+      ewise_for(n_tot, [&](int64_t st, int n){
+        sr->copy(dB+sz*st, dA+sz*st, n);
+        if (!is_one) sr->scal(n, alpha, dB+sz*st, 1);
+      });
+      if (!is_one) CTF_FLOPS_ADD(n_tot);
+    } else {
+      bool is_one = sr->isequal(beta, sr->mulid());
+      ewise_for(n_tot, [&](int64_t st, int n){
+        if (!is_one) sr->scal(n, beta, dB+sz*st, 1);
+        sr->axpy(n, alpha, dA+sz*st, 1, dB+sz*st, 1);
+      });
+      CTF_FLOPS_ADD((is_one ? 2 : 3)*n_tot);
+    }
+    TAU_FSTOP(ewise_sum);
+  }
+
+  bool ewise_ctr_applicable(contraction const * ctr){
+    tensor const * C = ctr->C;
+    if (ctr->is_custom || ctr->mask != NULL || !C->sr->has_mul()) return false;
+    if (C->data == ctr->A->data || C->data == ctr->B->data) return false;
+    if (!same_layout(ctr->A, C) || !same_layout(ctr->B, C)) return false;
+    for (int i=0; i<C->order; i++){
+      if (C->sym[i] != NS && C->sym[i] != SY) return false;
+    }
+    return same_distinct_idx(C->order, ctr->idx_A, ctr->idx_C) &&
+           same_distinct_idx(C->order, ctr->idx_B, ctr->idx_C);
+  }
+
+  void ewise_ctr(contraction const * ctr){
+    TAU_FSTART(ewise_ctr);
+    algstrct const * sr = ctr->C->sr;
+    char const * alpha = ctr->alpha == NULL || sr->isequal(ctr->alpha, sr->mulid()) ? NULL : ctr->alpha;
+    char const * beta = ctr->beta == NULL ? sr->mulid() : ctr->beta;
+    bool is_zero = sr->isequal(beta, sr->addid());
+    bool is_one = sr->isequal(beta, sr->mulid());
+    char const * dA = ctr->A->data;
+    char const * dB = ctr->B->data;
+    char * dC = ctr->C->data;
+    int64_t sz = sr->el_size;
+    int64_t n_tot = ctr->C->size;
+    ewise_for(n_tot, [&](int64_t st, int n){
+      if (is_zero) sr->set(dC+sz*st, sr->addid(), n);
+      else if (!is_one) sr->scal(n, beta, dC+sz*st, 1);
+      sr->hadamard(n, alpha, dA+sz*st, 1, dB+sz*st, 1, dC+sz*st, 1);
+    });
+    CTF_FLOPS_ADD(2*n_tot);
+  #ifndef SEQ
+    //as after a contraction, padding is restored to zero, since a product of paddings may not be zero (e.g. 0*inf)
+    if (ctr->C->is_cyclic) ctr->C->zero_out_padding();
+  #endif
+    TAU_FSTOP(ewise_ctr);
+  }
+}
@@ -0,0 +1,51 @@
+/*Copyright (c) 2011, Edgar Solomonik, all rights reserved.*/
+
+#ifndef __EWISE_H__
+#define __EWISE_H__
+
+#include "../interface/common.h"
+
+namespace CTF_int {
+  class tensor;
+  class summation;
+  class contraction;
+
+  /**
+   * \brief returns true if dense tensors A and B have the same shape and symmetry and are mapped
+   *        identically, so that their local data are aligned element by element on every processor
+   */
+  bool same_layout(tensor const * A, tensor const * B);
+
+  /**
+   * \brief returns true if the summation is of the form B["ij..."] = beta*B["ij..."] + alpha*A["ij..."]
+   *        with distinct indices in the same order on dense identically distributed tensors, so that
+   *        it can be executed by ewise_sum()
+   * \param[in] sum summation to check
+   */
+  bool ewise_sum_applicable(summation const * sum);
+
+  /**
+   * \brief executes a summation for which ewise_sum_applicable() returned true by a flat loop over
+   *        the local data, without mapping, transposition or allocation
+   * \param[in] sum summation to execute
+   */
+  void ewise_sum(summation const * sum);
+
+  /**
+   * \brief returns true if the contraction is an elementwise (Hadamard) product
+   *        C["ij..."] = beta*C["ij..."] + alpha*A["ij..."]*B["ij..."] with distinct indices in the same order
+   *        on dense identically distributed nonsymmetric or symmetric tensors, C not aliasing A or B,
+   *        so that it can be executed by ewise_ctr()
+   * \param[in] ctr contraction to check
+   */
+  bool ewise_ctr_applicable(contraction const * ctr);
+
+  /**
+   * \brief executes a contraction for which ewise_ctr_applicable() returned true by a flat loop over
+   *        the local data, without mapping, transposition or allocation
+   * \param[in] ctr contraction to execute
+   */
+  void ewise_ctr(contraction const * ctr);
+}
+
+#endif
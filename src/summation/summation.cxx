@@ -11,6 +11,8 @@
 #include "../redistribution/nosym_transp.h"
 #include "../redistribution/redist.h"
 #include "../scaling/scaling.h"
+#include "../redistribution/sparse_rw.h"
+#include "ewise.h"
 
 namespace CTF_int {
 
@@ -19,6 +21,7 @@ namespace CTF_int {
   summation::~summation(){
     if (idx_A != NULL) cdealloc(idx_A);
     if (idx_B != NULL) cdealloc(idx_B);
+    if (idx_mask != NULL) cdealloc(idx_mask);
   }
 
   summation::summation(summation const & other){
@@ -34,6 +37,13 @@ namespace CTF_int {
     } else is_custom = 0; 
     alpha = other.alpha;
     beta  = other.beta;
+    mask     = other.mask;
+    mask_cmp = other.mask_cmp;
+    idx_mask = NULL;
+    if (mask != NULL){
+      idx_mask = (int*)alloc(sizeof(int)*mask->order);
+      memcpy(idx_mask, other.idx_mask, sizeof(int)*mask->order);
+    }
   }
 
   summation::summation(tensor *     A_,
@@ -47,6 +57,9 @@ namespace CTF_int {
     B         = B_;
     beta      = beta_;
     is_custom = 0;
+    mask      = NULL;
+    idx_mask  = NULL;
+    mask_cmp  = false;
 
     idx_A     = (int*)alloc(sizeof(int)*A->order);
     idx_B     = (int*)alloc(sizeof(int)*B->order);
@@ -66,6 +79,9 @@ namespace CTF_int {
     B         = B_;
     beta      = beta_;
     is_custom = 0;
+    mask      = NULL;
+    idx_mask  = NULL;
+    mask_cmp  = false;
     
     conv_idx(A->order, cidx_A, &idx_A, B->order, cidx_B, &idx_B);
   }
@@ -84,6 +100,9 @@ namespace CTF_int {
     beta      = beta_;
     func      = func_;
     is_custom = 1;
+    mask      = NULL;
+    idx_mask  = NULL;
+    mask_cmp  = false;
 
     idx_A     = (int*)alloc(sizeof(int)*A->order);
     idx_B     = (int*)alloc(sizeof(int)*B->order);
@@ -106,17 +125,114 @@ namespace CTF_int {
     beta      = beta_;
     func      = func_;
     is_custom = 1;
+    mask      = NULL;
+    idx_mask  = NULL;
+    mask_cmp  = false;
 
     conv_idx(A->order, cidx_A, &idx_A, B->order, cidx_B, &idx_B);
   }
 
+  void summation::set_mask(tensor * M, char const * cidx_M, char const * cidx_B, bool complement){
+    for (int i=0; i<B->order; i++){
+      if (B->sym[i] != NS){
+        printf("CTF ERROR: masked summations require a nonsymmetric output tensor\n");
+        IASSERT(0);
+        return;
+      }
+    }
+    for (int i=0; i<M->order; i++){
+      if (M->sym[i] != NS){
+        printf("CTF ERROR: mask tensor must be nonsymmetric\n");
+        IASSERT(0);
+        return;
+      }
+    }
+    if (idx_mask != NULL) cdealloc(idx_mask);
+    mask = M;
+    mask_cmp = complement;
+    idx_mask = (int*)alloc(sizeof(int)*M->order);
+    for (int i=0; i<M->order; i++){
+      idx_mask[i] = -1;
+      for (int j=0; j<B->order; j++){
+        if (cidx_M[i] == cidx_B[j]) idx_mask[i] = idx_B[j];
+      }
+      for (int j=0; j<i; j++){
+        if (cidx_M[i] == cidx_M[j]) idx_mask[i] = -1;
+      }
+      if (idx_mask[i] == -1){
+        printf("CTF ERROR: each index of the mask must appear once in the mask and in the output\n");
+        IASSERT(0);
+      }
+    }
+  }
+
+  void summation::execute_masked(){
+    TAU_FSTART(summation_masked);
+    //if A has all indices of the mask, filtering it selects exactly the entries in the mask
+    bool is_nonsym = true;
+    for (int i=0; i<A->order; i++){
+      if (A->sym[i] != NS) is_nonsym = false;
+    }
+    int nshr = 0;
+    for (int j=0; j<mask->order; j++){
+      for (int i=0; i<A->order; i++){
+        if (idx_A[i] == idx_mask[j]){
+          nshr++;
+          break;
+        }
+      }
+    }
+    tensor * mA = A;
+    if (is_nonsym && nshr > 0 && (nshr == mask->order || !mask_cmp)){
+      mA = A->masked_copy(idx_A, mask, idx_mask, mask_cmp);
+    }
+    if (mA != A && nshr == mask->order){
+      summation sm(mA, idx_A, alpha, B, idx_B, beta);
+      if (is_custom){
+        sm.func = func;
+        sm.is_custom = 1;
+      }
+      sm.execute();
+    } else {
+      //otherwise the indices of B not in A are broadcast, so sum into an intermediate and apply the mask to it
+      if (is_custom && func->is_accumulator()){
+        printf("CTF ERROR: masks on summations with a transform require an operand with all indices of the mask\n");
+        IASSERT(0);
+      }
+      tensor * T = new tensor(B, 0, 1);
+      summation sm(mA, idx_A, alpha, T, idx_B, B->sr->addid());
+      if (is_custom){
+        sm.func = func;
+        sm.is_custom = 1;
+      }
+      sm.execute();
+      T->apply_mask(idx_B, mask, idx_mask, mask_cmp);
+      summation smT(T, idx_B, B->sr->mulid(), B, idx_B, beta);
+      smT.execute();
+      delete T;
+    }
+    if (mA != A) delete mA;
+    TAU_FSTOP(summation_masked);
+  }
+
   void summation::execute(bool run_diag){
+    A->flush_writes();
+    B->flush_writes();
+    if (mask != NULL){
+      mask->flush_writes();
+      execute_masked();
+      return;
+    }
 #if (DEBUG >= 2 || VERBOSE >= 1)
   #if DEBUG >= 2
     if (A->wrld->cdt.rank == 0) printf("Summation::execute (head):\n");
   #endif
     print();
 #endif
+    if (ewise_sum_applicable(this)){
+      ewise_sum(this);
+      return;
+    }
     //update_all_models(A->wrld->cdt.cm);
     int stat = home_sum_tsr(run_diag);
     assert(stat == SUCCESS); 
@@ -1339,6 +1455,91 @@ namespace CTF_int {
   }
 
 
+  /** \brief local density of a sparse output above which a dense summand is accumulated by densifying it */
+  static double dns_sp_sum_dens = .5;
+
+  void set_dns_sp_sum_density(double dens){
+    dns_sp_sum_dens = dens;
+  }
+
+  /**
+   * \brief accumulates nonsymmetric dense A into nonsymmetric sparse B when both are indexed identically,
+   *        without sparsifying A, A is remapped to the distribution of B if needed, then locally either
+   *        its blocks are merged with the pairs of B, or when B is dense enough the pairs of B are
+   *        scattered into (a copy of) A, which is then sparsified
+   * \return false if the summation is not of this form, in which case nothing is done
+   */
+  static bool sum_dns_into_sp(summation const * sum,
+                              tensor *          A,
+                              int const *       idx_A,
+                              tensor *          B,
+                              int const *       idx_B){
+    algstrct const * sr = B->sr;
+    if (sum->is_custom || sum->mask != NULL || A->is_sparse || !B->is_sparse) return false;
+    if (A->wrld != B->wrld || A->order != B->order || sr->addid() == NULL || !A->sr->has_same_ops(sr)) return false;
+    if (!A->is_mapped || !B->is_mapped || A->is_folded || B->is_folded) return false;
+    for (int i=0; i<B->order; i++){
+      if (idx_A[i] != idx_B[i] || A->sym[i] != NS || B->sym[i] != NS) return false;
+    }
+    TAU_FSTART(sum_dns_into_sp); 
+    int order = B->order;
+    bool is_aligned = A->topo == B->topo;
+    for (int i=0; i<order; i++){
+      if (!comp_dim_map(A->edge_map+i, B->edge_map+i)) is_aligned = false;
+    }
+    bool densify = B->nnz_loc > dns_sp_sum_dens*B->size;
+    tensor * dA = A;
+    if (!is_aligned || densify){
+      dA = new tensor(A);
+      dA->align(B);
+    }
+
+    int nvirt = 1;
+    int idx_lyr = B->wrld->rank;
+    int phase[order], phys_phase[order], virt_phase[order], virt_phys_rank[order];
+    int64_t edge_lda[order+1];
+    for (int i=0; i<order; i++){
+      mapping const * map = B->edge_map + i;
+      phase[i]          = map->calc_phase();
+      phys_phase[i]     = map->calc_phys_phase();
+      virt_phase[i]     = phase[i]/phys_phase[i];
+      virt_phys_rank[i] = map->calc_phys_rank(B->topo);
+      edge_lda[i]       = i == 0 ? 1 : edge_lda[i-1]*B->lens[i-1];
+      nvirt            *= virt_phase[i];
+      if (map->type == PHYSICAL_MAP)
+        idx_lyr -= B->topo->lda[map->cdt]*virt_phys_rank[i];
+    }
+    ASSERT(nvirt == B->calc_nvirt());
+    int64_t nnz_blk[nvirt];
+    if (idx_lyr == 0){
+      //if B is being overwritten, none of its pairs contribute
+      int64_t nnz_blk_B[nvirt];
+      if (sum->beta != NULL && sr->isequal(sum->beta, sr->addid()))
+        std::fill(nnz_blk_B, nnz_blk_B+nvirt, 0);
+      else
+        memcpy(nnz_blk_B, B->nnz_blk, sizeof(int64_t)*nvirt);
+      char * new_pairs = NULL;
+      if (densify){
+        sp_dns_sum(order, dA->size, nvirt, B->lens, dA->pad_edge_len, phase, dA->data, sum->alpha,
+                   nnz_blk_B, B->data, sum->beta, sr);
+        spsfy_tsr(order, dA->size, nvirt, dA->pad_edge_len, dA->sym, phase, phys_phase, virt_phase,
+                  virt_phys_rank, dA->data, new_pairs, nnz_blk, sr, edge_lda,
+                  [&](char const * c){ return !sr->isequal(c, sr->addid()); });
+      } else {
+        dns_sp_sum(order, dA->size, nvirt, B->lens, dA->pad_edge_len, phase, phys_phase, virt_phase,
+                   virt_phys_rank, dA->data, sum->alpha, nnz_blk_B, B->data, sum->beta, nnz_blk,
+                   new_pairs, sr);
+      }
+      if (B->data != NULL) cdealloc(B->data);
+      B->data = new_pairs;
+    } else
+      memcpy(nnz_blk, B->nnz_blk, sizeof(int64_t)*nvirt);
+    B->set_new_nnz_glb(nnz_blk);
+    if (dA != A) delete dA;
+    TAU_FSTOP(sum_dns_into_sp);
+    return true;
+  }
+
   /**
    * \brief PDAXPY: a*idx_map_A(A) + b*idx_map_B(B) -> idx_map_B(B).
    * \param[in] run_diag if 1 run diagonal sum
@@ -1408,6 +1609,16 @@ namespace CTF_int {
       map_B = new_idx_map;
     }
 
+    if (nst_B == 0 && sum_dns_into_sp(this, tnsr_A, map_A, tnsr_B, map_B)){
+      if (tnsr_A != A) delete tnsr_A;
+      CTF_int::cdealloc(map_A);
+      CTF_int::cdealloc(map_B);
+      CTF_int::cdealloc(dstack_map_B);
+      CTF_int::cdealloc(dstack_tsr_B);
+      TAU_FSTOP(sum_preprocessing);
+      return SUCCESS;
+    }
+
     if (!tnsr_A->is_sparse && tnsr_B->is_sparse){
       tensor * stnsr_A = tnsr_A;
       tnsr_A = new tensor(stnsr_A);
@@ -32,6 +32,12 @@ namespace CTF_int {
       bool is_custom;
       /** \brief function to execute on elements */
       univar_function const * func;
+      /** \brief tensor whose nonzeros select the entries of B that are summed into, NULL if none */
+      tensor * mask;
+      /** \brief indices of mask */
+      int * idx_mask;
+      /** \brief whether the entries selected are instead those not matching nonzeros of the mask */
+      bool mask_cmp;
 
       /** \brief lazy constructor */
 //      summation(){ idx_A = NULL; idx_B = NULL; alpha=NULL; beta=NULL; is_custom=0; };
@@ -92,6 +98,16 @@ namespace CTF_int {
                 char const *            beta,
                 univar_function const * func);
 
+      /**
+       * \brief restricts the summation to entries of B that match a nonzero of M,
+       *        B[idx_B] = beta*B[idx_B] + alpha * M[idx_M] o A[idx_A]
+       * \param[in] M mask tensor, nonsymmetric, only its sparsity pattern is used
+       * \param[in] cidx_M indices of M, each must be an index of B
+       * \param[in] cidx_B indices of B with the same naming as cidx_M
+       * \param[in] complement if true, keep only entries that do not match a nonzero of M
+       */
+      void set_mask(tensor * M, char const * cidx_M, char const * cidx_B, bool complement=false);
+
       /** \brief run summation  
         * \param[in] run_diag if true runs diagonal iterators (otherwise calls itself with run_diag=true later
         */
@@ -118,6 +134,11 @@ namespace CTF_int {
       void print();
 
     private:
+      /**
+       * \brief runs summation restricted by mask
+       */
+      void execute_masked();
+
       /**
        * \brief finds and return all summation indices which can be folded into
        *    dgemm,for which they must (1) not break symmetry (2) belong to 
@@ -251,6 +272,14 @@ namespace CTF_int {
        */
       void sp_sum();
   };
+
+  /**
+   * \brief sets the local density of a sparse output above which a dense summand with the same indices
+   *        is accumulated into it by scattering its pairs into the dense summand and sparsifying the result,
+   *        rather than by merging the dense blocks with its pairs (default .5)
+   * \param[in] dens fraction of nonzeros in the local part of the output
+   */
+  void set_dns_sp_sum_density(double dens);
 }
 
 #endif
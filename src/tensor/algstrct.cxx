@@ -140,6 +140,11 @@ namespace CTF_int {
     return NULL;
   }
 
+  bool algstrct::has_same_ops(algstrct const * other) const {
+    if (other == this) return true;
+    return el_size == other->el_size && isequal(addid(), other->addid()) && isequal(mulid(), other->mulid());
+  }
+
   void algstrct::safeaddinv(char const * a, char *& b) const {
     printf("CTF ERROR: no additive inverse present for this algebraic structure\n");
     ASSERT(0);
@@ -260,6 +265,22 @@ namespace CTF_int {
     assert(0);
   }
 
+  void algstrct::hadamard(int          n,
+                          char const * alpha,
+                          char const * A,
+                          int          incA,
+                          char const * B,
+                          int          incB,
+                          char       * C,
+                          int          incC)  const {
+    char tmp[el_size];
+    for (int i=0; i<n; i++){
+      mul(A+el_size*incA*(int64_t)i, B+el_size*incB*(int64_t)i, tmp);
+      if (alpha != NULL) mul(tmp, alpha, tmp);
+      add(tmp, C+el_size*incC*(int64_t)i, C+el_size*incC*(int64_t)i);
+    }
+  }
+
    void algstrct::gemm(char         tA,
                        char         tB,
                        int          m,
@@ -274,6 +295,22 @@ namespace CTF_int {
     ASSERT(0);
   }
 
+   void algstrct::gemm_batch(char                 tA,
+                             char                 tB,
+                             int                  l,
+                             int                  m,
+                             int                  n,
+                             int                  k,
+                             char const *         alpha,
+                             char const * const * A,
+                             char const * const * B,
+                             char const *         beta,
+                             char * const *       C)  const {
+    for (int i=0; i<l; i++){
+      gemm(tA, tB, m, n, k, alpha, A[i], B[i], beta, C[i]);
+    }
+  }
+
 
    void algstrct::offload_gemm(char         tA,
                                char         tB,
@@ -320,142 +357,264 @@ namespace CTF_int {
     return CTF_int::CSR_Matrix::csr_add(cA, cB, this);
   }
   
-  char * algstrct::csr_reduce(char * cA, int root, MPI_Comm cm) const {
+  /**
+   * \brief sends sbufs[i] to and receives rbufs[i] from peers[i] for each i, with 64-bit sizes,
+   *        messages longer than INT_MAX bytes are sent in several pieces
+   */
+  static void exchange_bytes(int             n,
+                             int const *     peers,
+                             char * const *  sbufs,
+                             int64_t const * ssz,
+                             char * const *  rbufs,
+                             int64_t const * rsz,
+                             MPI_Comm        cm){
+    std::vector<MPI_Request> reqs;
+    for (int i=0; rsz != NULL && i<n; i++){
+      for (int64_t off=0; off<rsz[i]; off+=INT_MAX){
+        reqs.push_back(MPI_Request());
+        MPI_Irecv(rbufs[i]+off, (int)std::min((int64_t)INT_MAX, rsz[i]-off), MPI_CHAR, peers[i], 0, cm, &reqs.back());
+      }
+    }
+    for (int i=0; ssz != NULL && i<n; i++){
+      for (int64_t off=0; off<ssz[i]; off+=INT_MAX){
+        reqs.push_back(MPI_Request());
+        MPI_Isend(sbufs[i]+off, (int)std::min((int64_t)INT_MAX, ssz[i]-off), MPI_CHAR, peers[i], 0, cm, &reqs.back());
+      }
+    }
+    if (reqs.size() > 0)
+      MPI_Waitall(reqs.size(), reqs.data(), MPI_STATUSES_IGNORE);
+  }
+
+  /**
+   * \brief factors p into its prime factors in increasing order, the radices of the levels of the
+   *        reduce-scatter, processors in a group of a level differ only in the digit of that radix
+   */
+  static std::vector<int> csr_red_radices(int p){
+    std::vector<int> radices;
+    for (int s=2; p>1; s++){
+      while (p%s == 0){
+        radices.push_back(s);
+        p /= s;
+      }
+    }
+    return radices;
+  }
+
+  char * algstrct::csr_reduce_scatter(char * cA, MPI_Comm cm) const {
     int r, p;
     MPI_Comm_rank(cm, &r);
     MPI_Comm_size(cm, &p);
     if (p==1) return cA;
-    TAU_FSTART(csr_reduce);
-    int s = 2;
-    double t_st = MPI_Wtime();
-    while (p%s != 0) s++;
-    int sr = r%s;
-    MPI_Comm scm;
-    MPI_Comm rcm;
-    MPI_Comm_split(cm, r/s, sr, &scm);
-    MPI_Comm_split(cm, sr, r/s, &rcm);
-    
-    CSR_Matrix A(cA);
-    int64_t sz_A = A.size();
-    char * parts_buffer; 
-    CSR_Matrix ** parts = (CSR_Matrix**)alloc(sizeof(CSR_Matrix*)*s);
-    A.partition(s, &parts_buffer, parts);
-    //MPI_Request reqs[2*(s-1)];
-    int rcv_szs[s];
-    int snd_szs[s];
-    int64_t tot_buf_size = 0;
-    for (int i=0; i<s; i++){
-      if (i==sr) snd_szs[i] = 0;
-      else snd_szs[i] = parts[i]->size();
-      tot_buf_size += snd_szs[i];
+    TAU_FSTART(csr_reduce_scatter);
+    std::vector<int> radices = csr_red_radices(p);
+    char * cur = cA;
+    int stride = 1;
+    for (int l=0; l<(int)radices.size(); l++){
+      int s = radices[l];
+      int d = (r/stride)%s;
+      //keep the rows of each s-th residue of the current part, send the others to the processors keeping them
+      CSR_Matrix A(cur);
+      char * parts_buffer;
+      CSR_Matrix ** parts = (CSR_Matrix**)alloc(sizeof(CSR_Matrix*)*s);
+      A.partition(s, &parts_buffer, parts);
+      int * peers = (int*)alloc(sizeof(int)*(s-1));
+      char ** sbufs = (char**)alloc(sizeof(char*)*(s-1));
+      char ** rbufs = (char**)alloc(sizeof(char*)*(s-1));
+      int64_t * ssz = (int64_t*)alloc(sizeof(int64_t)*(s-1));
+      int64_t * rsz = (int64_t*)alloc(sizeof(int64_t)*(s-1));
+      for (int i=0, j=0; i<s; i++){
+        if (i == d) continue;
+        peers[j] = r+(i-d)*stride;
+        sbufs[j] = (char*)(ssz+j);
+        rbufs[j] = (char*)(rsz+j);
+        ssz[j] = parts[i]->size();
+        j++;
+      }
+      int64_t * szs = (int64_t*)alloc(sizeof(int64_t)*(s-1));
+      std::fill(szs, szs+s-1, (int64_t)sizeof(int64_t));
+      exchange_bytes(s-1, peers, sbufs, szs, rbufs, szs, cm);
+      cdealloc(szs);
+      int64_t tot_rcv_sz = 0;
+      for (int j=0; j<s-1; j++){
+        tot_rcv_sz += rsz[j];
+      }
+      char * rcv_buf = (char*)alloc(std::max(tot_rcv_sz, (int64_t)1));
+      char ** smnds = (char**)alloc(sizeof(char*)*s);
+      bool * own = (bool*)alloc(sizeof(bool)*s);
+      int64_t off = 0;
+      for (int i=0, j=0; i<s; i++){
+        own[i] = false;
+        if (i == d){
+          smnds[i] = parts[i]->all_data;
+          continue;
+        }
+        sbufs[j] = parts[i]->all_data;
+        rbufs[j] = rcv_buf+off;
+        smnds[i] = rbufs[j];
+        off += rsz[j];
+        j++;
+      }
+      exchange_bytes(s-1, peers, sbufs, ssz, rbufs, rsz, cm);
+      for (int i=0; i<s; i++){
+        delete parts[i]; //does not actually free buffer space
+      }
+      cdealloc(parts);
+      for (int z=1; z<s; z<<=1){
+        for (int i=0; i<s-z; i+=2*z){
+          char * csr_new = csr_add(smnds[i], smnds[i+z]);
+          if (own[i]) cdealloc(smnds[i]);
+          if (own[i+z]) cdealloc(smnds[i+z]);
+          smnds[i] = csr_new;
+          own[i] = true;
+        }
+      }
+      if (cur != cA) cdealloc(cur);
+      cur = smnds[0];
+      cdealloc(parts_buffer);
+      cdealloc(rcv_buf);
+      cdealloc(smnds);
+      cdealloc(own);
+      cdealloc(peers);
+      cdealloc(sbufs);
+      cdealloc(rbufs);
+      cdealloc(ssz);
+      cdealloc(rsz);
+      stride *= s;
     }
+    TAU_FSTOP(csr_reduce_scatter);
+    return cur;
+  }
 
-    MPI_Alltoall(snd_szs, 1, MPI_INT, rcv_szs, 1, MPI_INT, scm);
-    int64_t tot_rcv_sz = 0;
-    for (int i=0; i<s; i++){
-      //printf("i=%d/%d,rcv_szs[i]=%d\n",i,s,rcv_szs[i]);
-      tot_rcv_sz += rcv_szs[i];
-    }
-    char * rcv_buf = (char*)alloc(tot_rcv_sz);
-  
-    char * smnds[s];
-    int rcv_displs[s];
-    int snd_displs[s];
-    rcv_displs[0] = 0;
-    for (int i=0; i<s; i++){
-      if (i>0) rcv_displs[i] = rcv_szs[i-1]+rcv_displs[i-1];
-      snd_displs[i] = parts[i]->all_data - parts[0]->all_data;
-      if (i==sr) smnds[i] = parts[i]->all_data;
-      else smnds[i] = rcv_buf + rcv_displs[i];
-//      printf("parts[%d].all_data = %p\n",i,parts[i]->all_data);
-  //    printf("snd_dipls[%d] = %d\n", i, snd_displs[i]);
-//      printf("rcv_dipls[%d] = %d\n", i, rcv_displs[i]);
-    }
-    MPI_Alltoallv(parts[0]->all_data, snd_szs, snd_displs, MPI_CHAR, rcv_buf, rcv_szs, rcv_displs, MPI_CHAR, scm);
-    for (int i=0; i<s; i++){
-      delete parts[i]; //does not actually free buffer space
-    }
-    cdealloc(parts);
-    /*  smnds[i] = (char*)alloc(rcv_szs[i]);
-      int sbw = (r/phase - i + s-1)%s;
-      int rbw = sbw + (r/(phase*s))*s + (r%phase);
-      int rfw = sfw + (r/(phase*s))*s + (r%phase);
-      char * rcv_data = (char*)alloc(rcv_szs[i]);
-      smnds[i] = rcv_data;
-      MPI_Isend(parts[sfw], snd_szs[i], MPI_CHAR, rfw, s+i, cm, reqs+i);
-      MPI_Irecv(rcv_data, rcv_szs[i], MPI_CHAR, rbw, s+i, cm, reqs+s-1+i);
-    }
-    MPI_Status stats[2*(s-1)];
-    MPI_Waitall(2*(s-1), reqs, stats);
-    for (int i=1; i<s; i++){
-      int sfw = (r/phase + i + s-1)%s;
-      cdealloc(parts[sfw]);
-    }
-    cdealloc(parts);*/
-    for (int z=1; z<s; z<<=1){
-      for (int i=0; i<s-z; i+=2*z){
-        char * csr_new = csr_add(smnds[i], smnds[i+z]);
-        if ((smnds[i] < parts_buffer || 
-             smnds[i] > parts_buffer+tot_buf_size) &&
-            (smnds[i] < rcv_buf || 
-             smnds[i] > rcv_buf+tot_rcv_sz))
-          cdealloc(smnds[i]);
-        if ((smnds[i+z] < parts_buffer || 
-             smnds[i+z] > parts_buffer+tot_buf_size) &&
-            (smnds[i+z] < rcv_buf || 
-             smnds[i+z] > rcv_buf+tot_rcv_sz))
-          cdealloc(smnds[i+z]);
-        smnds[i] = csr_new;
+  char * algstrct::csr_allreduce(char * cA, MPI_Comm cm) const {
+    int r, p;
+    MPI_Comm_rank(cm, &r);
+    MPI_Comm_size(cm, &p);
+    if (p==1) return cA;
+    char * cur = csr_reduce_scatter(cA, cm);
+    TAU_FSTART(csr_allreduce);
+    //undo the levels of the reduce-scatter in reverse order, merging the parts of each group
+    std::vector<int> radices = csr_red_radices(p);
+    int stride = p;
+    for (int l=(int)radices.size()-1; l>=0; l--){
+      int s = radices[l];
+      stride /= s;
+      int d = (r/stride)%s;
+      int * peers = (int*)alloc(sizeof(int)*(s-1));
+      char ** sbufs = (char**)alloc(sizeof(char*)*(s-1));
+      char ** rbufs = (char**)alloc(sizeof(char*)*(s-1));
+      int64_t * ssz = (int64_t*)alloc(sizeof(int64_t)*(s-1));
+      int64_t * rsz = (int64_t*)alloc(sizeof(int64_t)*(s-1));
+      int64_t my_sz = CSR_Matrix(cur).size();
+      for (int i=0, j=0; i<s; i++){
+        if (i == d) continue;
+        peers[j] = r+(i-d)*stride;
+        sbufs[j] = (char*)&my_sz;
+        rbufs[j] = (char*)(rsz+j);
+        ssz[j] = sizeof(int64_t);
+        j++;
       }
-    }
-    cdealloc(parts_buffer); //dealloc all parts
-    cdealloc(rcv_buf);
-    TAU_FSTOP(csr_reduce);
-    char * red_sum = csr_reduce(smnds[0], root/s, rcm);
-    TAU_FSTART(csr_reduce);
-    if (smnds[0] != red_sum) cdealloc(smnds[0]);
-    if (r/s == root/s){
-      CSR_Matrix cf(red_sum);
-      int sz = cf.size();
-      int sroot = root%s;
-      int cb_sizes[s];
-      if (sroot == sr) sz = 0;
-      MPI_Gather(&sz, 1, MPI_INT, cb_sizes, 1, MPI_INT, sroot, scm);
-      int64_t tot_cb_size = 0;
-      int cb_displs[s];
-      if (sr == sroot){
-        for (int i=0; i<s; i++){
-          cb_displs[i] = tot_cb_size;
-          tot_cb_size += cb_sizes[i];
+      exchange_bytes(s-1, peers, sbufs, ssz, rbufs, ssz, cm);
+      int64_t tot_rcv_sz = 0;
+      for (int j=0; j<s-1; j++){
+        tot_rcv_sz += rsz[j];
+      }
+      char * rcv_buf = (char*)alloc(std::max(tot_rcv_sz, (int64_t)1));
+      char ** smnds = (char**)alloc(sizeof(char*)*s);
+      int64_t off = 0;
+      for (int i=0, j=0; i<s; i++){
+        if (i == d){
+          smnds[i] = cur;
+          continue;
         }
+        sbufs[j] = cur;
+        ssz[j] = my_sz;
+        rbufs[j] = rcv_buf+off;
+        smnds[i] = rbufs[j];
+        off += rsz[j];
+        j++;
       }
-      char * cb_bufs = (char*)alloc(tot_cb_size);
-      MPI_Gatherv(red_sum, sz, MPI_CHAR, cb_bufs, cb_sizes, cb_displs, MPI_CHAR, sroot, scm);
-      MPI_Comm_free(&scm);
-      MPI_Comm_free(&rcm);
-      if (sr == sroot){
-        for (int i=0; i<s; i++){
-          smnds[i] = cb_bufs + cb_displs[i];
-          if (i==sr) smnds[i] = red_sum;
+      exchange_bytes(s-1, peers, sbufs, ssz, rbufs, rsz, cm);
+      CSR_Matrix merged(smnds, s);
+      if (cur != cA) cdealloc(cur);
+      cur = merged.all_data;
+      cdealloc(rcv_buf);
+      cdealloc(smnds);
+      cdealloc(peers);
+      cdealloc(sbufs);
+      cdealloc(rbufs);
+      cdealloc(ssz);
+      cdealloc(rsz);
+    }
+    TAU_FSTOP(csr_allreduce);
+    return cur;
+  }
+
+  char * algstrct::csr_reduce(char * cA, int root, MPI_Comm cm) const {
+    int r, p;
+    MPI_Comm_rank(cm, &r);
+    MPI_Comm_size(cm, &p);
+    if (p==1) return cA;
+    double t_st = MPI_Wtime();
+    int64_t sz_A = CSR_Matrix(cA).size();
+    //each processor reduces the rows of one residue modulo p, then the root gathers and interleaves them
+    char * part = csr_reduce_scatter(cA, cm);
+    char * out = csr_gather(part, root, cm);
+    if (r == root){
+      double t_end = MPI_Wtime() - t_st;
+      double tps[] = {t_end, 1.0, log2((double)p), (double)sz_A};
+      csrred_mdl.observe(tps);
+    }
+    return out;
+  }
+
+  char * algstrct::csr_gather(char * cA, int root, MPI_Comm cm) const {
+    int r, p;
+    MPI_Comm_rank(cm, &r);
+    MPI_Comm_size(cm, &p);
+    if (p==1) return cA;
+    TAU_FSTART(csr_gather);
+    int64_t sz = CSR_Matrix(cA).size();
+    if (r == root){
+      int64_t * szs = (int64_t*)alloc(sizeof(int64_t)*p);
+      MPI_Gather(&sz, 1, MPI_INT64_T, szs, 1, MPI_INT64_T, root, cm);
+      int * peers = (int*)alloc(sizeof(int)*(p-1));
+      char ** rbufs = (char**)alloc(sizeof(char*)*(p-1));
+      int64_t * rsz = (int64_t*)alloc(sizeof(int64_t)*(p-1));
+      char ** smnds = (char**)alloc(sizeof(char*)*p);
+      int64_t tot_rcv_sz = 0;
+      for (int i=0; i<p; i++){
+        if (i != root) tot_rcv_sz += szs[i];
+      }
+      char * rcv_buf = (char*)alloc(std::max(tot_rcv_sz, (int64_t)1));
+      int64_t off = 0;
+      for (int i=0, j=0; i<p; i++){
+        if (i == root){
+          smnds[i] = cA;
+          continue;
         }
-        CSR_Matrix out(smnds, s);
-        cdealloc(red_sum);
-        cdealloc(cb_bufs);
-        double t_end = MPI_Wtime() - t_st;
-        double tps[] = {t_end, 1.0, log2((double)p), (double)sz_A};
-        csrred_mdl.observe(tps);
-        TAU_FSTOP(csr_reduce);
-        return out.all_data;
-      } else {
-        cdealloc(red_sum);
-        cdealloc(cb_bufs);
-        TAU_FSTOP(csr_reduce);
-        return NULL;
+        peers[j] = i;
+        rsz[j] = szs[i];
+        rbufs[j] = rcv_buf+off;
+        smnds[i] = rbufs[j];
+        off += szs[i];
+        j++;
       }
+      exchange_bytes(p-1, peers, NULL, NULL, rbufs, rsz, cm);
+      CSR_Matrix out(smnds, p);
+      cdealloc(cA);
+      cdealloc(rcv_buf);
+      cdealloc(smnds);
+      cdealloc(peers);
+      cdealloc(rbufs);
+      cdealloc(rsz);
+      cdealloc(szs);
+      TAU_FSTOP(csr_gather);
+      return out.all_data;
     } else {
-      MPI_Comm_free(&scm);
-      MPI_Comm_free(&rcm);
-      TAU_FSTOP(csr_reduce);
+      MPI_Gather(&sz, 1, MPI_INT64_T, NULL, 1, MPI_INT64_T, root, cm);
+      exchange_bytes(1, &root, &cA, &sz, NULL, NULL, cm);
+      cdealloc(cA);
+      TAU_FSTOP(csr_gather);
       return NULL;
     }
   }
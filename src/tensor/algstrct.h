@@ -82,6 +82,9 @@ namespace CTF_int {
       /** \brief identity element for multiplication i.e. 1 */
       virtual char const * mulid() const;
 
+      /** \brief returns whether other has the same elements, identities and operators as this algebraic structure */
+      virtual bool has_same_ops(algstrct const * other) const;
+
       /** \brief b = -a */
       virtual void addinv(char const * a, char * b) const;
       
@@ -154,6 +157,16 @@ namespace CTF_int {
                         char       * Y,
                         int          incY)  const;
 
+      /** \brief C["i"]+=alpha*A["i"]*B["i"], where alpha may be NULL (multiplicative identity) and the strides may be zero */
+      virtual void hadamard(int          n,
+                            char const * alpha,
+                            char const * A,
+                            int          incA,
+                            char const * B,
+                            int          incB,
+                            char       * C,
+                            int          incC)  const;
+
       /** \brief beta*C["ij"]=alpha*A^tA["ik"]*B^tB["kj"]; */
       virtual void gemm(char         tA,
                         char         tB,
@@ -166,6 +179,19 @@ namespace CTF_int {
                         char const * beta,
                         char *       C)  const;
 
+      /** \brief beta*C[i]["ij"]=alpha*A[i]^tA["ik"]*B[i]^tB["kj"] for 0<=i<l, by default one gemm() call per i */
+      virtual void gemm_batch(char                 tA,
+                              char                 tB,
+                              int                  l,
+                              int                  m,
+                              int                  n,
+                              int                  k,
+                              char const *         alpha,
+                              char const * const * A,
+                              char const * const * B,
+                              char const *         beta,
+                              char * const *       C)  const;
+
       virtual void offload_gemm(char         tA,
                                 char         tB,
                                 int          m,
@@ -251,8 +277,24 @@ namespace CTF_int {
       /** \brief adds CSR matrices A (stored in cA) and B (stored in cB) to create matric C (pointer to all_data returned), C data allocated internally */
       virtual char * csr_add(char * cA, char * cB) const;
 
-      /** \brief reduces CSR matrices stored in cA on each processor in cm and returns result on processor root */
+      /** \brief reduces CSR matrices stored in cA on each processor in cm and returns result on processor root (NULL elsewhere) */
       virtual char * csr_reduce(char * cA, int root, MPI_Comm cm) const;
+
+      /**
+       * \brief reduces CSR matrices stored in cA on each processor in cm, leaving the rows i with i%p == rank of the
+       *        result on each processor (the parts CSR_Matrix::partition(p,...) gives), by recursive halving (one level
+       *        per prime factor of p) with point-to-point messages within cm, returns cA if cm has one processor
+       */
+      virtual char * csr_reduce_scatter(char * cA, MPI_Comm cm) const;
+
+      /** \brief reduces CSR matrices stored in cA on each processor in cm and returns the result on every processor */
+      virtual char * csr_allreduce(char * cA, MPI_Comm cm) const;
+
+      /**
+       * \brief gathers onto processor root the parts left by csr_reduce_scatter on the processors of cm and merges them,
+       *        deallocates cA and returns NULL on the other processors, returns cA if cm has one processor
+       */
+      virtual char * csr_gather(char * cA, int root, MPI_Comm cm) const;
     
       /** estimate time in seconds necessary for CSR reduction with input of size msg_sz */
       double estimate_csr_red_time(int64_t msg_sz, CommData const * cdt) const;
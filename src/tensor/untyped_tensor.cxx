@@ -14,18 +14,13 @@
 #include "../redistribution/cyclic_reshuffle.h"
 #include "../redistribution/glb_cyclic_reshuffle.h"
 #include "../redistribution/dgtog_redist.h"
+#include "../redistribution/sparse_reshuffle.h"
 
 
 using namespace CTF;
 
 namespace CTF_int {
 
-  LinModel<3> spredist_mdl(spredist_mdl_init,"spredist_mdl");
-  double spredist_est_time(int64_t size, int np){
-    double ps[] = {1.0, (double)log2(np), (double)size*log2(np)};
-    return spredist_mdl.est_time(ps);
-  }
-
 //  static const char * SY_strings[4] = {"NS", "SY", "AS", "SH"};
 
   Idx_Tensor tensor::operator[](const char * idx_map_){
@@ -35,6 +30,21 @@ namespace CTF_int {
 
   tensor::tensor(){
     order=-1;
+    is_write_buffered=false;
+    nwrite_buffered=0;
+    page_file=MPI_FILE_NULL;
+    page_file_name=NULL;
+  }
+
+  /**
+   * \brief closes and deletes the file of a paged out tensor
+   */
+  static void delete_page_file(MPI_File & file, char *& file_name){
+    MPI_File_close(&file);
+    MPI_File_delete(file_name, MPI_INFO_NULL);
+    cdealloc(file_name);
+    file = MPI_FILE_NULL;
+    file_name = NULL;
   }
 
   void tensor::free_self(){
@@ -61,6 +71,12 @@ namespace CTF_int {
         if (has_home && !is_home) cdealloc(home_buffer);
       }
       if (is_sparse) cdealloc(nnz_blk);
+      for (int i=0; i<(int)write_runs.size(); i++){
+        cdealloc(write_runs[i]);
+      }
+      write_runs.clear();
+      write_run_len.clear();
+      if (page_file != MPI_FILE_NULL) delete_page_file(page_file, page_file_name);
       order = -1;
       delete sr;
       cdealloc(name);
@@ -151,6 +167,7 @@ namespace CTF_int {
     if (other->wrld->rank == 0) {
       DPRINTF(2,"Repacking tensor %s into %s\n",other->name,nname);
     }
+    other->flush_writes();
 
     bool has_chng=false, less_sym=false, more_sym=false;
     for (int i=0; i<other->order; i++){
@@ -196,11 +213,13 @@ namespace CTF_int {
 
 
 
-  void tensor::copy_tensor_data(tensor const * other){
+  void tensor::copy_tensor_data(tensor const * other, char const * keep){
     //FIXME: do not unfold
 //      if (other->is_folded) other->unfold();
     ASSERT(!other->is_folded);
     ASSERT(other->is_mapped);
+    //merging buffered writes does not change the values of other
+    const_cast<tensor*>(other)->flush_writes();
 
     if (other->is_mapped && !other->is_sparse){
   #ifdef HOME_CONTRACT
@@ -237,18 +256,40 @@ namespace CTF_int {
       memcpy(this->data, other->data, sr->el_size*other->size);
     } else {
       ASSERT(this->is_sparse);
-      has_home = other->has_home;
+      //the home buffer of a sparse tensor away from home belongs to it, so the copy has no home
+      has_home = other->has_home && other->is_home;
       is_home = other->is_home;
-      this->home_buffer = other->home_buffer;
+      this->home_buffer = other->is_home ? other->home_buffer : NULL;
       if (data!=NULL)    CTF_int::cdealloc(this->data);
       if (nnz_blk!=NULL) CTF_int::cdealloc(this->nnz_blk);
-      CTF_int::alloc_ptr(other->nnz_loc*(sizeof(int64_t)+sr->el_size), 
-                       (void**)&this->data);
       CTF_int::alloc_ptr(other->calc_nvirt()*sizeof(int64_t), (void**)&this->nnz_blk);
-      memcpy(this->nnz_blk, other->nnz_blk, other->calc_nvirt()*sizeof(int64_t));
-      this->set_new_nnz_glb(other->nnz_blk);
-      memcpy(this->data, other->data, 
-             (sizeof(int64_t)+sr->el_size)*other->nnz_loc);
+      if (keep == NULL){
+        CTF_int::alloc_ptr(other->nnz_loc*(sizeof(int64_t)+sr->el_size), 
+                         (void**)&this->data);
+        memcpy(this->nnz_blk, other->nnz_blk, other->calc_nvirt()*sizeof(int64_t));
+        this->set_new_nnz_glb(other->nnz_blk);
+        memcpy(this->data, other->data, 
+               (sizeof(int64_t)+sr->el_size)*other->nnz_loc);
+      } else {
+        //copy only the selected pairs, which stay grouped by virtual block
+        int64_t psz = sr->pair_size();
+        int64_t nkeep = 0;
+        for (int64_t i=0; i<other->nnz_loc; i++){
+          if (keep[i]) nkeep++;
+        }
+        CTF_int::alloc_ptr(nkeep*psz, (void**)&this->data);
+        int64_t i = 0, j = 0;
+        for (int64_t v=0; v<other->calc_nvirt(); v++){
+          this->nnz_blk[v] = 0;
+          for (int64_t b=0; b<other->nnz_blk[v]; b++, i++){
+            if (keep[i]){
+              memcpy(this->data+psz*j, other->data+psz*i, psz);
+              this->nnz_blk[v]++;
+              j++;
+            }
+          }
+        }
+      }
     } 
     if (this->is_folded){
       delete this->rec_tsr;
@@ -274,8 +315,11 @@ namespace CTF_int {
     if (other->is_mapped)
       copy_mapping(other->order, other->edge_map, this->edge_map);
     this->size = other->size;
-    this->nnz_loc = other->nnz_loc;
-    this->nnz_tot = other->nnz_tot;
+    if (keep == NULL){
+      this->nnz_loc = other->nnz_loc;
+      this->nnz_tot = other->nnz_tot;
+    } else
+      this->set_new_nnz_glb(this->nnz_blk);
     //this->nnz_loc_max = other->nnz_loc_max;
 #if DEBUG>= 1
     if (wrld->rank == 0){
@@ -311,6 +355,7 @@ namespace CTF_int {
     this->is_data_aliased   = 0;
     this->has_zero_edge_len = 0;
     this->is_home           = 0;
+    this->is_home_acc       = 0;
     this->has_home          = 0;
     this->profile           = profile_;
     this->is_sparse         = is_sparse_;
@@ -318,6 +363,10 @@ namespace CTF_int {
     this->nnz_loc           = 0;
     this->nnz_tot           = 0;
     this->nnz_blk           = NULL;
+    this->is_write_buffered = false;
+    this->nwrite_buffered   = 0;
+    this->page_file         = MPI_FILE_NULL;
+    this->page_file_name    = NULL;
     this->is_csr            = false;
     this->nrow_idx          = -1;
 //    this->nnz_loc_max       = 0;
@@ -475,6 +524,8 @@ namespace CTF_int {
   }
 
   int tensor::set(char const * val) {
+    //the data of a paged out tensor is dropped rather than read back in
+    if (page_file != MPI_FILE_NULL) set_zero();
     sr->set(this->data, val, this->size);
     return zero_out_padding();
   }
@@ -487,10 +538,17 @@ namespace CTF_int {
 //    int64_t nvirt, bnvirt;
     int64_t memuse, bmemuse;
 
+    if (page_file != MPI_FILE_NULL) delete_page_file(page_file, page_file_name);
     if (this->is_mapped){
       if (is_sparse){
         cdealloc(this->data);
         this->data = NULL;
+        for (int i=0; i<(int)write_runs.size(); i++){
+          cdealloc(write_runs[i]);
+        }
+        write_runs.clear();
+        write_run_len.clear();
+        nwrite_buffered = 0;
 //        this->size = 0;
         memset(this->nnz_blk, 0, sizeof(int64_t)*calc_nvirt());
         this->set_new_nnz_glb(this->nnz_blk); 
@@ -638,26 +696,7 @@ namespace CTF_int {
       }
       printf("\n");*/
       char tname[200];
-      tname[0] = '\0';
-      sprintf(tname, "%s[", name);
-      for (int dim=0; dim<order; dim++){
-        if (dim>0)
-          sprintf(tname+strlen(tname), ",");
-        int tp = edge_map[dim].calc_phase();
-        int pp = edge_map[dim].calc_phys_phase();
-        int vp = tp/pp;
-        if (tp==1) sprintf(tname+strlen(tname),"1");
-        else {
-          if (pp > 1){
-            sprintf(tname+strlen(tname),"p%d(%d)",edge_map[dim].np,edge_map[dim].cdt);
-            if (edge_map[dim].has_child && edge_map[dim].child->type == PHYSICAL_MAP) 
-              sprintf(tname+strlen(tname),"p%d(%d)",edge_map[dim].child->np,edge_map[dim].child->cdt);
-          }
-          if (vp > 1) sprintf(tname+strlen(tname),"v%d",vp);
-        }
-//        sprintf(tname+strlen(tname),"c%d",edge_map[dim].has_child);
-      }
-      sprintf(tname+strlen(tname), "]");
+      get_map_str(tname, 200);
       printf("CTF: Tensor mapping is %s\n",tname);
 /*      printf("\nCTF: sym  len  tphs  pphs  vphs\n");
       for (int dim=0; dim<order; dim++){
@@ -669,6 +708,30 @@ namespace CTF_int {
     }
   }
    
+  void tensor::get_map_str(char * str, int max_len) const {
+    int len = snprintf(str, max_len, "%s[", name);
+    for (int dim=0; dim<order; dim++){
+      if (len >= max_len) break;
+      if (dim>0)
+        len += snprintf(str+len, max_len-len, ",");
+      int tp = edge_map[dim].calc_phase();
+      int pp = edge_map[dim].calc_phys_phase();
+      int vp = tp/pp;
+      if (len >= max_len) break;
+      if (tp==1) len += snprintf(str+len, max_len-len, "1");
+      else {
+        if (pp > 1){
+          len += snprintf(str+len, max_len-len, "p%d(%d)",edge_map[dim].np,edge_map[dim].cdt);
+          if (len < max_len && edge_map[dim].has_child && edge_map[dim].child->type == PHYSICAL_MAP) 
+            len += snprintf(str+len, max_len-len, "p%d(%d)",edge_map[dim].child->np,edge_map[dim].child->cdt);
+        }
+        if (len < max_len && vp > 1) len += snprintf(str+len, max_len-len, "v%d",vp);
+      }
+    }
+    if (len < max_len)
+      snprintf(str+len, max_len-len, "]");
+  }
+
   void tensor::set_name(char const * name_){
     cdealloc(name);
     this->name = (char*)alloc(strlen(name_)+1);
@@ -697,6 +760,8 @@ namespace CTF_int {
                       char const *  alpha,
                       int * const * permutation_B,
                       char const *  beta){
+    flush_writes();
+    A->flush_writes();
     int64_t sz_A, blk_sz_A, sz_B, blk_sz_B;
     char * all_data_A;
     char * all_data_B;
@@ -840,6 +905,8 @@ namespace CTF_int {
                      int const *  offsets_A,
                      int const *  ends_A,
                      char const * alpha){
+    flush_writes();
+    A->flush_writes();
       
     int64_t i, sz_A, blk_sz_A, sz_B, blk_sz_B;
     char * all_data_A, * blk_data_A;
@@ -940,6 +1007,8 @@ namespace CTF_int {
   void tensor::add_to_subworld(tensor *     tsr_sub,
                                char const * alpha,
                                char const * beta){
+    flush_writes();
+    if (tsr_sub != NULL) tsr_sub->flush_writes();
   #ifdef USE_SLICE_FOR_SUBWORLD
     int offsets[this->order];
     memset(offsets, 0, this->order*sizeof(int));
@@ -986,6 +1055,8 @@ namespace CTF_int {
   void tensor::add_from_subworld(tensor *     tsr_sub,
                                  char const * alpha,
                                  char const * beta){
+    flush_writes();
+    if (tsr_sub != NULL) tsr_sub->flush_writes();
   #ifdef USE_SLICE_FOR_SUBWORLD
     int offsets[this->order];
     memset(offsets, 0, this->order*sizeof(int));
@@ -1013,11 +1084,254 @@ namespace CTF_int {
 
   }
 
+  /**
+   * \brief sorts pairs by key and adds up the values of pairs with the same key
+   * \param[in] sr algebraic structure of the values
+   * \param[in] n number of pairs
+   * \param[in,out] prs pairs, of which the first (returned number) are the combined ones
+   * \return number of distinct keys
+   */
+  static int64_t combine_pairs(algstrct const * sr, int64_t n, char * prs){
+    if (n == 0) return 0;
+    PairIterator pi(sr, prs);
+    pi.sort(n);
+    int64_t m = 0;
+    for (int64_t i=1; i<n; i++){
+      if (pi[i].k() == pi[m].k())
+        sr->add(pi[m].d(), pi[i].d(), pi[m].d());
+      else {
+        m++;
+        if (m != i) memcpy(pi[m].ptr, pi[i].ptr, sr->pair_size());
+      }
+    }
+    return m+1;
+  }
+
+  /**
+   * \brief merges the last two of a sequence of runs of pairs sorted by key without repeated keys,
+   *        adding up the values of pairs with the same key
+   * \param[in] sr algebraic structure of the values
+   * \param[in,out] runs pairs of each run
+   * \param[in,out] run_len number of pairs in each run
+   */
+  static void merge_last_runs(algstrct const *       sr,
+                              std::vector<char*> &   runs,
+                              std::vector<int64_t> & run_len){
+    int r = runs.size()-1;
+    int64_t n_old = run_len[r-1];
+    int64_t n_new = run_len[r];
+    ConstPairIterator po(sr, runs[r-1]);
+    ConstPairIterator pn(sr, runs[r]);
+    char * prs = (char*)alloc(sr->pair_size()*(n_old+n_new));
+    PairIterator pm(sr, prs);
+    int64_t n = 0;
+    for (int64_t o=0, w=0; o<n_old || w<n_new; n++){
+      if (w == n_new || (o < n_old && po[o].k() < pn[w].k())){
+        memcpy(pm[n].ptr, po[o].ptr, sr->pair_size());
+        o++;
+      } else {
+        memcpy(pm[n].ptr, pn[w].ptr, sr->pair_size());
+        if (o < n_old && po[o].k() == pn[w].k()){
+          sr->add(po[o].d(), pn[w].d(), pm[n].d());
+          o++;
+        }
+        w++;
+      }
+    }
+    cdealloc(runs[r-1]);
+    cdealloc(runs[r]);
+    runs.pop_back();
+    run_len.pop_back();
+    runs[r-1] = prs;
+    run_len[r-1] = n;
+  }
+
+  void tensor::set_write_buffering(bool buffer){
+    if (!buffer) flush_writes();
+    is_write_buffered = buffer;
+  }
+
+  void tensor::flush_writes(){
+    page_in();
+    if (nwrite_buffered == 0) return;
+    TAU_FSTART(flush_writes);
+    while (write_runs.size() > 1){
+      merge_last_runs(sr, write_runs, write_run_len);
+    }
+    int64_t num_pair = 0;
+    char * pairs = NULL;
+    if (write_runs.size() == 1){
+      num_pair = write_run_len[0];
+      pairs = write_runs[0];
+    }
+    write_runs.clear();
+    write_run_len.clear();
+    nwrite_buffered = 0;
+    bool buffer = is_write_buffered;
+    is_write_buffered = false;
+    write(num_pair, sr->mulid(), sr->mulid(), pairs);
+    is_write_buffered = buffer;
+    if (pairs != NULL) cdealloc(pairs);
+    TAU_FSTOP(flush_writes);
+  }
+
+  void tensor::get_page_range(int64_t * my_st, int64_t * my_n) const {
+    int64_t tot_els = packed_size(order, lens, sym);
+    int64_t chnk_sz = tot_els/wrld->np;
+    *my_n = chnk_sz;
+    if (wrld->rank < tot_els%wrld->np) (*my_n)++;
+    *my_st = chnk_sz*wrld->rank + std::min((int64_t)wrld->rank, tot_els%wrld->np);
+  }
+
+  /**
+   * \brief number of chunks in which page_out() and page_in() move the my_n elements of each processor, the
+   *        same on all processors, so that the pairs of a chunk take at most a quarter of the memory available
+   *        (but are allowed at least a megabyte) and their bytes fit in an MPI count
+   */
+  static int64_t get_page_nchnk(tensor const * T, int64_t my_n){
+    int64_t avail = proc_bytes_available();
+    if (T->wrld->mem_budget > 0) avail = std::min(avail, T->wrld->mem_budget);
+    int64_t chnk_bytes = std::min((int64_t)INT_MAX, std::max(avail/4, (int64_t)1<<20));
+    int64_t nchnk = std::max((int64_t)1, (my_n*T->sr->pair_size()+chnk_bytes-1)/chnk_bytes);
+    MPI_Allreduce(MPI_IN_PLACE, &nchnk, 1, MPI_INT64_T, MPI_MAX, T->wrld->comm);
+    return nchnk;
+  }
+
+  void tensor::page_out(char const * path){
+    if (page_file != MPI_FILE_NULL) return;
+    flush_writes();
+    bool is_nonsym = true;
+    for (int i=0; i<order; i++){
+      if (sym[i] != NS) is_nonsym = false;
+    }
+    if (is_sparse || !is_nonsym || is_data_aliased){
+      if (wrld->rank == 0)
+        printf("CTF ERROR: only dense nonsymmetric tensors that own their data can be paged out, tensor %s cannot\n", name);
+      IASSERT(0);
+      return;
+    }
+    TAU_FSTART(page_out);
+    char * file_name = (char*)alloc(strlen(path)+16);
+    sprintf(file_name, "%s.%d", path, wrld->rank);
+    MPI_File file;
+    if (MPI_File_open(MPI_COMM_SELF, file_name, MPI_MODE_RDWR | MPI_MODE_CREATE, MPI_INFO_NULL, &file) != MPI_SUCCESS){
+      printf("CTF ERROR: could not open file %s to page out tensor %s\n", file_name, name);
+      cdealloc(file_name);
+      IASSERT(0);
+      TAU_FSTOP(page_out);
+      return;
+    }
+    if (!is_mapped) set_zero();
+    if (is_folded) unfold();
+    int64_t my_st, my_n;
+    get_page_range(&my_st, &my_n);
+    MPI_File_set_size(file, my_n*sr->el_size);
+    int64_t nchnk = get_page_nchnk(this, my_n);
+    char * pairs = (char*)alloc(sr->pair_size()*std::max((int64_t)1, (my_n+nchnk-1)/nchnk));
+    PairIterator pi(sr, pairs);
+    for (int64_t c=0; c<nchnk; c++){
+      int64_t st = (my_n*c)/nchnk;
+      int64_t n = (my_n*(c+1))/nchnk - st;
+      for (int64_t i=0; i<n; i++){
+        pi[i].write_key(my_st+st+i);
+      }
+      this->read(n, pairs);
+      for (int64_t i=0; i<n; i++){
+        char val[sr->el_size];
+        pi[i].read_val(val);
+        memcpy(pairs+i*sr->el_size, val, sr->el_size);
+      }
+      MPI_Status stat;
+      MPI_File_write_at(file, st*sr->el_size, pairs, n*sr->el_size, MPI_CHAR, &stat);
+    }
+    cdealloc(pairs);
+
+    //free the data and the mapping, which set_zero() redoes when the tensor is paged in
+    deregister_size();
+    if (is_home){
+      cdealloc(home_buffer);
+    } else {
+      if (data != NULL) cdealloc(data);
+      if (has_home) cdealloc(home_buffer);
+    }
+    data = NULL;
+    home_buffer = NULL;
+    is_home = 0;
+    has_home = 0;
+    size = 0;
+    clear_mapping();
+    page_file = file;
+    page_file_name = file_name;
+    TAU_FSTOP(page_out);
+  }
+
+  void tensor::page_in(){
+    if (page_file == MPI_FILE_NULL) return;
+    TAU_FSTART(page_in);
+    MPI_File file = page_file;
+    char * file_name = page_file_name;
+    page_file = MPI_FILE_NULL;
+    page_file_name = NULL;
+    set_zero();
+    int64_t my_st, my_n;
+    get_page_range(&my_st, &my_n);
+    int64_t nchnk = get_page_nchnk(this, my_n);
+    char * pairs = (char*)alloc(sr->pair_size()*std::max((int64_t)1, (my_n+nchnk-1)/nchnk));
+    PairIterator pi(sr, pairs);
+    for (int64_t c=0; c<nchnk; c++){
+      int64_t st = (my_n*c)/nchnk;
+      int64_t n = (my_n*(c+1))/nchnk - st;
+      //use latter part of buffer for the pure dense data, so that we do not need another buffer when forming pairs
+      char * pairs_tail = pairs + sizeof(int64_t)*n;
+      MPI_Status stat;
+      MPI_File_read_at(file, st*sr->el_size, pairs_tail, n*sr->el_size, MPI_CHAR, &stat);
+      for (int64_t i=0; i<n; i++){
+        char val[sr->el_size];
+        memcpy(val, pairs_tail+i*sr->el_size, sr->el_size);
+        pi[i].write_key(my_st+st+i);
+        pi[i].write_val(val);
+      }
+      this->write(n, sr->mulid(), sr->addid(), pairs);
+    }
+    cdealloc(pairs);
+    delete_page_file(file, file_name);
+    TAU_FSTOP(page_in);
+  }
+
   int tensor::write(int64_t      num_pair,
                     char const * alpha,
                     char const * beta,
                     char *       mapped_data,
                     char const   rw){
+    //writes that add to existing values are kept locally as sorted runs, which are merged whenever the
+    //last is at least half as large as the one before, so that there are logarithmically many runs and
+    //each pair is merged logarithmically many times before the runs are written at once, writes that
+    //replace values cannot be buffered, as which of them comes last is not known locally
+    if (rw == 'w' && is_write_buffered && is_sparse && sr->isequal(beta, sr->mulid())){
+      nwrite_buffered++;
+      //nnz_tot keeps the count before the buffered writes, as they are merged only when the tensor is flushed
+      if (num_pair > 0){
+        TAU_FSTART(buffer_write);
+        char * run = (char*)alloc(sr->pair_size()*num_pair);
+        memcpy(run, mapped_data, sr->pair_size()*num_pair);
+        if (alpha != NULL && !sr->isequal(alpha, sr->mulid())){
+          PairIterator pr(sr, run);
+          for (int64_t i=0; i<num_pair; i++){
+            sr->mul(pr[i].d(), alpha, pr[i].d());
+          }
+        }
+        write_runs.push_back(run);
+        write_run_len.push_back(combine_pairs(sr, num_pair, run));
+        while (write_runs.size() > 1 &&
+               2*write_run_len[write_runs.size()-1] >= write_run_len[write_runs.size()-2]){
+          merge_last_runs(sr, write_runs, write_run_len);
+        }
+        TAU_FSTOP(buffer_write);
+      }
+      return SUCCESS;
+    }
+    flush_writes();
+
     int i, num_virt;
     int * phase, * phys_phase, * virt_phase, * bucket_lda;
     int * virt_phys_rank;
@@ -1134,6 +1448,143 @@ namespace CTF_int {
     return SUCCESS;
   }
 
+  int tensor::write_range(int64_t      offset,
+                          int64_t      n,
+                          char const * range_data){
+    int64_t np = wrld->np;
+    bool is_nonsym = true;
+    for (int i=0; i<order; i++){
+      if (sym[i] != NS) is_nonsym = false;
+    }
+    if (is_sparse || !is_nonsym || !is_mapped){
+      char * pairs = (char*)alloc(sr->pair_size()*std::max(n,(int64_t)1));
+      PairIterator pp(sr, pairs);
+      for (int64_t i=0; i<n; i++){
+        pp[i].write_key(offset+i);
+        pp[i].write_val(range_data+i*sr->el_size);
+      }
+      int ret = write(n, sr->mulid(), sr->addid(), pairs);
+      cdealloc(pairs);
+      return ret;
+    }
+    if (has_zero_edge_len) return SUCCESS;
+    TAU_FSTART(write_range);
+    unfold();
+    set_padding();
+
+    int phase[order], phys_phase[order], phys_rank[order], bucket_lda[order];
+    int64_t lda[order];
+    int nvirt = 1;
+    int idx_lyr = wrld->rank;
+    for (int i=0; i<order; i++){
+      phase[i]      = edge_map[i].calc_phase();
+      phys_phase[i] = edge_map[i].calc_phys_phase();
+      phys_rank[i]  = edge_map[i].calc_phys_rank(topo);
+      nvirt        *= phase[i]/phys_phase[i];
+      lda[i]        = i == 0 ? 1 : lda[i-1]*lens[i-1];
+      if (edge_map[i].type == PHYSICAL_MAP){
+        bucket_lda[i] = topo->lda[edge_map[i].cdt];
+        idx_lyr -= bucket_lda[i]*phys_rank[i];
+      } else
+        bucket_lda[i] = 0;
+    }
+
+    //every process needs the ranges of all others to place the values it receives without keys
+    int64_t my_range[2] = {offset, n};
+    int64_t * ranges = (int64_t*)alloc(sizeof(int64_t)*2*np);
+    MPI_Allgather(my_range, 2, MPI_INT64_T, ranges, 2, MPI_INT64_T, wrld->comm);
+
+    //values go to their owners on the first layer in order of global index, as write() does
+    int64_t * send_counts = (int64_t*)alloc(sizeof(int64_t)*np);
+    int64_t * send_displs = (int64_t*)alloc(sizeof(int64_t)*np);
+    int64_t * recv_counts = (int64_t*)alloc(sizeof(int64_t)*np);
+    int64_t * recv_displs = (int64_t*)alloc(sizeof(int64_t)*np);
+    int * owners = (int*)alloc(sizeof(int)*std::max(n,(int64_t)1));
+    std::fill(send_counts, send_counts+np, 0);
+    for (int64_t i=0; i<n; i++){
+      int64_t k = offset+i;
+      int owner = 0;
+      for (int j=0; j<order; j++){
+        owner += ((k%lens[j])%phys_phase[j])*bucket_lda[j];
+        k /= lens[j];
+      }
+      owners[i] = owner;
+      send_counts[owner]++;
+    }
+    MPI_Alltoall(send_counts, 1, MPI_INT64_T, recv_counts, 1, MPI_INT64_T, wrld->comm);
+    send_displs[0] = 0;
+    recv_displs[0] = 0;
+    for (int64_t p=1; p<np; p++){
+      send_displs[p] = send_displs[p-1]+send_counts[p-1];
+      recv_displs[p] = recv_displs[p-1]+recv_counts[p-1];
+    }
+    char * send_buf = (char*)alloc(sr->el_size*std::max(n,(int64_t)1));
+    std::fill(send_counts, send_counts+np, 0);
+    for (int64_t i=0; i<n; i++){
+      memcpy(send_buf+(send_displs[owners[i]]+send_counts[owners[i]])*sr->el_size, range_data+i*sr->el_size, sr->el_size);
+      send_counts[owners[i]]++;
+    }
+    cdealloc(owners);
+    int64_t nrecv = recv_displs[np-1]+recv_counts[np-1];
+    char * recv_buf = (char*)alloc(sr->el_size*std::max(nrecv,(int64_t)1));
+    wrld->cdt.all_to_allv(send_buf, send_counts, send_displs, sr->el_size, recv_buf, recv_counts, recv_displs);
+    cdealloc(send_buf);
+
+    if (idx_lyr == 0 && nrecv > 0){
+      //the global indices of the local data that are in some range, in increasing order, are those
+      //received from the process with the lowest range first, each in the order it sent them
+      std::vector< std::pair<int64_t,int64_t> > gidx;
+      gidx.reserve(nrecv);
+      int64_t blk_sz = size/nvirt;
+      int virt_rank[order];
+      std::fill(virt_rank, virt_rank+order, 0);
+      for (int64_t b=0; b<nvirt; b++){
+        int64_t vb = b;
+        for (int j=0; j<order; j++){
+          virt_rank[j] = vb%(phase[j]/phys_phase[j]);
+          vb /= phase[j]/phys_phase[j];
+        }
+        for (int64_t e=0; e<blk_sz; e++){
+          int64_t r = e;
+          int64_t g = 0;
+          bool is_pad = false;
+          for (int j=0; j<order; j++){
+            int64_t ext = pad_edge_len[j]/phase[j];
+            int64_t c = (r%ext)*phase[j]+virt_rank[j]*phys_phase[j]+phys_rank[j];
+            r /= ext;
+            if (c >= lens[j]) is_pad = true;
+            g += c*lda[j];
+          }
+          if (!is_pad) gidx.push_back(std::pair<int64_t,int64_t>(g, b*blk_sz+e));
+        }
+      }
+      std::sort(gidx.begin(), gidx.end());
+      std::vector<int> srcs;
+      for (int p=0; p<np; p++){
+        if (recv_counts[p] > 0) srcs.push_back(p);
+      }
+      std::sort(srcs.begin(), srcs.end(), [&](int a, int b){ return ranges[2*a] < ranges[2*b]; });
+      std::fill(recv_counts, recv_counts+np, 0);
+      int is = 0;
+      for (int64_t i=0; i<(int64_t)gidx.size() && is<(int)srcs.size(); i++){
+        int64_t g = gidx[i].first;
+        while (is<(int)srcs.size() && g >= ranges[2*srcs[is]]+ranges[2*srcs[is]+1]) is++;
+        if (is == (int)srcs.size() || g < ranges[2*srcs[is]]) continue;
+        int p = srcs[is];
+        memcpy(data+gidx[i].second*sr->el_size, recv_buf+(recv_displs[p]+recv_counts[p])*sr->el_size, sr->el_size);
+        recv_counts[p]++;
+      }
+    }
+    cdealloc(recv_buf);
+    cdealloc(send_counts);
+    cdealloc(send_displs);
+    cdealloc(recv_counts);
+    cdealloc(recv_displs);
+    cdealloc(ranges);
+    TAU_FSTOP(write_range);
+    return SUCCESS;
+  }
+
   int tensor::read(int64_t      num_pair,
                    char const * alpha,
                    char const * beta,
@@ -1215,6 +1666,7 @@ namespace CTF_int {
                       Idx_Partition const & prl,
                       Idx_Partition const & blk,
                       bool                  unpack){
+    flush_writes();
     if (unpack){
       for (int i=0; i<order; i++){
         if (sym[i] != NS){
@@ -1267,6 +1719,7 @@ namespace CTF_int {
   }
 
   int tensor::sparsify(std::function<bool(char const*)> f){
+    flush_writes();
     if (is_sparse){
       TAU_FSTART(sparsify);
       int64_t nnz_loc_new = 0;
@@ -1411,8 +1864,185 @@ namespace CTF_int {
     return SUCCESS;
   }
 
+  /**
+   * \brief computes the index of key k (with respect to lens) restricted to dims
+   */
+  static int64_t mask_key(int64_t k, int order, int const * lens, int nshr, int const * dims, int64_t const * lda){
+    int64_t idx[order];
+    for (int i=0; i<order; i++){
+      idx[i] = k%lens[i];
+      k = k/lens[i];
+    }
+    int64_t mk = 0;
+    for (int s=0; s<nshr; s++){
+      mk += idx[dims[s]]*lda[s];
+    }
+    return mk;
+  }
+
+  void tensor::select_masked(int const *         idx_map,
+                             tensor *            M,
+                             int const *         idx_map_M,
+                             bool                complement,
+                             std::vector<char> & keep) const {
+    ASSERT(is_sparse);
+    ASSERT(nwrite_buffered == 0);
+    M->flush_writes();
+    int np = wrld->np;
+    int nshr = 0;
+    int shr_dim[M->order], shr_dim_M[M->order];
+    int64_t lda[M->order];
+    for (int j=0; j<M->order; j++){
+      for (int i=0; i<order; i++){
+        if (idx_map[i] == idx_map_M[j]){
+          ASSERT(lens[i] == M->lens[j]);
+          lda[nshr] = nshr == 0 ? 1 : lda[nshr-1]*M->lens[shr_dim_M[nshr-1]];
+          shr_dim[nshr] = i;
+          shr_dim_M[nshr] = j;
+          nshr++;
+          break;
+        }
+      }
+    }
+    //keys of nonzeros of M restricted to the shared indices, without duplicates
+    int64_t nM;
+    char * prs_M;
+    M->read_local_nnz(&nM, &prs_M);
+    ConstPairIterator pi_M(M->sr, prs_M);
+    std::vector<int64_t> mkeys(nM);
+    for (int64_t i=0; i<nM; i++){
+      mkeys[i] = mask_key(pi_M[i].k(), M->order, M->lens, nshr, shr_dim_M, lda);
+    }
+    if (prs_M != NULL) cdealloc(prs_M);
+    std::sort(mkeys.begin(), mkeys.end());
+    mkeys.erase(std::unique(mkeys.begin(), mkeys.end()), mkeys.end());
+
+    ConstPairIterator pi(sr, data);
+    std::vector<int64_t> xkeys(nnz_loc);
+    for (int64_t i=0; i<nnz_loc; i++){
+      xkeys[i] = mask_key(pi[i].k(), order, lens, nshr, shr_dim, lda);
+    }
+    keep.resize(nnz_loc);
+
+    int64_t nmk_loc = mkeys.size();
+    int64_t nmk_glb;
+    MPI_Allreduce(&nmk_loc, &nmk_glb, 1, MPI_INT64_T, MPI_SUM, wrld->comm);
+    if (nmk_glb <= std::max(nnz_tot/np, (int64_t)1)){
+      //the mask is no larger than the local part of this tensor, so replicate it
+      int cnt = nmk_loc;
+      std::vector<int> cnts(np), displs(np);
+      MPI_Allgather(&cnt, 1, MPI_INT, &cnts[0], 1, MPI_INT, wrld->comm);
+      for (int p=0; p<np; p++){
+        displs[p] = p == 0 ? 0 : displs[p-1]+cnts[p-1];
+      }
+      std::vector<int64_t> all_mkeys(std::max(nmk_glb,(int64_t)1));
+      MPI_Allgatherv(mkeys.empty() ? NULL : &mkeys[0], cnt, MPI_INT64_T,
+                     &all_mkeys[0], &cnts[0], &displs[0], MPI_INT64_T, wrld->comm);
+      all_mkeys.resize(nmk_glb);
+      std::sort(all_mkeys.begin(), all_mkeys.end());
+#ifdef USE_OMP
+      #pragma omp parallel for
+#endif
+      for (int64_t i=0; i<nnz_loc; i++){
+        keep[i] = std::binary_search(all_mkeys.begin(), all_mkeys.end(), xkeys[i]) != complement;
+      }
+    } else {
+      //otherwise each key is looked up on the processor that owns it, each distinct key of this tensor is sent once
+      std::vector<int64_t> qkeys(xkeys);
+      std::sort(qkeys.begin(), qkeys.end(), [&](int64_t a, int64_t b){
+        return a%np < b%np || (a%np == b%np && a < b); });
+      qkeys.erase(std::unique(qkeys.begin(), qkeys.end()), qkeys.end());
+      std::sort(mkeys.begin(), mkeys.end(), [&](int64_t a, int64_t b){
+        return a%np < b%np || (a%np == b%np && a < b); });
+      int64_t msend_counts[np], msend_displs[np], mrecv_counts[np], mrecv_displs[np];
+      int64_t qsend_counts[np], qsend_displs[np], qrecv_counts[np], qrecv_displs[np];
+      std::fill(msend_counts, msend_counts+np, 0);
+      std::fill(qsend_counts, qsend_counts+np, 0);
+      for (int64_t i=0; i<(int64_t)mkeys.size(); i++) msend_counts[mkeys[i]%np]++;
+      for (int64_t i=0; i<(int64_t)qkeys.size(); i++) qsend_counts[qkeys[i]%np]++;
+      MPI_Alltoall(msend_counts, 1, MPI_INT64_T, mrecv_counts, 1, MPI_INT64_T, wrld->comm);
+      MPI_Alltoall(qsend_counts, 1, MPI_INT64_T, qrecv_counts, 1, MPI_INT64_T, wrld->comm);
+      for (int p=0; p<np; p++){
+        msend_displs[p] = p == 0 ? 0 : msend_displs[p-1]+msend_counts[p-1];
+        mrecv_displs[p] = p == 0 ? 0 : mrecv_displs[p-1]+mrecv_counts[p-1];
+        qsend_displs[p] = p == 0 ? 0 : qsend_displs[p-1]+qsend_counts[p-1];
+        qrecv_displs[p] = p == 0 ? 0 : qrecv_displs[p-1]+qrecv_counts[p-1];
+      }
+      std::vector<int64_t> own_mkeys(std::max(mrecv_displs[np-1]+mrecv_counts[np-1],(int64_t)1));
+      std::vector<int64_t> own_qkeys(std::max(qrecv_displs[np-1]+qrecv_counts[np-1],(int64_t)1));
+      wrld->cdt.all_to_allv(mkeys.empty() ? NULL : &mkeys[0], msend_counts, msend_displs, sizeof(int64_t),
+                            &own_mkeys[0], mrecv_counts, mrecv_displs);
+      wrld->cdt.all_to_allv(qkeys.empty() ? NULL : &qkeys[0], qsend_counts, qsend_displs, sizeof(int64_t),
+                            &own_qkeys[0], qrecv_counts, qrecv_displs);
+      own_mkeys.resize(mrecv_displs[np-1]+mrecv_counts[np-1]);
+      std::sort(own_mkeys.begin(), own_mkeys.end());
+      int64_t nq = qrecv_displs[np-1]+qrecv_counts[np-1];
+      std::vector<char> own_found(std::max(nq,(int64_t)1));
+      for (int64_t i=0; i<nq; i++){
+        own_found[i] = std::binary_search(own_mkeys.begin(), own_mkeys.end(), own_qkeys[i]);
+      }
+      std::vector<char> found(std::max((int64_t)qkeys.size(),(int64_t)1));
+      wrld->cdt.all_to_allv(&own_found[0], qrecv_counts, qrecv_displs, sizeof(char),
+                            &found[0], qsend_counts, qsend_displs);
+#ifdef USE_OMP
+      #pragma omp parallel for
+#endif
+      for (int64_t i=0; i<nnz_loc; i++){
+        int64_t q = std::lower_bound(qkeys.begin(), qkeys.end(), xkeys[i], [&](int64_t a, int64_t b){
+          return a%np < b%np || (a%np == b%np && a < b); }) - qkeys.begin();
+        keep[i] = found[q] != complement;
+      }
+    }
+  }
+
+  void tensor::apply_mask(int const * idx_map, tensor * M, int const * idx_map_M, bool complement){
+    TAU_FSTART(apply_mask);
+    if (!is_sparse){
+      sparsify();
+      //algebraic structures without an additive identity have no zeros to drop
+      if (!is_sparse) sparsify([](char const *){ return true; });
+    }
+    flush_writes();
+    std::vector<char> keep;
+    select_masked(idx_map, M, idx_map_M, complement, keep);
+
+    //sparsify passes pointers to the values of the current pairs, from which we recover their position
+    char const * old_data = data;
+    int64_t psz = sr->pair_size();
+    sparsify([&](char const * v){ return (bool)keep[(v-old_data)/psz]; });
+    TAU_FSTOP(apply_mask);
+  }
+
+  tensor * tensor::masked_copy(int const * idx_map, tensor * M, int const * idx_map_M, bool complement){
+    if (!is_sparse){
+      tensor * T = new tensor(this, 1, 1);
+      T->apply_mask(idx_map, M, idx_map_M, complement);
+      return T;
+    }
+    TAU_FSTART(masked_copy);
+    flush_writes();
+    std::vector<char> keep;
+    select_masked(idx_map, M, idx_map_M, complement, keep);
+    tensor * T = new tensor(this, 0, 0);
+    T->copy_tensor_data(this, keep.empty() ? NULL : &keep[0]);
+    TAU_FSTOP(masked_copy);
+    return T;
+  }
+
   int tensor::read_local_nnz(int64_t * num_pair,
                              char **   mapped_data) const {
+    if (nwrite_buffered > 0){
+      printf("CTF ERROR: tensor %s has buffered writes, flush_writes() must be called on all processors before reading local data\n", name);
+      *num_pair = 0;
+      *mapped_data = NULL;
+      return ERROR;
+    }
+    if (page_file != MPI_FILE_NULL){
+      printf("CTF ERROR: tensor %s is paged out, page_in() must be called on all processors before reading local data\n", name);
+      *num_pair = 0;
+      *mapped_data = NULL;
+      return ERROR;
+    }
     if (sr->isequal(sr->addid(), NULL) && !is_sparse) 
       return read_local(num_pair,mapped_data);
     tensor tsr_cpy(this);
@@ -1427,6 +2057,18 @@ namespace CTF_int {
 
   int tensor::read_local(int64_t * num_pair,
                          char **   mapped_data) const {
+    if (nwrite_buffered > 0){
+      printf("CTF ERROR: tensor %s has buffered writes, flush_writes() must be called on all processors before reading local data\n", name);
+      *num_pair = 0;
+      *mapped_data = NULL;
+      return ERROR;
+    }
+    if (page_file != MPI_FILE_NULL){
+      printf("CTF ERROR: tensor %s is paged out, page_in() must be called on all processors before reading local data\n", name);
+      *num_pair = 0;
+      *mapped_data = NULL;
+      return ERROR;
+    }
     int i, num_virt, idx_lyr;
     int64_t np;
     int * virt_phase, * virt_phys_rank, * phys_phase, * phase;
@@ -1504,6 +2146,88 @@ namespace CTF_int {
     }
   }
 
+  void tensor::get_local_rows(int64_t * nrow, int64_t ** rows, int64_t * stride) const {
+    ASSERT(!is_sparse);
+    ASSERT(!is_folded);
+    ASSERT(is_mapped);
+    if (order == 0 || has_zero_edge_len){
+      *nrow = (order == 0 && size > 0) ? 1 : 0;
+      *rows = (int64_t*)alloc(sizeof(int64_t)*3);
+      (*rows)[0] = 0;
+      (*rows)[1] = 0;
+      (*rows)[2] = 1;
+      *stride = 1;
+      return;
+    }
+    int phase[order], phys_phase[order], virt_phase[order], phase_rank[order], virt_rank[order], idx[order];
+    int64_t lda[order];
+    int nvirt = 1;
+    for (int i=0; i<order; i++){
+      phase[i]      = edge_map[i].calc_phase();
+      phys_phase[i] = edge_map[i].calc_phys_phase();
+      virt_phase[i] = phase[i]/phys_phase[i];
+      phase_rank[i] = edge_map[i].calc_phys_rank(topo);
+      virt_rank[i]  = 0;
+      nvirt        *= virt_phase[i];
+      lda[i]        = i == 0 ? 1 : lda[i-1]*lens[i-1];
+    }
+    //count rows first, rows of a symmetric first mode have varying lengths
+    int64_t max_nrow = 0;
+    int64_t blk_sz = size/nvirt;
+    int64_t len0 = pad_edge_len[0]/phase[0];
+    max_nrow = nvirt*(len0 > 0 ? (blk_sz+len0-1)/len0 : 0);
+    if (sym[0] != NS) max_nrow = size;
+    int64_t * rws = (int64_t*)alloc(sizeof(int64_t)*3*std::max(max_nrow,(int64_t)1));
+    int64_t nr = 0;
+    for (int64_t p=0;;p++){
+      int64_t buf_offset = p*blk_sz;
+      int64_t idx_offset = 0;
+      for (int i=1; i<order; i++){
+        idx_offset += phase_rank[i]*lda[i];
+      }
+      memset(idx, 0, order*sizeof(int));
+      int64_t imax = len0;
+      for (;;){
+        if (sym[0] != NS)
+          imax = idx[1]+1;
+        rws[3*nr]   = buf_offset;
+        rws[3*nr+1] = idx_offset+phase_rank[0];
+        rws[3*nr+2] = imax;
+        nr++;
+        buf_offset += imax;
+        int act_lda;
+        for (act_lda=1; act_lda<order; act_lda++){
+          idx_offset -= (idx[act_lda]*phase[act_lda]+phase_rank[act_lda])*lda[act_lda];
+          idx[act_lda]++;
+          int act_max = pad_edge_len[act_lda]/phase[act_lda];
+          if (sym[act_lda] != NS) act_max = idx[act_lda+1]+1;
+          if (idx[act_lda] >= act_max)
+            idx[act_lda] = 0;
+          idx_offset += (idx[act_lda]*phase[act_lda]+phase_rank[act_lda])*lda[act_lda];
+          if (idx[act_lda] > 0)
+            break;
+        }
+        if (act_lda >= order) break;
+      }
+      ASSERT(buf_offset == (p+1)*blk_sz);
+      int act_lda;
+      for (act_lda=0; act_lda<order; act_lda++){
+        phase_rank[act_lda] -= virt_rank[act_lda]*phys_phase[act_lda];
+        virt_rank[act_lda]++;
+        if (virt_rank[act_lda] >= virt_phase[act_lda])
+          virt_rank[act_lda] = 0;
+        phase_rank[act_lda] += virt_rank[act_lda]*phys_phase[act_lda];
+        if (virt_rank[act_lda] > 0)
+          break;
+      }
+      if (act_lda >= order) break;
+    }
+    ASSERT(nr <= std::max(max_nrow,(int64_t)1));
+    *nrow = nr;
+    *rows = rws;
+    *stride = phase[0];
+  }
+
   PairIterator tensor::read_all_pairs(int64_t * num_pair, bool unpack){
     int numPes;
     int * nXs;
@@ -1511,6 +2235,7 @@ namespace CTF_int {
     int * pXs;
     char * my_pairs, * all_pairs;
 
+    flush_writes();
     numPes = wrld->np;
     if (has_zero_edge_len){
       *num_pair = 0;
@@ -1535,7 +2260,8 @@ namespace CTF_int {
         tA.leave_home_with_buffer();
         summation st(this, idx_A, sr->mulid(), &tA, idx_A, sr->mulid());
         st.execute();
-        return tA.read_all_pairs(num_pair, false);
+        //the algstrct of tA is freed with it, so rewrap its pairs with ours
+        return PairIterator(sr, tA.read_all_pairs(num_pair, false).ptr);
       }
     }
     alloc_ptr(numPes*sizeof(int), (void**)&nXs);
@@ -1627,6 +2353,7 @@ namespace CTF_int {
   }
 
   int tensor::reduce_sum(char * result, algstrct const * sr_other) {
+    page_in();
     ASSERT(is_mapped && !is_folded);
     tensor sc = tensor(sr_other, 0, NULL, NULL, wrld, 1);
     int idx_A[order];
@@ -1645,6 +2372,7 @@ namespace CTF_int {
   }
 
   int tensor::reduce_sumabs(char * result, algstrct const * sr_other){
+    page_in();
     ASSERT(is_mapped && !is_folded);
     univar_function func = univar_function(sr_other->abs);
     tensor sc = tensor(sr_other, 0, NULL, NULL, wrld, 1);
@@ -1660,6 +2388,7 @@ namespace CTF_int {
   }
 
   int tensor::reduce_sumsq(char * result) {
+    page_in();
     ASSERT(is_mapped && !is_folded);
     tensor sc = tensor(sr, 0, NULL, NULL, wrld, 1);
     int idx_A[order];
@@ -1683,6 +2412,8 @@ namespace CTF_int {
     char * pmy_data, * pall_data;
     int64_t k;
 
+    //collective, so buffered writes may be merged here, which does not change the values of the tensor
+    const_cast<tensor*>(this)->flush_writes();
     if (wrld->rank == 0)
       printf("Printing tensor %s\n",name);
     //print_map(fp);
@@ -1769,6 +2500,8 @@ namespace CTF_int {
 
     tensor * B = this;
     
+    const_cast<tensor*>(A)->flush_writes();
+    B->flush_writes();
     B->align(A);
 
     A->print_map(stdout, 1);
@@ -2040,6 +2773,8 @@ namespace CTF_int {
   #if VERIFY_REMAP
     char * shuffled_data_corr;
   #endif
+    double st_redist_time = MPI_Wtime();
+    double st_comm_time = get_comm_time();
 
     distribution new_dist = distribution(this);
     if (is_sparse) can_block_shuffle = 0;
@@ -2105,25 +2840,16 @@ namespace CTF_int {
       CTF_int::cdealloc((void*)this->data);
     } else {
       if (is_sparse){
-        //padded_reshuffle(sym, old_dist, new_dist, this->data, &shuffled_data, sr, wrld->cdt);
-        double st_time = MPI_Wtime();
         char * old_data = this->data;
-        
-        this->data = NULL;
-        int64_t old_nnz = nnz_loc;
-        nnz_loc = 0;
-        cdealloc(nnz_blk);
+        int64_t * old_nnz_blk = nnz_blk;
         nnz_blk = (int64_t*)alloc(sizeof(int64_t)*calc_nvirt());
-        std::fill(nnz_blk, nnz_blk+calc_nvirt(), 0);
-        this->write(old_nnz, sr->mulid(), sr->addid(), old_data);
-        //this->set_new_nnz_glb(nnz_blk);
-        shuffled_data = this->data;
+        sparse_reshuffle(order, lens, old_dist, new_dist, old_nnz_blk, old_data, nnz_blk, shuffled_data, sr, wrld->cdt);
+        nnz_loc = 0;
+        for (int v=0; v<calc_nvirt(); v++){
+          nnz_loc += nnz_blk[v];
+        }
+        cdealloc(old_nnz_blk);
         if (old_data != NULL) cdealloc(old_data);
-
-        double exe_time = MPI_Wtime()-st_time;
-        double nnz_frac = ((double)nnz_tot)/(old_dist.size*wrld->cdt.np);
-        double tps[] = {exe_time, 1.0, (double)log2(wrld->cdt.np),  (double)std::max(old_dist.size, new_dist.size)*log2(wrld->cdt.np)*sr->el_size*nnz_frac};
-        spredist_mdl.observe(tps);
       } else
         dgtog_reshuffle(sym, lens, old_dist, new_dist, &this->data, &shuffled_data, sr, wrld->cdt);
       //glb_cyclic_reshuffle(sym, old_dist, old_offsets, old_permutation, new_dist, new_offsets, new_permutation, &this->data, &shuffled_data, sr, wrld->cdt, 1, sr->mulid(), sr->addid());
@@ -2166,6 +2892,7 @@ namespace CTF_int {
       }
     }
   #endif
+    redist_time_add(MPI_Wtime()-st_redist_time, get_comm_time()-st_comm_time);
 
     return SUCCESS;
 
@@ -2195,7 +2922,7 @@ namespace CTF_int {
     } else {
       if (this->is_sparse)
         //est_time += 25.*COST_MEMBW*this->sr->el_size*std::max(this->size,old_dist.size)*nnz_frac+wrld->cdt.estimate_alltoall_time(1);
-        est_time += spredist_est_time(this->sr->el_size*std::max(this->size,old_dist.size)*nnz_frac, wrld->cdt.np);
+        est_time += spres_est_time(this->sr->pair_size()*std::max(this->size,old_dist.size)*nnz_frac, wrld->cdt.np, old_nvirt*wrld->cdt.np);
       else
         est_time += dgtog_est_time(this->sr->el_size*std::max(this->size,old_dist.size)*nnz_frac, wrld->cdt.np);
     }
@@ -2707,6 +3434,7 @@ namespace CTF_int {
   }
 
   void tensor::write_dense_to_file(MPI_File & file, int64_t offset){
+    flush_writes();
     bool need_unpack = is_sparse;
     for (int i=0; i<order; i++){
       if (sym[i] != NS) need_unpack = true;
@@ -51,8 +51,9 @@ namespace CTF_int {
       /** 
        * \brief copies all tensor data from other
        * \param[in] other tensor to copy from
+       * \param[in] keep if not NULL, other must be sparse and only its local nonzeros i with keep[i] are copied
        */
-      void copy_tensor_data(tensor const * other);
+      void copy_tensor_data(tensor const * other, char const * keep=NULL);
 
       /** 
        * \brief set edge mappings as specified
@@ -123,6 +124,9 @@ namespace CTF_int {
       int64_t home_size;
       /** \brief whether the latest tensor data is in the home buffer */
       bool is_home;
+      /** \brief whether the tensor left home without its data, so that its data is to be added to
+                 the home buffer rather than replace it when it returns home */
+      bool is_home_acc;
       /** \brief whether profiling should be done for contractions/sums involving this tensor */
       bool profile;
       /** \brief whether only the non-zero elements of the tensor are stored */
@@ -133,10 +137,25 @@ namespace CTF_int {
       int nrow_idx;
       /** \brief number of local nonzero elements */
       int64_t nnz_loc;
-      /** \brief maximum number of local nonzero elements over all procs*/
+      /** \brief maximum number of local nonzero elements over all procs, while writes are buffered the count before them */
       int64_t nnz_tot;
       /** \brief nonzero elements in each block owned locally */
       int64_t * nnz_blk;
+      /** \brief whether writes into the sparse tensor are buffered locally and merged into it only
+                 when it is next read or operated on */
+      bool is_write_buffered;
+      /** \brief number of writes buffered since the tensor was last merged, the same on all processors */
+      int64_t nwrite_buffered;
+      /** \brief locally buffered pairs, as runs sorted by key without repeated keys, each less than
+                 half as large as the one before it */
+      std::vector<char*> write_runs;
+      /** \brief number of pairs in each buffered run */
+      std::vector<int64_t> write_run_len;
+      /** \brief node-local file holding the data of the tensor while it is paged out, MPI_FILE_NULL if the data
+                 is in memory */
+      MPI_File page_file;
+      /** \brief name of page_file */
+      char * page_file_name;
       
       /**
        * \brief associated an index map with the tensor for future operation
@@ -278,6 +297,13 @@ namespace CTF_int {
        */
       void print_map(FILE * stream=stdout, bool allcall=1) const;
 
+      /**
+       * \brief writes mapping of tensor in the format printed by print_map, e.g. A[p2(0)v2,1]
+       * \param[in,out] str preallocated string
+       * \param[in] max_len size of str
+       */
+      void get_map_str(char * str, int max_len) const;
+
       /**
        * \brief set the tensor name 
        * \param[in] name to set
@@ -320,6 +346,57 @@ namespace CTF_int {
                  char *       mapped_data,
                  char const   rw='w');
 
+      /**
+       * \brief collectively overwrites the values of a range of consecutive global indices given by each
+       *        process, the ranges of different processes must not overlap, values of dense nonsymmetric
+       *        tensors are sent to their owners without keys and placed by the layout of the local data
+       * \param[in] offset global index of the first value given by this process
+       * \param[in] n number of values given by this process
+       * \param[in] range_data values of global indices offset to offset+n-1
+       */
+      int write_range(int64_t      offset,
+                      int64_t      n,
+                      char const * range_data);
+
+      /**
+       * \brief turns buffering of writes into a sparse tensor on or off. While on, writes that add to
+       *        the existing values (beta=1) are merged locally and redistributed only when the tensor is
+       *        next read or operated on, other writes first merge the buffered ones. Turning it off merges
+       *        buffered writes.
+       * \param[in] buffer whether to buffer writes
+       */
+      void set_write_buffering(bool buffer);
+
+      /**
+       * \brief merges any buffered writes into the tensor and pages it in if it is paged out, collective, does
+       *        nothing if neither is the case, done by the collective operations using the tensor, but must be
+       *        called before read_local
+       */
+      void flush_writes();
+
+      /**
+       * \brief moves the data of a dense nonsymmetric tensor out of memory into a node-local file on each
+       *        processor, which keeps its contiguous part (get_page_range()) of the elements in the order of
+       *        write_dense_to_file(). While paged out, the tensor is contracted in slabs streamed from the
+       *        files, and other operations page it back in first. Collective.
+       * \param[in] path prefix of the file names, processor i keeps its part in the file path.i
+       */
+      void page_out(char const * path);
+
+      /**
+       * \brief reads the data of a paged out tensor back into memory and deletes its files, collective,
+       *        does nothing if the tensor is in memory
+       */
+      void page_in();
+
+      /**
+       * \brief gives the elements, in the order of write_dense_to_file(), that this processor keeps in its file
+       *        while the tensor is paged out
+       * \param[out] my_st first element
+       * \param[out] my_n number of elements
+       */
+      void get_page_range(int64_t * my_st, int64_t * my_n) const;
+
       /**
        * \brief read tensor data with <key, value> pairs where key is the
        *         global index for the value, which gets filled in with
@@ -446,18 +523,67 @@ namespace CTF_int {
        */ 
       int sparsify(std::function<bool(char const*)> f);
 
+      /**
+       * \brief makes tensor sparse (if it is not) keeping only entries whose indices agree with those of
+       *        some nonzero of M on the indices this tensor shares with M (or with none, if complement)
+       * \param[in] idx_map indices of this tensor
+       * \param[in] M mask tensor, must be nonsymmetric, its values are not used
+       * \param[in] idx_map_M indices of M, each may appear only once
+       * \param[in] complement whether to keep only entries that do not match a nonzero of M
+       */
+      void apply_mask(int const * idx_map, tensor * M, int const * idx_map_M, bool complement);
+
+      /**
+       * \brief returns a sparse copy of this tensor with only the entries apply_mask() would keep,
+       *        if this tensor is sparse only the selected nonzeros are copied
+       * \param[in] idx_map indices of this tensor
+       * \param[in] M mask tensor, must be nonsymmetric, its values are not used
+       * \param[in] idx_map_M indices of M, each may appear only once
+       * \param[in] complement whether to keep only entries that do not match a nonzero of M
+       */
+      tensor * masked_copy(int const * idx_map, tensor * M, int const * idx_map_M, bool complement);
+
+      /**
+       * \brief determines which local nonzeros of this sparse tensor apply_mask() keeps
+       * \param[in] idx_map indices of this tensor
+       * \param[in] M mask tensor
+       * \param[in] idx_map_M indices of M
+       * \param[in] complement whether to keep only entries that do not match a nonzero of M
+       * \param[out] keep whether to keep each local nonzero
+       */
+      void select_masked(int const *         idx_map,
+                         tensor *            M,
+                         int const *         idx_map_M,
+                         bool                complement,
+                         std::vector<char> & keep) const;
+
+      /**
+       * \brief describes local data of a dense tensor as rows, contiguous in the local buffer,
+       *        whose consecutive elements are a fixed distance apart in global index,
+       *        so that per-element work can be done in parallel over rows
+       * \param[out] nrow number of rows
+       * \param[out] rows array of 3*nrow values: offset of row in data, global index of
+       *             first element (in terms of unpadded lens), and row length,
+       *             elements of rows that are padding have a meaningless global index
+       * \param[out] stride global index distance between consecutive elements of a row
+       */
+      void get_local_rows(int64_t * nrow, int64_t ** rows, int64_t * stride) const;
+
       /**
        * \brief read tensor data pairs local to processor including those with zero values
        *          WARNING: for sparse tensors this includes the zeros to maintain consistency with 
        *                   the behavior for dense tensors, use read_local_nnz to get only nonzeros
+       *          local, so buffered writes are not merged and must be flushed (collectively) beforehand
        * \param[out] num_pair number of values read
        * \param[out] mapped_data values read
+       * \return ERROR if there are buffered writes
        */
       int read_local(int64_t * num_pair,
                      char **   mapped_data) const;
 
       /**
-       * \brief read tensor data pairs local to processor that have nonzero values
+       * \brief read tensor data pairs local to processor that have nonzero values, buffered writes must
+       *        be flushed beforehand, as for read_local
        * \param[out] num_pair number of values read
        * \param[out] mapped_data values read
        */
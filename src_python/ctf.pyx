@@ -3,9 +3,12 @@ import sys
 from cython.operator cimport dereference as deref, preincrement as inc
 from libc.stdint cimport int64_t
 from libc.stdlib cimport malloc, free
+from libc.string cimport memcpy
 import numpy as np
 cimport numpy as cnp
 
+cnp.import_array()
+
 import struct
 #from enum import Enum
 #class SYM(Enum):
@@ -37,6 +40,9 @@ cdef extern from "../include/ctf.hpp" namespace "CTF_int":
 
     cdef cppclass tensor:
         algstrct * sr
+        char * data
+        int64_t size
+        bint is_sparse
         tensor()
         void prnt()
         int read(int64_t num_pair,
@@ -47,6 +53,9 @@ cdef extern from "../include/ctf.hpp" namespace "CTF_int":
                   char *  alpha,
                   char *  beta,
                   char *  data);
+        int write_range(int64_t offset,
+                        int64_t n,
+                        char *  data);
         int read_local(int64_t * num_pair,
                        char **   data)
         int read_local_nnz(int64_t * num_pair,
@@ -78,6 +87,8 @@ cdef extern from "../include/ctf.hpp" namespace "CTF":
         World()
         World(int)
 
+    World & get_universe()
+
     cdef cppclass Idx_Tensor(Term):
         Idx_Tensor(tensor *, char *);
         void operator=(Term B);
@@ -117,29 +128,45 @@ cdef int* int_arr_py_to_c(a):
 
 cdef char* interleave_py_pairs(a,b):
     cdef char * ca
-    dim = len(a)
+    cdef int64_t dim = len(a)
+    cdef int64_t i
     cdef int tA, tB
+    cdef cnp.int64_t[::1] ia = np.ascontiguousarray(a, dtype=np.int64)
+    cdef cnp.int8_t[::1] ib = np.ascontiguousarray(b).reshape(-1).view(dtype=np.int8)
     tA = sizeof(int64_t)
     tB = b.dtype.itemsize
-    ca = <char*> malloc(dim*(tA+tB))
+    ca = <char*> malloc(max(dim,1)*(tA+tB))
     if ca is NULL:
         raise MemoryError()
     for i in range(0,dim):
-        (<int64_t*>&(ca[i*(tA+tB)]))[0] = a[i]
-        for j in range(0,tB):
-         ca[(i+1)*tA+i*tB+j] = b.view(dtype=np.int8)[i*tB+j]
-#    ca[(i+1)*tA+i*tB:(i+1)*(tA+tB)-1] =( nb.view(dtype=np.int8)[i*tB:i*tB+tB-1])
-#    not sure why subarray copy doesn't work here
+        (<int64_t*>&(ca[i*(tA+tB)]))[0] = ia[i]
+        memcpy(&ca[(i+1)*tA+i*tB], &ib[i*tB], tB)
     return ca
 
 cdef void uninterleave_py_pairs(char * ca,a,b):
-    dim = len(a)
+    cdef int64_t dim = np.size(a)
+    cdef int64_t i
+    cdef int tA, tB
+    #unpack directly into a and b if they are contiguous arrays of the right type, otherwise into
+    #contiguous copies, which are then assigned elementwise with the shape (and strides) of a and b
+    a_direct = isinstance(a, np.ndarray) and a.dtype == np.int64 and a.flags['C_CONTIGUOUS']
+    b_direct = b.flags['C_CONTIGUOUS']
+    na = a.reshape(-1) if a_direct else np.empty(dim, dtype=np.int64)
+    nb = b.reshape(-1) if b_direct else np.empty(dim, dtype=b.dtype)
+    cdef cnp.int64_t[::1] ia = na
+    cdef cnp.int8_t[::1] ib = nb.view(dtype=np.int8)
     tB = b.dtype.itemsize
     tA = sizeof(int64_t)
     for i in range(0,dim):
-        a[i] = (<int64_t*>&(ca[i*(tA+tB)]))[0] 
-        for j in range(0,tB):
-            b.view(dtype=np.int8)[i*tB+j] = ca[(i+1)*tA+i*tB+j]
+        ia[i] = (<int64_t*>&(ca[i*(tA+tB)]))[0]
+        memcpy(&ib[i*tB], &ca[(i+1)*tA+i*tB], tB)
+    if not a_direct:
+        if isinstance(a, np.ndarray):
+            a[...] = na.reshape(a.shape)
+        else:
+            a[:] = na
+    if not b_direct:
+        b[...] = nb.reshape(b.shape)
 
 cdef class comm:
     cdef World * w
@@ -293,6 +320,51 @@ cdef class tsr:
     def tot_size(self):
         return self.dt.get_tot_size()
 
+    def block_range(self):
+        """
+        returns the range [start, end) of global indices owned by this rank in a block
+        distribution of the tensor over all ranks, in CTF's global index order
+        (first index fastest, i.e. Fortran order)
+        """
+        cdef int64_t sz, blk, rank, np_
+        sz = self.dt.get_tot_size()
+        rank = get_universe().rank
+        np_ = get_universe().np
+        blk = (sz+np_-1)//np_
+        return min(sz, rank*blk), min(sz, (rank+1)*blk)
+
+    def from_numpy(self, arr, offset=None):
+        """
+        collectively writes a rank-local contiguous chunk of the tensor, whose elements
+        have consecutive global indices starting at offset (default is the start of
+        this rank's block_range()), the buffer of arr is passed to CTF without packing
+        and its values are sent to their owners without keys
+        """
+        cdef int64_t n, st
+        cdef cnp.ndarray vals = np.ascontiguousarray(arr, dtype=self.typ).reshape(-1)
+        n = vals.shape[0]
+        if offset is None:
+            st = self.block_range()[0]
+        else:
+            st = offset
+        if st < 0 or st+n > self.dt.get_tot_size():
+            raise ValueError('chunk exceeds tensor size')
+        self.dt.write_range(st, n, <char*>vals.data)
+
+    def to_numpy(self):
+        """
+        returns a view (no copy) of the data stored locally by this rank, in CTF's internal
+        (cyclic, padded) layout, the view is valid until the tensor is next redistributed,
+        so read_local() should be used if the global indices of the elements are needed
+        """
+        cdef cnp.npy_intp dim
+        if self.dt.is_sparse:
+            raise ValueError('to_numpy only supports dense tensors')
+        dim = self.dt.size
+        arr = cnp.PyArray_SimpleNewFromData(1, &dim, np.dtype(self.typ).num, <void*>self.dt.data)
+        cnp.set_array_base(arr, self)
+        return arr
+
     def read_all(self, arr):
         cdef char * cvals
         cdef int64_t sz
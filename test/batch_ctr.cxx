@@ -0,0 +1,154 @@
+/*Copyright (c) 2011, Edgar Solomonik, all rights reserved.*/
+/** \addtogroup tests
+  * @{
+  * \defgroup batch_ctr batch_ctr
+  * @{
+  * \brief Tests batched contractions of many small tensors against the same contractions done one by one
+  */
+
+#include <ctf.hpp>
+using namespace CTF;
+
+/**
+ * \brief checks that T and R have the same values
+ */
+bool batch_ctr_match(Tensor<> & T, Tensor<> & R){
+  int64_t nT, nR;
+  double * dT, * dR;
+  T.read_all(&nT, &dT, true);
+  R.read_all(&nR, &dR, true);
+  bool pass = (nT == nR);
+  for (int64_t i=0; pass && i<nR; i++){
+    pass = fabs(dT[i] - dR[i]) <= 1.E-10*(1.+fabs(dR[i]));
+  }
+  free(dT);
+  free(dR);
+  return pass;
+}
+
+/**
+ * \brief contracts nb random tensors of the given shapes on world w by contract_batch and one by one
+ */
+bool batch_ctr_case(int          nb,
+                    World &      w,
+                    char const * idx_A,
+                    int const *  lens_A,
+                    char const * idx_B,
+                    int const *  lens_B,
+                    char const * idx_C,
+                    int const *  lens_C,
+                    double       alpha,
+                    double       beta){
+  int nsns[] = {NS, NS, NS, NS};
+  std::vector<Tensor<>*> A, B, C, R;
+  for (int i=0; i<nb; i++){
+    A.push_back(new Tensor<>(strlen(idx_A), lens_A, nsns, w, "A"));
+    B.push_back(new Tensor<>(strlen(idx_B), lens_B, nsns, w, "B"));
+    C.push_back(new Tensor<>(strlen(idx_C), lens_C, nsns, w, "C"));
+    A[i]->fill_random(-1., 1.);
+    B[i]->fill_random(-1., 1.);
+    C[i]->fill_random(-1., 1.);
+    R.push_back(new Tensor<>(*C[i]));
+    R[i]->contract(alpha, *A[i], idx_A, *B[i], idx_B, beta, idx_C);
+  }
+  contract_batch(alpha, A, idx_A, B, idx_B, beta, C, idx_C);
+  bool pass = true;
+  for (int i=0; i<nb; i++){
+    pass &= batch_ctr_match(*C[i], *R[i]);
+    delete A[i];
+    delete B[i];
+    delete C[i];
+    delete R[i];
+  }
+  return pass;
+}
+
+int batch_ctr(int     n,
+              World & dw){
+  int pass = 1;
+
+  World sw(MPI_COMM_SELF);
+  int nb = 7;
+  int lA[] = {n, n+1, n+2};
+  int lB[] = {n+2, n-1};
+  int lC[] = {n, n+1, n-1};
+
+  for (int iw=0; iw<2; iw++){
+    //tensors on a single-processor world per processor, then distributed over all processors
+    World & w = iw == 0 ? sw : dw;
+
+    //matrix multiplication without any transposition
+    int lBm[] = {n+1, n+2};
+    int lCm[] = {n, n+2};
+    pass &= batch_ctr_case(nb, w, "ik", lA, "kj", lBm, "ij", lCm, 1., 0.);
+
+    //transposed operands
+    int lAt[] = {n+2, n, n+1};
+    int lBt[] = {n-1, n+2};
+    pass &= batch_ctr_case(nb, w, "kij", lAt, "lk", lBt, "ijl", lC, 2., 1.);
+
+    //output with the indices of B first and a permuted operand
+    int lAp[] = {n+1, n+2, n};
+    int lCs[] = {n-1, n+1, n};
+    pass &= batch_ctr_case(nb, w, "jki", lAp, "kl", lB, "lji", lCs, -1., .5);
+
+    //output with interleaved indices
+    int lCi[] = {n, n-1, n+1};
+    pass &= batch_ctr_case(nb, w, "ijk", lA, "kl", lB, "ilj", lCi, 1., 0.);
+
+    //an index shared by all operands
+    pass &= batch_ctr_case(nb, w, "ijk", lA, "jk", lBm, "ij", lA, 1., 1.);
+  }
+
+  MPI_Allreduce(MPI_IN_PLACE, &pass, 1, MPI_INT, MPI_MIN, dw.comm);
+  if (dw.rank == 0){
+    if (pass)
+      printf("{ batched contractions of small tensors } passed\n");
+    else
+      printf("{ batched contractions of small tensors } failed\n");
+  }
+  return pass;
+}
+
+
+#ifndef TEST_SUITE
+char* getCmdOption(char ** begin,
+                   char ** end,
+                   const   std::string & option){
+  char ** itr = std::find(begin, end, option);
+  if (itr != end && ++itr != end){
+    return *itr;
+  }
+  return 0;
+}
+
+
+int main(int argc, char ** argv){
+  int rank, np, n;
+  int in_num = argc;
+  char ** input_str = argv;
+
+  MPI_Init(&argc, &argv);
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+  MPI_Comm_size(MPI_COMM_WORLD, &np);
+
+  if (getCmdOption(input_str, input_str+in_num, "-n")){
+    n = atoi(getCmdOption(input_str, input_str+in_num, "-n"));
+    if (n < 2) n = 5;
+  } else n = 5;
+
+
+  {
+    World dw(argc, argv);
+    batch_ctr(n, dw);
+  }
+
+  MPI_Finalize();
+  return 0;
+}
+/**
+ * @}
+ * @}
+ */
+
+#endif
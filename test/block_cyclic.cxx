@@ -0,0 +1,123 @@
+/*Copyright (c) 2011, Edgar Solomonik, all rights reserved.*/
+/** \addtogroup tests
+  * @{
+  * \defgroup block_cyclic block_cyclic
+  * @{
+  * \brief Tests writing and reading matrices in ScaLAPACK-style block-cyclic layouts
+  */
+
+#include <ctf.hpp>
+using namespace CTF;
+
+//number of global indices stored locally along a dimension, and their local offsets
+void get_bc_indices(int n, int b, int p, int me, int s, std::vector<int> & inds){
+  inds.clear();
+  for (int i=0; i<n; i++){
+    if ((i/b+s)%p == me) inds.push_back(i);
+  }
+}
+
+int block_cyclic(int     n,
+                 World & dw){
+  int pass = 1;
+  int nrow = n+3;
+  int ncol = 2*n+1;
+  int pr = 1;
+  for (int p=1; p*p<=dw.np; p++){
+    if (dw.np % p == 0) pr = p;
+  }
+  int pc = dw.np/pr;
+  int ipr = dw.rank%pr;
+  int ipc = dw.rank/pr;
+
+  int params[][4] = {{1,1,0,0}, {2,3,0,0}, {4,2,pr-1,pc-1}, {64,64,0,pc/2}, {3,1,pr/2,0}};
+  for (int t=0; t<5; t++){
+    int mb = params[t][0], nb = params[t][1], rsrc = params[t][2], csrc = params[t][3];
+    std::vector<int> rows, cols;
+    get_bc_indices(nrow, mb, pr, ipr, rsrc, rows);
+    get_bc_indices(ncol, nb, pc, ipc, csrc, cols);
+    int lda = rows.size()+t%2;
+    std::vector<double> loc(std::max((size_t)1,lda*cols.size()), -1.);
+    for (int j=0; j<(int)cols.size(); j++){
+      for (int i=0; i<(int)rows.size(); i++){
+        loc[j*lda+i] = rows[i]+cols[j]*nrow+1.;
+      }
+    }
+    //write into both the default mapping and one matching the processor grid
+    Matrix<> A(nrow, ncol, dw);
+    A.write_mat(mb, nb, pr, pc, rsrc, csrc, lda, loc.data());
+    int plens[] = {pr, pc};
+    Partition ip(2, plens);
+    Matrix<> B(nrow, ncol, "ij", ip["ij"], Idx_Partition(), NS, dw);
+    B.write_mat(mb, nb, pr, pc, rsrc, csrc, lda, loc.data());
+
+    std::vector<double> all(nrow*ncol);
+    A.read_all(all.data());
+    for (int64_t i=0; i<(int64_t)nrow*ncol; i++){
+      pass &= (all[i] == i+1.);
+    }
+    B.read_all(all.data());
+    for (int64_t i=0; i<(int64_t)nrow*ncol; i++){
+      pass &= (all[i] == i+1.);
+    }
+
+    std::vector<double> loc2(loc.size(), -1.);
+    A.read_mat(mb, nb, pr, pc, rsrc, csrc, lda, loc2.data());
+    pass &= (loc2 == loc);
+    std::fill(loc2.begin(), loc2.end(), -1.);
+    B.read_mat(mb, nb, pr, pc, rsrc, csrc, lda, loc2.data());
+    pass &= (loc2 == loc);
+  }
+
+  MPI_Allreduce(MPI_IN_PLACE, &pass, 1, MPI_INT, MPI_MIN, dw.comm);
+  if (dw.rank == 0){
+    if (pass)
+      printf("{ block-cyclic write_mat and read_mat } passed\n");
+    else
+      printf("{ block-cyclic write_mat and read_mat } failed\n");
+  }
+  return pass;
+}
+
+
+#ifndef TEST_SUITE
+char* getCmdOption(char ** begin,
+                   char ** end,
+                   const   std::string & option){
+  char ** itr = std::find(begin, end, option);
+  if (itr != end && ++itr != end){
+    return *itr;
+  }
+  return 0;
+}
+
+
+int main(int argc, char ** argv){
+  int rank, np, n;
+  int in_num = argc;
+  char ** input_str = argv;
+
+  MPI_Init(&argc, &argv);
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+  MPI_Comm_size(MPI_COMM_WORLD, &np);
+
+  if (getCmdOption(input_str, input_str+in_num, "-n")){
+    n = atoi(getCmdOption(input_str, input_str+in_num, "-n"));
+    if (n < 0) n = 7;
+  } else n = 7;
+
+
+  {
+    World dw(argc, argv);
+    block_cyclic(n, dw);
+  }
+
+  MPI_Finalize();
+  return 0;
+}
+/**
+ * @}
+ * @}
+ */
+
+#endif
@@ -0,0 +1,120 @@
+/*Copyright (c) 2011, Edgar Solomonik, all rights reserved.*/
+/** \addtogroup tests
+  * @{
+  * \defgroup comm_cache comm_cache
+  * @{
+  * \brief Tests that repeated contractions and summations reuse cached processor grid communicators
+  *        and give the same results when the cache holds at most one communicator
+  */
+
+#include <ctf.hpp>
+using namespace CTF;
+
+int comm_cache(int     n,
+               World & dw){
+  int pass = 1;
+  Matrix<> A(n, n+1, NS, dw, "A");
+  Matrix<> B(n+1, n+2, NS, dw, "B");
+  Matrix<> C(n, n+2, NS, dw, "C");
+  Matrix<> Cr(n, n+2, NS, dw, "Cr");
+  A.fill_random(-1., 1.);
+  B.fill_random(-1., 1.);
+  Cr["ij"] = A["ik"]*B["kj"];
+
+  int64_t nhit, nmiss, nhit2, nmiss2;
+  int ncomm;
+  dw.set_comm_cache_limit(128);
+  dw.get_comm_cache_stats(nhit, nmiss, ncomm);
+  for (int r=0; r<3; r++){
+    C["ij"] = A["ik"]*B["kj"];
+    C["ij"] -= Cr["ij"];
+  }
+  dw.get_comm_cache_stats(nhit2, nmiss2, ncomm);
+  //the operations above were done before, so their communicators are found in the cache
+  if (dw.np > 1 && nhit2 <= nhit) pass = 0;
+  if (C.norm2() > 1.E-10) pass = 0;
+
+  //communicators held by activated topologies (e.g. of the physical topology) are not evicted
+  int ncomm_pinned;
+  dw.set_comm_cache_limit(1);
+  dw.get_comm_cache_stats(nhit, nmiss, ncomm_pinned);
+  for (int r=0; r<3; r++){
+    C["ij"] = A["ik"]*B["kj"];
+    C["ij"] -= Cr["ij"];
+    if (C.norm2() > 1.E-10) pass = 0;
+  }
+  dw.get_comm_cache_stats(nhit2, nmiss2, ncomm);
+  if (ncomm > std::max(1, ncomm_pinned)) pass = 0;
+  dw.set_comm_cache_limit(128);
+
+  //worlds on the same communicator share its cache, destroying one of them keeps the communicators
+  //it no longer uses cached for the others
+  MPI_Comm cm;
+  MPI_Comm_dup(dw.comm, &cm);
+  {
+    World w1(cm);
+    int ncomm2;
+    {
+      int np = w1.np;
+      World w2(1, &np, cm);
+      Matrix<> A2(n, n+1, NS, w2, "A2");
+      A2.fill_random(-1., 1.);
+      w1.get_comm_cache_stats(nhit, nmiss, ncomm);
+    }
+    w1.get_comm_cache_stats(nhit2, nmiss2, ncomm2);
+    if (nhit2 != nhit || nmiss2 != nmiss || ncomm2 != ncomm) pass = 0;
+  }
+  MPI_Comm_free(&cm);
+
+  MPI_Allreduce(MPI_IN_PLACE, &pass, 1, MPI_INT, MPI_MIN, dw.comm);
+  if (dw.rank == 0){
+    if (pass)
+      printf("{ processor grid communicators are reused from the cache } passed\n");
+    else
+      printf("{ processor grid communicators are reused from the cache } failed\n");
+  }
+  return pass;
+}
+
+
+#ifndef TEST_SUITE
+char* getCmdOption(char ** begin,
+                   char ** end,
+                   const   std::string & option){
+  char ** itr = std::find(begin, end, option);
+  if (itr != end && ++itr != end){
+    return *itr;
+  }
+  return 0;
+}
+
+
+int main(int argc, char ** argv){
+  int rank, np, n;
+  int in_num = argc;
+  char ** input_str = argv;
+
+  MPI_Init(&argc, &argv);
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+  MPI_Comm_size(MPI_COMM_WORLD, &np);
+
+  if (getCmdOption(input_str, input_str+in_num, "-n")){
+    n = atoi(getCmdOption(input_str, input_str+in_num, "-n"));
+    if (n < 0) n = 23;
+  } else n = 23;
+
+
+  {
+    World dw(argc, argv);
+    comm_cache(n, dw);
+  }
+
+  MPI_Finalize();
+  return 0;
+}
+/**
+ * @}
+ * @}
+ */
+
+#endif
@@ -0,0 +1,148 @@
+/*Copyright (c) 2011, Edgar Solomonik, all rights reserved.*/
+/** \addtogroup tests
+  * @{
+  * \defgroup csr_reduce csr_reduce
+  * @{
+  * \brief Tests reduction, reduce-scatter, gather and allreduction of serialized CSR matrices
+  */
+
+#include <ctf.hpp>
+using namespace CTF;
+
+static bool csr_red_has(int rank, int i, int j){
+  return (i*7+j*3+rank)%5 == 0;
+}
+
+/**
+ * \brief checks that the rows of a CSR matrix hold the sum over np processors of the entries of their local matrices,
+ *        the rows of the matrix being the rows i of the full matrix with i%nparts == part
+ */
+static bool check_csr_red(char * cA, int np, int nrow, int ncol, int nparts, int part){
+  CTF_int::CSR_Matrix A(cA);
+  int const * IA = A.IA();
+  int const * JA = A.JA();
+  double const * vs = (double const*)A.vals();
+  bool pass = A.nrow() == (nrow-part+nparts-1)/nparts;
+  for (int k=0; pass && k<A.nrow(); k++){
+    int i = part+k*nparts;
+    int64_t nz = 0;
+    for (int j=0; j<ncol; j++){
+      double v = 0.;
+      bool has = false;
+      for (int r=0; r<np; r++){
+        if (csr_red_has(r, i, j)){
+          v += r+1+i+j;
+          has = true;
+        }
+      }
+      if (!has) continue;
+      int64_t l = IA[k]-1+nz;
+      if (l >= IA[k+1]-1 || JA[l] != j+1 || vs[l] != v) pass = false;
+      nz++;
+    }
+    if (IA[k]-1+nz != IA[k+1]-1) pass = false;
+  }
+  return pass;
+}
+
+int csr_reduce(int     n,
+               World & dw){
+  int pass = 1;
+  int nrow = n, ncol = n+3;
+  Semiring<> sr;
+  int64_t nnz = 0;
+  for (int i=0; i<nrow; i++){
+    for (int j=0; j<ncol; j++){
+      if (csr_red_has(dw.rank, i, j)) nnz++;
+    }
+  }
+  CTF_int::CSR_Matrix A(nnz, nrow, ncol, sizeof(double));
+  int * IA = A.IA();
+  int * JA = A.JA();
+  double * vs = (double*)A.vals();
+  IA[0] = 1;
+  for (int i=0; i<nrow; i++){
+    IA[i+1] = IA[i];
+    for (int j=0; j<ncol; j++){
+      if (csr_red_has(dw.rank, i, j)){
+        JA[IA[i+1]-1] = j+1;
+        vs[IA[i+1]-1] = dw.rank+1+i+j;
+        IA[i+1]++;
+      }
+    }
+  }
+
+  int root = 1%dw.np;
+  char * red = sr.csr_reduce(A.all_data, root, dw.comm);
+  if (dw.rank == root){
+    pass &= check_csr_red(red, dw.np, nrow, ncol, 1, 0);
+    if (red != A.all_data) CTF_int::cdealloc(red);
+  } else if (red != NULL) pass = 0;
+
+  char * part = sr.csr_reduce_scatter(A.all_data, dw.comm);
+  pass &= check_csr_red(part, dw.np, nrow, ncol, dw.np, dw.rank);
+  if (part != A.all_data){
+    char * gat = sr.csr_gather(part, root, dw.comm);
+    if (dw.rank == root){
+      pass &= check_csr_red(gat, dw.np, nrow, ncol, 1, 0);
+      CTF_int::cdealloc(gat);
+    } else if (gat != NULL) pass = 0;
+  }
+
+  char * all = sr.csr_allreduce(A.all_data, dw.comm);
+  pass &= check_csr_red(all, dw.np, nrow, ncol, 1, 0);
+  if (all != A.all_data) CTF_int::cdealloc(all);
+  CTF_int::cdealloc(A.all_data);
+
+  MPI_Allreduce(MPI_IN_PLACE, &pass, 1, MPI_INT, MPI_MIN, dw.comm);
+  if (dw.rank == 0){
+    if (pass)
+      printf("{ reductions of CSR matrices } passed\n");
+    else
+      printf("{ reductions of CSR matrices } failed\n");
+  }
+  return pass;
+}
+
+
+#ifndef TEST_SUITE
+char* getCmdOption(char ** begin,
+                   char ** end,
+                   const   std::string & option){
+  char ** itr = std::find(begin, end, option);
+  if (itr != end && ++itr != end){
+    return *itr;
+  }
+  return 0;
+}
+
+
+int main(int argc, char ** argv){
+  int rank, np, n;
+  int in_num = argc;
+  char ** input_str = argv;
+
+  MPI_Init(&argc, &argv);
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+  MPI_Comm_size(MPI_COMM_WORLD, &np);
+
+  if (getCmdOption(input_str, input_str+in_num, "-n")){
+    n = atoi(getCmdOption(input_str, input_str+in_num, "-n"));
+    if (n < 0) n = 23;
+  } else n = 23;
+
+
+  {
+    World dw(argc, argv);
+    csr_reduce(n, dw);
+  }
+
+  MPI_Finalize();
+  return 0;
+}
+/**
+ * @}
+ * @}
+ */
+
+#endif
@@ -0,0 +1,120 @@
+/*Copyright (c) 2011, Edgar Solomonik, all rights reserved.*/
+/** \addtogroup tests
+  * @{
+  * \defgroup ctr_report ctr_report
+  * @{
+  * \brief Tests that contraction reports recorded by a World describe each contraction
+  */
+
+#include <ctf.hpp>
+using namespace CTF;
+
+int ctr_report(int     n,
+               World & dw){
+  int pass = 1;
+
+  Matrix<> A(n, n+1, NS, dw, "A");
+  Matrix<> B(n+1, n+2, NS, dw, "B");
+  Matrix<> C(n, n+2, NS, dw, "C");
+  A.fill_random(-.5, .5);
+  B.fill_random(-.5, .5);
+
+  dw.begin_ctr_reports();
+  for (int i=0; i<3; i++){
+    C["ij"] += A["ik"]*B["kj"];
+  }
+  //summations are not recorded
+  C["ij"] += C["ij"];
+  dw.end_ctr_reports();
+  C["ij"] += A["ik"]*B["kj"];
+
+  pass &= (dw.ctr_reports.size() == 3);
+  for (int i=0; i<(int)dw.ctr_reports.size(); i++){
+    Contraction_report const & r = dw.ctr_reports[i];
+    pass &= (r.expr.find("C[") == 0);
+    pass &= (r.expr.find("A[") != std::string::npos && r.expr.find("B[") != std::string::npos);
+    pass &= (r.mapping.find("[") != std::string::npos);
+    pass &= (r.tot_time >= 0.0 && r.est_time >= 0.0);
+    pass &= (r.redist_time >= 0.0 && r.fold_time >= 0.0 && r.kernel_time >= 0.0);
+    pass &= (r.map_time >= 0.0 && r.map_time + r.redist_time + r.fold_time + r.kernel_time <= r.tot_time*1.01 + 1.E-6);
+    pass &= (r.comm_bytes >= 0);
+    pass &= (r.est_mem > 0 && r.peak_mem >= 0);
+  }
+  if (dw.ctr_reports.size() > 0){
+    //each process contracts its own blocks, so all flops should be accounted for
+    int64_t flops = 0;
+    for (int i=0; i<(int)dw.ctr_reports.size(); i++){
+      flops += dw.ctr_reports[i].flops;
+    }
+    int64_t tot_flops;
+    MPI_Allreduce(&flops, &tot_flops, 1, MPI_INT64_T, MPI_SUM, dw.comm);
+    pass &= (tot_flops >= 3*2*(int64_t)n*(n+1)*(n+2));
+  }
+
+  //with a memory budget below the predicted peak the result is unchanged and the mapping chosen
+  //(or the mappings of the slabs) is predicted to need less memory
+  Matrix<> Cb(n, n+2, NS, dw, "Cb");
+  int64_t est_mem = dw.ctr_reports[0].est_mem;
+  dw.begin_ctr_reports();
+  C["ij"] = A["ik"]*B["kj"];
+  dw.mem_budget = 8*(int64_t)(n*(n+1)+(n+1)*(n+2)+n*(n+2))/dw.np + est_mem/2;
+  Cb["ij"] = A["ik"]*B["kj"];
+  dw.mem_budget = 0;
+  dw.end_ctr_reports();
+  pass &= (dw.ctr_reports.size() == 2 && dw.ctr_reports[1].est_mem <= dw.ctr_reports[0].est_mem);
+  Cb["ij"] -= C["ij"];
+  pass &= (Cb.norm2() <= 1.E-10*C.norm2());
+  MPI_Allreduce(MPI_IN_PLACE, &pass, 1, MPI_INT, MPI_MIN, dw.comm);
+
+  if (dw.rank == 0){
+    if (pass)
+      printf("{ contraction reports } passed\n");
+    else
+      printf("{ contraction reports } failed\n");
+  }
+  return pass;
+}
+
+
+#ifndef TEST_SUITE
+char* getCmdOption(char ** begin,
+                   char ** end,
+                   const   std::string & option){
+  char ** itr = std::find(begin, end, option);
+  if (itr != end && ++itr != end){
+    return *itr;
+  }
+  return 0;
+}
+
+
+int main(int argc, char ** argv){
+  int rank, np, n;
+  int in_num = argc;
+  char ** input_str = argv;
+
+  MPI_Init(&argc, &argv);
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+  MPI_Comm_size(MPI_COMM_WORLD, &np);
+
+  if (getCmdOption(input_str, input_str+in_num, "-n")){
+    n = atoi(getCmdOption(input_str, input_str+in_num, "-n"));
+    if (n < 0) n = 7;
+  } else n = 7;
+
+
+  {
+    World dw(argc, argv);
+    ctr_report(n, dw);
+    dw.print_ctr_reports();
+  }
+
+  MPI_Finalize();
+  return 0;
+}
+/**
+ * @}
+ * @}
+ */
+
+#endif
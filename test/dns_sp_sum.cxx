@@ -0,0 +1,140 @@
+/*Copyright (c) 2011, Edgar Solomonik, all rights reserved.*/
+/** \addtogroup tests
+  * @{
+  * \defgroup dns_sp_sum dns_sp_sum
+  * @{
+  * \brief Tests accumulation of dense tensors into sparse tensors against the same sums into dense tensors
+  */
+
+#include <ctf.hpp>
+using namespace CTF;
+
+/**
+ * \brief checks that sparse S has the same values as dense R and stores exactly the nonzeros of R
+ */
+bool same_dns_sp(Tensor<> & S, Tensor<> & R, char const * idx){
+  Tensor<> D(S.order, S.lens, S.sym, *S.wrld);
+  D[idx] = S[idx];
+  int64_t nD, nR;
+  double * dD, * dR;
+  D.read_all(&nD, &dD, false);
+  R.read_all(&nR, &dR, false);
+  bool pass = (nD == nR);
+  int64_t nnz = 0;
+  for (int64_t i=0; pass && i<nR; i++){
+    pass = fabs(dD[i] - dR[i]) <= 1.E-10*(1.+fabs(dR[i]));
+    if (dR[i] != 0.) nnz++;
+  }
+  free(dD);
+  free(dR);
+  return pass && nnz == S.nnz_tot;
+}
+
+int dns_sp_sum(int     n,
+               World & dw){
+  int pass = 1;
+
+  for (int dns=0; dns<2; dns++){
+    //merge the dense blocks with the pairs of B, then scatter the pairs of B into dense blocks
+    CTF_int::set_dns_sp_sum_density(dns ? 0. : 1.);
+
+    Matrix<> A(n, n+1, dw, "A");
+    Matrix<> B(n, n+1, SP, dw, "B");
+    Matrix<> Br(n, n+1, dw, "Br");
+    A.fill_random(-1., 1.);
+    B.fill_sp_random(-1., 1., .2);
+    Br["ij"] = B["ij"];
+    B["ij"] += A["ij"];
+    Br["ij"] += A["ij"];
+    pass &= same_dns_sp(B, Br, "ij");
+
+    //dense summand with zeros, alpha and beta
+    Matrix<> As(n, n+1, SP, dw, "As");
+    Matrix<> Az(n, n+1, dw, "Az");
+    As.fill_sp_random(-1., 1., .3);
+    Az["ij"] = As["ij"];
+    Matrix<> C(n, n+1, SP, dw, "C");
+    Matrix<> Cr(n, n+1, dw, "Cr");
+    C.fill_sp_random(-1., 1., .3);
+    Cr["ij"] = C["ij"];
+    C.sum(2., Az, "ij", .5, "ij");
+    Cr.sum(2., Az, "ij", .5, "ij");
+    pass &= same_dns_sp(C, Cr, "ij");
+
+    //overwriting the sparse tensor keeps only the nonzeros of the summand
+    C["ij"] = Az["ij"];
+    Cr["ij"] = Az["ij"];
+    pass &= same_dns_sp(C, Cr, "ij");
+
+    //order three tensors with padding, the dense summand is the output of a preceding contraction
+    int lens[] = {n, n+2, n-1};
+    int lens_Y[] = {3, n+2, n-1};
+    int nsns[] = {NS, NS, NS};
+    Matrix<> X(n, 3, dw, "X");
+    Tensor<> Y(3, lens_Y, nsns, dw, "Y");
+    Tensor<> T(3, lens, nsns, dw, "T");
+    Tensor<> S(3, true, lens, nsns, dw);
+    Tensor<> Sr(3, lens, nsns, dw, "Sr");
+    X.fill_random(-1., 1.);
+    Y.fill_random(-1., 1.);
+    T["ijk"] = X["il"]*Y["ljk"];
+    S.fill_sp_random(-1., 1., .1);
+    Sr["ijk"] = S["ijk"];
+    S["ijk"] -= T["ijk"];
+    Sr["ijk"] -= T["ijk"];
+    pass &= same_dns_sp(S, Sr, "ijk");
+  }
+  CTF_int::set_dns_sp_sum_density(.5);
+
+  MPI_Allreduce(MPI_IN_PLACE, &pass, 1, MPI_INT, MPI_MIN, dw.comm);
+  if (dw.rank == 0){
+    if (pass)
+      printf("{ dense tensors accumulated into sparse tensors } passed\n");
+    else
+      printf("{ dense tensors accumulated into sparse tensors } failed\n");
+  }
+  return pass;
+}
+
+
+#ifndef TEST_SUITE
+char* getCmdOption(char ** begin,
+                   char ** end,
+                   const   std::string & option){
+  char ** itr = std::find(begin, end, option);
+  if (itr != end && ++itr != end){
+    return *itr;
+  }
+  return 0;
+}
+
+
+int main(int argc, char ** argv){
+  int rank, np, n;
+  int in_num = argc;
+  char ** input_str = argv;
+
+  MPI_Init(&argc, &argv);
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+  MPI_Comm_size(MPI_COMM_WORLD, &np);
+
+  if (getCmdOption(input_str, input_str+in_num, "-n")){
+    n = atoi(getCmdOption(input_str, input_str+in_num, "-n"));
+    if (n < 0) n = 11;
+  } else n = 11;
+
+
+  {
+    World dw(argc, argv);
+    dns_sp_sum(n, dw);
+  }
+
+  MPI_Finalize();
+  return 0;
+}
+/**
+ * @}
+ * @}
+ */
+
+#endif
@@ -0,0 +1,150 @@
+/*Copyright (c) 2011, Edgar Solomonik, all rights reserved.*/
+/** \addtogroup tests
+  * @{
+  * \defgroup ewise ewise
+  * @{
+  * \brief Tests sums, scalings and elementwise products of identically distributed tensors against
+  *        the same operations done on the gathered data
+  */
+
+#include <ctf.hpp>
+using namespace CTF;
+
+/**
+ * \brief gathers all (unpacked) values of T
+ */
+std::vector<double> ewise_values(Tensor<> & T){
+  int64_t n;
+  double * d;
+  T.read_all(&n, &d, true);
+  std::vector<double> v(d, d+n);
+  free(d);
+  return v;
+}
+
+bool ewise_match(Tensor<> & T, std::vector<double> const & ref){
+  std::vector<double> v = ewise_values(T);
+  bool pass = v.size() == ref.size();
+  for (int64_t i=0; pass && i<(int64_t)v.size(); i++){
+    pass = fabs(v[i] - ref[i]) <= 1.E-10*(1.+fabs(ref[i]));
+  }
+  return pass;
+}
+
+int ewise(int     n,
+          World & dw){
+  int pass = 1;
+
+  int lens[] = {n, n+1, n+2};
+  int nsns[] = {NS, NS, NS};
+  Tensor<> A(3, lens, nsns, dw, "A");
+  Tensor<> B(3, lens, nsns, dw, "B");
+  Tensor<> C(3, lens, nsns, dw, "C");
+  A.fill_random(-1., 1.);
+  B.fill_random(-1., 1.);
+  C.fill_random(-1., 1.);
+  std::vector<double> a = ewise_values(A);
+  std::vector<double> b = ewise_values(B);
+  std::vector<double> c = ewise_values(C);
+  std::vector<double> r(a.size());
+
+  //sums with and without scaling factors
+  B["ijk"] += A["ijk"];
+  for (size_t i=0; i<r.size(); i++){ b[i] += a[i]; }
+  pass &= ewise_match(B, b);
+
+  B.sum(2., A, "ijk", .5, "ijk");
+  for (size_t i=0; i<r.size(); i++){ b[i] = .5*b[i] + 2.*a[i]; }
+  pass &= ewise_match(B, b);
+
+  B["ijk"] = -3.*A["ijk"];
+  for (size_t i=0; i<r.size(); i++){ b[i] = -3.*a[i]; }
+  pass &= ewise_match(B, b);
+
+  //scaling in place, the operand is also the output
+  A["ijk"] *= 2.;
+  for (size_t i=0; i<r.size(); i++){ a[i] *= 2.; }
+  pass &= ewise_match(A, a);
+
+  //elementwise products
+  C["ijk"] = A["ijk"]*B["ijk"];
+  for (size_t i=0; i<r.size(); i++){ c[i] = a[i]*b[i]; }
+  pass &= ewise_match(C, c);
+
+  C["ijk"] += 2.*A["ijk"]*B["ijk"];
+  for (size_t i=0; i<r.size(); i++){ c[i] += 2.*a[i]*b[i]; }
+  pass &= ewise_match(C, c);
+
+  C.contract(1., A, "ijk", B, "ijk", -1., "ijk");
+  for (size_t i=0; i<r.size(); i++){ c[i] = a[i]*b[i] - c[i]; }
+  pass &= ewise_match(C, c);
+
+  //symmetric operands
+  Matrix<> S(n, n, SY, dw, "S");
+  Matrix<> T(n, n, SY, dw, "T");
+  Matrix<> U(n, n, SY, dw, "U");
+  S.fill_random(-1., 1.);
+  T.fill_random(-1., 1.);
+  std::vector<double> s = ewise_values(S);
+  std::vector<double> t = ewise_values(T);
+  S["ij"] += T["ij"];
+  for (size_t i=0; i<s.size(); i++){ s[i] += t[i]; }
+  pass &= ewise_match(S, s);
+
+  U["ij"] = S["ij"]*T["ij"];
+  std::vector<double> u(s.size());
+  for (size_t i=0; i<s.size(); i++){ u[i] = s[i]*t[i]; }
+  pass &= ewise_match(U, u);
+
+  MPI_Allreduce(MPI_IN_PLACE, &pass, 1, MPI_INT, MPI_MIN, dw.comm);
+  if (dw.rank == 0){
+    if (pass)
+      printf("{ elementwise operations on identically distributed tensors } passed\n");
+    else
+      printf("{ elementwise operations on identically distributed tensors } failed\n");
+  }
+  return pass;
+}
+
+
+#ifndef TEST_SUITE
+char* getCmdOption(char ** begin,
+                   char ** end,
+                   const   std::string & option){
+  char ** itr = std::find(begin, end, option);
+  if (itr != end && ++itr != end){
+    return *itr;
+  }
+  return 0;
+}
+
+
+int main(int argc, char ** argv){
+  int rank, np, n;
+  int in_num = argc;
+  char ** input_str = argv;
+
+  MPI_Init(&argc, &argv);
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+  MPI_Comm_size(MPI_COMM_WORLD, &np);
+
+  if (getCmdOption(input_str, input_str+in_num, "-n")){
+    n = atoi(getCmdOption(input_str, input_str+in_num, "-n"));
+    if (n < 0) n = 9;
+  } else n = 9;
+
+
+  {
+    World dw(argc, argv);
+    ewise(n, dw);
+  }
+
+  MPI_Finalize();
+  return 0;
+}
+/**
+ * @}
+ * @}
+ */
+
+#endif
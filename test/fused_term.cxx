@@ -0,0 +1,198 @@
+/*Copyright (c) 2011, Edgar Solomonik, all rights reserved.*/
+/** \addtogroup tests
+  * @{
+  * \defgroup fused_term fused_term
+  * @{
+  * \brief Tests expressions of sums and elementwise products of identically distributed tensors,
+  *        which are evaluated in a single fused pass, against the same expressions on the gathered data
+  */
+
+#include <ctf.hpp>
+using namespace CTF;
+
+/**
+ * \brief gathers all (unpacked) values of T
+ */
+std::vector<double> fused_term_values(Tensor<> & T){
+  int64_t n;
+  double * d;
+  T.read_all(&n, &d, true);
+  std::vector<double> v(d, d+n);
+  free(d);
+  return v;
+}
+
+bool fused_term_match(Tensor<> & T, std::vector<double> const & ref){
+  std::vector<double> v = fused_term_values(T);
+  bool pass = v.size() == ref.size();
+  for (int64_t i=0; pass && i<(int64_t)v.size(); i++){
+    pass = fabs(v[i] - ref[i]) <= 1.E-10*(1.+fabs(ref[i]));
+  }
+  return pass;
+}
+
+int fused_term(int     n,
+               World & dw){
+  int pass = 1;
+
+  Matrix<> A(n, n, dw, "A");
+  Matrix<> B(n, n, dw, "B");
+  Matrix<> C(n, n, dw, "C");
+  Matrix<> D(n, n, dw, "D");
+  Matrix<> X(n, n, dw, "X");
+  A.fill_random(-1., 1.);
+  B.fill_random(-1., 1.);
+  C.fill_random(-1., 1.);
+  D.fill_random(-1., 1.);
+  X.fill_random(-1., 1.);
+  std::vector<double> a = fused_term_values(A);
+  std::vector<double> b = fused_term_values(B);
+  std::vector<double> c = fused_term_values(C);
+  std::vector<double> d = fused_term_values(D);
+  std::vector<double> x = fused_term_values(X);
+  int64_t nn = n*n;
+
+  //product of a tensor and a difference
+  X["ij"] = D["ij"]*(B["ij"] - C["ij"]);
+  for (int64_t i=0; i<nn; i++){ x[i] = d[i]*(b[i] - c[i]); }
+  pass &= fused_term_match(X, x);
+
+  //sums of scaled products and sums, accumulated into the output
+  X["ij"] += 2.*A["ij"]*B["ij"]*C["ij"] + 3.*(A["ij"] - D["ij"]) - B["ij"];
+  for (int64_t i=0; i<nn; i++){ x[i] += 2.*a[i]*b[i]*c[i] + 3.*(a[i] - d[i]) - b[i]; }
+  pass &= fused_term_match(X, x);
+
+  //the output is also an operand
+  X["ij"] = X["ij"]*(A["ij"] + B["ij"]);
+  for (int64_t i=0; i<nn; i++){ x[i] = x[i]*(a[i] + b[i]); }
+  pass &= fused_term_match(X, x);
+
+  //a transposed operand is materialized, the rest is fused
+  X["ij"] = D["ij"]*(B["ij"] + A["ji"]);
+  for (int64_t i=0; i<n; i++){
+    for (int64_t j=0; j<n; j++){
+      x[i+j*n] = d[i+j*n]*(b[i+j*n] + a[j+i*n]);
+    }
+  }
+  pass &= fused_term_match(X, x);
+
+  //a true contraction is summed into the output after the fused operands
+  X["ij"] = B["ij"] - A["ik"]*C["kj"] + 2.*D["ij"];
+  for (int64_t i=0; i<n; i++){
+    for (int64_t j=0; j<n; j++){
+      x[i+j*n] = b[i+j*n] + 2.*d[i+j*n];
+      for (int64_t k=0; k<n; k++){
+        x[i+j*n] -= a[i+k*n]*c[k+j*n];
+      }
+    }
+  }
+  pass &= fused_term_match(X, x);
+
+  //a nested contraction is evaluated into an intermediate which is an operand of the fused pass
+  X["ij"] = D["ij"]*(B["ij"] - A["ik"]*C["kj"]);
+  for (int64_t i=0; i<n; i++){
+    for (int64_t j=0; j<n; j++){
+      x[i+j*n] = b[i+j*n];
+      for (int64_t k=0; k<n; k++){
+        x[i+j*n] -= a[i+k*n]*c[k+j*n];
+      }
+      x[i+j*n] *= d[i+j*n];
+    }
+  }
+  pass &= fused_term_match(X, x);
+
+  //Jacobi updates with a dense and a sparse matrix, the second reusing the intermediate of the first
+  Matrix<> R(n, n, SP, dw, "R");
+  R["ij"] = A["ij"];
+  Vector<> bv(n, dw, "bv");
+  Vector<> dv(n, dw, "dv");
+  Vector<> xv(n, dw, "xv");
+  bv.fill_random(-1., 1.);
+  dv.fill_random(1., 2.);
+  xv.fill_random(-1., 1.);
+  //the inverse is also taken of the padding of dv, which must not leak into xv
+  Transform<> inv([](double & a){ a = 1./a; });
+  inv(dv["i"]);
+  std::vector<double> vb = fused_term_values(bv);
+  std::vector<double> vd = fused_term_values(dv);
+  std::vector<double> vx = fused_term_values(xv);
+  for (int it=0; it<2; it++){
+    if (it == 0) xv["i"] = dv["i"]*(bv["i"] - A["ij"]*xv["j"]);
+    else xv["i"] = dv["i"]*(bv["i"] - R["ij"]*xv["j"]);
+    std::vector<double> vy(n);
+    for (int64_t i=0; i<n; i++){
+      vy[i] = vb[i];
+      for (int64_t j=0; j<n; j++){
+        vy[i] -= a[i+j*n]*vx[j];
+      }
+      vy[i] *= vd[i];
+    }
+    vx = vy;
+    pass &= fused_term_match(xv, vx);
+  }
+
+  //symmetric operands
+  Matrix<> S(n, n, SY, dw, "S");
+  Matrix<> T(n, n, SY, dw, "T");
+  Matrix<> U(n, n, SY, dw, "U");
+  S.fill_random(-1., 1.);
+  T.fill_random(-1., 1.);
+  std::vector<double> s = fused_term_values(S);
+  std::vector<double> t = fused_term_values(T);
+  U["ij"] = S["ij"]*(S["ij"] - .5*T["ij"]);
+  std::vector<double> u(s.size());
+  for (size_t i=0; i<s.size(); i++){ u[i] = s[i]*(s[i] - .5*t[i]); }
+  pass &= fused_term_match(U, u);
+
+  MPI_Allreduce(MPI_IN_PLACE, &pass, 1, MPI_INT, MPI_MIN, dw.comm);
+  if (dw.rank == 0){
+    if (pass)
+      printf("{ fused elementwise expressions } passed\n");
+    else
+      printf("{ fused elementwise expressions } failed\n");
+  }
+  return pass;
+}
+
+
+#ifndef TEST_SUITE
+char* getCmdOption(char ** begin,
+                   char ** end,
+                   const   std::string & option){
+  char ** itr = std::find(begin, end, option);
+  if (itr != end && ++itr != end){
+    return *itr;
+  }
+  return 0;
+}
+
+
+int main(int argc, char ** argv){
+  int rank, np, n;
+  int in_num = argc;
+  char ** input_str = argv;
+
+  MPI_Init(&argc, &argv);
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+  MPI_Comm_size(MPI_COMM_WORLD, &np);
+
+  if (getCmdOption(input_str, input_str+in_num, "-n")){
+    n = atoi(getCmdOption(input_str, input_str+in_num, "-n"));
+    if (n < 0) n = 13;
+  } else n = 13;
+
+
+  {
+    World dw(argc, argv);
+    fused_term(n, dw);
+  }
+
+  MPI_Finalize();
+  return 0;
+}
+/**
+ * @}
+ * @}
+ */
+
+#endif
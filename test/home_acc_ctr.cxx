@@ -0,0 +1,131 @@
+/*Copyright (c) 2011, Edgar Solomonik, all rights reserved.*/
+/** \addtogroup tests
+  * @{
+  * \defgroup home_acc_ctr home_acc_ctr
+  * @{
+  * \brief Tests contractions whose output leaves its home mapping, including overwrites of outputs holding NaN
+  */
+
+#include <ctf.hpp>
+using namespace CTF;
+
+/**
+ * \brief sets every element of M to NaN
+ */
+void fill_home_acc_nan(Matrix<> & M){
+  int64_t np;
+  int64_t * inds;
+  double * vals;
+  M.read_local(&np, &inds, &vals);
+  for (int64_t i=0; i<np; i++){
+    vals[i] = NAN;
+  }
+  M.write(np, inds, vals);
+  free(inds);
+  free(vals);
+}
+
+bool same_home_acc_values(Tensor<> & A, Tensor<> & B){
+  int64_t nA, nB;
+  double * dA, * dB;
+  A.read_all(&nA, &dA, false);
+  B.read_all(&nB, &dB, false);
+  bool pass = (nA == nB);
+  for (int64_t i=0; pass && i<nA; i++){
+    pass = fabs(dA[i] - dB[i]) <= 1.E-10*(1.+fabs(dA[i]));
+  }
+  free(dA);
+  free(dB);
+  return pass;
+}
+
+int home_acc_ctr(int     n,
+                 World & dw){
+  int pass = 1;
+  int m = n+6;
+
+  Matrix<> A(m, m, NS, dw, "A");
+  Matrix<> B(m, m, NS, dw, "B");
+  Matrix<> C(m, m, NS, dw, "C");
+  Matrix<> R(m, m, NS, dw, "R");
+  Vector<> x(m, dw, "x");
+  Vector<> y(m, dw, "y");
+  A.fill_random(-1., 1.);
+  B.fill_random(-1., 1.);
+  x.fill_random(-1., 1.);
+  y.fill_random(-1., 1.);
+
+  //the product gives C a home mapping, which the outer product and the transposed product may not use
+  C["ij"] = A["ik"]*B["kj"];
+  R["ij"] = C["ij"];
+  C["ij"] += x["i"]*y["j"];
+  R["ij"] += x["i"]*y["j"];
+  pass &= same_home_acc_values(C, R);
+
+  //overwriting C must not keep the NaN in it, whether or not it moves away from home
+  fill_home_acc_nan(C);
+  C["ij"] = x["i"]*y["j"];
+  R["ij"] = x["i"]*y["j"];
+  pass &= same_home_acc_values(C, R);
+  fill_home_acc_nan(C);
+  C["ij"] = A["ki"]*B["jk"];
+  R["ij"] = A["ki"]*B["jk"];
+  pass &= same_home_acc_values(C, R);
+
+  //a later contraction that keeps C in place adds to the values left by the ones above
+  C["ij"] += A["ik"]*B["kj"];
+  R["ij"] += A["ik"]*B["kj"];
+  pass &= same_home_acc_values(C, R);
+
+  MPI_Allreduce(MPI_IN_PLACE, &pass, 1, MPI_INT, MPI_MIN, dw.comm);
+  if (dw.rank == 0){
+    if (pass)
+      printf("{ contractions into outputs that leave their home mapping } passed\n");
+    else
+      printf("{ contractions into outputs that leave their home mapping } failed\n");
+  }
+  return pass;
+}
+
+
+#ifndef TEST_SUITE
+char* getCmdOption(char ** begin,
+                   char ** end,
+                   const   std::string & option){
+  char ** itr = std::find(begin, end, option);
+  if (itr != end && ++itr != end){
+    return *itr;
+  }
+  return 0;
+}
+
+
+int main(int argc, char ** argv){
+  int rank, np, n;
+  int in_num = argc;
+  char ** input_str = argv;
+
+  MPI_Init(&argc, &argv);
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+  MPI_Comm_size(MPI_COMM_WORLD, &np);
+
+  if (getCmdOption(input_str, input_str+in_num, "-n")){
+    n = atoi(getCmdOption(input_str, input_str+in_num, "-n"));
+    if (n < 0) n = 7;
+  } else n = 7;
+
+
+  {
+    World dw(argc, argv);
+    home_acc_ctr(n, dw);
+  }
+
+  MPI_Finalize();
+  return 0;
+}
+/**
+ * @}
+ * @}
+ */
+
+#endif
@@ -0,0 +1,197 @@
+/*Copyright (c) 2011, Edgar Solomonik, all rights reserved.*/
+/** \addtogroup tests
+  * @{
+  * \defgroup masked_ctr masked_ctr
+  * @{
+  * \brief Tests contractions and summations restricted to the nonzeros (or zeros) of a mask
+  */
+
+#include <ctf.hpp>
+using namespace CTF;
+
+/**
+ * \brief checks that every entry of T is the entry of F where M is (or is not, if cmp) nonzero and R elsewhere
+ */
+bool check_masked(Tensor<> & T, Tensor<> & F, Tensor<> & M, Tensor<> & R, bool cmp){
+  int64_t n;
+  double * dT, * dF, * dM, * dR;
+  T.read_all(&n, &dT);
+  F.read_all(&n, &dF);
+  M.read_all(&n, &dM);
+  R.read_all(&n, &dR);
+  bool pass = true;
+  for (int64_t i=0; i<n; i++){
+    double ref = ((dM[i] != 0.) != cmp) ? dF[i] : dR[i];
+    if (std::abs(dT[i] - ref) > 1.E-9*(1.+std::abs(ref))) pass = false;
+  }
+  free(dT);
+  free(dF);
+  free(dM);
+  free(dR);
+  return pass;
+}
+
+int masked_ctr(int     n,
+               World & dw){
+  int pass = 1;
+
+  Matrix<> A(n, n, SP, dw, "A");
+  Matrix<> B(n, n, NS, dw, "B");
+  Matrix<> M(n, n, SP, dw, "M");
+  Vector<> x(n, SP, dw, "x");
+  Vector<> v(n, SP, dw, "v");
+  dw.glob_wrld_rng.seed(11);
+  A.fill_sp_random(1., 2., .3);
+  B.fill_random(-1., 1.);
+  M.fill_sp_random(1., 2., .2);
+  x.fill_sp_random(1., 2., .3);
+  v.fill_sp_random(1., 2., .4);
+
+  Matrix<> Z(n, n, NS, dw, "Z");
+  Vector<> z(n, NS, dw, "z");
+  Matrix<> C0(n, n, NS, dw, "C0");
+  C0.fill_random(-1., 1.);
+
+  //mask has indices from both operands, so the product is masked after filtering A by rows of M
+  Matrix<> F(n, n, NS, dw, "F");
+  F["ij"] = A["ik"]*B["kj"];
+  Matrix<> C(n, n, SP, dw, "C");
+  C["ij"].masked(M) += A["ik"]*B["kj"];
+  pass &= check_masked(C, F, M, Z, false);
+  Matrix<> Cc(C0);
+  Cc["ij"].masked(M, true) += A["ik"]*B["kj"];
+  Matrix<> Fc(C0);
+  Fc["ij"] += F["ij"];
+  pass &= check_masked(Cc, Fc, M, C0, true);
+
+  //transposed operands and mask, with the sparse operand second and with both operands sparse
+  Matrix<> Bs(n, n, SP, dw, "Bs");
+  Bs.fill_sp_random(1., 2., .3);
+  Matrix<> Ft(n, n, NS, dw, "Ft");
+  Matrix<> Mt(n, n, SP, dw, "Mt");
+  Mt["ij"] = M["ji"];
+  Ft["ij"] = B["ki"]*A["jk"];
+  Matrix<> Ct(C0);
+  Ct["ij"].masked(M["ji"]) = B["ki"]*A["jk"];
+  pass &= check_masked(Ct, Ft, Mt, Z, false);
+  Ft["ij"] = A["ik"]*Bs["kj"];
+  Matrix<> Cs(n, n, SP, dw, "Cs");
+  Cs["ij"].masked(M, true) += A["ik"]*Bs["kj"];
+  pass &= check_masked(Cs, Ft, M, Z, true);
+
+  //mask indices all belong to A, so filtering A is exact
+  Vector<> y(n, SP, dw, "y");
+  Vector<> f(n, NS, dw, "f");
+  f["j"] = x["i"]*A["ij"];
+  y["j"].masked(v["j"], true) += x["i"]*A["ij"];
+  pass &= check_masked(y, f, v, z, true);
+  y["j"].masked(v["j"]) = x["i"]*A["ij"];
+  pass &= check_masked(y, f, v, z, false);
+
+  //vector masks on sparse matrix-vector products are applied within the kernel
+  Vector<> w(n, SP, dw, "w");
+  Vector<> fw(n, NS, dw, "fw");
+  fw["i"] = A["ij"]*x["j"];
+  w["i"].masked(v) += A["ij"]*x["j"];
+  pass &= check_masked(w, fw, v, z, false);
+  w["i"].masked(v, true) = A["ij"]*x["j"];
+  pass &= check_masked(w, fw, v, z, true);
+  Vector<> s(n, SP, dw, "s");
+  if (dw.rank == 0){
+    int64_t idx = n/2;
+    double val = 1.;
+    s.write(1, &idx, &val);
+  } else s.write(0, NULL, NULL);
+  y["j"].masked(s) = x["i"]*A["ij"];
+  pass &= check_masked(y, f, s, z, false);
+
+  //summations with and without broadcast indices
+  Matrix<> D(n, n, NS, dw, "D");
+  D["ij"].masked(M) += A["ij"];
+  pass &= check_masked(D, A, M, Z, false);
+  Matrix<> E(n, n, SP, dw, "E");
+  Matrix<> G(n, n, NS, dw, "G");
+  Vector<> xd(n, NS, dw, "xd");
+  xd["i"] = x["i"];
+  G["ij"] = xd["i"];
+  E["ij"].masked(M["ij"]) += x["i"];
+  pass &= check_masked(E, G, M, Z, false);
+
+  //masked relaxation in the tropical semiring, as in a BFS/SSSP step over unvisited vertices
+  Semiring<double> trop(std::numeric_limits<double>::infinity(),
+                        [](double a, double b){ return std::min(a,b); },
+                        MPI_MIN,
+                        0.,
+                        [](double a, double b){ return a+b; });
+  Matrix<double> W(n, n, SP, dw, trop, "W");
+  Vector<double> d(n, SP, dw, "d", 0, trop);
+  Vector<double> u(n, SP, dw, "u", 0, trop);
+  Vector<double> fu(n, SP, dw, "fu", 0, trop);
+  W["ij"] = A["ij"];
+  d["i"] = x["i"];
+  u["j"] = d["i"]*W["ij"];
+  fu["j"].masked(v, true) += d["i"]*W["ij"];
+  int64_t nu;
+  double * du, * dfu, * dv;
+  u.read_all(&nu, &du);
+  fu.read_all(&nu, &dfu);
+  v.read_all(&nu, &dv);
+  for (int64_t i=0; i<nu; i++){
+    if (dfu[i] != (dv[i] != 0. ? std::numeric_limits<double>::infinity() : du[i])) pass = 0;
+  }
+  free(du);
+  free(dfu);
+  free(dv);
+
+  MPI_Allreduce(MPI_IN_PLACE, &pass, 1, MPI_INT, MPI_MIN, dw.comm);
+  if (dw.rank == 0){
+    if (pass)
+      printf("{ masked contractions and summations } passed\n");
+    else
+      printf("{ masked contractions and summations } failed\n");
+  }
+  return pass;
+}
+
+
+#ifndef TEST_SUITE
+char* getCmdOption(char ** begin,
+                   char ** end,
+                   const   std::string & option){
+  char ** itr = std::find(begin, end, option);
+  if (itr != end && ++itr != end){
+    return *itr;
+  }
+  return 0;
+}
+
+
+int main(int argc, char ** argv){
+  int rank, np, n;
+  int in_num = argc;
+  char ** input_str = argv;
+
+  MPI_Init(&argc, &argv);
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+  MPI_Comm_size(MPI_COMM_WORLD, &np);
+
+  if (getCmdOption(input_str, input_str+in_num, "-n")){
+    n = atoi(getCmdOption(input_str, input_str+in_num, "-n"));
+    if (n < 0) n = 7;
+  } else n = 7;
+
+
+  {
+    World dw(argc, argv);
+    masked_ctr(n, dw);
+  }
+
+  MPI_Finalize();
+  return 0;
+}
+/**
+ * @}
+ * @}
+ */
+
+#endif
@@ -0,0 +1,133 @@
+/*Copyright (c) 2011, Edgar Solomonik, all rights reserved.*/
+/** \addtogroup tests
+  * @{
+  * \defgroup packed_sym_ctr packed_sym_ctr
+  * @{
+  * \brief Tests contractions of antisymmetric tensors done in packed form under a memory budget against the same
+  *        contractions of their unpacked copies
+  */
+
+#include <ctf.hpp>
+using namespace CTF;
+
+bool same_unpacked_values(Tensor<> & A, Tensor<> & B){
+  int64_t nA, nB;
+  double * dA, * dB;
+  A.read_all(&nA, &dA, true);
+  B.read_all(&nB, &dB, true);
+  bool pass = (nA == nB);
+  for (int64_t i=0; pass && i<nA; i++){
+    pass = fabs(dA[i] - dB[i]) <= 1.E-10*(1.+fabs(dA[i]));
+  }
+  free(dA);
+  free(dB);
+  return pass;
+}
+
+int packed_sym_ctr(int     n,
+                   World & dw){
+  int pass = 1;
+
+  int lens[] = {n, n, n};
+  int as_ns[] = {AS, NS};
+  int as_ns_ns[] = {AS, NS, NS};
+  int as_as_ns[] = {AS, AS, NS};
+  int ns_ns_ns[] = {NS, NS, NS};
+  Matrix<> A(n, n, AS, dw, "A");
+  Matrix<> B(n, n, NS, dw, "B");
+  Tensor<> T(3, lens, as_ns_ns, dw, "T");
+  Tensor<> W(3, lens, as_as_ns, dw, "W");
+  Vector<> x(n, dw, "x");
+  A.fill_random(-1., 1.);
+  B.fill_random(-1., 1.);
+  T.fill_random(-1., 1.);
+  W.fill_random(-1., 1.);
+  x.fill_random(-1., 1.);
+
+  //references from unpacked copies
+  Matrix<> An(n, n, NS, dw, "An");
+  Tensor<> Tn(3, lens, ns_ns_ns, dw, "Tn");
+  Tensor<> Wn(3, lens, ns_ns_ns, dw, "Wn");
+  An["ij"] = A["ij"];
+  Tn["ijl"] = T["ijl"];
+  Wn["ijl"] = W["ijl"];
+  Matrix<> Cr(n, n, NS, dw, "Cr");
+  Tensor<> Ur(3, lens, ns_ns_ns, dw, "Ur");
+  Matrix<> Vr(n, n, NS, dw, "Vr");
+  Cr["ij"] = An["ik"]*B["kj"];
+  Ur["ijl"] = Tn["ikl"]*B["kj"];
+  Vr["ij"] = Wn["ijk"]*x["k"];
+  //an antisymmetric output of a product of nonsymmetric matrices, compared to the same contraction done unpacked
+  Matrix<> Dr(n, n, AS, dw, "Dr");
+  Dr["ij"] = B["ik"]*An["kj"];
+
+  //a budget of one byte leaves no room to unpack the broken symmetries
+  dw.mem_budget = 1;
+  Matrix<> C(n, n, NS, dw, "C");
+  Tensor<> U(3, lens, ns_ns_ns, dw, "U");
+  Matrix<> V(n, n, AS, dw, "V");
+  C["ij"] = A["ik"]*B["kj"];
+  U["ijl"] = T["ikl"]*B["kj"];
+  V["ij"] = W["ijk"]*x["k"];
+  Matrix<> D(n, n, AS, dw, "D");
+  D["ij"] = B["ik"]*An["kj"];
+  dw.mem_budget = 0;
+  Matrix<> Vn(n, n, NS, dw, "Vn");
+  Vn["ij"] = V["ij"];
+  pass &= same_unpacked_values(C, Cr);
+  pass &= same_unpacked_values(U, Ur);
+  pass &= same_unpacked_values(Vn, Vr);
+  pass &= same_unpacked_values(D, Dr);
+
+  MPI_Allreduce(MPI_IN_PLACE, &pass, 1, MPI_INT, MPI_MIN, dw.comm);
+  if (dw.rank == 0){
+    if (pass)
+      printf("{ packed antisymmetric contractions under a memory budget match unpacked ones } passed\n");
+    else
+      printf("{ packed antisymmetric contractions under a memory budget match unpacked ones } failed\n");
+  }
+  return pass;
+}
+
+
+#ifndef TEST_SUITE
+char* getCmdOption(char ** begin,
+                   char ** end,
+                   const   std::string & option){
+  char ** itr = std::find(begin, end, option);
+  if (itr != end && ++itr != end){
+    return *itr;
+  }
+  return 0;
+}
+
+
+int main(int argc, char ** argv){
+  int rank, np, n;
+  int in_num = argc;
+  char ** input_str = argv;
+
+  MPI_Init(&argc, &argv);
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+  MPI_Comm_size(MPI_COMM_WORLD, &np);
+
+  if (getCmdOption(input_str, input_str+in_num, "-n")){
+    n = atoi(getCmdOption(input_str, input_str+in_num, "-n"));
+    if (n < 0) n = 6;
+  } else n = 6;
+
+
+  {
+    World dw(argc, argv);
+    packed_sym_ctr(n, dw);
+  }
+
+  MPI_Finalize();
+  return 0;
+}
+/**
+ * @}
+ * @}
+ */
+
+#endif
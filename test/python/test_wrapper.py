@@ -33,4 +33,18 @@ norm = C.norm2()
 if rank is 0:
   print 'error norm is ' + repr(norm)
 
+D = ctf.tsr([4, 5])
+[st, end] = D.block_range()
+D.from_numpy(np.arange(st, end, dtype=np.float64))
+vals = np.zeros(20, dtype=np.float64)
+D.read_all(vals)
+#scale local data in place through a view of it
+d = D.to_numpy()
+d[:] = d[:] * 2.
+vals2 = np.zeros(20, dtype=np.float64)
+D.read_all(vals2)
+if rank is 0:
+  print 'from_numpy error is ' + repr(np.linalg.norm(vals - np.arange(20.)))
+  print 'to_numpy error is ' + repr(np.linalg.norm(vals2 - 2.*np.arange(20.)))
+
 ctf.MPI_end()
@@ -0,0 +1,123 @@
+/*Copyright (c) 2011, Edgar Solomonik, all rights reserved.*/
+/** \addtogroup tests
+  * @{
+  * \defgroup random_fill random_fill
+  * @{
+  * \brief Tests that random fills of dense and sparse tensors do not depend on the process grid or mapping
+  *        and that sparse fills produce the expected number of nonzeros
+  */
+
+#include <ctf.hpp>
+using namespace CTF;
+
+bool same_values(Tensor<> & A, Tensor<> & B){
+  int64_t nA, nB;
+  double * dA, * dB;
+  A.read_all(&nA, &dA, false);
+  B.read_all(&nB, &dB, false);
+  bool pass = (nA == nB);
+  for (int64_t i=0; pass && i<nA; i++){
+    pass = (dA[i] == dB[i]);
+  }
+  free(dA);
+  free(dB);
+  return pass;
+}
+
+int random_fill(int     n,
+                World & dw){
+  int pass = 1;
+  World sw(MPI_COMM_SELF);
+
+  int lens[] = {n, n+1, n+2};
+  int nsns[] = {NS, NS, NS};
+  int syns[] = {SY, NS, NS};
+  int plens[] = {dw.np};
+  Partition pe(1, plens);
+
+  Tensor<> A(3, lens, nsns, dw, "A");
+  Tensor<> A2(3, lens, nsns, dw, "ijk", pe["k"], Idx_Partition(), "A2");
+  Tensor<> As(3, lens, nsns, sw, "As");
+  dw.glob_wrld_rng.seed(13);
+  A.fill_random(-1., 1.);
+  dw.glob_wrld_rng.seed(13);
+  A2.fill_random(-1., 1.);
+  sw.glob_wrld_rng.seed(13);
+  As.fill_random(-1., 1.);
+  pass &= same_values(A, A2);
+  pass &= same_values(A, As);
+  pass &= (A.norm2() > 0.);
+
+  int slens[] = {n, n, n+1};
+  Tensor<> S(3, slens, syns, dw, "S");
+  Tensor<> Ss(3, slens, syns, sw, "Ss");
+  dw.glob_wrld_rng.seed(17);
+  S.fill_random(-1., 1.);
+  sw.glob_wrld_rng.seed(17);
+  Ss.fill_random(-1., 1.);
+  pass &= same_values(S, Ss);
+
+  double frac = .13;
+  Tensor<> P(3, true, lens, nsns, dw, Ring<>(), "P");
+  Tensor<> Ps(3, true, lens, nsns, sw, Ring<>(), "Ps");
+  dw.glob_wrld_rng.seed(19);
+  P.fill_sp_random(1., 2., frac);
+  sw.glob_wrld_rng.seed(19);
+  Ps.fill_sp_random(1., 2., frac);
+  int64_t exp_nnz = (int64_t)(n*(n+1)*(n+2)*frac+.5);
+  pass &= (P.nnz_tot == exp_nnz);
+  pass &= (Ps.nnz_tot == exp_nnz);
+  pass &= same_values(P, Ps);
+
+  MPI_Allreduce(MPI_IN_PLACE, &pass, 1, MPI_INT, MPI_MIN, dw.comm);
+  if (dw.rank == 0){
+    if (pass)
+      printf("{ random fills are independent of mapping and sparse fill has expected nnz } passed\n");
+    else
+      printf("{ random fills are independent of mapping and sparse fill has expected nnz } failed\n");
+  }
+  return pass;
+}
+
+
+#ifndef TEST_SUITE
+char* getCmdOption(char ** begin,
+                   char ** end,
+                   const   std::string & option){
+  char ** itr = std::find(begin, end, option);
+  if (itr != end && ++itr != end){
+    return *itr;
+  }
+  return 0;
+}
+
+
+int main(int argc, char ** argv){
+  int rank, np, n;
+  int in_num = argc;
+  char ** input_str = argv;
+
+  MPI_Init(&argc, &argv);
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+  MPI_Comm_size(MPI_COMM_WORLD, &np);
+
+  if (getCmdOption(input_str, input_str+in_num, "-n")){
+    n = atoi(getCmdOption(input_str, input_str+in_num, "-n"));
+    if (n < 0) n = 7;
+  } else n = 7;
+
+
+  {
+    World dw(argc, argv);
+    random_fill(n, dw);
+  }
+
+  MPI_Finalize();
+  return 0;
+}
+/**
+ * @}
+ * @}
+ */
+
+#endif
@@ -3,7 +3,7 @@
   * @{ 
   * \defgroup readwrite_test readwrite_test
   * @{ 
-  * \brief Tests how writes to diagonals are handled for various tensors
+  * \brief Tests how writes to diagonals are handled for various tensors, and writes of ranges of global indices
   */
 
 #include <ctf.hpp>
@@ -131,6 +131,34 @@ int readwrite_test(int n,
     }
 #endif
   }
+
+  //each process writes a range of consecutive global indices, the last n entries are left unwritten
+  int sizeR3[] = {n, n+1, n+2};
+  Tensor<> R_NS(3, sizeR3, shape_NS4, dw);
+  int64_t nw = ((int64_t)n)*(n+1)*(n+2)-n;
+  int64_t blk = (nw+num_pes-1)/num_pes;
+  int64_t st = std::min(nw, rank*blk);
+  int64_t nr = std::min(nw, (rank+1)*blk)-st;
+  std::vector<double> rvals(std::max(nr,(int64_t)1));
+  for (int64_t j=0; j<nr; j++){
+    rvals[j] = st+j+1.;
+  }
+  R_NS.write_range(st, nr, (char const*)rvals.data());
+  int64_t nall;
+  double * all_vals;
+  R_NS.read_all(&nall, &all_vals);
+  for (int64_t j=0; j<nall; j++){
+    if (all_vals[j] != (j < nw ? j+1. : 0.)){
+      pass = 0;
+#ifndef TEST_SUITE
+      if (rank == 0){
+        printf("Range write failed at index %ld!\n", j);
+      }
+#endif
+      break;
+    }
+  }
+  free(all_vals);
   
   if (rank == 0){
     MPI_Reduce(MPI_IN_PLACE, &pass, 1, MPI_INT, MPI_MIN, 0, MPI_COMM_WORLD);
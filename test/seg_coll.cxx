@@ -0,0 +1,123 @@
+/*Copyright (c) 2011, Edgar Solomonik, all rights reserved.*/
+/** \addtogroup tests
+  * @{
+  * \defgroup seg_coll seg_coll
+  * @{
+  * \brief Tests broadcasts and reductions done in pipelined segments, directly and within contractions
+  */
+
+#include <ctf.hpp>
+using namespace CTF;
+
+int seg_coll(int     n,
+             World & dw){
+  int pass = 1;
+  int64_t cnt = 7*n+3;
+  int np = dw.np, rank = dw.rank;
+  std::vector<double> a(cnt), b(cnt), c(cnt);
+  for (int64_t i=0; i<cnt; i++){
+    a[i] = rank == np-1 ? i : -1.;
+    b[i] = rank+i;
+  }
+  Matrix<> A(n, n+1, NS, dw, "A");
+  Matrix<> B(n+1, n+2, NS, dw, "B");
+  Matrix<> Cr(n, n+2, NS, dw, "Cr");
+  A.fill_random(-1., 1.);
+  B.fill_random(-1., 1.);
+  Cr["ij"] = A["ik"]*B["kj"];
+
+  //segments of 5 doubles, so that messages are pipelined in several, partly filled, segments
+  CTF_int::set_coll_segments(8, 40);
+  //with the default models a broadcast of so many small segments is predicted to be slower than an
+  //unsegmented one, it is pipelined when the unsegmented one is modeled as slow
+  double bcast_coeff = CTF_int::bcast_mdl.coeff_guess[2];
+  for (int s=0; s<2; s++){
+    for (int64_t i=0; i<cnt; i++){
+      a[i] = rank == np-1 ? i : -1.;
+    }
+    if (s == 1) CTF_int::bcast_mdl.coeff_guess[2] = 1.;
+    pass &= (dw.cdt.estimate_bcast_time(cnt*sizeof(double)) < 1.) == (s == 0 || np > 1);
+    dw.cdt.bcast(a.data(), cnt, MPI_DOUBLE, np-1);
+    for (int64_t i=0; i<cnt; i++){
+      if (a[i] != i) pass = 0;
+    }
+  }
+  CTF_int::bcast_mdl.coeff_guess[2] = bcast_coeff;
+  double sum_r = np*(np-1)/2.;
+  dw.cdt.allred(b.data(), c.data(), cnt, MPI_DOUBLE, MPI_SUM);
+  for (int64_t i=0; i<cnt; i++){
+    if (c[i] != sum_r+np*i) pass = 0;
+  }
+  dw.cdt.allred(MPI_IN_PLACE, b.data(), cnt, MPI_DOUBLE, MPI_MAX);
+  for (int64_t i=0; i<cnt; i++){
+    if (b[i] != np-1+i) pass = 0;
+  }
+  for (int64_t i=0; i<cnt; i++){
+    b[i] = rank+i;
+  }
+  if (rank == 0){
+    dw.cdt.red(MPI_IN_PLACE, b.data(), cnt, MPI_DOUBLE, MPI_SUM, 0);
+    for (int64_t i=0; i<cnt; i++){
+      if (b[i] != sum_r+np*i) pass = 0;
+    }
+  } else
+    dw.cdt.red(b.data(), NULL, cnt, MPI_DOUBLE, MPI_SUM, 0);
+
+  Matrix<> C(n, n+2, NS, dw, "C");
+  C["ij"] = A["ik"]*B["kj"];
+  C["ij"] -= Cr["ij"];
+  if (C.norm2() > 1.E-10) pass = 0;
+  CTF_int::set_coll_segments(((int64_t)1)<<26, ((int64_t)1)<<23);
+
+  MPI_Allreduce(MPI_IN_PLACE, &pass, 1, MPI_INT, MPI_MIN, dw.comm);
+  if (dw.rank == 0){
+    if (pass)
+      printf("{ segmented broadcasts and reductions } passed\n");
+    else
+      printf("{ segmented broadcasts and reductions } failed\n");
+  }
+  return pass;
+}
+
+
+#ifndef TEST_SUITE
+char* getCmdOption(char ** begin,
+                   char ** end,
+                   const   std::string & option){
+  char ** itr = std::find(begin, end, option);
+  if (itr != end && ++itr != end){
+    return *itr;
+  }
+  return 0;
+}
+
+
+int main(int argc, char ** argv){
+  int rank, np, n;
+  int in_num = argc;
+  char ** input_str = argv;
+
+  MPI_Init(&argc, &argv);
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+  MPI_Comm_size(MPI_COMM_WORLD, &np);
+
+  if (getCmdOption(input_str, input_str+in_num, "-n")){
+    n = atoi(getCmdOption(input_str, input_str+in_num, "-n"));
+    if (n < 0) n = 23;
+  } else n = 23;
+
+
+  {
+    World dw(argc, argv);
+    seg_coll(n, dw);
+  }
+
+  MPI_Finalize();
+  return 0;
+}
+/**
+ * @}
+ * @}
+ */
+
+#endif
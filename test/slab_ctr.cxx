@@ -0,0 +1,150 @@
+/*Copyright (c) 2011, Edgar Solomonik, all rights reserved.*/
+/** \addtogroup tests
+  * @{
+  * \defgroup slab_ctr slab_ctr
+  * @{
+  * \brief Tests contractions done in slabs to fit a memory budget against the same contractions done at once
+  */
+
+#include <ctf.hpp>
+using namespace CTF;
+
+bool same_slab_values(Tensor<> & A, Tensor<> & B){
+  int64_t nA, nB;
+  double * dA, * dB;
+  A.read_all(&nA, &dA, false);
+  B.read_all(&nB, &dB, false);
+  bool pass = (nA == nB);
+  for (int64_t i=0; pass && i<nA; i++){
+    pass = fabs(dA[i] - dB[i]) <= 1.E-10*(1.+fabs(dA[i]));
+  }
+  free(dA);
+  free(dB);
+  return pass;
+}
+
+int slab_ctr(int     n,
+             World & dw){
+  int pass = 1;
+  int m = n+1;
+  int k = n+2;
+
+  Matrix<> A(m, k, NS, dw, "A");
+  Matrix<> B(k, n, NS, dw, "B");
+  Matrix<> C(m, n, NS, dw, "C");
+  Matrix<> Cr(m, n, NS, dw, "Cr");
+  int lens_T[] = {m, k, n};
+  int lens_U[] = {m, n, n};
+  int nsns[] = {NS, NS, NS};
+  Tensor<> T(3, lens_T, nsns, dw, "T");
+  Tensor<> U(3, lens_U, nsns, dw, "U");
+  Tensor<> Ur(3, lens_U, nsns, dw, "Ur");
+  Matrix<> S(m, m, NS, dw, "S");
+  Matrix<> Sr(m, m, NS, dw, "Sr");
+  A.fill_random(-1., 1.);
+  B.fill_random(-1., 1.);
+  C.fill_random(-1., 1.);
+  T.fill_random(-1., 1.);
+  Cr["ij"] = C["ij"];
+
+  //a budget of one byte forces slabs of length one, a budget of twice the matrices gives longer slabs
+  int64_t budgets[] = {1, 16*(m*k+k*n+m*n)/dw.np};
+  for (int b=0; b<2; b++){
+    dw.mem_budget = 0;
+    Cr["ij"] += 2.*A["ik"]*B["kj"];
+    Ur["ijl"] = T["ikl"]*B["kj"];
+    Sr["ij"] = A["ik"]*A["jk"];
+    dw.mem_budget = budgets[b];
+    C["ij"] += 2.*A["ik"]*B["kj"];
+    U["ijl"] = T["ikl"]*B["kj"];
+    S["ij"] = A["ik"]*A["jk"];
+    dw.mem_budget = 0;
+    pass &= same_slab_values(C, Cr);
+    pass &= same_slab_values(U, Ur);
+    pass &= same_slab_values(S, Sr);
+  }
+
+  //operands paged out to files are contracted in slabs read from and written to the files, with the
+  //default budget (one slab if it fits) and with the larger one above, and are paged in when read
+  for (int b=0; b<2; b++){
+    dw.mem_budget = 0;
+    Cr["ij"] += 2.*A["ik"]*B["kj"];
+    Ur["ijl"] = T["ikl"]*B["kj"];
+    Sr["ij"] = A["ik"]*A["jk"];
+    A.page_out("slab_ctr_A");
+    C.page_out("slab_ctr_C");
+    T.page_out("slab_ctr_T");
+    U.page_out("slab_ctr_U");
+    S.page_out("slab_ctr_S");
+    dw.mem_budget = b == 0 ? 0 : budgets[1];
+    C["ij"] += 2.*A["ik"]*B["kj"];
+    U["ijl"] = T["ikl"]*B["kj"];
+    pass &= A.page_file != MPI_FILE_NULL && T.page_file != MPI_FILE_NULL;
+    //in S, A is split into slabs along i as one operand but is used whole as the other, so it is paged in
+    S["ij"] = A["ik"]*A["jk"];
+    dw.mem_budget = 0;
+    pass &= C.page_file != MPI_FILE_NULL && U.page_file != MPI_FILE_NULL && S.page_file != MPI_FILE_NULL;
+    pass &= same_slab_values(C, Cr);
+    pass &= same_slab_values(U, Ur);
+    pass &= same_slab_values(S, Sr);
+    A.page_in();
+    T.page_in();
+    char name[64];
+    sprintf(name, "slab_ctr_C.%d", dw.rank);
+    FILE * fp = fopen(name, "r");
+    pass &= fp == NULL && C.page_file == MPI_FILE_NULL;
+    if (fp != NULL) fclose(fp);
+  }
+
+  MPI_Allreduce(MPI_IN_PLACE, &pass, 1, MPI_INT, MPI_MIN, dw.comm);
+  if (dw.rank == 0){
+    if (pass)
+      printf("{ contractions in slabs under a memory budget match contractions done at once } passed\n");
+    else
+      printf("{ contractions in slabs under a memory budget match contractions done at once } failed\n");
+  }
+  return pass;
+}
+
+
+#ifndef TEST_SUITE
+char* getCmdOption(char ** begin,
+                   char ** end,
+                   const   std::string & option){
+  char ** itr = std::find(begin, end, option);
+  if (itr != end && ++itr != end){
+    return *itr;
+  }
+  return 0;
+}
+
+
+int main(int argc, char ** argv){
+  int rank, np, n;
+  int in_num = argc;
+  char ** input_str = argv;
+
+  MPI_Init(&argc, &argv);
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+  MPI_Comm_size(MPI_COMM_WORLD, &np);
+
+  if (getCmdOption(input_str, input_str+in_num, "-n")){
+    n = atoi(getCmdOption(input_str, input_str+in_num, "-n"));
+    if (n < 0) n = 7;
+  } else n = 7;
+
+
+  {
+    World dw(argc, argv);
+    slab_ctr(n, dw);
+  }
+
+  MPI_Finalize();
+  return 0;
+}
+/**
+ * @}
+ * @}
+ */
+
+#endif
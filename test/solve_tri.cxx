@@ -0,0 +1,136 @@
+/*Copyright (c) 2011, Edgar Solomonik, all rights reserved.*/
+/** \addtogroup tests
+  * @{
+  * \defgroup solve_tri solve_tri
+  * @{
+  * \brief Tests triangular solves via ScaLAPACK for real and complex matrices, with the (conjugate)
+  *        transpose of the triangular factor on either side, requires CTF built with -DUSE_SCALAPACK
+  */
+
+#include <ctf.hpp>
+using namespace CTF;
+
+double conj_solve_tri(double a){ return a; }
+
+std::complex<double> conj_solve_tri(std::complex<double> a){ return std::conj(a); }
+
+double rand_solve_tri(double){ return drand48()-.5; }
+
+std::complex<double> rand_solve_tri(std::complex<double>){ return std::complex<double>(drand48()-.5, drand48()-.5); }
+
+/**
+ * \brief fills M with random values, if tri is 1 (-1) keeps only the lower (upper) triangle and adds n to the diagonal
+ */
+template <typename dtype>
+void fill_solve_tri(Matrix<dtype> & M, int tri){
+  int64_t np;
+  int64_t * idx;
+  dtype * data;
+  M.read_local(&np, &idx, &data);
+  for (int64_t i=0; i<np; i++){
+    int64_t r = idx[i]%M.nrow;
+    int64_t c = idx[i]/M.nrow;
+    data[i] = rand_solve_tri(data[i]);
+    if (tri != 0 && r == c) data[i] += (dtype)M.nrow;
+    if ((tri == 1 && r < c) || (tri == -1 && r > c)) data[i] = 0.;
+  }
+  M.write(np, idx, data);
+  free(idx);
+  free(data);
+}
+
+template <typename dtype>
+bool test_solve_tri(int n, World & dw){
+  int m = n+2;
+  bool pass = true;
+  for (int lower=0; lower<2; lower++){
+    Matrix<dtype> L(n, n, NS, dw);
+    fill_solve_tri(L, lower ? 1 : -1);
+    for (int from_left=0; from_left<2; from_left++){
+      Matrix<dtype> B(from_left ? n : m, from_left ? m : n, NS, dw);
+      fill_solve_tri(B, 0);
+      for (int transp_L=0; transp_L<2; transp_L++){
+        Matrix<dtype> X;
+        B.solve_tri(L, X, lower, from_left, transp_L);
+        Matrix<dtype> opL(n, n, NS, dw);
+        if (transp_L){
+          opL["ij"] = L["ji"];
+          Transform<dtype>([](dtype & a){ a = conj_solve_tri(a); })(opL["ij"]);
+        } else
+          opL["ij"] = L["ij"];
+        Matrix<dtype> R(B);
+        if (from_left)
+          R["ij"] -= opL["ik"]*X["kj"];
+        else
+          R["ij"] -= X["ik"]*opL["kj"];
+        int64_t np;
+        int64_t * idx;
+        dtype * data;
+        R.read_local(&np, &idx, &data);
+        for (int64_t i=0; i<np; i++){
+          if (std::abs(data[i]) > 1.E-10) pass = false;
+        }
+        free(idx);
+        free(data);
+      }
+    }
+  }
+  return pass;
+}
+
+int solve_tri(int     n,
+              World & dw){
+  srand48(dw.rank);
+  int pass = test_solve_tri<double>(n, dw) && test_solve_tri< std::complex<double> >(n, dw);
+  MPI_Allreduce(MPI_IN_PLACE, &pass, 1, MPI_INT, MPI_MIN, dw.comm);
+  if (dw.rank == 0){
+    if (pass)
+      printf("{ op(L)*X = B and X*op(L) = B solved via ScaLAPACK } passed\n");
+    else
+      printf("{ op(L)*X = B and X*op(L) = B solved via ScaLAPACK } failed\n");
+  }
+  return pass;
+}
+
+
+#ifndef TEST_SUITE
+char* getCmdOption(char ** begin,
+                   char ** end,
+                   const   std::string & option){
+  char ** itr = std::find(begin, end, option);
+  if (itr != end && ++itr != end){
+    return *itr;
+  }
+  return 0;
+}
+
+
+int main(int argc, char ** argv){
+  int rank, np, n;
+  int in_num = argc;
+  char ** input_str = argv;
+
+  MPI_Init(&argc, &argv);
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+  MPI_Comm_size(MPI_COMM_WORLD, &np);
+
+  if (getCmdOption(input_str, input_str+in_num, "-n")){
+    n = atoi(getCmdOption(input_str, input_str+in_num, "-n"));
+    if (n < 0) n = 7;
+  } else n = 7;
+
+
+  {
+    World dw(argc, argv);
+    solve_tri(n, dw);
+  }
+
+  MPI_Finalize();
+  return 0;
+}
+/**
+ * @}
+ * @}
+ */
+
+#endif
@@ -0,0 +1,161 @@
+/*Copyright (c) 2011, Edgar Solomonik, all rights reserved.*/
+/** \addtogroup tests
+  * @{
+  * \defgroup sp_write_buffer sp_write_buffer
+  * @{
+  * \brief Tests buffered writes into sparse tensors against the same writes done directly
+  */
+
+#include <ctf.hpp>
+using namespace CTF;
+
+/**
+ * \brief checks that T and R have the same values
+ */
+bool sp_write_buffer_match(Tensor<> & T, Tensor<> & R){
+  int64_t nT, nR;
+  double * dT, * dR;
+  T.read_all(&nT, &dT, true);
+  R.read_all(&nR, &dR, true);
+  bool pass = (nT == nR);
+  for (int64_t i=0; pass && i<nR; i++){
+    pass = fabs(dT[i] - dR[i]) <= 1.E-10*(1.+fabs(dR[i]));
+  }
+  free(dT);
+  free(dR);
+  return pass;
+}
+
+/**
+ * \brief writes the same batch of random pairs, with repeated keys, into T and R
+ */
+void sp_write_buffer_batch(Matrix<> & T, Matrix<> & R, int n, int64_t nb, double alpha, double beta, int seed){
+  int64_t * inds = (int64_t*)malloc(sizeof(int64_t)*nb);
+  double * vals = (double*)malloc(sizeof(double)*nb);
+  srand48(seed);
+  for (int64_t i=0; i<nb; i++){
+    inds[i] = lrand48()%(n*(int64_t)n/4);
+    vals[i] = drand48();
+  }
+  T.write(nb, alpha, beta, inds, vals);
+  R.write(nb, alpha, beta, inds, vals);
+  free(inds);
+  free(vals);
+}
+
+int sp_write_buffer(int     n,
+                    World & dw){
+  int pass = 1;
+
+  Matrix<> T(n, n, SP, dw, "T");
+  Matrix<> R(n, n, SP, dw, "R");
+  T.set_write_buffering(true);
+
+  //writes that add to existing values, many of them to the same keys
+  for (int b=0; b<20; b++){
+    sp_write_buffer_batch(T, R, n, 1+b%7, 1., 1., 17*b+dw.rank);
+  }
+  pass &= T.nwrite_buffered == 20;
+  pass &= T.write_runs.size() <= 8;
+  //the count of nonzeros is that before the buffered writes until they are merged
+  pass &= T.nnz_tot == 0;
+  Matrix<> DT(n, n, dw);
+  Matrix<> DR(n, n, dw);
+  DT["ij"] = T["ij"];
+  DR["ij"] = R["ij"];
+  pass &= T.nwrite_buffered == 0;
+  pass &= sp_write_buffer_match(DT, DR);
+
+  //writes that replace existing values, scaled writes, and a switch back to adding
+  for (int b=0; b<10; b++){
+    sp_write_buffer_batch(T, R, n, 3, 1., 0., 5*b+dw.rank+1000);
+  }
+  for (int b=0; b<10; b++){
+    sp_write_buffer_batch(T, R, n, 2+b, 2., 1., 3*b+dw.rank+2000);
+  }
+  Matrix<> CT(n, n, dw);
+  Matrix<> CR(n, n, dw);
+  CT["ij"] = T["ik"]*T["kj"];
+  CR["ij"] = R["ik"]*R["kj"];
+  pass &= sp_write_buffer_match(CT, CR);
+
+  //reads see the buffered writes
+  sp_write_buffer_batch(T, R, n, 4, 1., 1., dw.rank+3000);
+  pass &= std::abs(T.norm2() - R.norm2()) <= 1.E-10*R.norm2();
+  pass &= T.nnz_tot == R.nnz_tot;
+
+  //local reads need an explicit flush, as merging the writes is collective
+  sp_write_buffer_batch(T, R, n, 3, 1., 1., dw.rank+3500);
+  T.flush_writes();
+  int64_t nT, nR;
+  int64_t * iT, * iR;
+  double * vT, * vR;
+  T.read_local_nnz(&nT, &iT, &vT);
+  R.read_local_nnz(&nR, &iR, &vR);
+  pass &= nT == nR;
+  for (int64_t i=0; pass && i<nR; i++){
+    pass = iT[i] == iR[i] && fabs(vT[i] - vR[i]) <= 1.E-10*(1.+fabs(vR[i]));
+  }
+  free(iT);
+  free(vT);
+  free(iR);
+  free(vR);
+  sp_write_buffer_batch(T, R, n, 4, 1., 1., dw.rank+4000);
+  T.set_write_buffering(false);
+  pass &= T.nwrite_buffered == 0;
+  DT["ij"] = T["ij"];
+  DR["ij"] = R["ij"];
+  pass &= sp_write_buffer_match(DT, DR);
+
+  MPI_Allreduce(MPI_IN_PLACE, &pass, 1, MPI_INT, MPI_MIN, dw.comm);
+  if (dw.rank == 0){
+    if (pass)
+      printf("{ buffered sparse writes } passed\n");
+    else
+      printf("{ buffered sparse writes } failed\n");
+  }
+  return pass;
+}
+
+
+#ifndef TEST_SUITE
+char* getCmdOption(char ** begin,
+                   char ** end,
+                   const   std::string & option){
+  char ** itr = std::find(begin, end, option);
+  if (itr != end && ++itr != end){
+    return *itr;
+  }
+  return 0;
+}
+
+
+int main(int argc, char ** argv){
+  int rank, np, n;
+  int in_num = argc;
+  char ** input_str = argv;
+
+  MPI_Init(&argc, &argv);
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+  MPI_Comm_size(MPI_COMM_WORLD, &np);
+
+  if (getCmdOption(input_str, input_str+in_num, "-n")){
+    n = atoi(getCmdOption(input_str, input_str+in_num, "-n"));
+    if (n < 4) n = 9;
+  } else n = 9;
+
+
+  {
+    World dw(argc, argv);
+    sp_write_buffer(n, dw);
+  }
+
+  MPI_Finalize();
+  return 0;
+}
+/**
+ * @}
+ * @}
+ */
+
+#endif
@@ -0,0 +1,141 @@
+/*Copyright (c) 2011, Edgar Solomonik, all rights reserved.*/
+/** \addtogroup tests
+  * @{
+  * \defgroup spgemm spgemm
+  * @{
+  * \brief Tests products of sparse matrices into sparse and dense matrices against the same products
+  *        of dense matrices, for shapes whose best mappings replicate different operands
+  */
+
+#include <ctf.hpp>
+using namespace CTF;
+
+bool close_matrices(Matrix<> & A, Matrix<> & B){
+  int64_t nA, nB;
+  double * dA, * dB;
+  A.read_all(&nA, &dA, false);
+  B.read_all(&nB, &dB, false);
+  bool pass = (nA == nB);
+  for (int64_t i=0; pass && i<nA; i++){
+    pass = fabs(dA[i] - dB[i]) <= 1.E-10*(1.+fabs(dA[i]));
+  }
+  free(dA);
+  free(dB);
+  return pass;
+}
+
+int spgemm(int     n,
+           World & dw){
+  int pass = 1;
+  //square, a long contracted index (replicating C) and short contracted index (replicating A and B)
+  int shapes[][3] = {{n, n, n}, {n/2+1, 8*n, n/2+2}, {4*n, 2, 3*n}};
+  for (int s=0; s<3; s++){
+    int m = shapes[s][0], k = shapes[s][1], l = shapes[s][2];
+    Matrix<> A(m, k, SP, dw, "A");
+    Matrix<> B(k, l, SP, dw, "B");
+    Matrix<> Ad(m, k, dw, "Ad");
+    Matrix<> Bd(k, l, dw, "Bd");
+    A.fill_sp_random(-1., 1., .1);
+    B.fill_sp_random(-1., 1., .1);
+    Ad["ij"] = A["ij"];
+    Bd["ij"] = B["ij"];
+
+    Matrix<> C(m, l, SP, dw, "C");
+    Matrix<> Cd(m, l, dw, "Cd");
+    Matrix<> Cr(m, l, dw, "Cr");
+    C["ij"] = A["ik"]*B["kj"];
+    Cd["ij"] = A["ik"]*B["kj"];
+    Cr["ij"] = Ad["ik"]*Bd["kj"];
+    pass &= close_matrices(Cd, Cr);
+    Cd["ij"] = C["ij"];
+    pass &= close_matrices(Cd, Cr);
+
+    //accumulate into the sparse output
+    C["ij"] += 2.*A["ik"]*B["kj"];
+    Cr["ij"] += 2.*Ad["ik"]*Bd["kj"];
+    Cd["ij"] = C["ij"];
+    pass &= close_matrices(Cd, Cr);
+  }
+
+  //a thin product with a long contracted index that is already distributed over all processes and about
+  //half of the output nonzero, for which replicating C is cheap, as each process computes a partial C
+  //from its part of the contracted index, which is modeled as sparser than the reduced C
+  int kl = 256*n;
+  double dl = sqrt(1.-pow(.5, 1./kl));
+  double frac_C = CTF_int::ctr_nnz_frac(dl, dl, kl);
+  pass &= fabs(frac_C - .5) <= 1.E-9;
+  int nparts[] = {2, dw.np, 16};
+  for (int p=0; p<3; p++){
+    if (nparts[p] <= 1) continue;
+    double frac_P = CTF_int::partial_nnz_frac(frac_C, nparts[p]);
+    //a partial result has the nonzeros of the product over its part of the contracted index, and the
+    //partial results together have at least as many nonzeros as their sum
+    pass &= frac_P < frac_C && frac_P*nparts[p] >= frac_C;
+    pass &= fabs(frac_P - CTF_int::ctr_nnz_frac(dl, dl, kl/(double)nparts[p])) <= 1.E-9;
+  }
+  int plens[] = {dw.np};
+  Partition pe(1, plens);
+  Matrix<> Al(n, kl, "ik", pe["k"], Idx_Partition(), SP, dw, Ring<double>(), "Al");
+  Matrix<> Bl(kl, n, "kj", pe["k"], Idx_Partition(), SP, dw, Ring<double>(), "Bl");
+  Al.fill_sp_random(-1., 1., dl);
+  Bl.fill_sp_random(-1., 1., dl);
+  Matrix<> Cl(n, n, SP, dw, "Cl");
+  Matrix<> Cld(n, n, dw, "Cld");
+  Matrix<> Clr(n, n, dw, "Clr");
+  Cl["ij"] = Al["ik"]*Bl["kj"];
+  Cld["ij"] = Cl["ij"];
+  Clr["ij"] = Al["ik"]*Bl["kj"];
+  pass &= close_matrices(Cld, Clr);
+
+  MPI_Allreduce(MPI_IN_PLACE, &pass, 1, MPI_INT, MPI_MIN, dw.comm);
+  if (dw.rank == 0){
+    if (pass)
+      printf("{ products of sparse matrices } passed\n");
+    else
+      printf("{ products of sparse matrices } failed\n");
+  }
+  return pass;
+}
+
+
+#ifndef TEST_SUITE
+char* getCmdOption(char ** begin,
+                   char ** end,
+                   const   std::string & option){
+  char ** itr = std::find(begin, end, option);
+  if (itr != end && ++itr != end){
+    return *itr;
+  }
+  return 0;
+}
+
+
+int main(int argc, char ** argv){
+  int rank, np, n;
+  int in_num = argc;
+  char ** input_str = argv;
+
+  MPI_Init(&argc, &argv);
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+  MPI_Comm_size(MPI_COMM_WORLD, &np);
+
+  if (getCmdOption(input_str, input_str+in_num, "-n")){
+    n = atoi(getCmdOption(input_str, input_str+in_num, "-n"));
+    if (n < 0) n = 23;
+  } else n = 23;
+
+
+  {
+    World dw(argc, argv);
+    spgemm(n, dw);
+  }
+
+  MPI_Finalize();
+  return 0;
+}
+/**
+ * @}
+ * @}
+ */
+
+#endif
@@ -0,0 +1,157 @@
+/*Copyright (c) 2011, Edgar Solomonik, all rights reserved.*/
+/** \addtogroup tests
+  * @{
+  * \defgroup spmspv spmspv
+  * @{
+  * \brief Tests products of sparse matrices with sparse and dense vectors against the same products with a dense matrix
+  */
+
+#include <ctf.hpp>
+using namespace CTF;
+
+template <typename dtype>
+bool close_values(Vector<dtype> & a, Vector<dtype> & b){
+  int64_t na, nb;
+  dtype * da, * db;
+  a.read_all(&na, &da, false);
+  b.read_all(&nb, &db, false);
+  bool pass = (na == nb);
+  for (int64_t i=0; pass && i<na; i++){
+    pass = da[i] == db[i] || std::abs(da[i] - db[i]) <= 1.E-10*(1.+std::abs(da[i]));
+  }
+  free(da);
+  free(db);
+  return pass;
+}
+
+int spmspv(int     n,
+           World & dw){
+  int pass = 1;
+
+  Matrix<> A(n, n+1, SP, dw, "A");
+  Matrix<> Ad(n, n+1, dw, "Ad");
+  A.fill_sp_random(-1., 1., .2);
+  Ad["ij"] = A["ij"];
+
+  //dense and very sparse vectors, each multiplied along either mode of A
+  Vector<> xd(n+1, dw, "xd");
+  Vector<> xs(n+1, SP, dw, "xs");
+  Vector<> wd(n, dw, "wd");
+  Vector<> ws(n, SP, dw, "ws");
+  xd.fill_random(-1., 1.);
+  xs.fill_sp_random(-1., 1., 2./(n+1));
+  wd.fill_random(-1., 1.);
+  ws.fill_sp_random(-1., 1., .3);
+
+  Vector<> y(n, dw, "y");
+  Vector<> yr(n, dw, "yr");
+  y["i"] = A["ij"]*xd["j"];
+  yr["i"] = Ad["ij"]*xd["j"];
+  pass &= close_values(y, yr);
+
+  y["i"] = A["ij"]*xs["j"];
+  yr["i"] = Ad["ij"]*xs["j"];
+  pass &= close_values(y, yr);
+
+  //alpha and beta with the contracted index first and the vector as the left operand
+  Vector<> z(n+1, dw, "z");
+  Vector<> zr(n+1, dw, "zr");
+  z.fill_random(-1., 1.);
+  zr["j"] = z["j"];
+  z["j"] += 2.*wd["i"]*A["ij"];
+  zr["j"] += 2.*wd["i"]*Ad["ij"];
+  pass &= close_values(z, zr);
+
+  z["j"] += ws["i"]*A["ij"];
+  zr["j"] += ws["i"]*Ad["ij"];
+  pass &= close_values(z, zr);
+
+  //sparse output
+  Vector<> ys(n, SP, dw, "ys");
+  ys["i"] = A["ij"]*xs["j"];
+  yr["i"] = Ad["ij"]*xs["j"];
+  Vector<> yd(n, dw, "yd");
+  yd["i"] = ys["i"];
+  pass &= close_values(yd, yr);
+
+  //relaxation over the tropical semiring with the output aliasing the vector, as in Bellman-Ford
+  Semiring<double> trop(INFINITY,
+                        [](double a, double b){ return std::min(a,b); },
+                        MPI_MIN,
+                        0.,
+                        [](double a, double b){ return a+b; });
+  Matrix<> G(n, n, SP, dw, trop, "G");
+  Matrix<> Gd(n, n, dw, trop, "Gd");
+  G.fill_sp_random(1., 2., .3);
+  Gd["ij"] = G["ij"];
+  Vector<> p(n, SP, dw, "p", 0, trop);
+  Vector<> pr(n, dw, "pr", 0, trop);
+  if (dw.rank == 0){
+    int64_t idx = 0;
+    double val = 0.;
+    p.write(1, &idx, &val);
+    pr.write(1, &idx, &val);
+  } else {
+    p.write(0, NULL, NULL);
+    pr.write(0, NULL, NULL);
+  }
+  for (int r=0; r<3; r++){
+    p["i"] += G["ij"]*p["j"];
+    pr["i"] += Gd["ij"]*pr["j"];
+  }
+  Vector<> pd(n, dw, "pd", 0, trop);
+  pd["i"] = p["i"];
+  pass &= close_values(pd, pr);
+
+  MPI_Allreduce(MPI_IN_PLACE, &pass, 1, MPI_INT, MPI_MIN, dw.comm);
+  if (dw.rank == 0){
+    if (pass)
+      printf("{ sparse matrix times sparse and dense vectors } passed\n");
+    else
+      printf("{ sparse matrix times sparse and dense vectors } failed\n");
+  }
+  return pass;
+}
+
+
+#ifndef TEST_SUITE
+char* getCmdOption(char ** begin,
+                   char ** end,
+                   const   std::string & option){
+  char ** itr = std::find(begin, end, option);
+  if (itr != end && ++itr != end){
+    return *itr;
+  }
+  return 0;
+}
+
+
+int main(int argc, char ** argv){
+  int rank, np, n;
+  int in_num = argc;
+  char ** input_str = argv;
+
+  MPI_Init(&argc, &argv);
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+  MPI_Comm_size(MPI_COMM_WORLD, &np);
+
+  if (getCmdOption(input_str, input_str+in_num, "-n")){
+    n = atoi(getCmdOption(input_str, input_str+in_num, "-n"));
+    if (n < 0) n = 23;
+  } else n = 23;
+
+
+  {
+    World dw(argc, argv);
+    spmspv(n, dw);
+  }
+
+  MPI_Finalize();
+  return 0;
+}
+/**
+ * @}
+ * @}
+ */
+
+#endif
@@ -0,0 +1,115 @@
+/*Copyright (c) 2011, Edgar Solomonik, all rights reserved.*/
+/** \addtogroup tests
+  * @{
+  * \defgroup sptensor_remap sptensor_remap
+  * @{
+  * \brief Tests that remapping sparse tensors between processor grid mappings preserves their nonzeros
+  */
+
+#include <ctf.hpp>
+using namespace CTF;
+
+bool same_entries(Tensor<> & A, Tensor<> & B){
+  int64_t nA, nB;
+  double * dA, * dB;
+  A.read_all(&nA, &dA, false);
+  B.read_all(&nB, &dB, false);
+  bool pass = (nA == nB);
+  for (int64_t i=0; pass && i<nA; i++){
+    pass = (dA[i] == dB[i]);
+  }
+  free(dA);
+  free(dB);
+  return pass;
+}
+
+int sptensor_remap(int     n,
+                   World & dw){
+  int pass = 1;
+
+  int lens[] = {n, n+1, n+2};
+  int nsns[] = {NS, NS, NS};
+  int plens[] = {dw.np};
+  Partition pe(1, plens);
+  int plens2[] = {1, dw.np};
+  if (dw.np % 2 == 0){
+    plens2[0] = 2;
+    plens2[1] = dw.np/2;
+  }
+  Partition pe2(2, plens2);
+
+  Tensor<> A(3, true, lens, nsns, dw, Ring<>(), "A");
+  A.fill_sp_random(1., 2., .2);
+
+  //mappings with the nonzeros along each mode split across processors, on one and two dimensional grids
+  Tensor<> B(3, true, lens, nsns, dw, "ijk", pe["i"], Idx_Partition(), "B");
+  Tensor<> C(3, true, lens, nsns, dw, "ijk", pe["k"], Idx_Partition(), "C");
+  Tensor<> D(3, true, lens, nsns, dw, "ijk", pe2["kj"], Idx_Partition(), "D");
+  B["ijk"] = A["ijk"];
+  C["ijk"] = B["ijk"];
+  D["ijk"] = C["ijk"];
+  pass &= same_entries(A, B);
+  pass &= same_entries(A, C);
+  pass &= same_entries(A, D);
+  pass &= (D.nnz_tot == A.nnz_tot);
+
+  //transposition remaps the nonzeros to a different index ordering
+  Tensor<> T(3, true, lens, nsns, dw, Ring<>(), "T");
+  int tlens[] = {n+2, n, n+1};
+  Tensor<> AT(3, true, tlens, nsns, dw, Ring<>(), "AT");
+  AT["kij"] = A["ijk"];
+  T["ijk"] = AT["kij"];
+  pass &= same_entries(A, T);
+
+  MPI_Allreduce(MPI_IN_PLACE, &pass, 1, MPI_INT, MPI_MIN, dw.comm);
+  if (dw.rank == 0){
+    if (pass)
+      printf("{ sparse tensor remapping preserves nonzeros } passed\n");
+    else
+      printf("{ sparse tensor remapping preserves nonzeros } failed\n");
+  }
+  return pass;
+}
+
+
+#ifndef TEST_SUITE
+char* getCmdOption(char ** begin,
+                   char ** end,
+                   const   std::string & option){
+  char ** itr = std::find(begin, end, option);
+  if (itr != end && ++itr != end){
+    return *itr;
+  }
+  return 0;
+}
+
+
+int main(int argc, char ** argv){
+  int rank, np, n;
+  int in_num = argc;
+  char ** input_str = argv;
+
+  MPI_Init(&argc, &argv);
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+  MPI_Comm_size(MPI_COMM_WORLD, &np);
+
+  if (getCmdOption(input_str, input_str+in_num, "-n")){
+    n = atoi(getCmdOption(input_str, input_str+in_num, "-n"));
+    if (n < 0) n = 7;
+  } else n = 7;
+
+
+  {
+    World dw(argc, argv);
+    sptensor_remap(n, dw);
+  }
+
+  MPI_Finalize();
+  return 0;
+}
+/**
+ * @}
+ * @}
+ */
+
+#endif
@@ -0,0 +1,184 @@
+/*Copyright (c) 2011, Edgar Solomonik, all rights reserved.*/
+/** \addtogroup tests
+  * @{
+  * \defgroup tensor_network tensor_network
+  * @{
+  * \brief Tests contraction of tensor networks, with and without slicing over sub-worlds, against
+  *        the same networks contracted pairwise in a fixed order
+  */
+
+#include <ctf.hpp>
+using namespace CTF;
+
+/**
+ * \brief checks that T and R have the same values
+ */
+bool tensor_network_match(Tensor<> & T, Tensor<> & R){
+  int64_t nT, nR;
+  double * dT, * dR;
+  T.read_all(&nT, &dT, true);
+  R.read_all(&nR, &dR, true);
+  bool pass = (nT == nR);
+  for (int64_t i=0; pass && i<nR; i++){
+    pass = fabs(dT[i] - dR[i]) <= 1.E-9*(1.+fabs(dR[i]));
+  }
+  free(dT);
+  free(dR);
+  return pass;
+}
+
+/**
+ * \brief contracts N into C with enough memory and with a quarter of the memory the unsliced
+ *        network needs, checks against R, which must contain beta*C + alpha*N
+ * \param[in] sliceable whether the memory limit must lead to slicing, which it need not when
+ *            no single index touches every intermediate of peak size, e.g. in a matrix chain
+ */
+bool tensor_network_check(Network<> & N, Tensor<> & C, char const * idx_C, Tensor<> & R,
+                          double alpha, double beta, bool sliceable){
+  bool pass = true;
+  for (int sliced=0; sliced<2; sliced++){
+    Tensor<> T(C);
+    N.mem_limit = -1;
+    if (sliced){
+      CTF_int::network_plan plan;
+      N.get_plan(T, idx_C, plan);
+      N.mem_limit = (int64_t)(plan.peak*sizeof(double)/(4*C.wrld->np));
+      N.get_plan(T, idx_C, plan);
+      if (sliceable) pass &= plan.npiece > 1;
+    }
+    N.contract(alpha, T, idx_C, beta);
+    pass &= tensor_network_match(T, R);
+  }
+  return pass;
+}
+
+int tensor_network(int     n,
+                   World & dw){
+  int pass = 1;
+
+  //a loop of tensors with a dangling index on each and a shared index between the first and third
+  Matrix<> A(n, n+1, dw, "A");
+  int lB[] = {n+1, n, n+2};
+  int lD[] = {n+2, n-1, n, n};
+  Tensor<> B(3, lB, dw, Ring<>(), "B");
+  Tensor<> D(4, lD, dw, Ring<>(), "D");
+  Matrix<> E(n-1, n, dw, "E");
+  A.fill_random(-1., 1.);
+  B.fill_random(-1., 1.);
+  D.fill_random(-1., 1.);
+  E.fill_random(-1., 1.);
+  {
+    Network<> N;
+    N.add(A, "ia");
+    N.add(B, "ajb");
+    N.add(D, "bcki");
+    N.add(E, "cj");
+    int lC[] = {n, n};
+    Tensor<> C(2, lC, dw, Ring<>(), "C");
+    C.fill_random(-1., 1.);
+    //reference contracted pairwise in a fixed order
+    int lX[] = {n, n, n+2};
+    int lY[] = {n, n-1, n};
+    Tensor<> X(3, lX, dw, Ring<>(), "X");
+    Tensor<> Y(3, lY, dw, Ring<>(), "Y");
+    X["ijb"] = A["ia"]*B["ajb"];
+    Y["jck"] = X["ijb"]*D["bcki"];
+    Tensor<> R(C);
+    R["jk"] = .5*R["jk"];
+    R["jk"] += 2.*Y["jck"]*E["cj"];
+    pass &= tensor_network_check(N, C, "jk", R, 2., .5, true);
+
+    //full contraction into a scalar
+    Network<> F;
+    F.add(A, "ia");
+    F.add(B, "ajb");
+    F.add(D, "bcki");
+    F.add(E, "cj");
+    Scalar<> s(dw);
+    Scalar<> r(dw);
+    r[""] = Y["jck"]*E["cj"];
+    pass &= tensor_network_check(F, s, "", r, 1., 0., true);
+  }
+
+  //a chain of more matrices than are ordered exhaustively
+  {
+    int nm = 14;
+    std::vector< Matrix<> * > M;
+    Network<> N;
+    char idx_M[nm][3];
+    for (int i=0; i<nm; i++){
+      M.push_back(new Matrix<>(n+i%3, n+(i+1)%3, dw));
+      M[i]->fill_random(-1., 1.);
+      idx_M[i][0] = 'a'+i;
+      idx_M[i][1] = 'a'+i+1;
+      idx_M[i][2] = '\0';
+      N.add(*M[i], idx_M[i]);
+    }
+    Matrix<> * R = new Matrix<>(*M[0]);
+    for (int i=1; i<nm; i++){
+      Matrix<> * T = new Matrix<>(n, n+(i+1)%3, dw);
+      (*T)["ik"] = (*R)["ij"]*(*M[i])["jk"];
+      delete R;
+      R = T;
+    }
+    char idx_C[] = {'a', (char)('a'+nm), '\0'};
+    Matrix<> C(n, n+nm%3, dw);
+    pass &= tensor_network_check(N, C, idx_C, *R, 1., 0., false);
+    delete R;
+    for (int i=0; i<nm; i++){
+      delete M[i];
+    }
+  }
+
+  MPI_Allreduce(MPI_IN_PLACE, &pass, 1, MPI_INT, MPI_MIN, dw.comm);
+  if (dw.rank == 0){
+    if (pass)
+      printf("{ tensor network contraction with slicing } passed\n");
+    else
+      printf("{ tensor network contraction with slicing } failed\n");
+  }
+  return pass;
+}
+
+
+#ifndef TEST_SUITE
+char* getCmdOption(char ** begin,
+                   char ** end,
+                   const   std::string & option){
+  char ** itr = std::find(begin, end, option);
+  if (itr != end && ++itr != end){
+    return *itr;
+  }
+  return 0;
+}
+
+
+int main(int argc, char ** argv){
+  int rank, np, n;
+  int in_num = argc;
+  char ** input_str = argv;
+
+  MPI_Init(&argc, &argv);
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+  MPI_Comm_size(MPI_COMM_WORLD, &np);
+
+  if (getCmdOption(input_str, input_str+in_num, "-n")){
+    n = atoi(getCmdOption(input_str, input_str+in_num, "-n"));
+    if (n < 2) n = 5;
+  } else n = 5;
+
+
+  {
+    World dw(argc, argv);
+    tensor_network(n, dw);
+  }
+
+  MPI_Finalize();
+  return 0;
+}
+/**
+ * @}
+ * @}
+ */
+
+#endif
@@ -25,6 +25,26 @@
 #include "univar_function.cxx"
 #include "bivar_function.cxx"
 #include "bivar_transform.cxx"
+#include "ctr_report.cxx"
+#include "random_fill.cxx"
+#include "sptensor_remap.cxx"
+#include "block_cyclic.cxx"
+#include "masked_ctr.cxx"
+#include "spmspv.cxx"
+#include "packed_sym_ctr.cxx"
+#include "unfolded_ctr.cxx"
+#include "slab_ctr.cxx"
+#include "home_acc_ctr.cxx"
+#include "spgemm.cxx"
+#include "comm_cache.cxx"
+#include "csr_reduce.cxx"
+#include "seg_coll.cxx"
+#include "dns_sp_sum.cxx"
+#include "ewise.cxx"
+#include "fused_term.cxx"
+#include "batch_ctr.cxx"
+#include "tensor_network.cxx"
+#include "sp_write_buffer.cxx"
 
 #include "../examples/trace.cxx"
 #include "../examples/dft_3D.cxx"
@@ -193,6 +213,86 @@ int main(int argc, char ** argv){
       printf("Testing SY times NS with n = %d:\n",n);
     pass.push_back(sy_times_ns(n,dw));
 
+    if (rank == 0)
+      printf("Testing contraction reports with n = %d:\n",n);
+    pass.push_back(ctr_report(n,dw));
+
+    if (rank == 0)
+      printf("Testing random fills with n = %d:\n",n);
+    pass.push_back(random_fill(n,dw));
+
+    if (rank == 0)
+      printf("Testing sparse tensor remapping with n = %d:\n",n);
+    pass.push_back(sptensor_remap(n,dw));
+
+    if (rank == 0)
+      printf("Testing block-cyclic matrix read and write with n = %d:\n",n);
+    pass.push_back(block_cyclic(n,dw));
+
+    if (rank == 0)
+      printf("Testing masked contractions and summations with n = %d:\n",n);
+    pass.push_back(masked_ctr(n,dw));
+
+    if (rank == 0)
+      printf("Testing sparse matrix times sparse and dense vectors with n = %d:\n",n);
+    pass.push_back(spmspv(n,dw));
+
+    if (rank == 0)
+      printf("Testing packed antisymmetric contractions under a memory budget with n = %d:\n",n);
+    pass.push_back(packed_sym_ctr(n,dw));
+
+    if (rank == 0)
+      printf("Testing elementwise contractions that cannot be folded with n = %d:\n",n);
+    pass.push_back(unfolded_ctr(n,dw));
+
+    if (rank == 0)
+      printf("Testing contractions in slabs under a memory budget with n = %d:\n",n);
+    pass.push_back(slab_ctr(n,dw));
+
+    if (rank == 0)
+      printf("Testing contractions into outputs that leave their home mapping with n = %d:\n",n);
+    pass.push_back(home_acc_ctr(n,dw));
+
+    if (rank == 0)
+      printf("Testing products of sparse matrices with n = %d:\n",n);
+    pass.push_back(spgemm(n,dw));
+
+    if (rank == 0)
+      printf("Testing reuse of cached processor grid communicators with n = %d:\n",n);
+    pass.push_back(comm_cache(n,dw));
+
+    if (rank == 0)
+      printf("Testing reductions of CSR matrices with n = %d:\n",n);
+    pass.push_back(csr_reduce(n,dw));
+
+    if (rank == 0)
+      printf("Testing segmented broadcasts and reductions with n = %d:\n",n);
+    pass.push_back(seg_coll(n,dw));
+
+    if (rank == 0)
+      printf("Testing accumulation of dense tensors into sparse tensors with n = %d:\n",n);
+    pass.push_back(dns_sp_sum(n,dw));
+
+    if (rank == 0)
+      printf("Testing elementwise operations on identically distributed tensors with n = %d:\n",n);
+    pass.push_back(ewise(n,dw));
+
+    if (rank == 0)
+      printf("Testing fused elementwise expressions with n = %d:\n",n);
+    pass.push_back(fused_term(n,dw));
+
+    if (rank == 0)
+      printf("Testing batched contractions of small tensors with n = %d:\n",n);
+    pass.push_back(batch_ctr(n,dw));
+
+    if (rank == 0)
+      printf("Testing tensor network contraction with slicing with n = %d:\n",n);
+    pass.push_back(tensor_network(n,dw));
+
+    if (rank == 0)
+      printf("Testing buffered writes into sparse tensors with n = %d:\n",n);
+    pass.push_back(sp_write_buffer(n,dw));
+
 #if 0
     if (rank == 0)
       printf("Testing skew-symmetric Strassen's algorithm with n = %d:\n",n*n);
@@ -0,0 +1,138 @@
+/*Copyright (c) 2011, Edgar Solomonik, all rights reserved.*/
+/** \addtogroup tests
+  * @{
+  * \defgroup unfolded_ctr unfolded_ctr
+  * @{
+  * \brief Tests contractions that cannot be folded into a matrix multiplication (elementwise products)
+  *        against the same contractions done with a custom function
+  */
+
+#include <ctf.hpp>
+using namespace CTF;
+
+bool same_tensors(Tensor<> & A, Tensor<> & B){
+  int64_t nA, nB;
+  double * dA, * dB;
+  A.read_all(&nA, &dA, false);
+  B.read_all(&nB, &dB, false);
+  bool pass = (nA == nB);
+  for (int64_t i=0; pass && i<nA; i++){
+    pass = fabs(dA[i] - dB[i]) <= 1.E-10*(1.+fabs(dA[i]));
+  }
+  free(dA);
+  free(dB);
+  return pass;
+}
+
+int unfolded_ctr(int     n,
+                 World & dw){
+  int pass = 1;
+  int m = n+1;
+  int k = n+2;
+  CTF::Function<> fmul([](double a, double b){ return a*b; });
+
+  //elementwise products, with alpha and beta
+  int lens_A[] = {m, n, k};
+  int nsns[] = {NS, NS, NS};
+  Tensor<> A(3, lens_A, nsns, dw, "A");
+  Tensor<> B(3, lens_A, nsns, dw, "B");
+  Tensor<> C(3, lens_A, nsns, dw, "C");
+  Tensor<> Cr(3, lens_A, nsns, dw, "Cr");
+  A.fill_random(-1., 1.);
+  B.fill_random(-1., 1.);
+  C.fill_random(-1., 1.);
+  Cr["ijl"] = C["ijl"];
+  C["ijl"] += 2.*A["ijl"]*B["ijl"];
+  Tensor<> B2(3, lens_A, nsns, dw, "B2");
+  B2["ijl"] = 2.*B["ijl"];
+  Cr["ijl"] += fmul(A["ijl"],B2["ijl"]);
+  pass &= same_tensors(C, Cr);
+
+  //elementwise products of transposed operands, so that no index has unit stride in all of them
+  int lens_At[] = {k, m, n};
+  int lens_Bt[] = {n, m, k};
+  Tensor<> At(3, lens_At, nsns, dw, "At");
+  Tensor<> Bt(3, lens_Bt, nsns, dw, "Bt");
+  At.fill_random(-1., 1.);
+  Bt.fill_random(-1., 1.);
+  C["ijl"] = At["lij"]*Bt["jil"];
+  Cr["ijl"] = fmul(At["lij"],Bt["jil"]);
+  pass &= same_tensors(C, Cr);
+
+  //elementwise products with a symmetric operand, the nonsymmetric index is innermost
+  int lens_S[] = {m, m};
+  int sy[] = {SY, NS};
+  int lens_D[] = {m, m, k};
+  Tensor<> S(2, lens_S, sy, dw, "S");
+  Tensor<> D(3, lens_D, nsns, dw, "D");
+  Tensor<> E(3, lens_D, nsns, dw, "E");
+  Tensor<> Er(3, lens_D, nsns, dw, "Er");
+  S.fill_random(-1., 1.);
+  D.fill_random(-1., 1.);
+  E["ijl"] = S["ij"]*D["ijl"];
+  Er["ijl"] = fmul(S["ij"],D["ijl"]);
+  pass &= same_tensors(E, Er);
+
+  //row scaling combined with a sum over an index appearing in one operand only
+  Matrix<> M(m, k, NS, dw, "M");
+  Vector<> w(m, dw, "w");
+  Vector<> v(m, dw, "v");
+  Vector<> vr(m, dw, "vr");
+  M.fill_random(-1., 1.);
+  w.fill_random(-1., 1.);
+  v["i"] = M["il"]*w["i"];
+  vr["i"] = fmul(M["il"],w["i"]);
+  pass &= same_tensors(v, vr);
+
+  MPI_Allreduce(MPI_IN_PLACE, &pass, 1, MPI_INT, MPI_MIN, dw.comm);
+  if (dw.rank == 0){
+    if (pass)
+      printf("{ contractions that cannot be folded match elementwise evaluation } passed\n");
+    else
+      printf("{ contractions that cannot be folded match elementwise evaluation } failed\n");
+  }
+  return pass;
+}
+
+
+#ifndef TEST_SUITE
+char* getCmdOption(char ** begin,
+                   char ** end,
+                   const   std::string & option){
+  char ** itr = std::find(begin, end, option);
+  if (itr != end && ++itr != end){
+    return *itr;
+  }
+  return 0;
+}
+
+
+int main(int argc, char ** argv){
+  int rank, np, n;
+  int in_num = argc;
+  char ** input_str = argv;
+
+  MPI_Init(&argc, &argv);
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+  MPI_Comm_size(MPI_COMM_WORLD, &np);
+
+  if (getCmdOption(input_str, input_str+in_num, "-n")){
+    n = atoi(getCmdOption(input_str, input_str+in_num, "-n"));
+    if (n < 0) n = 7;
+  } else n = 7;
+
+
+  {
+    World dw(argc, argv);
+    unfolded_ctr(n, dw);
+  }
+
+  MPI_Finalize();
+  return 0;
+}
+/**
+ * @}
+ * @}
+ */
+
+#endif